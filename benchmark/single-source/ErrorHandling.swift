@@ -39,3 +39,34 @@ public func run_ErrorHandling(N: Int) {
   }
 }
 
+
+// Throw and catch in the same function once 'parseDigit' is inlined, with
+// an error payload large enough to need its own box.
+struct ParseError : ErrorType {
+  let position: Int
+  let character: UInt8
+}
+
+@inline(__always)
+func parseDigit(c: UInt8, at position: Int) throws -> Int {
+  if c < 48 || c > 57 {
+    throw ParseError(position: position, character: c)
+  }
+  return Int(c) - 48
+}
+
+@inline(never)
+public func run_ErrorHandlingInlined(N: Int) {
+  let input: [UInt8] = Array("12a45b78c0".utf8)
+  var sum = 0
+  for _ in 1...5000*N {
+    for (i, c) in input.enumerate() {
+      do {
+        sum = sum &+ (try parseDigit(c, at: i))
+      } catch _ {
+        sum = sum &- 1
+      }
+    }
+  }
+  CheckResults(sum != 0, "Incorrect results in ErrorHandlingInlined")
+}
@@ -124,6 +124,7 @@ precommitTests = [
   "DictionaryRemove": run_DictionaryRemove,
   "DictionarySwap": run_DictionarySwap,
   "ErrorHandling": run_ErrorHandling,
+  "ErrorHandlingInlined": run_ErrorHandlingInlined,
   "GlobalClass": run_GlobalClass,
   "Hanoi": run_Hanoi,
   "HashTest": run_HashTest,
@@ -72,6 +72,7 @@ namespace swift {
   class NominalTypeDecl;
   class TupleTypeElt;
   class EnumElementDecl;
+  class UnifiedStatsReporter;
   enum OptionalTypeKind : unsigned;
   class ProtocolDecl;
   class SubstitutableType;
@@ -156,6 +157,52 @@ public:
   ~ConstraintCheckerArenaRAII();
 };
 
+/// \brief Puts an ASTContext in thread-safe mode for the lifetime of this
+/// object, letting several threads create AST nodes and intern names in it
+/// at once, as is done when source files are parsed in parallel.
+///
+/// Identifiers that already exist are looked up without locking, and new
+/// ones lock only a part of the identifier table, so threads interning
+/// names rarely wait for each other. Nothing else about the context may be
+/// used concurrently. Every thread that
+/// allocates in the permanent arena while this is active, including the one
+/// that created it, must do so from within a \c ThreadArenaRAII.
+class ConcurrentASTContextRAII {
+  ASTContext &Self;
+
+public:
+  explicit ConcurrentASTContextRAII(ASTContext &self);
+
+  ConcurrentASTContextRAII(const ConcurrentASTContextRAII &) = delete;
+  ConcurrentASTContextRAII &
+  operator=(const ConcurrentASTContextRAII &) = delete;
+
+  ~ConcurrentASTContextRAII();
+};
+
+/// \brief Directs the permanent-arena allocations the current thread makes
+/// in an ASTContext that is used concurrently into an allocator of its own
+/// for the lifetime of this object, so that threads don't contend for the
+/// context's allocator.
+///
+/// The allocator belongs to the context, and the memory is freed along with
+/// it. Once this object is destroyed, the allocator is handed to the next
+/// \c ThreadArenaRAII, so that short-lived ones don't each start a new slab.
+class ThreadArenaRAII {
+  ASTContext &Self;
+  llvm::BumpPtrAllocator *Allocator;
+  const ASTContext *PrevContext;
+  llvm::BumpPtrAllocator *PrevAllocator;
+
+public:
+  explicit ThreadArenaRAII(ASTContext &self);
+
+  ThreadArenaRAII(const ThreadArenaRAII &) = delete;
+  ThreadArenaRAII &operator=(const ThreadArenaRAII &) = delete;
+
+  ~ThreadArenaRAII();
+};
+
 /// \brief Describes either a nominal type declaration or an extension
 /// declaration.
 typedef llvm::PointerUnion<NominalTypeDecl *, ExtensionDecl *>
@@ -172,6 +219,8 @@ public:
   Implementation &Impl;
   
   friend class ConstraintCheckerArenaRAII;
+  friend class ConcurrentASTContextRAII;
+  friend class ThreadArenaRAII;
 public:
   ASTContext(LangOptions &langOpts, SearchPathOptions &SearchPathOpts,
              SourceManager &SourceMgr, DiagnosticEngine &Diags);
@@ -189,6 +238,10 @@ public:
   /// Diags - The diagnostics engine.
   DiagnosticEngine &Diags;
 
+  /// The counters to update with statistics about the compilation, or null
+  /// if statistics aren't being collected.
+  UnifiedStatsReporter *Stats = nullptr;
+
   /// The set of top-level modules we have loaded.
   /// This map is used for iteration, therefore it's a MapVector and not a
   /// DenseMap.
@@ -539,6 +539,15 @@ namespace swift {
       return Result;
     }
 
+    /// \brief Send a diagnostic whose text has already been formatted, such
+    /// as one collected by another engine, to all diagnostic consumers.
+    ///
+    /// Whether and how the diagnostic is shown is decided by this engine, as
+    /// for any diagnostic with the same ID, so the engine that formatted it
+    /// should not have filtered anything out.
+    void emitFormattedDiagnostic(SourceLoc Loc, StringRef Text,
+                                 const DiagnosticInfo &Info);
+
     /// \brief Emit a diagnostic using a preformatted array of diagnostic
     /// arguments.
     ///
@@ -0,0 +1,90 @@
+//===--- ConcurrentStringTable.h - Thread-safe string interning -*- C++ -*-===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// A table of interned strings that several threads can use at once. Strings
+// are spread over a fixed number of shards by hash. Looking up a string that
+// is already in the table never takes a lock; adding one locks only its
+// shard, and only while the table is in thread-safe mode.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SWIFT_BASIC_CONCURRENTSTRINGTABLE_H
+#define SWIFT_BASIC_CONCURRENTSTRINGTABLE_H
+
+#include "swift/Basic/LLVM.h"
+#include "llvm/ADT/StringRef.h"
+
+#include <cstddef>
+#include <memory>
+
+namespace swift {
+
+/// A set of unique, immutable copies of strings, each of which lives as long
+/// as the table.
+class ConcurrentStringTable {
+public:
+  enum : unsigned {
+    /// The number of independently locked parts of the table.
+    NumShards = 16
+  };
+
+  /// The alignment of the strings returned by \c intern, which leaves their
+  /// low bits free for use by pointer unions.
+  enum : size_t { StringAlignment = 8 };
+
+private:
+  struct Shard;
+  std::unique_ptr<Shard[]> Shards;
+
+  /// Whether strings may be added by several threads at once.
+  bool ThreadSafe = false;
+
+public:
+  ConcurrentStringTable();
+  ~ConcurrentStringTable();
+
+  ConcurrentStringTable(const ConcurrentStringTable &) = delete;
+  ConcurrentStringTable &operator=(const ConcurrentStringTable &) = delete;
+
+  /// Returns the table's copy of \p str, adding one if there isn't one yet.
+  ///
+  /// The copy is null-terminated, aligned to \c StringAlignment, and the same
+  /// pointer is returned for every string with the same contents.
+  const char *intern(StringRef str);
+
+  /// Returns the table's copy of \p str, or null if there isn't one.
+  ///
+  /// A string that another thread is adding at the same time may or may not
+  /// be found.
+  const char *lookup(StringRef str) const;
+
+  /// Allows (or stops allowing) \c intern to be called from several threads
+  /// at once. \c lookup is always safe to call concurrently with \c intern.
+  ///
+  /// This may only be changed while no other thread is using the table.
+  void setThreadSafe(bool value) { ThreadSafe = value; }
+  bool isThreadSafe() const { return ThreadSafe; }
+
+  /// Returns the number of strings in the table.
+  ///
+  /// This may not be called while other threads are adding strings.
+  size_t size() const;
+
+  /// Returns the number of bytes allocated by the table.
+  ///
+  /// This may not be called while other threads are adding strings.
+  size_t getMemorySize() const;
+};
+
+} // end namespace swift
+
+#endif // SWIFT_BASIC_CONCURRENTSTRINGTABLE_H
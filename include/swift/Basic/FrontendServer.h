@@ -0,0 +1,123 @@
+//===--- FrontendServer.h - Protocol of the frontend server -----*- C++ -*-===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// The frontend server ("swift -frontend-server <socket>") is a long-lived
+// process which runs frontend jobs on behalf of the driver, so that jobs with
+// the same configuration can start from a compiler that has already loaded the
+// standard library and set up the Clang importer.
+//
+// A client connects to the server's Unix domain socket once per job and sends
+// a request: the executable it would have run, and the working directory,
+// arguments and environment of the job, along with the descriptor to which the
+// job's output should be written. The server replies with the pid of the
+// process running the job as soon as it has started, or with -1 if it won't
+// run the job, in which case the client should run the job itself. Once that
+// process exits, the server sends its wait status and the resources it used.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SWIFT_BASIC_FRONTENDSERVER_H
+#define SWIFT_BASIC_FRONTENDSERVER_H
+
+#include "swift/Basic/LLVM.h"
+#include "llvm/ADT/StringRef.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace swift {
+namespace sys {
+namespace frontend_server {
+
+/// A job sent to the server.
+struct Request {
+  /// The executable the client would have run. The server only runs jobs for
+  /// clients of the same compiler.
+  std::string ExecPath;
+
+  std::string WorkingDirectory;
+
+  /// The arguments of the job, not including the name of the executable.
+  std::vector<std::string> Args;
+
+  /// The environment of the job, as "NAME=VALUE" strings.
+  std::vector<std::string> Env;
+};
+
+/// How a job run by the server finished.
+struct Result {
+  /// The status of the process which ran the job, as reported by waitpid().
+  int Status = 0;
+
+  /// The CPU time spent executing in user mode, in microseconds.
+  uint64_t UserTime = 0;
+
+  /// The CPU time spent executing in the kernel, in microseconds.
+  uint64_t SystemTime = 0;
+
+  /// The peak resident set size of the process, in bytes.
+  uint64_t MaxRSS = 0;
+};
+
+/// Returns true if the frontend server can be used on the current system.
+bool isSupported();
+
+/// \brief Connects to the server listening at \p SocketPath.
+///
+/// \returns the connected socket, or -1 if there is no server there.
+int connect(StringRef SocketPath);
+
+/// \brief Creates a socket at \p SocketPath and listens for clients on it.
+///
+/// Only the current user may connect to the socket. A stale socket left at
+/// \p SocketPath by a server which is no longer running is replaced.
+///
+/// \returns the listening socket, or -1 on error (including if another
+/// server is already listening at \p SocketPath).
+int listen(StringRef SocketPath);
+
+/// Returns true if the process at the other end of the connected \p Socket
+/// runs as the same user as this one.
+bool isPeerSameUser(int Socket);
+
+/// \brief Sends \p R, and \p OutputFD as the descriptor to which the job's
+/// output should be written.
+///
+/// \returns true on error, false on success
+bool sendRequest(int Socket, const Request &R, int OutputFD);
+
+/// \brief Receives a request sent with \ref sendRequest.
+///
+/// \returns true on error, false on success
+bool receiveRequest(int Socket, Request &R, int &OutputFD);
+
+/// \brief Sends the pid of the process running the job, or -1 if the job
+/// was rejected.
+///
+/// \returns true on error, false on success
+bool sendPid(int Socket, int64_t Pid);
+
+/// \returns true on error, false on success
+bool receivePid(int Socket, int64_t &Pid);
+
+/// \returns true on error, false on success
+bool sendResult(int Socket, const Result &R);
+
+/// \returns true on error, false on success
+bool receiveResult(int Socket, Result &R);
+
+} // end namespace frontend_server
+} // end namespace sys
+} // end namespace swift
+
+#endif
@@ -0,0 +1,90 @@
+//===--- JobServer.h - Client for a make-compatible jobserver ---*- C++ -*-===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SWIFT_BASIC_JOBSERVER_H
+#define SWIFT_BASIC_JOBSERVER_H
+
+#include "swift/Basic/LLVM.h"
+#include "llvm/ADT/StringRef.h"
+
+#include <memory>
+#include <string>
+
+namespace swift {
+namespace sys {
+
+/// \brief A client of the jobserver that GNU make (and compatible build
+/// systems) shares with the processes it runs.
+///
+/// The jobserver is a pipe or named FIFO holding one single-byte token for
+/// each job that may run in parallel, beyond the one every process is allowed
+/// to run without asking. A process takes a token before starting each
+/// additional job, and writes the same byte back once that job finishes, so
+/// that the number of jobs running across all cooperating processes stays
+/// within the limit given to the top-level make.
+class JobServer {
+  /// The descriptor that tokens are read from. This is opened separately
+  /// from the one inherited from make, so that it can be made non-blocking
+  /// without affecting any other process.
+  int ReadFD;
+
+  /// The descriptor that tokens are written back to.
+  int WriteFD;
+
+  /// Whether this object opened \c WriteFD, and so must close it.
+  bool OwnsWriteFD;
+
+  /// The tokens currently held, in the order they were acquired.
+  std::string Tokens;
+
+  JobServer(int ReadFD, int WriteFD, bool OwnsWriteFD)
+    : ReadFD(ReadFD), WriteFD(WriteFD), OwnsWriteFD(OwnsWriteFD) {}
+
+public:
+  JobServer(const JobServer &) = delete;
+  JobServer &operator=(const JobServer &) = delete;
+
+  /// Returns all held tokens to the jobserver.
+  ~JobServer();
+
+  /// \brief Connects to the jobserver described by \p MakeFlags, in the
+  /// format of the MAKEFLAGS environment variable.
+  ///
+  /// \returns null if \p MakeFlags doesn't describe a jobserver, or if the
+  /// jobserver can't be used from this process (for example, because make
+  /// didn't pass its descriptors down).
+  static std::unique_ptr<JobServer> connect(StringRef MakeFlags);
+
+  /// \brief Connects to the jobserver described by the MAKEFLAGS environment
+  /// variable, if there is one.
+  static std::unique_ptr<JobServer> connectFromEnvironment();
+
+  /// \brief Takes a token from the jobserver, without blocking.
+  ///
+  /// \returns true if a token was acquired.
+  bool tryAcquire();
+
+  /// \brief Returns the token acquired most recently to the jobserver.
+  void release();
+
+  /// \returns the number of tokens currently held.
+  unsigned getNumTokens() const { return Tokens.size(); }
+
+  /// \returns a descriptor which becomes readable when the jobserver may
+  /// have a token available, suitable for use with poll().
+  int getPollFD() const { return ReadFD; }
+};
+
+} // end namespace sys
+} // end namespace swift
+
+#endif
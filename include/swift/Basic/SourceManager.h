@@ -14,8 +14,10 @@
 #define SWIFT_SOURCEMANAGER_H
 
 #include "swift/Basic/SourceLoc.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Mutex.h"
 #include "llvm/Support/SourceMgr.h"
 #include <map>
 
@@ -33,6 +35,10 @@ class SourceManager {
   /// Associates buffer identifiers to buffer IDs.
   llvm::StringMap<unsigned> BufIdentIDMap;
 
+  /// The IDs of buffers added with \c addMemBufferRef, whose contents are
+  /// owned by the client.
+  llvm::DenseSet<unsigned> BorrowedBufferIDs;
+
   // #line directive handling.
   struct VirtualFile {
     CharSourceRange Range;
@@ -42,6 +48,11 @@ class SourceManager {
   std::map<const char *, VirtualFile> VirtualFiles;
   mutable std::pair<const char *, const VirtualFile*> CachedVFile = {};
 
+  /// Guards \c VirtualFiles, \c CachedVFile and the line number cache of
+  /// \c LLVMSourceMgr, so that locations can be looked up from several
+  /// threads at once, as when source files are parsed in parallel.
+  mutable llvm::sys::Mutex LineLookupLock;
+
 public:
   llvm::SourceMgr &getLLVMSourceMgr() {
     return LLVMSourceMgr;
@@ -127,6 +138,26 @@ public:
   /// away as soon as this function returns.
   unsigned addMemBufferCopy(StringRef InputData, StringRef BufIdentifier = "");
 
+  /// Adds the contents of \p Buffer to the \c SourceManager without copying
+  /// them.
+  ///
+  /// The client keeps ownership of \p Buffer, which must be null-terminated
+  /// and must outlive the \c SourceManager.
+  unsigned addMemBufferRef(const llvm::MemoryBuffer *Buffer);
+
+  /// The number of bytes taken up by the contents of source buffers, by
+  /// where they live.
+  struct BufferMemoryUsage {
+    /// Contents read into (or copied onto) the heap.
+    size_t MallocBytes = 0;
+    /// Contents of files mapped into memory.
+    size_t MMapBytes = 0;
+    /// Contents owned by the client, added with \c addMemBufferRef.
+    size_t BorrowedBytes = 0;
+  };
+
+  BufferMemoryUsage getBufferMemoryUsage() const;
+
   /// Returns a buffer ID for a previously added buffer with the given
   /// buffer identifier, or None if there is no such buffer.
   Optional<unsigned> getIDForBufferIdentifier(StringRef BufIdentifier);
@@ -182,6 +213,7 @@ public:
   std::pair<unsigned, unsigned>
   getLineAndColumn(SourceLoc Loc, unsigned BufferID = 0) const {
     assert(Loc.isValid());
+    llvm::sys::ScopedLock Lock(LineLookupLock);
     int LineOffset = getLineOffset(Loc);
     int l, c;
     std::tie(l, c) = LLVMSourceMgr.getLineAndColumn(Loc.Value, BufferID);
@@ -196,6 +228,7 @@ public:
   /// This does not respect #line directives.
   unsigned getLineNumber(SourceLoc Loc, unsigned BufferID = 0) const {
     assert(Loc.isValid());
+    llvm::sys::ScopedLock Lock(LineLookupLock);
     return LLVMSourceMgr.FindLineNumber(Loc.Value, BufferID);
   }
 
@@ -0,0 +1,94 @@
+//===--- Statistic.h - Counters collected for one compiler job --*- C++ -*-===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// With -stats-output-dir, the driver and each frontend job write the counters
+// they collected to a JSON file of their own in the given directory. The
+// files for two builds can be summed and compared with
+// utils/process-stats-dir.py.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SWIFT_BASIC_STATISTIC_H
+#define SWIFT_BASIC_STATISTIC_H
+
+#include "swift/Basic/LLVM.h"
+#include "llvm/ADT/StringRef.h"
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace swift {
+
+/// Collects the counters of one run of the driver or the frontend, along
+/// with the total time spent in each SharedTimer, and writes them to a file
+/// when it is destroyed.
+///
+/// The file holds a single JSON object mapping names such as "AST.NumDecls"
+/// or "time.swift.Type checking.wall" to numbers, so that files from
+/// different jobs and builds can be combined without knowing what's in them.
+class UnifiedStatsReporter {
+public:
+  struct DriverCounters {
+#define DRIVER_STATISTIC(ID) uint64_t ID = 0;
+#include "swift/Basic/Statistics.def"
+  };
+
+  struct FrontendCounters {
+#define FRONTEND_STATISTIC(TYPE, ID) uint64_t ID = 0;
+#include "swift/Basic/Statistics.def"
+  };
+
+private:
+  std::string ProgramName;
+  std::string Directory;
+  std::string FilenameModel;
+  std::chrono::steady_clock::time_point StartTime;
+
+  std::unique_ptr<DriverCounters> Driver;
+  std::unique_ptr<FrontendCounters> Frontend;
+
+  /// Counters whose names are only known at run time, such as the number of
+  /// declarations deserialized from each module.
+  std::map<std::string, uint64_t> ExtraCounters;
+
+  /// Writes the counters to a new file in the directory.
+  ///
+  /// \returns true on error, false on success
+  bool write();
+
+public:
+  /// Creates a reporter for \p programName (such as "swift-frontend") that
+  /// writes its file to \p directory. \p moduleName and \p inputName become
+  /// part of the file's name, which is otherwise made unique.
+  ///
+  /// Only the SharedTimers created after the reporter are counted.
+  UnifiedStatsReporter(StringRef programName, StringRef moduleName,
+                       StringRef inputName, StringRef directory);
+  ~UnifiedStatsReporter();
+
+  UnifiedStatsReporter(const UnifiedStatsReporter &) = delete;
+  UnifiedStatsReporter &operator=(const UnifiedStatsReporter &) = delete;
+
+  DriverCounters &getDriverCounters();
+  FrontendCounters &getFrontendCounters();
+
+  /// Sets the counter called \p name, which should not be one of the
+  /// counters listed in Statistics.def.
+  void setCounter(StringRef name, uint64_t value);
+};
+
+} // end namespace swift
+
+#endif // SWIFT_BASIC_STATISTIC_H
@@ -13,14 +13,19 @@
 #ifndef SWIFT_BASIC_TASKQUEUE_H
 #define SWIFT_BASIC_TASKQUEUE_H
 
+#include "swift/Basic/JobServer.h"
 #include "swift/Basic/LLVM.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/Optional.h"
 #include "llvm/Config/config.h"
 #include "llvm/Support/Program.h"
 
+#include <algorithm>
 #include <functional>
 #include <memory>
 #include <queue>
+#include <string>
+#include <vector>
 
 namespace swift {
 namespace sys {
@@ -38,14 +43,78 @@ enum class TaskFinishedResponse {
   StopExecution,
 };
 
+/// \brief The resources used by a task, measured once it has finished.
+struct TaskResourceUsage {
+  /// The elapsed real time between starting the task and collecting its exit
+  /// status, in microseconds.
+  uint64_t WallTime = 0;
+
+  /// The CPU time spent executing in user mode, in microseconds.
+  uint64_t UserTime = 0;
+
+  /// The CPU time spent executing in the kernel, in microseconds.
+  uint64_t SystemTime = 0;
+
+  /// The peak resident set size of the task, in bytes.
+  uint64_t MaxRSS = 0;
+};
+
+/// \brief A queue of tasks which have not begun execution.
+///
+/// Tasks with a higher priority are removed first. Tasks with equal
+/// priorities are removed in the order in which they were added.
+template <typename TaskTy>
+class TaskPriorityQueue {
+  struct Entry {
+    unsigned Priority;
+    unsigned Sequence;
+    std::unique_ptr<TaskTy> T;
+  };
+
+  /// A max-heap of entries, ordered by \c runsLater.
+  std::vector<Entry> Heap;
+
+  unsigned NextSequence = 0;
+
+  static bool runsLater(const Entry &LHS, const Entry &RHS) {
+    if (LHS.Priority != RHS.Priority)
+      return LHS.Priority < RHS.Priority;
+    return LHS.Sequence > RHS.Sequence;
+  }
+
+public:
+  bool empty() const { return Heap.empty(); }
+
+  void push(std::unique_ptr<TaskTy> T, unsigned Priority) {
+    Heap.push_back({Priority, NextSequence++, std::move(T)});
+    std::push_heap(Heap.begin(), Heap.end(), runsLater);
+  }
+
+  std::unique_ptr<TaskTy> pop() {
+    assert(!empty() && "no tasks to pop");
+    std::pop_heap(Heap.begin(), Heap.end(), runsLater);
+    std::unique_ptr<TaskTy> T = std::move(Heap.back().T);
+    Heap.pop_back();
+    return T;
+  }
+};
+
 /// \brief A class encapsulating the execution of multiple tasks in parallel.
 class TaskQueue {
   /// Tasks which have not begun execution.
-  std::queue<std::unique_ptr<Task>> QueuedTasks;
+  TaskPriorityQueue<Task> QueuedTasks;
 
   /// The number of tasks to execute in parallel.
   unsigned NumberOfParallelTasks;
 
+  /// The jobserver shared with other processes, if any, from which a token
+  /// must be acquired for every task beyond the first running at a time.
+  std::unique_ptr<JobServer> SharedJobServer;
+
+  /// The socket of the frontend server to which frontend tasks are sent, or
+  /// empty if every task is run as a new process.
+  std::string FrontendServerPath;
+
 public:
   /// \brief Create a new TaskQueue instance.
   ///
@@ -72,12 +141,16 @@ public:
   /// \param ReturnCode the return code of the task which finished execution.
   /// \param Output the output from the task which finished execution,
   /// if available. (This may not be available on all platforms.)
+  /// \param Usage the resources used by the task which finished execution,
+  /// if available. (This may not be available on all platforms.)
   /// \param Context the context which was passed when the task was added
   ///
   /// \returns true if further execution of tasks should stop,
   /// false if execution should continue
   typedef std::function<TaskFinishedResponse(ProcessId Pid, int ReturnCode,
-                                             StringRef Output, void *Context)>
+                                             StringRef Output,
+                                             Optional<TaskResourceUsage> Usage,
+                                             void *Context)>
     TaskFinishedCallback;
 
   /// \brief A callback which will be executed if a task exited abnormally due
@@ -88,13 +161,28 @@ public:
   /// no reason could be deduced, this may be empty.
   /// \param Output the output from the task which exited abnormally, if
   /// available. (This may not be available on all platforms.)
+  /// \param Usage the resources used by the task which exited abnormally, if
+  /// available. (This may not be available on all platforms.)
   /// \param Context the context which was passed when the task was added
   ///
   /// \returns a TaskFinishedResponse indicating whether or not execution
   /// should proceed
   typedef std::function<TaskFinishedResponse(ProcessId Pid, StringRef ErrorMsg,
-                                             StringRef Output, void *Context)>
+                                             StringRef Output,
+                                             Optional<TaskResourceUsage> Usage,
+                                             void *Context)>
     TaskSignalledCallback;
+
+  /// \brief A callback which will be executed as output from a task arrives,
+  /// while the task is still executing.
+  ///
+  /// \param Pid the ProcessId of the task which produced the output.
+  /// \param Output the output which has arrived since the callback was last
+  /// called for this task. (The TaskFinishedCallback or TaskSignalledCallback
+  /// still receives all of the task's output.)
+  /// \param Context the context which was passed when the task was added
+  typedef std::function<void(ProcessId Pid, StringRef Output, void *Context)>
+    TaskOutputCallback;
 #pragma clang diagnostic pop
 
   /// \brief Indicates whether TaskQueue supports buffering output on the
@@ -105,6 +193,21 @@ public:
   /// if the task actually generated output.
   static bool supportsBufferingOutput();
 
+  /// \brief Indicates whether TaskQueue passes output to the
+  /// TaskOutputCallback as it arrives on the current system.
+  ///
+  /// \note If this returns false, the TaskOutputCallback passed to
+  /// \ref execute will never be called.
+  static bool supportsStreamingOutput();
+
+  /// \brief Indicates whether TaskQueue measures the resources used by each
+  /// task on the current system.
+  ///
+  /// \note If this returns false, the TaskFinishedCallback and
+  /// TaskSignalledCallback passed to \ref execute will always receive None for
+  /// the resource usage.
+  static bool supportsResourceUsage();
+
   /// \brief Indicates whether TaskQueue supports parallel execution on the
   /// current system.
   static bool supportsParallelExecution();
@@ -113,6 +216,26 @@ public:
   /// parallel
   unsigned getNumberOfParallelTasks() const;
 
+  /// \brief Shares the limit on parallel tasks with other processes through
+  /// \p JS.
+  ///
+  /// Tasks are then only started in parallel when a token can be acquired
+  /// from \p JS, in addition to being limited by the number of parallel tasks.
+  /// Each token is returned as soon as the task it was acquired for finishes.
+  void setJobServer(std::unique_ptr<JobServer> JS) {
+    SharedJobServer = std::move(JS);
+  }
+
+  /// \brief Runs frontend tasks (those whose first argument is "-frontend")
+  /// in the frontend server listening at \p SocketPath.
+  ///
+  /// Tasks are still run as new processes if the server can't be reached or
+  /// won't run them, and on systems where the frontend server isn't
+  /// supported.
+  void setFrontendServer(StringRef SocketPath) {
+    FrontendServerPath = SocketPath.str();
+  }
+
   /// \brief Adds a task to the TaskQueue.
   ///
   /// \param ExecPath the path to the executable which the task should execute
@@ -120,9 +243,12 @@ public:
   /// \param Env the environment which should be used for the task;
   /// must be null-terminated. If empty, inherits the parent's environment.
   /// \param Context an optional context which will be associated with the task
+  /// \param Priority tasks with higher priorities begin execution before
+  /// those with lower priorities which are queued at the same time; tasks
+  /// with equal priorities begin execution in the order they were added
   virtual void addTask(const char *ExecPath, ArrayRef<const char *> Args,
                        ArrayRef<const char *> Env = llvm::None,
-                       void *Context = nullptr);
+                       void *Context = nullptr, unsigned Priority = 0);
 
   /// \brief Synchronously executes the tasks in the TaskQueue.
   ///
@@ -130,12 +256,15 @@ public:
   /// \param Finished a callback which will be called when a task finishes
   /// \param Signalled a callback which will be called if a task exited
   /// abnormally due to a signal
+  /// \param OutputReceived a callback which will be called as output from a
+  /// task arrives
   ///
   /// \returns true if all tasks did not execute successfully
   virtual bool
   execute(TaskBeganCallback Began = TaskBeganCallback(),
           TaskFinishedCallback Finished = TaskFinishedCallback(),
-          TaskSignalledCallback Signalled = TaskSignalledCallback());
+          TaskSignalledCallback Signalled = TaskSignalledCallback(),
+          TaskOutputCallback OutputReceived = TaskOutputCallback());
 
   /// Returns true if there are any tasks that have been queued but have not
   /// yet been executed.
@@ -159,7 +288,7 @@ class DummyTaskQueue : public TaskQueue {
       : ExecPath(ExecPath), Args(Args), Env(Env), Context(Context) {}
   };
 
-  std::queue<std::unique_ptr<DummyTask>> QueuedTasks;
+  TaskPriorityQueue<DummyTask> QueuedTasks;
 
 public:
   /// \brief Create a new DummyTaskQueue instance.
@@ -168,12 +297,13 @@ public:
 
   virtual void addTask(const char *ExecPath, ArrayRef<const char *> Args,
                        ArrayRef<const char *> Env = llvm::None,
-                       void *Context = nullptr);
+                       void *Context = nullptr, unsigned Priority = 0);
 
   virtual bool
   execute(TaskBeganCallback Began = TaskBeganCallback(),
           TaskFinishedCallback Finished = TaskFinishedCallback(),
-          TaskSignalledCallback Signalled = TaskSignalledCallback());
+          TaskSignalledCallback Signalled = TaskSignalledCallback(),
+          TaskOutputCallback OutputReceived = TaskOutputCallback());
 };
 
 } // end namespace sys
@@ -15,11 +15,77 @@
 
 #include "swift/Basic/LLVM.h"
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/Timer.h"
 
+#include <chrono>
+#include <string>
+
 namespace swift {
+  /// Records nested, timestamped spans of the compiler's work, which can be
+  /// written out as a trace in the Chrome trace event format and loaded into
+  /// a trace viewer (such as chrome://tracing).
+  ///
+  /// \sa CompileTimeTraceScope
+  class CompileTimeTrace {
+    static bool Enabled;
+
+  public:
+    /// Starts recording spans. Must be called before any
+    /// CompileTimeTraceScopes have been created.
+    ///
+    /// Spans shorter than \p granularity microseconds are not recorded, to
+    /// keep the trace of a large module to a manageable size.
+    static void enable(unsigned granularity);
+
+    static bool isEnabled() { return Enabled; }
+
+    /// Writes the spans recorded so far to \p os, as a JSON object.
+    static void write(raw_ostream &os);
+  };
+
+  /// Records a span of the compile-time trace, if it is enabled, that starts
+  /// when this object is created and ends when it is destroyed.
+  ///
+  /// Spans on the same thread nest by time, so a scope created while another
+  /// one is alive shows up beneath it.
+  class CompileTimeTraceScope {
+    std::chrono::steady_clock::time_point Start;
+    std::string Name;
+    std::string Detail;
+    bool Active = false;
+
+    void begin(StringRef name, std::string &&detail);
+    void end();
+
+  public:
+    explicit CompileTimeTraceScope(StringRef name) {
+      if (CompileTimeTrace::isEnabled())
+        begin(name, std::string());
+    }
+
+    /// Records a span with a description of what was worked on, such as a
+    /// file or function name. \p getDetail is only called if the trace is
+    /// enabled.
+    CompileTimeTraceScope(StringRef name,
+                          llvm::function_ref<std::string()> getDetail) {
+      if (CompileTimeTrace::isEnabled())
+        begin(name, getDetail());
+    }
+
+    CompileTimeTraceScope(const CompileTimeTraceScope &) = delete;
+    CompileTimeTraceScope &operator=(const CompileTimeTraceScope &) = delete;
+
+    ~CompileTimeTraceScope() {
+      if (Active)
+        end();
+    }
+  };
+
   /// A convenience class for declaring a timer that's part of the Swift
   /// compilation timers group.
+  ///
+  /// Each timer is also a span of the compile-time trace.
   class SharedTimer {
     enum class State {
       Initial,
@@ -27,15 +93,47 @@ namespace swift {
       Enabled
     };
     static State CompilationTimersEnabled;
+    static bool TotalsEnabled;
 
     Optional<llvm::NamedRegionTimer> Timer;
+    CompileTimeTraceScope Trace;
 
-  public:
-    explicit SharedTimer(StringRef name) {
+    /// The name and start time of this timer, if totals are being collected.
+    StringRef TotalName;
+    std::chrono::steady_clock::time_point TotalStart;
+
+    void start(StringRef name) {
       if (CompilationTimersEnabled == State::Enabled)
         Timer.emplace(name, StringRef("Swift compilation"));
       else
         CompilationTimersEnabled = State::Skipped;
+
+      if (TotalsEnabled) {
+        TotalName = name;
+        TotalStart = std::chrono::steady_clock::now();
+      }
+    }
+
+    void addToTotal();
+
+  public:
+    explicit SharedTimer(StringRef name) : Trace(name) {
+      start(name);
+    }
+
+    /// Times \p name, and records its span of the compile-time trace with a
+    /// description of what was worked on.
+    SharedTimer(StringRef name, llvm::function_ref<std::string()> getDetail)
+        : Trace(name, getDetail) {
+      start(name);
+    }
+
+    SharedTimer(const SharedTimer &) = delete;
+    SharedTimer &operator=(const SharedTimer &) = delete;
+
+    ~SharedTimer() {
+      if (!TotalName.empty())
+        addToTotal();
     }
 
     /// Must be called before any SharedTimers have been created.
@@ -44,6 +142,19 @@ namespace swift {
              "a timer has already been created");
       CompilationTimersEnabled = State::Enabled;
     }
+
+    /// Starts adding up the time spent in the timers with each name, for
+    /// all threads together. Timers created before this are not counted.
+    ///
+    /// Timer names must be string literals if totals are collected.
+    static void enableTotals() {
+      TotalsEnabled = true;
+    }
+
+    /// Calls \p fn with the name of each timer and the total wall-clock time
+    /// spent in it so far, in seconds, in order of name.
+    static void
+    forEachTotal(llvm::function_ref<void(StringRef name, double seconds)> fn);
   };
 }
 
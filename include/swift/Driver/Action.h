@@ -14,6 +14,7 @@
 #define SWIFT_DRIVER_ACTION_H
 
 #include "swift/Basic/LLVM.h"
+#include "swift/Driver/FileStamp.h"
 #include "swift/Driver/Types.h"
 #include "swift/Driver/Util.h"
 #include "llvm/ADT/ArrayRef.h"
@@ -135,11 +136,26 @@ public:
       NewlyAdded
     };
     Status status = UpToDate;
-    llvm::sys::TimeValue previousModTime;
+
+    /// The state of the input when it was last built.
+    FileStamp previousStamp;
+
+    /// The state of the input now, as found by the driver's check of all of
+    /// its inputs before it builds any jobs.
+    FileStamp currentStamp;
+
+    /// Whether that check found the input to have changed since it was last
+    /// built, or couldn't tell.
+    bool hasChanged = true;
+
+    /// How long the input took to compile in the previous build, in
+    /// milliseconds, or 0 if that isn't known.
+    unsigned previousDuration = 0;
 
     InputInfo() = default;
-    InputInfo(Status stat, llvm::sys::TimeValue time)
-        : status(stat), previousModTime(time) {}
+    InputInfo(Status stat, llvm::sys::TimeValue time) : status(stat) {
+      previousStamp.ModTime = time;
+    }
 
     static InputInfo makeNewlyAdded() {
       return InputInfo(Status::NewlyAdded, llvm::sys::TimeValue::MaxTime());
@@ -0,0 +1,233 @@
+//===--- BinaryDependencies.h - Binary dependency file format ---*- C++ -*-===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// This file describes a compact binary encoding for the files used to drive
+// incremental builds: the per-file reference dependencies (".swiftdeps")
+// written by the frontend, and the build record written by the driver.
+//
+// Both kinds of file consist of a fixed-size header, a kind-specific info
+// block, a table of fixed-size records, and a table of interned strings. All
+// integers are little-endian. Records refer to strings by index, so a reader
+// can use a memory-mapped file in place without allocating anything per
+// entry.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SWIFT_DRIVER_BINARYDEPENDENCIES_H
+#define SWIFT_DRIVER_BINARYDEPENDENCIES_H
+
+#include "swift/Basic/LLVM.h"
+#include "swift/Driver/FileStamp.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/TimeValue.h"
+#include <vector>
+
+namespace swift {
+namespace binary_deps {
+
+/// The version of the binary format. Readers reject files with any other
+/// version.
+const uint16_t FormatVersion = 3;
+
+/// The sections of a reference dependencies file, in the order in which they
+/// are written.
+enum class Section : uint8_t {
+  ProvidesTopLevel,
+  ProvidesNominal,
+  ProvidesMember,
+  ProvidesDynamicLookup,
+  DependsTopLevel,
+  DependsMember,
+  DependsNominal,
+  DependsDynamicLookup,
+  DependsExternal,
+};
+const unsigned NumSections = unsigned(Section::DependsExternal) + 1;
+
+/// Returns the key used for \p S in the YAML form of a dependencies file.
+StringRef getSectionName(Section S);
+
+/// Returns true if the entries of \p S are (type, member) pairs.
+///
+/// Member entries are stored as the mangled name of the type and the name of
+/// the member joined by a NUL character, which is also how the driver's
+/// dependency graph keys them.
+bool isMemberSection(Section S);
+
+/// Returns true if entries of \p S may carry a fingerprint of the
+/// declarations that provide them.
+bool canHaveFingerprints(Section S);
+
+/// A single entry in a reference dependencies file.
+struct DependencyEntry {
+  Section Kind;
+  StringRef Name;
+  bool IsCascading;
+
+  /// A hash of the declarations that provide this entry, or an empty string
+  /// if there isn't one.
+  StringRef Fingerprint;
+};
+
+/// Returns true if \p data starts with the signature of a binary reference
+/// dependencies file.
+bool isBinaryDependencyFile(StringRef data);
+
+/// Returns true if \p data starts with the signature of a binary build
+/// record.
+bool isBinaryBuildRecord(StringRef data);
+
+/// Collects the contents of a reference dependencies file, and writes them out
+/// either in the binary format or as YAML.
+class DependencyFileWriter {
+  llvm::StringMap<unsigned> StringIndices;
+  std::vector<StringRef> Strings;
+
+  struct Entry {
+    Section Kind;
+    bool IsCascading;
+    unsigned Name;
+    unsigned Fingerprint;
+  };
+  std::vector<Entry> Entries;
+
+  unsigned SectionMask = 0;
+  unsigned InterfaceHash;
+
+  unsigned intern(StringRef str);
+
+public:
+  DependencyFileWriter();
+
+  /// Records that \p S should be written even if it has no entries.
+  void beginSection(Section S) { SectionMask |= 1U << unsigned(S); }
+
+  /// Adds an entry to \p S.
+  ///
+  /// Entries within a section are written in the order they were added.
+  /// A non-empty \p fingerprint is only allowed in sections for which
+  /// canHaveFingerprints returns true.
+  void addEntry(Section S, StringRef name, bool isCascading = true,
+                StringRef fingerprint = StringRef());
+
+  /// Adds a (type, member) entry to the member section \p S.
+  void addMemberEntry(Section S, StringRef mangledTypeName,
+                      StringRef memberName, bool isCascading = true,
+                      StringRef fingerprint = StringRef());
+
+  void setInterfaceHash(StringRef hash);
+
+  void writeBinary(raw_ostream &out) const;
+  void writeYAML(raw_ostream &out) const;
+};
+
+/// A read-only view of a binary reference dependencies file.
+///
+/// The view does not own its data; the buffer it was created from must
+/// outlive it.
+class DependencyFileView {
+  StringRef Data;
+  size_t StringsOffset;
+  size_t RecordsOffset;
+  size_t StringDataOffset;
+  unsigned NumRecords;
+  unsigned InterfaceHash;
+  unsigned SectionMask;
+
+  DependencyFileView() = default;
+
+public:
+  /// Returns a view of \p data, or None if \p data is not a well-formed binary
+  /// reference dependencies file.
+  static Optional<DependencyFileView> get(StringRef data);
+
+  bool hasSection(Section S) const {
+    return SectionMask & (1U << unsigned(S));
+  }
+
+  /// Returns the interface hash, or an empty string if there isn't one.
+  StringRef getInterfaceHash() const;
+
+  unsigned getNumEntries() const { return NumRecords; }
+  DependencyEntry getEntry(unsigned i) const;
+
+  /// Prints the contents of this file in the YAML dependencies format.
+  void printAsYAML(raw_ostream &out) const;
+};
+
+/// The state of an input in a build record.
+enum class InputStatus : uint8_t {
+  UpToDate,
+  NeedsCascadingBuild,
+  NeedsNonCascadingBuild,
+};
+
+/// A single input in a build record.
+struct BuildRecordInput {
+  StringRef Path;
+  InputStatus Status;
+
+  /// The state of the input when it was last built.
+  driver::FileStamp PreviousStamp;
+
+  /// How long the input took to compile in the previous build, in
+  /// milliseconds, or 0 if that isn't known.
+  unsigned PreviousDuration;
+};
+
+/// Writes a build record in the binary format.
+void writeBuildRecord(raw_ostream &out, StringRef version, StringRef options,
+                      llvm::sys::TimeValue buildTime,
+                      ArrayRef<BuildRecordInput> inputs);
+
+/// A read-only view of a binary build record.
+///
+/// The view does not own its data; the buffer it was created from must
+/// outlive it.
+class BuildRecordView {
+  StringRef Data;
+  size_t StringsOffset;
+  size_t RecordsOffset;
+  size_t StringDataOffset;
+  unsigned NumRecords;
+  unsigned Version;
+  unsigned Options;
+  llvm::sys::TimeValue BuildTime;
+
+  BuildRecordView() = default;
+
+public:
+  /// Returns a view of \p data, or None if \p data is not a well-formed binary
+  /// build record.
+  static Optional<BuildRecordView> get(StringRef data);
+
+  /// The version of the compiler that wrote the record.
+  StringRef getVersion() const;
+
+  /// The hash of the options that affect incremental builds.
+  StringRef getOptions() const;
+
+  llvm::sys::TimeValue getBuildTime() const { return BuildTime; }
+
+  unsigned getNumInputs() const { return NumRecords; }
+  BuildRecordInput getInput(unsigned i) const;
+
+  /// Prints the contents of this record in the YAML build record format.
+  void printAsYAML(raw_ostream &out) const;
+};
+
+} // end namespace binary_deps
+} // end namespace swift
+
+#endif
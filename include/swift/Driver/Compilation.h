@@ -37,9 +37,13 @@ namespace opt {
 
 namespace swift {
   class DiagnosticEngine;
+  class UnifiedStatsReporter;
 
 namespace driver {
+  class BatchJob;
+  class CompilationCache;
   class Driver;
+  class OutputInfo;
   class ToolChain;
 
 /// An enum providing different levels of output which should be produced
@@ -92,6 +96,10 @@ private:
   /// This is used for incremental builds.
   std::string CompilationRecordPath;
 
+  /// Whether the compilation record should be written in the binary format
+  /// rather than YAML.
+  bool BinaryCompilationRecord = false;
+
   /// A hash representing all the arguments that could trigger a full rebuild.
   std::string ArgsHash;
 
@@ -132,6 +140,51 @@ private:
   /// rebuilt.
   bool ShowIncrementalBuildDecisions = false;
 
+  /// When true, a file whose interface changed only causes files that depend
+  /// on its changed declarations to be rebuilt, as determined by the
+  /// fingerprints in its dependencies file.
+  bool UseFingerprints = true;
+
+  /// When true, jobs that are ready to run at the same time are started
+  /// longest critical path first, as estimated from how long each input took
+  /// to compile in the previous build.
+  bool UseJobPriorities = true;
+
+  /// When true, prints the time and memory used by each job once all jobs
+  /// have finished.
+  bool ShowJobResourceUsage = false;
+
+  /// When non-null, the cache consulted before running each compile job, and
+  /// updated after running it.
+  std::unique_ptr<CompilationCache> Cache;
+
+  /// When non-empty, the socket of the frontend server which should run
+  /// frontend jobs, rather than a new process for each.
+  std::string FrontendServerPath;
+
+  /// When non-null, the files the build system says may have changed since
+  /// the last build (-driver-changed-files). No other inputs or external
+  /// dependencies are checked for changes.
+  std::unique_ptr<ChangedFileList> ChangedFiles;
+
+  /// When true, an input that appears to have been modified during the build
+  /// is only diagnosed if its contents have changed.
+  bool CompareInputHashes = false;
+
+  /// When batch mode is enabled, the ToolChain used to combine ready compile
+  /// jobs into BatchJobs. Null if batch mode is disabled.
+  const ToolChain *BatchModeToolChain = nullptr;
+
+  /// The OutputInfo with which BatchJobs are constructed.
+  std::unique_ptr<const OutputInfo> BatchModeOutputInfo;
+
+  /// The number of batches into which ready compile jobs are partitioned.
+  unsigned BatchCount = 1;
+
+  /// When non-null, the counters to update with statistics about the jobs,
+  /// which are written out when the Compilation is destroyed.
+  std::unique_ptr<UnifiedStatsReporter> Stats;
+
   static const Job *unwrap(const std::unique_ptr<const Job> &p) {
     return p.get();
   }
@@ -189,11 +242,56 @@ public:
     ShowIncrementalBuildDecisions = value;
   }
 
+  void disableFingerprints() {
+    UseFingerprints = false;
+  }
+
+  void disableJobPriorities() {
+    UseJobPriorities = false;
+  }
+
+  void setShowsJobResourceUsage(bool value = true) {
+    ShowJobResourceUsage = value;
+  }
+
+  void setCompilationCache(std::unique_ptr<CompilationCache> cache) {
+    Cache = std::move(cache);
+  }
+
+  void setFrontendServer(StringRef socketPath) {
+    FrontendServerPath = socketPath;
+  }
+
+  void setChangedFileList(std::unique_ptr<ChangedFileList> changedFiles) {
+    ChangedFiles = std::move(changedFiles);
+  }
+
+  void setComparesInputHashes(bool value = true) {
+    CompareInputHashes = value;
+  }
+
+  void setStatsReporter(std::unique_ptr<UnifiedStatsReporter> stats) {
+    Stats = std::move(stats);
+  }
+
+  /// Combines compile jobs that are ready to run at the same time into at
+  /// most \p Count BatchJobs, each performed by a single frontend invocation.
+  void enableBatchMode(const ToolChain &TC, const OutputInfo &OI,
+                       unsigned Count);
+
+  bool getBatchModeEnabled() const {
+    return BatchModeToolChain != nullptr;
+  }
+
   void setCompilationRecordPath(StringRef path) {
     assert(CompilationRecordPath.empty() && "already set");
     CompilationRecordPath = path;
   }
 
+  void setBinaryCompilationRecord(bool value = true) {
+    BinaryCompilationRecord = value;
+  }
+
   void setLastBuildTime(llvm::sys::TimeValue time) {
     LastBuildTime = time;
   }
@@ -0,0 +1,132 @@
+//===--- CompilationCache.h - Local cache of compile job outputs -*- C++ -*-===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// The compilation cache lets the driver skip frontend jobs whose outputs were
+// already produced by an identical job, in this build directory or any other
+// that shares the same cache directory.
+//
+// Each entry is a single file in the cache directory, named after a hash of
+// the job's frontend command line (with its own output paths abstracted away)
+// and the contents of every source file in the module. Because the modules a
+// file imports aren't known until the frontend has run, entries also record
+// the external dependencies listed in the job's reference dependencies file,
+// along with a hash of each; an entry is only used if those are unchanged.
+// Consequently only compile jobs that emit a .swiftdeps file are cached.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SWIFT_DRIVER_COMPILATIONCACHE_H
+#define SWIFT_DRIVER_COMPILATIONCACHE_H
+
+#include "swift/Basic/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+
+#include <string>
+
+namespace swift {
+namespace driver {
+
+class Compilation;
+class Job;
+
+/// \brief A local, content-addressed store of the outputs of compile jobs.
+class CompilationCache {
+public:
+  /// Counts of what happened to the jobs looked up in the cache.
+  struct Statistics {
+    /// Jobs whose outputs were found in the cache.
+    unsigned Hits = 0;
+
+    /// Jobs which had to run because their outputs weren't found.
+    unsigned Misses = 0;
+
+    /// Jobs whose outputs were added to the cache after they ran.
+    unsigned Stores = 0;
+
+    /// Entries removed to keep the cache within its size limit.
+    unsigned Evictions = 0;
+  };
+
+private:
+  /// The directory holding the cache entries.
+  std::string Directory;
+
+  /// The total size, in bytes, to which the entries are trimmed after each
+  /// build.
+  uint64_t SizeLimit;
+
+  /// The hashes of the contents of each file read so far, or empty strings
+  /// for files that couldn't be read.
+  llvm::StringMap<std::string> ContentHashes;
+
+  /// The key of each job looked up so far, or an empty string if the job
+  /// can't be cached.
+  llvm::DenseMap<const Job *, std::string> Keys;
+
+  Statistics Stats;
+
+  /// Returns the hash of the contents of the file at \p path, or an empty
+  /// string if it can't be read.
+  StringRef getContentHash(StringRef path);
+
+  /// Returns the key of the entry for \p Cmd, or an empty string if \p Cmd
+  /// can't be cached.
+  StringRef getKey(const Compilation &C, const Job &Cmd);
+
+  std::string getEntryPath(StringRef key) const;
+
+public:
+  /// The default value of the size limit, in bytes.
+  static const uint64_t DefaultSizeLimit = 5ULL * 1024 * 1024 * 1024;
+
+  CompilationCache(StringRef Directory, uint64_t SizeLimit = DefaultSizeLimit)
+    : Directory(Directory), SizeLimit(SizeLimit) {}
+
+  /// Returns true if the outputs of \p Cmd may be stored in the cache.
+  ///
+  /// This is true of compile jobs that produce a single primary output and a
+  /// reference dependencies file.
+  static bool isCacheable(const Job &Cmd);
+
+  /// \brief Looks for the outputs of \p Cmd in the cache, and if they're
+  /// there, writes them to the paths where \p Cmd would have.
+  ///
+  /// \param[out] Output set to the output the job printed when it ran.
+  ///
+  /// \returns true if the outputs were found and written, in which case
+  /// \p Cmd doesn't need to run.
+  bool materialize(const Compilation &C, const Job &Cmd, std::string &Output);
+
+  /// \brief Adds the outputs of \p Cmd, which has just run successfully, to
+  /// the cache.
+  ///
+  /// \param Output what the job printed, to be replayed on later hits.
+  ///
+  /// Failures are ignored; the job's outputs just won't be found next time.
+  void store(const Compilation &C, const Job &Cmd, StringRef Output);
+
+  /// Removes the least recently used entries until the cache is no larger
+  /// than its size limit.
+  void trim();
+
+  const Statistics &getStatistics() const { return Stats; }
+
+  /// Prints a one-line summary of the statistics.
+  void printStatistics(raw_ostream &out) const;
+};
+
+} // end namespace driver
+} // end namespace swift
+
+#endif
@@ -90,6 +90,22 @@ private:
   struct ProvidesEntryTy {
     std::string name;
     DependencyMaskTy kindMask;
+
+    /// The fingerprints of the declarations providing this name, as of the
+    /// most recent load of the node.
+    std::string fingerprint;
+
+    /// The kinds under which this name was provided in the most recent load
+    /// of the node.
+    DependencyMaskTy loadedKinds;
+
+    /// The kinds under which this name was provided with a fingerprint in the
+    /// most recent load of the node.
+    DependencyMaskTy fingerprintedKinds;
+
+    /// True if the most recent load of the node provided this name with the
+    /// same fingerprints as the load before it.
+    bool isUnchanged;
   };
   static_assert(std::is_move_constructible<ProvidesEntryTy>::value, "");
 
@@ -169,7 +185,8 @@ protected:
   }
 
   void markTransitive(SmallVectorImpl<const void *> &visited,
-                      const void *node, MarkTracerImpl *tracer = nullptr);
+                      const void *node, MarkTracerImpl *tracer = nullptr,
+                      bool onlyChangedProvides = false);
   bool markIntransitive(const void *node) {
     assert(Provides.count(node) && "node is not in the graph");
     return Marked.insert(node).second;
@@ -243,6 +260,11 @@ public:
   /// ("depends") are not cleared; new dependencies are considered additive.
   ///
   /// If \p node has already been marked, only its outgoing edges are updated.
+  ///
+  /// The fingerprints of the newly loaded "provides" entries are compared
+  /// with those from the previous load of \p node.
+  ///
+  /// \sa markTransitiveFromChangedProvides
   LoadResult loadFromPath(T node, StringRef path) {
     return DependencyGraphImpl::loadFromPath(Traits::getAsVoidPointer(node),
                                              path);
@@ -290,6 +312,24 @@ public:
     copyBack(visited, rawMarked);
   }
 
+  /// Like #markTransitive, but only follows the entries in \p node's
+  /// "provides" set whose fingerprints changed when \p node was last loaded.
+  ///
+  /// Names provided without a fingerprint are always followed. This is only
+  /// valid when \p node was rebuilt because its own source changed; if
+  /// something it depends on changed, the meaning of its declarations may
+  /// have changed even though their fingerprints did not.
+  template <unsigned N>
+  void markTransitiveFromChangedProvides(SmallVector<T, N> &visited, T node,
+                                         MarkTracer *tracer = nullptr) {
+    SmallVector<const void *, N> rawMarked;
+    DependencyGraphImpl::markTransitive(rawMarked,
+                                        Traits::getAsVoidPointer(node),
+                                        tracer, /*onlyChangedProvides=*/true);
+    // FIXME: How can we avoid this copy?
+    copyBack(visited, rawMarked);
+  }
+
   template <unsigned N>
   void markExternal(SmallVector<T, N> &visited, StringRef externalDependency) {
     SmallVector<const void *, N> rawMarked;
@@ -0,0 +1,161 @@
+//===--- FileStamp.h - Recorded state of input files ------------*- C++ -*-===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// The build record remembers a stamp for each input: its modification time,
+// size and identity, and with -driver-compare-input-hashes a hash of its
+// contents. An input is unchanged if a fresh stat() gives the same
+// attributes. If the attributes differ but there is a hash, the contents are
+// hashed again to tell whether the file was really modified or just touched.
+//
+// All of the driver's inputs are checked in one parallel pass. A build system
+// that already knows which files it has changed can pass that list with
+// -driver-changed-files, in which case the other inputs aren't looked at at
+// all.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SWIFT_DRIVER_FILESTAMP_H
+#define SWIFT_DRIVER_FILESTAMP_H
+
+#include "swift/Basic/LLVM.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/TimeValue.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <system_error>
+
+namespace swift {
+namespace driver {
+
+/// What the driver knows about the state of an input file.
+struct FileStamp {
+  /// The modification time of the file, or MaxTime if the file hasn't been
+  /// looked at.
+  llvm::sys::TimeValue ModTime = llvm::sys::TimeValue::MaxTime();
+
+  uint64_t Size = 0;
+
+  /// The device and inode number of the file (or whatever identifies the
+  /// file on this platform), so that a file replaced by another one with the
+  /// same size and modification time still counts as changed.
+  uint64_t Device = 0;
+  uint64_t Inode = 0;
+
+  /// The MD5 hash of the file's contents, or all zeros if it isn't known.
+  uint8_t Hash[16] = {};
+
+  bool isKnown() const {
+    return ModTime != llvm::sys::TimeValue::MaxTime();
+  }
+
+  /// Returns false if only the modification time is known, as in build
+  /// records written before stamps were recorded.
+  bool hasIdentity() const {
+    return Device != 0 || Inode != 0;
+  }
+
+  bool hasHash() const;
+
+  /// Returns true if \p other has the same modification time, size and
+  /// identity as this stamp, i.e. if the file can be assumed unchanged
+  /// without reading it. If either stamp only has a modification time, only
+  /// that is compared.
+  bool hasSameAttributes(const FileStamp &other) const {
+    if (ModTime != other.ModTime)
+      return false;
+    if (!hasIdentity() || !other.hasIdentity())
+      return true;
+    return Size == other.Size && Device == other.Device &&
+           Inode == other.Inode;
+  }
+
+  /// Returns true if both stamps have a hash and the hashes are equal.
+  bool hasSameHash(const FileStamp &other) const;
+
+  /// Returns the hash as a string of 32 hex digits, or an empty string if it
+  /// isn't known.
+  std::string getHashString() const;
+
+  /// Sets the hash from a string written by \ref getHashString.
+  ///
+  /// \returns true on error, false on success
+  bool setHashString(StringRef str);
+};
+
+/// The files a build system says may have changed since the last build, as
+/// given by -driver-changed-files. Any other file is assumed to be unchanged.
+class ChangedFileList {
+  /// The absolute paths of the files on the list.
+  llvm::StringSet<> Paths;
+
+  /// The directory relative paths are resolved against.
+  std::string WorkingDirectory;
+
+  ChangedFileList() = default;
+
+public:
+  /// Reads the list at \p path, which names one file per line.
+  ///
+  /// \returns the list, or null if it couldn't be read, in which case
+  /// \p error describes why.
+  static std::unique_ptr<ChangedFileList> load(StringRef path,
+                                               std::error_code &error);
+
+  /// Returns true if \p path is on the list. Relative paths, on the list or
+  /// not, are resolved against the working directory.
+  bool contains(StringRef path) const;
+};
+
+/// The state of one file to be checked by \ref checkFileStamps.
+struct FileStampCheck {
+  enum Result {
+    /// The file's attributes match the previous stamp, or its contents have
+    /// the same hash.
+    Unchanged,
+    /// The file has been modified, or there was no previous stamp.
+    Changed,
+    /// The file could not be stat'ed; see \c Error.
+    Missing
+  };
+
+  StringRef Path;
+
+  /// The file's stamp from the previous build.
+  FileStamp Previous;
+
+  /// The file's stamp now. If the file's attributes are unchanged, the
+  /// previous hash is carried over.
+  FileStamp Current;
+
+  /// If set, the file is taken to be unchanged without looking at it, as long
+  /// as there is a previous stamp.
+  bool AssumeUnchanged = false;
+
+  Result Status = Changed;
+  std::error_code Error;
+};
+
+/// Fills in the current stamp and status of each of \p checks, stat'ing the
+/// files on several threads at once.
+///
+/// If \p useHashes is set, files whose attributes have changed (or which have
+/// no previous stamp) are hashed, and are unchanged if the hash is the same
+/// as before.
+void checkFileStamps(MutableArrayRef<FileStampCheck> checks, bool useHashes);
+
+} // end namespace driver
+} // end namespace swift
+
+#endif
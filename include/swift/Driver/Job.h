@@ -15,6 +15,7 @@
 
 #include "swift/Basic/LLVM.h"
 #include "swift/Driver/Action.h"
+#include "swift/Driver/FileStamp.h"
 #include "swift/Driver/Types.h"
 #include "swift/Driver/Util.h"
 #include "llvm/Option/Option.h"
@@ -23,7 +24,6 @@
 #include "llvm/ADT/PointerIntPair.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
-#include "llvm/Support/TimeValue.h"
 #include "llvm/Support/raw_ostream.h"
 
 #include <memory>
@@ -117,8 +117,8 @@ private:
   /// Whether the job wants a list of input or output files created.
   FilelistInfo FilelistFileInfo;
 
-  /// The modification time of the main input file, if any.
-  llvm::sys::TimeValue InputModTime = llvm::sys::TimeValue::MaxTime();
+  /// The state of the main input file, if any, when the job was built.
+  FileStamp InputStamp;
 
 public:
   Job(const JobAction &Source,
@@ -152,12 +152,12 @@ public:
     SourceAndCondition.setInt(Cond);
   }
 
-  void setInputModTime(llvm::sys::TimeValue time) {
-    InputModTime = time;
+  void setInputStamp(const FileStamp &stamp) {
+    InputStamp = stamp;
   }
 
-  llvm::sys::TimeValue getInputModTime() const {
-    return InputModTime;
+  const FileStamp &getInputStamp() const {
+    return InputStamp;
   }
 
   ArrayRef<std::pair<const char *, const char *>> getExtraEnvironment() const {
@@ -181,6 +181,33 @@ public:
                              const llvm::opt::ArgStringList &Args);
 };
 
+/// A Job that performs several compile Jobs in a single frontend invocation.
+///
+/// BatchJobs are formed by the Compilation at execution time, when batch mode
+/// is enabled, and are not part of its list of Jobs. When a BatchJob finishes,
+/// each of its combined Jobs is considered to have finished.
+class BatchJob : public Job {
+  SmallVector<const Job *, 4> CombinedJobs;
+
+  /// The temporary output file map naming the supplementary outputs of each
+  /// combined Job, which must be written before the BatchJob runs.
+  const char *OutputFileMapPath;
+
+public:
+  BatchJob(const JobAction &Source,
+           std::unique_ptr<CommandOutput> Output,
+           const char *Executable,
+           llvm::opt::ArgStringList Arguments,
+           EnvironmentVector ExtraEnvironment,
+           FilelistInfo Info,
+           ArrayRef<const Job *> Combined,
+           const char *OutputFileMapPath);
+
+  ArrayRef<const Job *> getCombinedJobs() const { return CombinedJobs; }
+
+  StringRef getOutputFileMapPath() const { return OutputFileMapPath; }
+};
+
 } // end namespace driver
 } // end namespace swift
 
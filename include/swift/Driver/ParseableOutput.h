@@ -29,17 +29,24 @@ class Job;
 namespace parseable_output {
 
 using swift::sys::ProcessId;
+using swift::sys::TaskResourceUsage;
 
 /// \brief Emits a "began" message to the given stream.
 void emitBeganMessage(raw_ostream &os, const Job &Cmd, ProcessId Pid);
 
 /// \brief Emits a "finished" message to the given stream.
+///
+/// \p Usage is included under the "usage" key, if present.
 void emitFinishedMessage(raw_ostream &os, const Job &Cmd, ProcessId Pid,
-                         int ExitStatus, StringRef Output);
+                         int ExitStatus, StringRef Output,
+                         Optional<TaskResourceUsage> Usage = None);
 
 /// \brief Emits a "signalled" message to the given stream.
+///
+/// \p Usage is included under the "usage" key, if present.
 void emitSignalledMessage(raw_ostream &os, const Job &Cmd, ProcessId Pid,
-                          StringRef ErrorMsg, StringRef Output);
+                          StringRef ErrorMsg, StringRef Output,
+                          Optional<TaskResourceUsage> Usage = None);
 
 /// \brief Emits a "skipped" message to the given stream.
 void emitSkippedMessage(raw_ostream &os, const Job &Cmd);
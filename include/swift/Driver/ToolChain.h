@@ -23,6 +23,7 @@
 
 namespace swift {
 namespace driver {
+  class BatchJob;
   class CommandOutput;
   class Compilation;
   class Driver;
@@ -160,6 +161,16 @@ public:
                                     std::unique_ptr<CommandOutput> output,
                                     const OutputInfo &OI) const;
 
+  /// Construct a BatchJob that performs each of the compile \p jobs in a
+  /// single frontend invocation, with their outputs unchanged.
+  ///
+  /// The supplementary outputs of each primary file are passed to the
+  /// frontend in a temporary output file map, which the Compilation writes
+  /// before running the BatchJob.
+  std::unique_ptr<BatchJob> constructBatchJob(ArrayRef<const Job *> jobs,
+                                              Compilation &C,
+                                              const OutputInfo &OI) const;
+
   /// Return the default language type to use for the given extension.
   virtual types::ID lookupTypeForExtension(StringRef Ext) const;
 };
@@ -26,6 +26,7 @@
 #include "swift/AST/IRGenOptions.h"
 #include "swift/AST/LinkLibrary.h"
 #include "swift/AST/Module.h"
+#include "swift/AST/ReferencedNameTracker.h"
 #include "swift/AST/SearchPathOptions.h"
 #include "swift/AST/SILOptions.h"
 #include "swift/Parse/CodeCompletionCallbacks.h"
@@ -41,6 +42,7 @@
 #include "llvm/Support/Host.h"
 #include "llvm/Support/MemoryBuffer.h"
 
+#include <deque>
 #include <memory>
 
 namespace swift {
@@ -64,6 +66,10 @@ class CompilerInvocation {
 
   CodeCompletionCallbacksFactory *CodeCompletionFactory = nullptr;
 
+  /// Whether the input and code completion buffers outlive any
+  /// CompilerInstance set up with this invocation.
+  bool BuffersOutliveInstance = false;
+
 public:
   CompilerInvocation();
 
@@ -246,6 +252,17 @@ public:
     return FrontendOpts.InputBuffers;
   }
 
+  /// Promises that the input buffers and the code completion buffer, which
+  /// must be null-terminated, outlive the CompilerInstance, so that it can use
+  /// them in place instead of copying them.
+  void setBuffersOutliveInstance(bool Value = true) {
+    BuffersOutliveInstance = Value;
+  }
+
+  bool getBuffersOutliveInstance() const {
+    return BuffersOutliveInstance;
+  }
+
   StringRef getOutputFilename() const {
     return FrontendOpts.getSingleOutputFilename();
   }
@@ -311,10 +328,24 @@ class CompilerInstance {
   unsigned MainBufferID = NO_SUCH_BUFFER;
   unsigned PrimaryBufferID = NO_SUCH_BUFFER;
 
+  /// In batch mode, the buffer IDs of all primary inputs, in the order they
+  /// were given. PrimaryBufferID is the first of them.
+  std::vector<unsigned> BatchPrimaryBufferIDs;
+
   SourceFile *PrimarySourceFile = nullptr;
 
+  /// In batch mode, the primary SourceFiles, parallel to
+  /// BatchPrimaryBufferIDs.
+  std::vector<SourceFile *> BatchPrimarySourceFiles;
+
+  /// In batch mode, the name trackers for all primary files but the first,
+  /// which uses NameTracker.
+  std::deque<ReferencedNameTracker> BatchNameTrackers;
+
   void createSILModule(bool WholeModule = false);
+  void setInvocation(const CompilerInvocation &Invok);
   void setPrimarySourceFile(SourceFile *SF);
+  bool isPrimaryBuffer(unsigned BufferID) const;
 
 public:
   SourceManager &getSourceMgr() { return SourceMgr; }
@@ -386,6 +417,26 @@ public:
   /// \returns the primary SourceFile, or nullptr if there is no primary input
   SourceFile *getPrimarySourceFile() { return PrimarySourceFile; }
 
+  /// Gets every primary SourceFile of a batch mode CompilerInstance, in the
+  /// order they were given.
+  /// \returns the primary SourceFiles, or an empty array if there are fewer
+  /// than two primary inputs
+  ArrayRef<SourceFile *> getBatchPrimarySourceFiles() {
+    return BatchPrimarySourceFiles;
+  }
+
+  /// \brief Creates the ASTContext and module loaders for \p Invocation,
+  /// without loading any inputs.
+  ///
+  /// This lets a long-lived process prepare an instance (for example, by
+  /// loading the standard library into it) before the inputs it will compile
+  /// are known. The following call to setup() must then be passed an
+  /// invocation that differs from \p Invocation only in its inputs and
+  /// outputs.
+  ///
+  /// \returns true if there was an error.
+  bool setupASTContext(const CompilerInvocation &Invocation);
+
   /// \brief Returns true if there was an error during setup.
   bool setup(const CompilerInvocation &Invocation);
 
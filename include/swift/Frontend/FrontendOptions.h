@@ -74,6 +74,19 @@ public:
   /// be generated for the whole module.
   Optional<SelectedInput> PrimaryInput;
 
+  /// Every primary input, in command-line order, when more than one was
+  /// given. PrimaryInput is the first of them.
+  ///
+  /// In this batch mode, all primary files are type-checked by a single
+  /// CompilerInstance and then compiled one at a time. The primary output of
+  /// each is the corresponding entry in OutputFilenames, and its
+  /// supplementary outputs are named by BatchOutputFileMapPath.
+  std::vector<SelectedInput> BatchPrimaryInputs;
+
+  /// The path to an output file map naming the supplementary outputs of each
+  /// primary input in batch mode.
+  std::string BatchOutputFileMapPath;
+
   /// The kind of input on which the frontend should operate.
   InputFileKind InputKind = InputFileKind::IFK_Swift;
 
@@ -112,6 +125,10 @@ public:
   /// The path to which we should output a Swift reference dependencies file.
   std::string ReferenceDependenciesFilePath;
 
+  /// Whether the reference dependencies file should use the binary format
+  /// rather than YAML.
+  bool BinaryReferenceDependencies = false;
+
   /// The path to which we should output a fixits as source edits.
   std::string FixitsOutputPath;
 
@@ -169,16 +186,53 @@ public:
   /// If set, dumps wall time taken to check each function body to llvm::errs().
   bool DebugTimeFunctionBodies = false;
 
+  /// If non-zero, warn when a function body takes longer than this many
+  /// milliseconds to type-check.
+  unsigned WarnLongFunctionBodies = 0;
+
+  /// If non-zero, warn when an expression takes longer than this many
+  /// milliseconds to type-check.
+  unsigned WarnLongExpressionTypeChecking = 0;
+
+  /// If set, the limits above are treated as exceeded by every function
+  /// body and expression, so that the warnings can be tested.
+  bool DebugAlwaysWarnLongTypeChecking = false;
+
   /// If set, prints the time taken in each major compilation phase to 
   /// llvm::errs().
   ///
   /// \sa swift::SharedTimer
   bool DebugTimeCompilation = false;
 
+  /// If non-empty, a trace of the time taken by each part of the compilation
+  /// is written to this path.
+  ///
+  /// \sa swift::CompileTimeTrace
+  std::string CompileTimeTracePath;
+
+  /// Spans of the compile-time trace shorter than this many microseconds are
+  /// not recorded.
+  unsigned CompileTimeTraceGranularity = 500;
+
+  /// If non-empty, a file of statistics about this job is written to this
+  /// directory.
+  ///
+  /// \sa swift::UnifiedStatsReporter
+  std::string StatsOutputDir;
+
   /// Indicates whether function body parsing should be delayed
   /// until the end of all files.
   bool DelayedFunctionBodyParsing = false;
 
+  /// Indicates whether function bodies in files other than the primary files
+  /// should be skipped when parsing, since they will not be type-checked or
+  /// emitted. Bodies of transparent functions are still parsed.
+  bool SkipSecondaryFunctionBodies = false;
+
+  /// The number of threads the source files other than the main file may be
+  /// parsed on. Files are parsed one after another if this is 0 or 1.
+  unsigned NumParsingThreads = 0;
+
   /// Indicates whether or not an import statement can pick up a Swift source
   /// file (as opposed to a module file).
   bool EnableSourceImport = false;
@@ -250,6 +304,9 @@ public:
   /// Indicates whether the RequestedAction will immediately run code.
   bool actionIsImmediate() const;
 
+  /// Indicates whether more than one primary input was given.
+  bool isBatchMode() const { return BatchPrimaryInputs.size() > 1; }
+
   void forAllOutputPaths(std::function<void(const std::string &)> fn) const;
   
   /// Gets the name of the specified output filename.
@@ -13,6 +13,7 @@
 #ifndef SWIFT_PARSE_DELAYED_PARSING_CALLBACKS_H
 #define SWIFT_PARSE_DELAYED_PARSING_CALLBACKS_H
 
+#include "swift/AST/Attr.h"
 #include "swift/Basic/SourceLoc.h"
 #include "swift/Basic/SourceManager.h"
 #include "swift/Parse/Parser.h"
@@ -28,6 +29,12 @@ class DelayedParsingCallbacks {
 public:
   virtual ~DelayedParsingCallbacks() = default;
 
+  /// Checks if a function body should be parsed right away, as it would be
+  /// without delayed parsing, instead of being delayed or skipped.
+  virtual bool shouldParseFunctionBodyNow(const DeclAttributes &Attrs) {
+    return false;
+  }
+
   /// Checks if a function body should be delayed or skipped altogether.
   virtual bool shouldDelayFunctionBodyParsing(Parser &TheParser,
                                               AbstractFunctionDecl *AFD,
@@ -44,6 +51,38 @@ class AlwaysDelayedCallbacks : public DelayedParsingCallbacks {
   }
 };
 
+/// \brief Implementation of callbacks that delay the bodies of transparent
+/// functions, so that they can be parsed later if they are needed for
+/// inlining, and skip all other bodies.
+class SkipNonTransparentFunctions : public DelayedParsingCallbacks {
+  bool shouldDelayFunctionBodyParsing(Parser &TheParser,
+                                      AbstractFunctionDecl *AFD,
+                                      const DeclAttributes &Attrs,
+                                      SourceRange BodyRange) override {
+    return Attrs.hasAttribute<TransparentAttr>();
+  }
+};
+
+/// \brief Implementation of callbacks for the files of a module other than
+/// the primary files, whose declarations are used but whose function bodies
+/// are not type-checked or emitted.
+///
+/// The bodies of transparent functions are parsed as usual, since they are
+/// part of what a file provides to the rest of the module; all other bodies
+/// are skipped.
+class SkipSecondaryFunctionBodies : public DelayedParsingCallbacks {
+  bool shouldParseFunctionBodyNow(const DeclAttributes &Attrs) override {
+    return Attrs.hasAttribute<TransparentAttr>();
+  }
+
+  bool shouldDelayFunctionBodyParsing(Parser &TheParser,
+                                      AbstractFunctionDecl *AFD,
+                                      const DeclAttributes &Attrs,
+                                      SourceRange BodyRange) override {
+    return false;
+  }
+};
+
 /// \brief Implementation of callbacks that guide the parser in delayed
 /// parsing for code completion.
 class CodeCompleteDelayedCallbacks : public DelayedParsingCallbacks {
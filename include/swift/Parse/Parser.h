@@ -135,6 +135,10 @@ public:
 
   bool isDelayedParsingEnabled() const { return DelayedParseCB != nullptr; }
 
+  /// Returns true if the body of a function with the attributes \p Attrs
+  /// should be delayed or skipped rather than parsed now.
+  bool shouldConsumeFunctionBody(const DeclAttributes &Attrs) const;
+
   void setDelayedParsingCallbacks(DelayedParsingCallbacks *DelayedParseCB) {
     this->DelayedParseCB = DelayedParseCB;
   }
@@ -300,11 +304,15 @@ public:
   llvm::SmallVector<StructureMarker, 16> StructureMarkers;
 
 public:
+  /// \param Diags if non-null, the engine to report diagnostics to instead
+  /// of the ASTContext's.
   Parser(unsigned BufferID, SourceFile &SF, SILParserState *SIL,
-         PersistentParserState *PersistentState = nullptr);
+         PersistentParserState *PersistentState = nullptr,
+         DiagnosticEngine *Diags = nullptr);
   Parser(std::unique_ptr<Lexer> Lex, SourceFile &SF,
          SILParserState *SIL = nullptr,
-         PersistentParserState *PersistentState = nullptr);
+         PersistentParserState *PersistentState = nullptr,
+         DiagnosticEngine *Diags = nullptr);
   ~Parser();
 
   bool isInSILMode() const { return SIL != nullptr; }
@@ -61,6 +61,25 @@ struct FieldRecordIterator {
   }
 };
 
+// Field descriptors contain a collection of field records for a single
+// class, struct or enum declaration, or describe a protocol declaration,
+// which has no fields.
+enum class FieldDescriptorKind : uint16_t {
+  Struct,
+  Class,
+  Enum,
+
+  // A Swift protocol whose existentials use the opaque representation.
+  Protocol,
+
+  // A class-bound Swift protocol.
+  ClassProtocol,
+
+  // An Objective-C protocol defined in Swift. Its existentials are
+  // class-bound and have no witness table for it.
+  ObjCProtocol,
+};
+
 struct FieldDescriptor {
   const FieldRecord *getFieldRecordBuffer() const {
     return reinterpret_cast<const FieldRecord *>(this + 1);
@@ -69,8 +88,15 @@ struct FieldDescriptor {
   const RelativeDirectPointer<const char> MangledTypeName;
 
 public:
+  const FieldDescriptorKind Kind;
+  const uint16_t FieldRecordSize;
   const uint32_t NumFields;
-  const uint32_t FieldRecordSize;
+
+  bool isProtocol() const {
+    return Kind == FieldDescriptorKind::Protocol ||
+           Kind == FieldDescriptorKind::ClassProtocol ||
+           Kind == FieldDescriptorKind::ObjCProtocol;
+  }
 
   using const_iterator = FieldRecordIterator;
 
@@ -19,8 +19,11 @@
 #define SWIFT_REFLECTION_REFLECTIONCONTEXT_H
 
 #include "swift/Reflection/Reader.h"
-#include "swift/Reflection/TypeRef.h"
+#include "swift/Reflection/TypeRefBuilder.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
 
+#include <algorithm>
 #include <iostream>
 
 class NodePointer;
@@ -28,23 +31,210 @@ class NodePointer;
 namespace swift {
 namespace reflection {
 
+using llvm::dyn_cast;
+using llvm::dyn_cast_or_null;
+
+/// The name and type of a stored property or enum case.
+struct FieldTypeInfo {
+  std::string Name;
+  const TypeRef *TR;
+};
+
 class ReflectionContext {
   MemoryReader &Reader;
+  TypeRefBuilder Builder;
+
+  /// Field descriptors, keyed by the mangled name of the nominal type
+  /// declaration they describe.
+  llvm::StringMap<const FieldDescriptor *> FieldDescriptorIndex;
+
+  /// Field descriptors of protocol declarations, keyed by their uniqued
+  /// protocol type.
+  llvm::DenseMap<const ProtocolTypeRef *, const FieldDescriptor *>
+    ProtocolDescriptorIndex;
+
+  /// Associated type descriptors, keyed by the mangled name of the nominal
+  /// type declaration of the conforming type, as in FieldDescriptorIndex.
+  llvm::StringMap<std::vector<const AssociatedTypeDescriptor *>>
+    AssociatedTypeIndex;
+
+  /// The number of entries of Reader.getInfo() that have been added to the
+  /// indexes. Sections added to the reader later are indexed on the next
+  /// lookup.
+  unsigned NumIndexedInfos = 0;
+
+  void updateIndexes() {
+    const auto &Infos = Reader.getInfo();
+    for (; NumIndexedInfos < Infos.size(); ++NumIndexedInfos) {
+      const auto &sections = Infos[NumIndexedInfos];
+
+      for (const auto &descriptor : sections.Fields) {
+        if (descriptor.isProtocol()) {
+          auto TR = Builder.decodeMangledType(descriptor.getMangledTypeName());
+          if (auto P = dyn_cast_or_null<ProtocolTypeRef>(TR))
+            ProtocolDescriptorIndex.insert({P, &descriptor});
+          continue;
+        }
+
+        auto Name = getIndexKey(descriptor.getMangledTypeName());
+        if (Name.empty())
+          continue;
+        // The first section to describe a type wins, as with a linear scan.
+        FieldDescriptorIndex.insert({Name, &descriptor});
+      }
+
+      for (const auto &descriptor : sections.AssociatedTypes) {
+        auto Name = getIndexKey(descriptor.getMangledConformingTypeName());
+        if (Name.empty())
+          continue;
+        AssociatedTypeIndex[Name].push_back(&descriptor);
+      }
+    }
+  }
+
+  /// Returns the key under which the indexes store descriptors for the type
+  /// with the given mangled name, which is the remangled name of its nominal
+  /// type declaration, so that every spelling of a type's name finds the
+  /// same entries.
+  StringRef getIndexKey(StringRef MangledName) {
+    return getNominalMangledName(Builder.decodeMangledType(MangledName));
+  }
 
   void dumpTypeRef(const std::string &MangledName,
-                   std::ostream &OS, bool printTypeName = false) const {
+                   std::ostream &OS, bool printTypeName = false) {
     auto TypeName = Demangle::demangleTypeAsString(MangledName);
-    auto DemangleTree = Demangle::demangleTypeAsNode(MangledName);
-    auto TR = decodeDemangleNode(DemangleTree);
+    auto TR = Builder.decodeMangledType(MangledName);
     OS << TypeName << '\n';
-    TR->dump(OS);
+    if (TR == nullptr)
+      OS << "<<null>>\n";
+    else
+      TR->dump(OS);
     std::cout << std::endl;
   }
 
 public:
   ReflectionContext(MemoryReader &Reader) : Reader(Reader) {}
 
-  void dumpFieldSection(std::ostream &OS) const {
+  TypeRefBuilder &getBuilder() {
+    return Builder;
+  }
+
+  /// Returns the mangled name of the nominal type declaration underlying
+  /// \p TR, or an empty string if \p TR is not a nominal type.
+  static StringRef getNominalMangledName(const TypeRef *TR) {
+    if (TR == nullptr)
+      return StringRef();
+    if (auto N = dyn_cast<NominalTypeRef>(TR))
+      return N->getMangledName();
+    if (auto BG = dyn_cast<BoundGenericTypeRef>(TR))
+      return BG->getMangledName();
+    return StringRef();
+  }
+
+  /// Find the field descriptor for the nominal type declaration with the
+  /// given mangled name, or return nullptr if none of the added reflection
+  /// sections describe it.
+  const FieldDescriptor *lookupFieldDescriptor(StringRef NominalMangledName) {
+    updateIndexes();
+    auto Found = FieldDescriptorIndex.find(NominalMangledName);
+    if (Found == FieldDescriptorIndex.end())
+      return nullptr;
+    return Found->getValue();
+  }
+
+  /// Find the field descriptor for the nominal type \p TR, or return
+  /// nullptr if none of the added reflection sections describe it.
+  const FieldDescriptor *getFieldDescriptor(const TypeRef *TR) {
+    auto Name = getNominalMangledName(TR);
+    if (Name.empty())
+      return nullptr;
+    return lookupFieldDescriptor(Name);
+  }
+
+  /// Find the field descriptor for the protocol \p P, or return nullptr if
+  /// none of the added reflection sections describe it.
+  const FieldDescriptor *getProtocolDescriptor(const ProtocolTypeRef *P) {
+    updateIndexes();
+    auto Found = ProtocolDescriptorIndex.find(P);
+    if (Found == ProtocolDescriptorIndex.end())
+      return nullptr;
+    return Found->second;
+  }
+
+  /// Find the associated type descriptors of every conformance of the type
+  /// with the given mangled name.
+  ///
+  /// The result is a copy, since indexing sections added to the reader
+  /// later may reallocate the index's storage.
+  std::vector<const AssociatedTypeDescriptor *>
+  lookupAssociatedTypes(StringRef MangledConformingTypeName) {
+    updateIndexes();
+    auto Name = getIndexKey(MangledConformingTypeName);
+    if (Name.empty())
+      return {};
+    auto Found = AssociatedTypeIndex.find(Name);
+    if (Found == AssociatedTypeIndex.end())
+      return {};
+    return Found->getValue();
+  }
+
+  /// Collect the names and types of the stored properties or enum cases of
+  /// the nominal type \p TR, substituting its generic arguments into the
+  /// field types.
+  ///
+  /// Returns false if no field descriptor for \p TR was found.
+  bool getFieldTypeRefs(const TypeRef *TR,
+                        std::vector<FieldTypeInfo> &Fields) {
+    auto Descriptor = getFieldDescriptor(TR);
+    if (Descriptor == nullptr)
+      return false;
+
+    // Map the generic parameters of the declaration to the arguments of
+    // the bound generic type.
+    GenericArgumentMap Subs;
+    if (auto BG = dyn_cast<BoundGenericTypeRef>(TR)) {
+      auto DescriptorTR =
+        Builder.decodeMangledType(Descriptor->getMangledTypeName());
+      if (auto Unbound = dyn_cast_or_null<BoundGenericTypeRef>(DescriptorTR)) {
+        auto Params = Unbound->getGenericParams();
+        auto Args = BG->getGenericParams();
+        for (unsigned i = 0, e = std::min(Params.size(), Args.size());
+             i != e; ++i) {
+          if (auto GTP = dyn_cast_or_null<GenericTypeParameterTypeRef>(
+                Params[i]))
+            Subs[{GTP->getDepth(), GTP->getIndex()}] = Args[i];
+        }
+      }
+    }
+
+    for (auto &field : *Descriptor) {
+      auto FieldTR = Builder.decodeMangledType(field.getMangledTypeName());
+      if (FieldTR != nullptr && !Subs.empty())
+        FieldTR = FieldTR->subst(Builder, Subs);
+      Fields.push_back({field.getFieldName(), FieldTR});
+    }
+    return true;
+  }
+
+  /// Decode the mangled type name of every field descriptor and field
+  /// record in all reflection sections, returning the number of names
+  /// decoded.
+  unsigned decodeAllFieldTypes() {
+    unsigned NumDecoded = 0;
+    for (const auto &sections : Reader.getInfo()) {
+      for (const auto &descriptor : sections.Fields) {
+        Builder.decodeMangledType(descriptor.getMangledTypeName());
+        ++NumDecoded;
+        for (auto &field : descriptor) {
+          Builder.decodeMangledType(field.getMangledTypeName());
+          ++NumDecoded;
+        }
+      }
+    }
+    return NumDecoded;
+  }
+
+  void dumpFieldSection(std::ostream &OS) {
     for (const auto &sections : Reader.getInfo()) {
       for (const auto &descriptor : sections.Fields) {
         dumpTypeRef(descriptor.getMangledTypeName(), OS);
@@ -56,7 +246,7 @@ public:
     }
   }
 
-  void dumpAssociatedTypeSection(std::ostream &OS) const {
+  void dumpAssociatedTypeSection(std::ostream &OS) {
     for (const auto &sections : Reader.getInfo()) {
       for (const auto &descriptor : sections.AssociatedTypes) {
         auto conformingTypeName = Demangle::demangleTypeAsString(
@@ -75,7 +265,7 @@ public:
     }
   }
 
-  void dumpAllSections(std::ostream &OS) const {
+  void dumpAllSections(std::ostream &OS) {
     OS << "FIELDS:\n";
     for (size_t i = 0; i < 7; ++i) OS << '=';
     OS << std::endl;
@@ -0,0 +1,882 @@
+//===--- TypeLowering.h - Swift Type Lowering for Reflection ----*- C++ -*-===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// Implements logic for computing in-memory layouts from TypeRefs loaded from
+// reflection metadata.
+//
+// This must be kept in sync with the fixed-size layout rules of IRGen.
+// Layouts that IRGen computes from information not present in reflection
+// metadata -- spare bits of multi-payload enums, superclass fields and
+// indirect enum cases -- are not modeled yet; such types are either laid out
+// conservatively or not at all. Existentials of protocols whose field
+// descriptors are not available cannot be laid out.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SWIFT_REFLECTION_TYPELOWERING_H
+#define SWIFT_REFLECTION_TYPELOWERING_H
+
+#include "swift/Reflection/ReflectionContext.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/Support/ErrorHandling.h"
+
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace swift {
+namespace reflection {
+
+enum class TypeInfoKind : unsigned {
+  Builtin,
+  Record,
+  Reference,
+};
+
+enum class RecordKind : unsigned {
+  // A tuple.
+  Tuple,
+
+  // A struct.
+  Struct,
+
+  // An enum with no payload cases.
+  NoPayloadEnum,
+
+  // An enum with a single payload case.
+  SinglePayloadEnum,
+
+  // An enum with multiple payload cases.
+  MultiPayloadEnum,
+
+  // A thick function value: a function pointer and a context.
+  ThickFunction,
+
+  // An opaque existential container.
+  Existential,
+
+  // A class-bound existential: a reference and witness tables.
+  ClassExistential,
+
+  // An ErrorType existential: a single reference to a boxed value.
+  ErrorExistential,
+
+  // An existential metatype: a metadata pointer and witness tables.
+  ExistentialMetatype,
+
+  // The instance of a class: the heap object header followed by the
+  // stored properties.
+  ClassInstance,
+};
+
+/// The layout of a value of some type.
+class TypeInfo {
+  TypeInfoKind Kind;
+  unsigned Size, Alignment, Stride, NumExtraInhabitants;
+
+public:
+  TypeInfo(TypeInfoKind Kind, unsigned Size, unsigned Alignment,
+           unsigned Stride, unsigned NumExtraInhabitants)
+    : Kind(Kind), Size(Size), Alignment(Alignment), Stride(Stride),
+      NumExtraInhabitants(NumExtraInhabitants) {
+    assert(Alignment > 0);
+  }
+
+  virtual ~TypeInfo() {}
+
+  TypeInfoKind getKind() const { return Kind; }
+
+  unsigned getSize() const { return Size; }
+  unsigned getAlignment() const { return Alignment; }
+  unsigned getStride() const { return Stride; }
+  unsigned getNumExtraInhabitants() const { return NumExtraInhabitants; }
+
+  void dump() const;
+  void dump(std::ostream &OS, unsigned Indent = 0) const;
+};
+
+/// Builtin scalar types, such as integers, floats and raw pointers.
+class BuiltinTypeInfo : public TypeInfo {
+  std::string Name;
+
+public:
+  BuiltinTypeInfo(StringRef Name, unsigned Size, unsigned Alignment,
+                  unsigned NumExtraInhabitants)
+    : TypeInfo(TypeInfoKind::Builtin, Size, Alignment,
+               std::max(Size, Alignment), NumExtraInhabitants),
+      Name(Name) {}
+
+  StringRef getName() const { return Name; }
+
+  static bool classof(const TypeInfo *TI) {
+    return TI->getKind() == TypeInfoKind::Builtin;
+  }
+};
+
+/// A strong reference to a heap object.
+class ReferenceTypeInfo : public TypeInfo {
+public:
+  ReferenceTypeInfo(unsigned Size, unsigned Alignment,
+                    unsigned NumExtraInhabitants)
+    : TypeInfo(TypeInfoKind::Reference, Size, Alignment, Size,
+               NumExtraInhabitants) {}
+
+  static bool classof(const TypeInfo *TI) {
+    return TI->getKind() == TypeInfoKind::Reference;
+  }
+};
+
+/// A stored property, tuple element or enum payload.
+struct FieldInfo {
+  std::string Name;
+  unsigned Offset;
+  const TypeRef *TR;
+  const TypeInfo &TI;
+};
+
+/// Aggregates built out of fields: tuples, structs, enums, existentials and
+/// class instances.
+class RecordTypeInfo : public TypeInfo {
+  RecordKind SubKind;
+  std::vector<FieldInfo> Fields;
+
+public:
+  RecordTypeInfo(unsigned Size, unsigned Alignment, unsigned Stride,
+                 unsigned NumExtraInhabitants, RecordKind SubKind,
+                 const std::vector<FieldInfo> &Fields)
+    : TypeInfo(TypeInfoKind::Record, Size, Alignment, Stride,
+               NumExtraInhabitants),
+      SubKind(SubKind), Fields(Fields) {}
+
+  RecordKind getRecordKind() const { return SubKind; }
+  const std::vector<FieldInfo> &getFields() const { return Fields; }
+
+  static bool classof(const TypeInfo *TI) {
+    return TI->getKind() == TypeInfoKind::Record;
+  }
+};
+
+/// Computes and memoizes the layout of TypeRefs.
+///
+/// Because TypeRefs are uniqued by the TypeRefBuilder, each distinct type is
+/// only lowered once.
+class TypeConverter {
+  ReflectionContext &RC;
+  unsigned PointerSize;
+
+  std::vector<std::unique_ptr<const TypeInfo>> Pool;
+  llvm::DenseMap<const TypeRef *, const TypeInfo *> Cache;
+  llvm::DenseMap<const TypeRef *, const TypeInfo *> ClassInstanceCache;
+  llvm::DenseSet<const TypeRef *> RecursionCheck;
+
+  const TypeInfo *RawPointerTI = nullptr;
+  const TypeInfo *ReferenceTI = nullptr;
+  const TypeInfo *EmptyTI = nullptr;
+
+  friend class LowerType;
+  friend class RecordTypeInfoBuilder;
+
+public:
+  template <typename T, typename... Args>
+  const T *makeTypeInfo(Args... args) {
+    auto TI = new T(::std::forward<Args>(args)...);
+    Pool.push_back(std::unique_ptr<const TypeInfo>(TI));
+    return TI;
+  }
+
+  TypeConverter(ReflectionContext &RC, unsigned PointerSize = sizeof(void *))
+    : RC(RC), PointerSize(PointerSize) {}
+
+  TypeConverter(const TypeConverter &) = delete;
+  TypeConverter &operator=(const TypeConverter &) = delete;
+
+  ReflectionContext &getContext() const { return RC; }
+
+  unsigned getPointerSize() const { return PointerSize; }
+
+  /// The number of extra inhabitants of a heap object or metadata pointer.
+  ///
+  /// This is the number of bit patterns below the least valid pointer
+  /// value, which is the first page on all supported platforms.
+  unsigned getPointerExtraInhabitants() const { return 4096; }
+
+  /// The layout of a raw, non-null pointer.
+  const TypeInfo *getRawPointerTypeInfo();
+
+  /// The layout of a strong reference to a Swift or Objective-C object.
+  const TypeInfo *getReferenceTypeInfo();
+
+  /// The layout of a value that takes up no storage, such as a thin
+  /// metatype.
+  const TypeInfo *getEmptyTypeInfo();
+
+  /// Returns the layout of a value of type \p TR, or nullptr if its layout
+  /// cannot be computed from the available reflection metadata.
+  const TypeInfo *getTypeInfo(const TypeRef *TR);
+
+  /// Returns the layout of the heap instance of the class type \p TR, or
+  /// nullptr if it cannot be computed.
+  const TypeInfo *getClassInstanceTypeInfo(const TypeRef *TR);
+};
+
+/// Lays out fields one after another at their natural alignment, the way
+/// IRGen lays out structs and tuples.
+class RecordTypeInfoBuilder {
+  TypeConverter &TC;
+  unsigned Size, Alignment, NumExtraInhabitants;
+  RecordKind Kind;
+  std::vector<FieldInfo> Fields;
+  bool Invalid;
+
+public:
+  RecordTypeInfoBuilder(TypeConverter &TC, RecordKind Kind,
+                        unsigned StartOffset = 0)
+    : TC(TC), Size(StartOffset), Alignment(1), NumExtraInhabitants(0),
+      Kind(Kind), Invalid(false) {}
+
+  bool isInvalid() const {
+    return Invalid;
+  }
+
+  unsigned addField(unsigned fieldSize, unsigned fieldAlignment) {
+    assert(fieldAlignment > 0);
+
+    // Align the current size appropriately.
+    Size = ((Size + fieldAlignment - 1) & ~(fieldAlignment - 1));
+
+    // Record the offset.
+    unsigned offset = Size;
+
+    // Update the aggregate size.
+    Size += fieldSize;
+
+    // Update the aggregate alignment.
+    Alignment = std::max(Alignment, fieldAlignment);
+
+    return offset;
+  }
+
+  void addField(const std::string &Name, const TypeRef *TR) {
+    const TypeInfo *TI = TC.getTypeInfo(TR);
+    if (TI == nullptr) {
+      Invalid = true;
+      return;
+    }
+
+    // The extra inhabitants of a record are those of the field with the
+    // most extra inhabitants.
+    NumExtraInhabitants = std::max(NumExtraInhabitants,
+                                   TI->getNumExtraInhabitants());
+
+    unsigned offset = addField(TI->getSize(), TI->getAlignment());
+    Fields.push_back({Name, offset, TR, *TI});
+  }
+
+  void setNumExtraInhabitants(unsigned Count) {
+    NumExtraInhabitants = Count;
+  }
+
+  const RecordTypeInfo *build() {
+    if (Invalid)
+      return nullptr;
+
+    // Calculate the stride.
+    unsigned Stride = ((Size + Alignment - 1) & ~(Alignment - 1));
+    if (Stride == 0)
+      Stride = 1;
+
+    return TC.makeTypeInfo<RecordTypeInfo>(Size, Alignment, Stride,
+                                           NumExtraInhabitants, Kind,
+                                           Fields);
+  }
+};
+
+/// Returns the number of bytes needed to store \p NumTags distinct tag
+/// values.
+static inline unsigned getNumTagBytes(unsigned NumTags) {
+  if (NumTags <= 1)
+    return 0;
+  if (NumTags <= 0x100)
+    return 1;
+  if (NumTags <= 0x10000)
+    return 2;
+  return 4;
+}
+
+class LowerType : public TypeRefVisitor<LowerType, const TypeInfo *> {
+  TypeConverter &TC;
+
+  const TypeInfo *makeScalar(StringRef Name, unsigned Size,
+                             unsigned NumExtraInhabitants = 0) {
+    unsigned Alignment = std::min(std::max(Size, 1U), 16U);
+    return TC.makeTypeInfo<BuiltinTypeInfo>(Name, Size, Alignment,
+                                            NumExtraInhabitants);
+  }
+
+  /// Parse the bit width following a builtin integer or float prefix.
+  static unsigned parseBitWidth(StringRef Digits) {
+    unsigned Width = 0;
+    if (Digits.getAsInteger(10, Width))
+      return 0;
+    return Width;
+  }
+
+  /// Returns the demangle tree of the nominal type declaration with the
+  /// given mangled name, or nullptr if it cannot be demangled.
+  static Demangle::NodePointer getNominalNode(StringRef MangledName) {
+    auto Node = Demangle::demangleTypeAsNode(MangledName.data(),
+                                             MangledName.size());
+    while (Node && Node->getKind() == Demangle::Node::Kind::Type &&
+           Node->hasChildren())
+      Node = Node->getChild(0);
+    return Node;
+  }
+
+  /// Returns the protocols of the existential type \p TR. For a single
+  /// protocol, the result refers to \p TR itself.
+  static TypeRefArray getProtocols(const TypeRef *const &TR) {
+    if (auto PC = dyn_cast_or_null<ProtocolCompositionTypeRef>(TR))
+      return PC->getProtocols();
+    return TypeRefArray(TR);
+  }
+
+  /// Determines whether existentials of \p Protocols are class-bound and
+  /// how many witness tables they carry, using the kinds recorded in the
+  /// protocols' field descriptors, as IRGen does from the declarations.
+  ///
+  /// Returns false if some protocol is not described by the available
+  /// reflection metadata.
+  bool classifyProtocols(TypeRefArray Protocols, bool &ClassBound,
+                         unsigned &NumWitnessTables) {
+    ClassBound = false;
+    NumWitnessTables = 0;
+
+    for (auto Protocol : Protocols) {
+      auto P = dyn_cast_or_null<ProtocolTypeRef>(Protocol);
+      if (P == nullptr)
+        return false;
+
+      // AnyObject is class-bound but needs no witness table. ErrorType is
+      // an ordinary protocol when composed with others. Both are special
+      // to the compiler, so don't depend on the standard library having
+      // been built with reflection metadata.
+      if (P->isAnyObject()) {
+        ClassBound = true;
+        continue;
+      }
+      if (P->isErrorType()) {
+        ++NumWitnessTables;
+        continue;
+      }
+
+      auto Descriptor = TC.getContext().getProtocolDescriptor(P);
+      if (Descriptor == nullptr)
+        return false;
+
+      switch (Descriptor->Kind) {
+      case FieldDescriptorKind::ObjCProtocol:
+        // Objective-C protocols dispatch through objc_msgSend.
+        ClassBound = true;
+        break;
+      case FieldDescriptorKind::ClassProtocol:
+        ClassBound = true;
+        ++NumWitnessTables;
+        break;
+      case FieldDescriptorKind::Protocol:
+        ++NumWitnessTables;
+        break;
+      default:
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  const TypeInfo *getExistentialTypeInfo(const TypeRef *TR) {
+    unsigned WordSize = TC.getPointerSize();
+    auto Protocols = getProtocols(TR);
+
+    // ErrorType on its own is a single reference to a boxed value.
+    if (Protocols.size() == 1) {
+      auto P = dyn_cast_or_null<ProtocolTypeRef>(Protocols[0]);
+      if (P != nullptr && P->isErrorType()) {
+        RecordTypeInfoBuilder builder(TC, RecordKind::ErrorExistential);
+        builder.addField(WordSize, WordSize);
+        builder.setNumExtraInhabitants(TC.getPointerExtraInhabitants());
+        return builder.build();
+      }
+    }
+
+    bool ClassBound;
+    unsigned NumWitnessTables;
+    if (!classifyProtocols(Protocols, ClassBound, NumWitnessTables))
+      return nullptr;
+
+    RecordTypeInfoBuilder builder(TC, ClassBound
+                                      ? RecordKind::ClassExistential
+                                      : RecordKind::Existential);
+    if (ClassBound) {
+      // A strong reference to the instance, which also provides the
+      // extra inhabitants.
+      builder.addField(WordSize, WordSize);
+    } else {
+      // A three-word fixed-size buffer and the metadata pointer.
+      builder.addField(3 * WordSize, WordSize);
+      builder.addField(WordSize, WordSize);
+    }
+    for (unsigned i = 0; i < NumWitnessTables; ++i)
+      builder.addField(WordSize, WordSize);
+    builder.setNumExtraInhabitants(TC.getPointerExtraInhabitants());
+    return builder.build();
+  }
+
+  /// Returns true if the metatype of \p TR has a single value and is
+  /// therefore stored thin, taking up no space. Only metatypes of classes
+  /// and of types that might be bound to a class are stored as a pointer.
+  static bool hasSingletonMetatype(const TypeRef *TR) {
+    if (TR == nullptr)
+      return false;
+    if (auto M = dyn_cast<MetatypeTypeRef>(TR))
+      return hasSingletonMetatype(M->getInstanceType());
+    if (isa<GenericTypeParameterTypeRef>(TR) ||
+        isa<DependentMemberTypeRef>(TR))
+      return false;
+    if (auto N = dyn_cast<NominalTypeRef>(TR))
+      return !isClass(N->getMangledName());
+    if (auto BG = dyn_cast<BoundGenericTypeRef>(TR))
+      return !isClass(BG->getMangledName());
+    return true;
+  }
+
+  static bool isClass(StringRef MangledName) {
+    auto Node = getNominalNode(MangledName);
+    return Node && Node->getKind() == Demangle::Node::Kind::Class;
+  }
+
+  const TypeInfo *getEnumTypeInfo(const TypeRef *TR,
+                                  const std::vector<FieldTypeInfo> &Cases);
+
+public:
+  LowerType(TypeConverter &TC) : TC(TC) {}
+
+  const TypeInfo *visitBuiltinTypeRef(const BuiltinTypeRef *B) {
+    auto Name = B->getMangledName();
+    unsigned WordSize = TC.getPointerSize();
+
+    if (Name.startswith("Bi") && Name.endswith("_")) {
+      // Builtin.IntN is rounded up to a power-of-two number of bytes.
+      unsigned Bits = parseBitWidth(Name.substr(2, Name.size() - 3));
+      if (Bits == 0)
+        return nullptr;
+      unsigned Size = 1;
+      while (Size * 8 < Bits)
+        Size *= 2;
+      return makeScalar(Name, Size);
+    }
+
+    if (Name.startswith("Bf") && Name.endswith("_")) {
+      unsigned Bits = parseBitWidth(Name.substr(2, Name.size() - 3));
+      switch (Bits) {
+      case 16: return makeScalar(Name, 2);
+      case 32: return makeScalar(Name, 4);
+      case 64: return makeScalar(Name, 8);
+      case 80: return makeScalar(Name, 16);
+      case 128: return makeScalar(Name, 16);
+      default: return nullptr;
+      }
+    }
+
+    if (Name == "Bw")
+      return makeScalar(Name, WordSize);
+    if (Name == "Bp")
+      return TC.getRawPointerTypeInfo();
+    if (Name == "Bo" || Name == "BO" || Name == "Bb")
+      return TC.getReferenceTypeInfo();
+    if (Name == "BB")
+      return TC.makeTypeInfo<BuiltinTypeInfo>(Name, 3 * WordSize, WordSize,
+                                              0);
+
+    // Vectors and other builtins are not supported yet.
+    return nullptr;
+  }
+
+  const TypeInfo *visitNominalTypeRef(const NominalTypeRef *N) {
+    return visitAnyNominalTypeRef(N, N->getMangledName());
+  }
+
+  const TypeInfo *visitBoundGenericTypeRef(const BoundGenericTypeRef *BG) {
+    return visitAnyNominalTypeRef(BG, BG->getMangledName());
+  }
+
+  const TypeInfo *visitAnyNominalTypeRef(const TypeRef *TR,
+                                         StringRef MangledName) {
+    using NodeKind = Demangle::Node::Kind;
+    auto Node = getNominalNode(MangledName);
+    if (!Node)
+      return nullptr;
+
+    switch (Node->getKind()) {
+    case NodeKind::Class:
+      return TC.getReferenceTypeInfo();
+    case NodeKind::Structure: {
+      std::vector<FieldTypeInfo> Fields;
+      if (!TC.getContext().getFieldTypeRefs(TR, Fields))
+        return nullptr;
+      RecordTypeInfoBuilder builder(TC, RecordKind::Struct);
+      for (auto &Field : Fields)
+        builder.addField(Field.Name, Field.TR);
+      return builder.build();
+    }
+    case NodeKind::Enum: {
+      std::vector<FieldTypeInfo> Cases;
+      if (!TC.getContext().getFieldTypeRefs(TR, Cases))
+        return nullptr;
+      return getEnumTypeInfo(TR, Cases);
+    }
+    default:
+      return nullptr;
+    }
+  }
+
+  const TypeInfo *visitTupleTypeRef(const TupleTypeRef *T) {
+    RecordTypeInfoBuilder builder(TC, RecordKind::Tuple);
+    for (auto Element : T->getElements())
+      builder.addField("", Element);
+    return builder.build();
+  }
+
+  const TypeInfo *visitFunctionTypeRef(const FunctionTypeRef *F) {
+    // Stored function values are thick: a function pointer followed by a
+    // context reference.
+    RecordTypeInfoBuilder builder(TC, RecordKind::ThickFunction);
+    builder.addField(TC.getRawPointerTypeInfo()->getSize(),
+                     TC.getRawPointerTypeInfo()->getAlignment());
+    builder.addField(TC.getReferenceTypeInfo()->getSize(),
+                     TC.getReferenceTypeInfo()->getAlignment());
+    builder.setNumExtraInhabitants(TC.getPointerExtraInhabitants());
+    return builder.build();
+  }
+
+  const TypeInfo *visitProtocolTypeRef(const ProtocolTypeRef *P) {
+    return getExistentialTypeInfo(P);
+  }
+
+  const TypeInfo *
+  visitProtocolCompositionTypeRef(const ProtocolCompositionTypeRef *PC) {
+    return getExistentialTypeInfo(PC);
+  }
+
+  const TypeInfo *visitMetatypeTypeRef(const MetatypeTypeRef *M) {
+    auto InstanceTR = M->getInstanceType();
+    if (InstanceTR == nullptr)
+      return nullptr;
+
+    // Metatypes substituted for a generic parameter's metatype keep the
+    // thick representation of the unsubstituted type.
+    if (!M->wasAbstract() && hasSingletonMetatype(InstanceTR))
+      return TC.getEmptyTypeInfo();
+    return TC.getRawPointerTypeInfo();
+  }
+
+  const TypeInfo *
+  visitExistentialMetatypeTypeRef(const ExistentialMetatypeTypeRef *EM) {
+    // The metadata pointer followed by the witness tables.
+    bool ClassBound;
+    unsigned NumWitnessTables;
+    auto InstanceTR = EM->getInstanceType();
+    if (!classifyProtocols(getProtocols(InstanceTR), ClassBound,
+                           NumWitnessTables))
+      return nullptr;
+
+    RecordTypeInfoBuilder builder(TC, RecordKind::ExistentialMetatype);
+    unsigned WordSize = TC.getPointerSize();
+    for (unsigned i = 0; i < NumWitnessTables + 1; ++i)
+      builder.addField(WordSize, WordSize);
+    builder.setNumExtraInhabitants(TC.getPointerExtraInhabitants());
+    return builder.build();
+  }
+
+  // Unsubstituted generic parameters and dependent types have no layout.
+
+  const TypeInfo *
+  visitGenericTypeParameterTypeRef(const GenericTypeParameterTypeRef *GTP) {
+    return nullptr;
+  }
+
+  const TypeInfo *
+  visitDependentMemberTypeRef(const DependentMemberTypeRef *DM) {
+    return nullptr;
+  }
+
+  const TypeInfo *visitAssociatedTypeRef(const AssociatedTypeRef *AT) {
+    return nullptr;
+  }
+};
+
+inline const TypeInfo *
+LowerType::getEnumTypeInfo(const TypeRef *TR,
+                           const std::vector<FieldTypeInfo> &Cases) {
+  // Enum elements are recorded with their interface type: either
+  // 'Self.Type -> Self' for an empty case, or
+  // 'Self.Type -> Payload -> Self' for a case with a payload.
+  unsigned NoPayloadCases = 0;
+  std::vector<FieldInfo> PayloadCases;
+  unsigned MaxPayloadSize = 0, Alignment = 1;
+
+  for (auto &Case : Cases) {
+    auto CaseTR = dyn_cast_or_null<FunctionTypeRef>(Case.TR);
+    if (CaseTR == nullptr)
+      return nullptr;
+
+    auto PayloadFn = dyn_cast_or_null<FunctionTypeRef>(CaseTR->getResult());
+    if (PayloadFn == nullptr) {
+      ++NoPayloadCases;
+      continue;
+    }
+
+    auto PayloadTR = PayloadFn->getInput();
+    auto PayloadTI = TC.getTypeInfo(PayloadTR);
+    if (PayloadTI == nullptr)
+      return nullptr;
+
+    PayloadCases.push_back({Case.Name, 0, PayloadTR, *PayloadTI});
+    MaxPayloadSize = std::max(MaxPayloadSize, PayloadTI->getSize());
+    Alignment = std::max(Alignment, PayloadTI->getAlignment());
+  }
+
+  unsigned Size, NumExtraInhabitants = 0;
+  RecordKind Kind;
+
+  if (PayloadCases.empty()) {
+    Kind = RecordKind::NoPayloadEnum;
+    Size = getNumTagBytes(NoPayloadCases);
+    Alignment = std::max(Size, 1U);
+    if (Size > 0) {
+      uint64_t NumValues = uint64_t(1) << (Size * 8);
+      NumExtraInhabitants = unsigned(
+        std::min<uint64_t>(NumValues - NoPayloadCases, 0x7fffffff));
+    }
+  } else if (PayloadCases.size() == 1) {
+    Kind = RecordKind::SinglePayloadEnum;
+    auto &PayloadTI = PayloadCases[0].TI;
+    Size = PayloadTI.getSize();
+    unsigned PayloadExtraInhabitants = PayloadTI.getNumExtraInhabitants();
+
+    if (NoPayloadCases <= PayloadExtraInhabitants) {
+      // Empty cases are stored in the payload's extra inhabitants.
+      NumExtraInhabitants = PayloadExtraInhabitants - NoPayloadCases;
+    } else {
+      // The remaining empty cases need extra tag bytes. Each tag value
+      // other than the payload's own can distinguish as many empty cases
+      // as the payload has bit patterns.
+      unsigned Remaining = NoPayloadCases - PayloadExtraInhabitants;
+      unsigned NumTags;
+      if (Size >= 4)
+        NumTags = 2;
+      else {
+        unsigned PerTag = 1U << (Size * 8);
+        NumTags = 1 + (Remaining + PerTag - 1) / PerTag;
+      }
+      Size += getNumTagBytes(NumTags);
+    }
+  } else {
+    // FIXME: Spare bits of the payloads are not used for the tag.
+    Kind = RecordKind::MultiPayloadEnum;
+    unsigned NumTags = PayloadCases.size();
+    if (NoPayloadCases > 0) {
+      if (MaxPayloadSize >= 4)
+        NumTags += 1;
+      else {
+        unsigned PerTag = 1U << (MaxPayloadSize * 8);
+        NumTags += (NoPayloadCases + PerTag - 1) / PerTag;
+      }
+    }
+    Size = MaxPayloadSize + getNumTagBytes(NumTags);
+  }
+
+  unsigned Stride = ((Size + Alignment - 1) & ~(Alignment - 1));
+  if (Stride == 0)
+    Stride = 1;
+
+  return TC.makeTypeInfo<RecordTypeInfo>(Size, Alignment, Stride,
+                                         NumExtraInhabitants, Kind,
+                                         PayloadCases);
+}
+
+inline const TypeInfo *TypeConverter::getRawPointerTypeInfo() {
+  if (RawPointerTI == nullptr)
+    RawPointerTI = makeTypeInfo<BuiltinTypeInfo>("Bp", PointerSize,
+                                                 PointerSize,
+                                                 getPointerExtraInhabitants());
+  return RawPointerTI;
+}
+
+inline const TypeInfo *TypeConverter::getReferenceTypeInfo() {
+  if (ReferenceTI == nullptr)
+    ReferenceTI = makeTypeInfo<ReferenceTypeInfo>(PointerSize, PointerSize,
+                                                  getPointerExtraInhabitants());
+  return ReferenceTI;
+}
+
+inline const TypeInfo *TypeConverter::getEmptyTypeInfo() {
+  if (EmptyTI == nullptr)
+    EmptyTI = makeTypeInfo<BuiltinTypeInfo>("", 0, 1, 0);
+  return EmptyTI;
+}
+
+inline const TypeInfo *TypeConverter::getTypeInfo(const TypeRef *TR) {
+  if (TR == nullptr)
+    return nullptr;
+
+  // See if we already computed the result.
+  auto found = Cache.find(TR);
+  if (found != Cache.end())
+    return found->second;
+
+  // Detect invalid recursive value types (IRGen should not emit them in
+  // the first place, but we might be reading corrupt data).
+  if (!RecursionCheck.insert(TR).second)
+    return nullptr;
+
+  auto *TI = LowerType(*this).visit(TR);
+  Cache[TR] = TI;
+
+  RecursionCheck.erase(TR);
+
+  return TI;
+}
+
+inline const TypeInfo *
+TypeConverter::getClassInstanceTypeInfo(const TypeRef *TR) {
+  auto found = ClassInstanceCache.find(TR);
+  if (found != ClassInstanceCache.end())
+    return found->second;
+
+  std::vector<FieldTypeInfo> Fields;
+  const TypeInfo *TI = nullptr;
+  if (RC.getFieldTypeRefs(TR, Fields)) {
+    // Stored properties follow the heap object header, which is the
+    // isa pointer followed by the reference counts.
+    RecordTypeInfoBuilder builder(*this, RecordKind::ClassInstance,
+                                  2 * PointerSize);
+    // The header is pointer-aligned.
+    builder.addField(0, PointerSize);
+    for (auto &Field : Fields)
+      builder.addField(Field.Name, Field.TR);
+    TI = builder.build();
+  }
+
+  ClassInstanceCache[TR] = TI;
+  return TI;
+}
+
+class PrintTypeInfo {
+  std::ostream &OS;
+  unsigned Indent;
+
+  std::ostream &indent(unsigned Amount) {
+    for (unsigned i = 0; i < Amount; ++i)
+      OS << ' ';
+    return OS;
+  }
+
+  std::ostream &printHeader(const std::string &Name) {
+    indent(Indent) << '(' << Name;
+    return OS;
+  }
+
+  void printBasics(const TypeInfo &TI) {
+    OS << " size=" << TI.getSize();
+    OS << " alignment=" << TI.getAlignment();
+    OS << " stride=" << TI.getStride();
+    OS << " num_extra_inhabitants=" << TI.getNumExtraInhabitants();
+  }
+
+  void printFields(const RecordTypeInfo &TI) {
+    Indent += 2;
+    for (const auto &Field : TI.getFields()) {
+      OS << "\n";
+      printHeader("field");
+      if (!Field.Name.empty())
+        OS << " name=" << Field.Name;
+      OS << " offset=" << Field.Offset;
+      OS << "\n";
+      Indent += 2;
+      print(Field.TI);
+      Indent -= 2;
+      OS << ')';
+    }
+    Indent -= 2;
+  }
+
+  static const char *getRecordKindName(RecordKind Kind) {
+    switch (Kind) {
+    case RecordKind::Tuple: return "tuple";
+    case RecordKind::Struct: return "struct";
+    case RecordKind::NoPayloadEnum: return "no_payload_enum";
+    case RecordKind::SinglePayloadEnum: return "single_payload_enum";
+    case RecordKind::MultiPayloadEnum: return "multi_payload_enum";
+    case RecordKind::ThickFunction: return "thick_function";
+    case RecordKind::Existential: return "existential";
+    case RecordKind::ClassExistential: return "class_existential";
+    case RecordKind::ErrorExistential: return "error_existential";
+    case RecordKind::ExistentialMetatype: return "existential_metatype";
+    case RecordKind::ClassInstance: return "class_instance";
+    }
+
+    llvm_unreachable("Unhandled RecordKind in switch.");
+  }
+
+public:
+  PrintTypeInfo(std::ostream &OS, unsigned Indent)
+    : OS(OS), Indent(Indent) {}
+
+  void print(const TypeInfo &TI) {
+    switch (TI.getKind()) {
+    case TypeInfoKind::Builtin:
+      printHeader("builtin");
+      printBasics(TI);
+      OS << ')';
+      return;
+    case TypeInfoKind::Reference:
+      printHeader("reference");
+      printBasics(TI);
+      OS << ')';
+      return;
+    case TypeInfoKind::Record: {
+      auto &RecordTI = cast<RecordTypeInfo>(TI);
+      printHeader(getRecordKindName(RecordTI.getRecordKind()));
+      printBasics(TI);
+      printFields(RecordTI);
+      OS << ')';
+      return;
+    }
+    }
+  }
+};
+
+inline void TypeInfo::dump() const {
+  dump(std::cerr);
+}
+
+inline void TypeInfo::dump(std::ostream &OS, unsigned Indent) const {
+  PrintTypeInfo(OS, Indent).print(*this);
+  OS << '\n';
+}
+
+} // end namespace reflection
+} // end namespace swift
+
+#endif // SWIFT_REFLECTION_TYPELOWERING_H
@@ -19,6 +19,10 @@
 #define SWIFT_REFLECTION_TYPEREF_H
 
 #include "swift/Basic/Demangle.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/FoldingSet.h"
+#include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Casting.h"
 
 #include <iostream>
@@ -29,8 +33,12 @@ namespace swift {
 namespace reflection {
 
 class ReflectionContext;
+class TypeRefBuilder;
 
+using llvm::ArrayRef;
+using llvm::StringRef;
 using llvm::cast;
+using llvm::isa;
 
 enum class TypeRefKind {
 #define TYPEREF(Id, Parent) Id,
@@ -39,38 +47,62 @@ enum class TypeRefKind {
 };
 
 class TypeRef;
-using TypeRefPointer = std::shared_ptr<TypeRef>;
-using ConstTypeRefPointer = std::shared_ptr<const TypeRef>;
-using TypeRefVector = std::vector<TypeRefPointer>;
-using ConstTypeRefVector = const std::vector<TypeRefPointer>;
-
-class TypeRef : public std::enable_shared_from_this<TypeRef> {
+using TypeRefArray = ArrayRef<const TypeRef *>;
+
+/// Maps (depth, index) pairs of generic type parameters to their
+/// substitutions.
+using GenericArgumentMap
+  = llvm::DenseMap<std::pair<unsigned, unsigned>, const TypeRef *>;
+
+/// A reference to a Swift type, decoded from a mangled name found in the
+/// reflection metadata.
+///
+/// TypeRefs are immutable and uniqued by the TypeRefBuilder that created
+/// them, which also owns their memory. Two TypeRefs from the same builder
+/// describe the same type if and only if they are the same pointer.
+class TypeRef : public llvm::FoldingSetNode {
   TypeRefKind Kind;
 
-public:
+protected:
   TypeRef(TypeRefKind Kind) : Kind(Kind) {}
 
+public:
+  TypeRef(const TypeRef &) = delete;
+  TypeRef &operator=(const TypeRef &) = delete;
+
   TypeRefKind getKind() const {
     return Kind;
   }
 
+  /// Returns true if this type contains no generic type parameters.
+  bool isConcrete() const;
+
+  /// Replace generic type parameters with the types in \p Subs,
+  /// returning a TypeRef uniqued in \p Builder.
+  const TypeRef *subst(TypeRefBuilder &Builder,
+                       const GenericArgumentMap &Subs) const;
+
   void dump() const;
   void dump(std::ostream &OS, unsigned Indent = 0) const;
 };
 
 class BuiltinTypeRef final : public TypeRef {
-  std::string MangledName;
+  StringRef MangledName;
 
 public:
-  BuiltinTypeRef(std::string MangledName)
+  BuiltinTypeRef(StringRef MangledName)
     : TypeRef(TypeRefKind::Builtin), MangledName(MangledName) {}
 
-  static std::shared_ptr<BuiltinTypeRef> create(std::string MangledName) {
-    return std::make_shared<BuiltinTypeRef>(MangledName);
+  StringRef getMangledName() const {
+    return MangledName;
+  }
+
+  static void Profile(llvm::FoldingSetNodeID &ID, StringRef MangledName) {
+    ID.AddString(MangledName);
   }
 
-  std::string getMangledName() const {
-    return MangledName;
+  void Profile(llvm::FoldingSetNodeID &ID) const {
+    Profile(ID, MangledName);
   }
 
   static bool classof(const TypeRef *TR) {
@@ -79,18 +111,22 @@ public:
 };
 
 class NominalTypeRef final : public TypeRef {
-  std::string MangledName;
+  StringRef MangledName;
 
 public:
-  NominalTypeRef(std::string MangledName)
+  NominalTypeRef(StringRef MangledName)
     : TypeRef(TypeRefKind::Nominal), MangledName(MangledName) {}
 
-  static std::shared_ptr<NominalTypeRef> create(std::string MangledName) {
-    return std::make_shared<NominalTypeRef>(MangledName);
+  StringRef getMangledName() const {
+    return MangledName;
   }
 
-  std::string getMangledName() const {
-    return MangledName;
+  static void Profile(llvm::FoldingSetNodeID &ID, StringRef MangledName) {
+    ID.AddString(MangledName);
+  }
+
+  void Profile(llvm::FoldingSetNodeID &ID) const {
+    Profile(ID, MangledName);
   }
 
   static bool classof(const TypeRef *TR) {
@@ -99,30 +135,33 @@ public:
 };
 
 class BoundGenericTypeRef final : public TypeRef {
-  std::string MangledName;
-  TypeRefVector GenericParams;
+  StringRef MangledName;
+  TypeRefArray GenericParams;
 
 public:
-  BoundGenericTypeRef(std::string MangledName, TypeRefVector GenericParams)
+  BoundGenericTypeRef(StringRef MangledName, TypeRefArray GenericParams)
     : TypeRef(TypeRefKind::BoundGeneric),
       MangledName(MangledName),
       GenericParams(GenericParams) {}
 
-  static std::shared_ptr<BoundGenericTypeRef>
-  create(std::string MangledName, TypeRefVector GenericParams) {
-    return std::make_shared<BoundGenericTypeRef>(MangledName, GenericParams);
-  }
-
-  std::string getMangledName() const {
+  StringRef getMangledName() const {
     return MangledName;
   }
 
-  TypeRefVector getGenericParams() {
+  TypeRefArray getGenericParams() const {
     return GenericParams;
   }
 
-  ConstTypeRefVector getGenericParams() const {
-    return GenericParams;
+  static void Profile(llvm::FoldingSetNodeID &ID, StringRef MangledName,
+                      TypeRefArray GenericParams) {
+    ID.AddString(MangledName);
+    ID.AddInteger(GenericParams.size());
+    for (auto Param : GenericParams)
+      ID.AddPointer(Param);
+  }
+
+  void Profile(llvm::FoldingSetNodeID &ID) const {
+    Profile(ID, MangledName, GenericParams);
   }
 
   static bool classof(const TypeRef *TR) {
@@ -131,23 +170,25 @@ public:
 };
 
 class TupleTypeRef final : public TypeRef {
-  TypeRefVector Elements;
+  TypeRefArray Elements;
 
 public:
-  TupleTypeRef(TypeRefVector Elements)
+  TupleTypeRef(TypeRefArray Elements)
     : TypeRef(TypeRefKind::Tuple), Elements(Elements) {}
 
-  static std::shared_ptr<TupleTypeRef> create(TypeRefVector Elements) {
-    return std::make_shared<TupleTypeRef>(Elements);
-  }
-
-  TypeRefVector getElements() {
+  TypeRefArray getElements() const {
     return Elements;
   };
 
-  ConstTypeRefVector getElements() const {
-    return Elements;
-  };
+  static void Profile(llvm::FoldingSetNodeID &ID, TypeRefArray Elements) {
+    ID.AddInteger(Elements.size());
+    for (auto Element : Elements)
+      ID.AddPointer(Element);
+  }
+
+  void Profile(llvm::FoldingSetNodeID &ID) const {
+    Profile(ID, Elements);
+  }
 
   static bool classof(const TypeRef *TR) {
     return TR->getKind() == TypeRefKind::Tuple;
@@ -155,32 +196,29 @@ public:
 };
 
 class FunctionTypeRef final : public TypeRef {
-  TypeRefPointer Input;
-  TypeRefPointer Result;
+  const TypeRef *Input;
+  const TypeRef *Result;
 
 public:
-  FunctionTypeRef(TypeRefPointer Input, TypeRefPointer Result)
+  FunctionTypeRef(const TypeRef *Input, const TypeRef *Result)
     : TypeRef(TypeRefKind::Function), Input(Input), Result(Result) {}
 
-  static std::shared_ptr<FunctionTypeRef> create(TypeRefPointer Input,
-                                                 TypeRefPointer Result) {
-    return std::make_shared<FunctionTypeRef>(Input, Result);
-  }
-
-  TypeRefPointer getInput() {
+  const TypeRef *getInput() const {
     return Input;
   };
 
-  ConstTypeRefPointer getInput() const {
-    return Input;
-  };
-
-  TypeRefPointer getResult() {
+  const TypeRef *getResult() const {
     return Result;
   }
 
-  ConstTypeRefPointer getResult() const {
-    return Result;
+  static void Profile(llvm::FoldingSetNodeID &ID, const TypeRef *Input,
+                      const TypeRef *Result) {
+    ID.AddPointer(Input);
+    ID.AddPointer(Result);
+  }
+
+  void Profile(llvm::FoldingSetNodeID &ID) const {
+    Profile(ID, Input, Result);
   }
 
   static bool classof(const TypeRef *TR) {
@@ -189,49 +227,65 @@ public:
 };
 
 class ProtocolTypeRef final : public TypeRef {
-  std::string ModuleName;
-  std::string Name;
+  StringRef ModuleName;
+  StringRef Name;
 
 public:
-  ProtocolTypeRef(std::string ModuleName, std::string Name)
+  ProtocolTypeRef(StringRef ModuleName, StringRef Name)
     : TypeRef(TypeRefKind::Protocol), ModuleName(ModuleName), Name(Name) {}
 
-  static std::shared_ptr<ProtocolTypeRef>
-  create(std::string ModuleName, std::string Name) {
-    return std::make_shared<ProtocolTypeRef>(ModuleName, Name);
-  }
-
-  std::string getName() const {
+  StringRef getName() const {
     return Name;
   }
 
-  std::string getModuleName() const {
+  StringRef getModuleName() const {
     return ModuleName;
   }
 
+  /// Returns true if this is the standard library's AnyObject protocol.
+  bool isAnyObject() const {
+    return ModuleName == "Swift" && Name == "AnyObject";
+  }
+
+  /// Returns true if this is the standard library's ErrorType protocol.
+  bool isErrorType() const {
+    return ModuleName == "Swift" && Name == "ErrorType";
+  }
+
+  static void Profile(llvm::FoldingSetNodeID &ID, StringRef ModuleName,
+                      StringRef Name) {
+    ID.AddString(ModuleName);
+    ID.AddString(Name);
+  }
+
+  void Profile(llvm::FoldingSetNodeID &ID) const {
+    Profile(ID, ModuleName, Name);
+  }
+
   static bool classof(const TypeRef *TR) {
     return TR->getKind() == TypeRefKind::Protocol;
   }
 };
 
 class ProtocolCompositionTypeRef final : public TypeRef {
-  TypeRefVector Protocols;
+  TypeRefArray Protocols;
 
 public:
-  ProtocolCompositionTypeRef(TypeRefVector Protocols)
+  ProtocolCompositionTypeRef(TypeRefArray Protocols)
     : TypeRef(TypeRefKind::ProtocolComposition), Protocols(Protocols) {}
 
-  static std::shared_ptr<ProtocolCompositionTypeRef>
-  create(TypeRefVector Protocols) {
-    return std::make_shared<ProtocolCompositionTypeRef>(Protocols);
+  TypeRefArray getProtocols() const {
+    return Protocols;
   }
 
-  TypeRefVector getProtocols() {
-    return Protocols;
+  static void Profile(llvm::FoldingSetNodeID &ID, TypeRefArray Protocols) {
+    ID.AddInteger(Protocols.size());
+    for (auto Protocol : Protocols)
+      ID.AddPointer(Protocol);
   }
 
-  ConstTypeRefVector getProtocols() const {
-    return Protocols;
+  void Profile(llvm::FoldingSetNodeID &ID) const {
+    Profile(ID, Protocols);
   }
 
   static bool classof(const TypeRef *TR) {
@@ -240,22 +294,33 @@ public:
 };
 
 class MetatypeTypeRef final : public TypeRef {
-  TypeRefPointer InstanceType;
+  const TypeRef *InstanceType;
+  bool WasAbstract;
 
 public:
-  MetatypeTypeRef(TypeRefPointer InstanceType)
-    : TypeRef(TypeRefKind::Metatype), InstanceType(InstanceType) {}
+  MetatypeTypeRef(const TypeRef *InstanceType, bool WasAbstract)
+    : TypeRef(TypeRefKind::Metatype), InstanceType(InstanceType),
+      WasAbstract(WasAbstract) {}
 
-  static std::shared_ptr<MetatypeTypeRef> create(TypeRefPointer InstanceType) {
-    return std::make_shared<MetatypeTypeRef>(InstanceType);
+  const TypeRef *getInstanceType() const {
+    return InstanceType;
   }
 
-  TypeRefPointer getInstanceType() {
-    return InstanceType;
+  /// Returns true if this metatype was produced by substituting into a
+  /// metatype of a generic parameter or dependent type. Such metatypes are
+  /// stored thick even if their instance type has a singleton metatype.
+  bool wasAbstract() const {
+    return WasAbstract;
   }
 
-  ConstTypeRefPointer getInstanceType() const {
-    return InstanceType;
+  static void Profile(llvm::FoldingSetNodeID &ID,
+                      const TypeRef *InstanceType, bool WasAbstract) {
+    ID.AddPointer(InstanceType);
+    ID.AddBoolean(WasAbstract);
+  }
+
+  void Profile(llvm::FoldingSetNodeID &ID) const {
+    Profile(ID, InstanceType, WasAbstract);
   }
 
   static bool classof(const TypeRef *TR) {
@@ -264,22 +329,23 @@ public:
 };
 
 class ExistentialMetatypeTypeRef final : public TypeRef {
-  TypeRefPointer InstanceType;
+  const TypeRef *InstanceType;
 
 public:
-  ExistentialMetatypeTypeRef(TypeRefPointer InstanceType)
+  ExistentialMetatypeTypeRef(const TypeRef *InstanceType)
     : TypeRef(TypeRefKind::ExistentialMetatype), InstanceType(InstanceType) {}
-  static std::shared_ptr<ExistentialMetatypeTypeRef>
-  create(TypeRefPointer InstanceType) {
-    return std::make_shared<ExistentialMetatypeTypeRef>(InstanceType);
-  }
 
-  TypeRefPointer getInstanceType() {
+  const TypeRef *getInstanceType() const {
     return InstanceType;
   }
 
-  ConstTypeRefPointer getInstanceType() const {
-    return InstanceType;
+  static void Profile(llvm::FoldingSetNodeID &ID,
+                      const TypeRef *InstanceType) {
+    ID.AddPointer(InstanceType);
+  }
+
+  void Profile(llvm::FoldingSetNodeID &ID) const {
+    Profile(ID, InstanceType);
   }
 
   static bool classof(const TypeRef *TR) {
@@ -295,11 +361,6 @@ public:
   GenericTypeParameterTypeRef(uint32_t Index, uint32_t Depth)
     : TypeRef(TypeRefKind::GenericTypeParameter), Index(Index), Depth(Depth) {}
 
-  static std::shared_ptr<GenericTypeParameterTypeRef>
-  create(uint32_t Index, uint32_t Depth) {
-    return std::make_shared<GenericTypeParameterTypeRef>(Index, Depth);
-  }
-
   uint32_t getIndex() const {
     return Index;
   }
@@ -308,37 +369,45 @@ public:
     return Depth;
   }
 
+  static void Profile(llvm::FoldingSetNodeID &ID, uint32_t Index,
+                      uint32_t Depth) {
+    ID.AddInteger(Index);
+    ID.AddInteger(Depth);
+  }
+
+  void Profile(llvm::FoldingSetNodeID &ID) const {
+    Profile(ID, Index, Depth);
+  }
+
   static bool classof(const TypeRef *TR) {
     return TR->getKind() == TypeRefKind::GenericTypeParameter;
   }
 };
 
 class DependentMemberTypeRef final : public TypeRef {
-  TypeRefPointer Member;
-  TypeRefPointer Base;
+  const TypeRef *Member;
+  const TypeRef *Base;
 
 public:
-  DependentMemberTypeRef(TypeRefPointer Member, TypeRefPointer Base)
+  DependentMemberTypeRef(const TypeRef *Member, const TypeRef *Base)
     : TypeRef(TypeRefKind::DependentMember), Member(Member), Base(Base) {}
-  static std::shared_ptr<DependentMemberTypeRef>
-  create(TypeRefPointer Member, TypeRefPointer Base) {
-    return std::make_shared<DependentMemberTypeRef>(Member, Base);
-  }
 
-  TypeRefPointer getMember() {
+  const TypeRef *getMember() const {
     return Member;
   }
 
-  ConstTypeRefPointer getMember() const {
-    return Member;
+  const TypeRef *getBase() const {
+    return Base;
   }
 
-  TypeRefPointer getBase() {
-    return Base;
+  static void Profile(llvm::FoldingSetNodeID &ID, const TypeRef *Member,
+                      const TypeRef *Base) {
+    ID.AddPointer(Member);
+    ID.AddPointer(Base);
   }
 
-  ConstTypeRefPointer getBase() const {
-    return Base;
+  void Profile(llvm::FoldingSetNodeID &ID) const {
+    Profile(ID, Member, Base);
   }
 
   static bool classof(const TypeRef *TR) {
@@ -347,18 +416,22 @@ public:
 };
 
 class AssociatedTypeRef final : public TypeRef {
-  std::string Name;
+  StringRef Name;
 
 public:
-  AssociatedTypeRef(std::string Name)
+  AssociatedTypeRef(StringRef Name)
     : TypeRef(TypeRefKind::Associated), Name(Name) {}
 
-  static std::shared_ptr<AssociatedTypeRef> create(std::string Name) {
-    return std::make_shared<AssociatedTypeRef>(Name);
+  StringRef getName() const {
+    return Name;
   }
 
-  std::string getName() const {
-    return Name;
+  static void Profile(llvm::FoldingSetNodeID &ID, StringRef Name) {
+    ID.AddString(Name);
+  }
+
+  void Profile(llvm::FoldingSetNodeID &ID) const {
+    Profile(ID, Name);
   }
 
   static bool classof(const TypeRef *TR) {
@@ -424,64 +497,64 @@ public:
 
   void visitBuiltinTypeRef(const BuiltinTypeRef *B) {
     printHeader("builtin");
-    auto demangled = Demangle::demangleTypeAsString(B->getMangledName());
+    auto demangled = Demangle::demangleTypeAsString(B->getMangledName().str());
     printField("", demangled);
     OS << ')';
   }
 
   void visitNominalTypeRef(const NominalTypeRef *N) {
     printHeader("nominal");
-    auto demangled = Demangle::demangleTypeAsString(N->getMangledName());
+    auto demangled = Demangle::demangleTypeAsString(N->getMangledName().str());
     printField("", demangled);
     OS << ')';
   }
 
   void visitBoundGenericTypeRef(const BoundGenericTypeRef *BG) {
     printHeader("bound-generic");
-    auto demangled = Demangle::demangleTypeAsString(BG->getMangledName());
+    auto demangled = Demangle::demangleTypeAsString(BG->getMangledName().str());
     printField("", demangled);
     for (auto param : BG->getGenericParams())
-      printRec(param.get());
+      printRec(param);
     OS << ')';
   }
 
   void visitTupleTypeRef(const TupleTypeRef *T) {
     printHeader("tuple");
     for (auto element : T->getElements())
-      printRec(element.get());
+      printRec(element);
     OS << ')';
   }
 
   void visitFunctionTypeRef(const FunctionTypeRef *F) {
     printHeader("function");
-    printRec(F->getInput().get());
-    printRec(F->getResult().get());
+    printRec(F->getInput());
+    printRec(F->getResult());
     OS << ')';
   }
 
   void visitProtocolTypeRef(const ProtocolTypeRef *P) {
     printHeader("protocol");
-    printField("module", P->getModuleName());
-    printField("name", P->getName());
+    printField("module", P->getModuleName().str());
+    printField("name", P->getName().str());
     OS << ')';
   }
 
   void visitProtocolCompositionTypeRef(const ProtocolCompositionTypeRef *PC) {
     printHeader("protocol-composition");
     for (auto protocol : PC->getProtocols())
-      printRec(protocol.get());
+      printRec(protocol);
     OS << ')';
   }
 
   void visitMetatypeTypeRef(const MetatypeTypeRef *M) {
     printHeader("metatype");
-    printRec(M->getInstanceType().get());
+    printRec(M->getInstanceType());
     OS << ')';
   }
 
   void visitExistentialMetatypeTypeRef(const ExistentialMetatypeTypeRef *EM) {
     printHeader("existential-metatype");
-    printRec(EM->getInstanceType().get());
+    printRec(EM->getInstanceType());
     OS << ')';
   }
 
@@ -494,92 +567,92 @@ public:
 
   void visitDependentMemberTypeRef(const DependentMemberTypeRef *DM) {
     printHeader("dependent-member");
-    printRec(DM->getBase().get());
-    printRec(DM->getMember().get());
+    printRec(DM->getBase());
+    printRec(DM->getMember());
     OS << ')';
   }
 
   void visitAssociatedTypeRef(const AssociatedTypeRef *AT) {
     printHeader("associated-type");
-    printField("name", AT->getName());
+    printField("name", AT->getName().str());
     OS << ')';
   }
 };
 
-TypeRefPointer decodeDemangleNode(Demangle::NodePointer Node) {
-  using NodeKind = Demangle::Node::Kind;
-  switch (Node->getKind()) {
-    case NodeKind::Type:
-      return decodeDemangleNode(Node->getChild(0));
-    case NodeKind::BoundGenericClass:
-    case NodeKind::BoundGenericEnum:
-    case NodeKind::BoundGenericStructure: {
-      auto mangledName = Demangle::mangleNode(Node->getChild(0));
-      auto genericArgs = Node->getChild(1);
-      TypeRefVector Params;
-      for (auto genericArg : *genericArgs)
-        Params.push_back(decodeDemangleNode(genericArg));
-
-      return BoundGenericTypeRef::create(mangledName, Params);
-    }
-    case NodeKind::Class:
-    case NodeKind::Enum:
-    case NodeKind::Structure: {
-      auto mangledName = Demangle::mangleNode(Node);
-      return NominalTypeRef::create(mangledName);
-    }
-    case NodeKind::BuiltinTypeName: {
-      auto mangledName = Demangle::mangleNode(Node);
-      return BuiltinTypeRef::create(mangledName);
-    }
-    case NodeKind::ExistentialMetatype: {
-      auto instance = decodeDemangleNode(Node->getChild(0));
-      return ExistentialMetatypeTypeRef::create(instance);
-    }
-    case NodeKind::Metatype: {
-      auto instance = decodeDemangleNode(Node->getChild(0));
-      return MetatypeTypeRef::create(instance);
-    }
-    case NodeKind::Protocol: {
-      auto moduleName = Node->getChild(0)->getText();
-      auto name = Node->getChild(1)->getText();
-      return ProtocolTypeRef::create(moduleName, name);
-    }
-    case NodeKind::DependentGenericParamType: {
-      auto depth = Node->getChild(0)->getIndex();
-      auto index = Node->getChild(1)->getIndex();
-      return GenericTypeParameterTypeRef::create(index, depth);
-    }
-    case NodeKind::FunctionType: {
-      auto input = decodeDemangleNode(Node->getChild(0));
-      auto result = decodeDemangleNode(Node->getChild(1));
-      return FunctionTypeRef::create(input, result);
-    }
-    case NodeKind::ArgumentTuple:
-      return decodeDemangleNode(Node->getChild(0));
-    case NodeKind::ReturnType:
-      return decodeDemangleNode(Node->getChild(0));
-    case NodeKind::NonVariadicTuple: {
-      TypeRefVector Elements;
-      for (auto element : *Node)
-        Elements.push_back(decodeDemangleNode(element));
-      return TupleTypeRef::create(Elements);
-    }
-    case NodeKind::TupleElement:
-      return decodeDemangleNode(Node->getChild(0));
-    case NodeKind::DependentGenericType: {
-      return decodeDemangleNode(Node->getChild(1));
-    }
-    case NodeKind::DependentMemberType: {
-      auto member = decodeDemangleNode(Node->getChild(0));
-      auto base = decodeDemangleNode(Node->getChild(1));
-      return DependentMemberTypeRef::create(member, base);
-    }
-    case NodeKind::DependentAssociatedTypeRef:
-      return AssociatedTypeRef::create(Node->getText());
-    default:
-      return nullptr;
+class TypeRefIsConcrete
+  : public TypeRefVisitor<TypeRefIsConcrete, bool> {
+public:
+  bool visit(const TypeRef *TR) {
+    // The decoder leaves a child null if it couldn't decode it, and nothing
+    // is known about a type that couldn't be decoded.
+    if (TR == nullptr)
+      return false;
+    return TypeRefVisitor::visit(TR);
+  }
+
+  bool visitBuiltinTypeRef(const BuiltinTypeRef *B) {
+    return true;
+  }
+
+  bool visitNominalTypeRef(const NominalTypeRef *N) {
+    return true;
+  }
+
+  bool visitBoundGenericTypeRef(const BoundGenericTypeRef *BG) {
+    for (auto Param : BG->getGenericParams())
+      if (!visit(Param))
+        return false;
+    return true;
   }
+
+  bool visitTupleTypeRef(const TupleTypeRef *T) {
+    for (auto Element : T->getElements())
+      if (!visit(Element))
+        return false;
+    return true;
+  }
+
+  bool visitFunctionTypeRef(const FunctionTypeRef *F) {
+    return visit(F->getInput()) && visit(F->getResult());
+  }
+
+  bool visitProtocolTypeRef(const ProtocolTypeRef *P) {
+    return true;
+  }
+
+  bool
+  visitProtocolCompositionTypeRef(const ProtocolCompositionTypeRef *PC) {
+    for (auto Protocol : PC->getProtocols())
+      if (!visit(Protocol))
+        return false;
+    return true;
+  }
+
+  bool visitMetatypeTypeRef(const MetatypeTypeRef *M) {
+    return visit(M->getInstanceType());
+  }
+
+  bool
+  visitExistentialMetatypeTypeRef(const ExistentialMetatypeTypeRef *EM) {
+    return visit(EM->getInstanceType());
+  }
+
+  bool
+  visitGenericTypeParameterTypeRef(const GenericTypeParameterTypeRef *GTP) {
+    return false;
+  }
+
+  bool visitDependentMemberTypeRef(const DependentMemberTypeRef *DM) {
+    return false;
+  }
+
+  bool visitAssociatedTypeRef(const AssociatedTypeRef *AT) {
+    return true;
+  }
+};
+
+inline bool TypeRef::isConcrete() const {
+  return TypeRefIsConcrete().visit(this);
 }
 
 void TypeRef::dump() const {
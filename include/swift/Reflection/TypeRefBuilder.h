@@ -0,0 +1,366 @@
+//===--- TypeRefBuilder.h - Swift Type Reference Builder --------*- C++ -*-===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// Implements utilities for constructing TypeRefs. TypeRefs are hash-consed
+// and allocated in an arena owned by the builder.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SWIFT_REFLECTION_TYPEREFBUILDER_H
+#define SWIFT_REFLECTION_TYPEREFBUILDER_H
+
+#include "swift/Reflection/TypeRef.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Allocator.h"
+
+#include <cstring>
+
+namespace swift {
+namespace reflection {
+
+/// Creates and uniques TypeRefs.
+///
+/// Every TypeRef returned from a builder is allocated in the builder's arena
+/// and lives as long as the builder does. Structurally identical types are
+/// represented by a single node, so TypeRefs from the same builder can be
+/// compared by pointer.
+class TypeRefBuilder {
+  llvm::BumpPtrAllocator Allocator;
+
+#define TYPEREF(Id, Parent) \
+  llvm::FoldingSet<Id##TypeRef> Id##TypeRefs;
+#include "swift/Reflection/TypeRefs.def"
+
+  /// Cache of mangled type names that have already been decoded.
+  llvm::StringMap<const TypeRef *> DecodedTypes;
+
+  unsigned NumTypeRefs = 0;
+
+  StringRef persist(StringRef S) {
+    if (S.empty())
+      return StringRef();
+    auto Mem = static_cast<char *>(Allocator.Allocate(S.size(), 1));
+    memcpy(Mem, S.data(), S.size());
+    return StringRef(Mem, S.size());
+  }
+
+  TypeRefArray persist(TypeRefArray Elements) {
+    if (Elements.empty())
+      return TypeRefArray();
+    auto Mem = Allocator.Allocate<const TypeRef *>(Elements.size());
+    std::uninitialized_copy(Elements.begin(), Elements.end(), Mem);
+    return TypeRefArray(Mem, Elements.size());
+  }
+
+  template <typename T>
+  T persist(T Value) {
+    return Value;
+  }
+
+  /// Look up a TypeRef structurally identical to the one described by
+  /// \p Args, creating it if it does not exist yet.
+  ///
+  /// Strings and arrays are only copied into the arena when a new node is
+  /// created.
+  template <typename T, typename... Args>
+  const T *findOrCreate(llvm::FoldingSet<T> &Set, Args... args) {
+    llvm::FoldingSetNodeID ID;
+    T::Profile(ID, args...);
+
+    void *InsertPos = nullptr;
+    if (auto Existing = Set.FindNodeOrInsertPos(ID, InsertPos))
+      return Existing;
+
+    auto TR = new (Allocator.Allocate<T>()) T(persist(args)...);
+    Set.InsertNode(TR, InsertPos);
+    ++NumTypeRefs;
+    return TR;
+  }
+
+public:
+  TypeRefBuilder() = default;
+  TypeRefBuilder(const TypeRefBuilder &) = delete;
+  TypeRefBuilder &operator=(const TypeRefBuilder &) = delete;
+
+  const BuiltinTypeRef *createBuiltinType(StringRef MangledName) {
+    return findOrCreate(BuiltinTypeRefs, MangledName);
+  }
+
+  const NominalTypeRef *createNominalType(StringRef MangledName) {
+    return findOrCreate(NominalTypeRefs, MangledName);
+  }
+
+  const BoundGenericTypeRef *
+  createBoundGenericType(StringRef MangledName, TypeRefArray GenericParams) {
+    return findOrCreate(BoundGenericTypeRefs, MangledName, GenericParams);
+  }
+
+  const TupleTypeRef *createTupleType(TypeRefArray Elements) {
+    return findOrCreate(TupleTypeRefs, Elements);
+  }
+
+  const FunctionTypeRef *createFunctionType(const TypeRef *Input,
+                                            const TypeRef *Result) {
+    return findOrCreate(FunctionTypeRefs, Input, Result);
+  }
+
+  const ProtocolTypeRef *createProtocolType(StringRef ModuleName,
+                                            StringRef Name) {
+    return findOrCreate(ProtocolTypeRefs, ModuleName, Name);
+  }
+
+  const ProtocolCompositionTypeRef *
+  createProtocolCompositionType(TypeRefArray Protocols) {
+    return findOrCreate(ProtocolCompositionTypeRefs, Protocols);
+  }
+
+  const MetatypeTypeRef *createMetatypeType(const TypeRef *InstanceType,
+                                            bool WasAbstract = false) {
+    return findOrCreate(MetatypeTypeRefs, InstanceType, WasAbstract);
+  }
+
+  const ExistentialMetatypeTypeRef *
+  createExistentialMetatypeType(const TypeRef *InstanceType) {
+    return findOrCreate(ExistentialMetatypeTypeRefs, InstanceType);
+  }
+
+  const GenericTypeParameterTypeRef *
+  createGenericTypeParameterType(uint32_t Index, uint32_t Depth) {
+    return findOrCreate(GenericTypeParameterTypeRefs, Index, Depth);
+  }
+
+  const DependentMemberTypeRef *
+  createDependentMemberType(const TypeRef *Member, const TypeRef *Base) {
+    return findOrCreate(DependentMemberTypeRefs, Member, Base);
+  }
+
+  const AssociatedTypeRef *createAssociatedType(StringRef Name) {
+    return findOrCreate(AssociatedTypeRefs, Name);
+  }
+
+  /// Decode a demangle tree into a TypeRef, or return nullptr if the tree
+  /// does not describe a type this library understands.
+  const TypeRef *decodeDemangleNode(Demangle::NodePointer Node) {
+    using NodeKind = Demangle::Node::Kind;
+    if (!Node)
+      return nullptr;
+
+    switch (Node->getKind()) {
+      case NodeKind::Type:
+        return decodeDemangleNode(Node->getChild(0));
+      case NodeKind::BoundGenericClass:
+      case NodeKind::BoundGenericEnum:
+      case NodeKind::BoundGenericStructure: {
+        auto mangledName = Demangle::mangleNode(Node->getChild(0));
+        auto genericArgs = Node->getChild(1);
+        llvm::SmallVector<const TypeRef *, 4> Params;
+        for (auto genericArg : *genericArgs)
+          Params.push_back(decodeDemangleNode(genericArg));
+
+        return createBoundGenericType(mangledName, Params);
+      }
+      case NodeKind::Class:
+      case NodeKind::Enum:
+      case NodeKind::Structure: {
+        auto mangledName = Demangle::mangleNode(Node);
+        return createNominalType(mangledName);
+      }
+      case NodeKind::BuiltinTypeName: {
+        auto mangledName = Demangle::mangleNode(Node);
+        return createBuiltinType(mangledName);
+      }
+      case NodeKind::ExistentialMetatype: {
+        auto instance = decodeDemangleNode(Node->getChild(0));
+        return createExistentialMetatypeType(instance);
+      }
+      case NodeKind::Metatype: {
+        auto instance = decodeDemangleNode(Node->getChild(0));
+        return createMetatypeType(instance);
+      }
+      case NodeKind::Protocol: {
+        auto moduleName = Node->getChild(0)->getText();
+        auto name = Node->getChild(1)->getText();
+        return createProtocolType(moduleName, name);
+      }
+      case NodeKind::ProtocolList: {
+        // A single protocol is a protocol type; any other number of them,
+        // including none, is a composition.
+        auto TypeList = Node->getChild(0);
+        if (TypeList->getNumChildren() == 1)
+          return decodeDemangleNode(TypeList->getChild(0));
+
+        llvm::SmallVector<const TypeRef *, 4> Protocols;
+        for (auto Protocol : *TypeList)
+          Protocols.push_back(decodeDemangleNode(Protocol));
+        return createProtocolCompositionType(Protocols);
+      }
+      case NodeKind::DependentGenericParamType: {
+        auto depth = Node->getChild(0)->getIndex();
+        auto index = Node->getChild(1)->getIndex();
+        return createGenericTypeParameterType(index, depth);
+      }
+      case NodeKind::FunctionType: {
+        auto input = decodeDemangleNode(Node->getChild(0));
+        auto result = decodeDemangleNode(Node->getChild(1));
+        return createFunctionType(input, result);
+      }
+      case NodeKind::ArgumentTuple:
+        return decodeDemangleNode(Node->getChild(0));
+      case NodeKind::ReturnType:
+        return decodeDemangleNode(Node->getChild(0));
+      case NodeKind::NonVariadicTuple: {
+        llvm::SmallVector<const TypeRef *, 4> Elements;
+        for (auto element : *Node)
+          Elements.push_back(decodeDemangleNode(element));
+        return createTupleType(Elements);
+      }
+      case NodeKind::TupleElement:
+        return decodeDemangleNode(Node->getChild(0));
+      case NodeKind::DependentGenericType: {
+        return decodeDemangleNode(Node->getChild(1));
+      }
+      case NodeKind::DependentMemberType: {
+        auto member = decodeDemangleNode(Node->getChild(0));
+        auto base = decodeDemangleNode(Node->getChild(1));
+        return createDependentMemberType(member, base);
+      }
+      case NodeKind::DependentAssociatedTypeRef:
+        return createAssociatedType(Node->getText());
+      default:
+        return nullptr;
+    }
+  }
+
+  /// Decode a mangled type name into a TypeRef.
+  ///
+  /// Each distinct mangled name is only demangled once; later requests for
+  /// the same name return the cached node.
+  const TypeRef *decodeMangledType(StringRef MangledName) {
+    auto Found = DecodedTypes.find(MangledName);
+    if (Found != DecodedTypes.end())
+      return Found->getValue();
+
+    auto Node = Demangle::demangleTypeAsNode(MangledName.data(),
+                                             MangledName.size());
+    auto TR = decodeDemangleNode(Node);
+    DecodedTypes.insert({MangledName, TR});
+    return TR;
+  }
+
+  /// Returns the number of distinct TypeRefs created by this builder.
+  unsigned getNumTypeRefs() const {
+    return NumTypeRefs;
+  }
+
+  /// Returns the number of bytes allocated in the TypeRef arena.
+  size_t getTotalMemory() const {
+    return Allocator.getTotalMemory();
+  }
+};
+
+class TypeRefSubstitution
+  : public TypeRefVisitor<TypeRefSubstitution, const TypeRef *> {
+  TypeRefBuilder &Builder;
+  const GenericArgumentMap &Substitutions;
+
+  template <typename Range>
+  llvm::SmallVector<const TypeRef *, 4> substAll(const Range &TRs) {
+    llvm::SmallVector<const TypeRef *, 4> Result;
+    for (auto TR : TRs)
+      Result.push_back(visit(TR));
+    return Result;
+  }
+
+public:
+  TypeRefSubstitution(TypeRefBuilder &Builder,
+                      const GenericArgumentMap &Substitutions)
+    : Builder(Builder), Substitutions(Substitutions) {}
+
+  const TypeRef *visit(const TypeRef *TR) {
+    // Concrete types are unchanged by substitution.
+    if (TR == nullptr || TR->isConcrete())
+      return TR;
+    return TypeRefVisitor::visit(TR);
+  }
+
+  const TypeRef *visitBuiltinTypeRef(const BuiltinTypeRef *B) {
+    return B;
+  }
+
+  const TypeRef *visitNominalTypeRef(const NominalTypeRef *N) {
+    return N;
+  }
+
+  const TypeRef *visitBoundGenericTypeRef(const BoundGenericTypeRef *BG) {
+    return Builder.createBoundGenericType(BG->getMangledName(),
+                                          substAll(BG->getGenericParams()));
+  }
+
+  const TypeRef *visitTupleTypeRef(const TupleTypeRef *T) {
+    return Builder.createTupleType(substAll(T->getElements()));
+  }
+
+  const TypeRef *visitFunctionTypeRef(const FunctionTypeRef *F) {
+    return Builder.createFunctionType(visit(F->getInput()),
+                                      visit(F->getResult()));
+  }
+
+  const TypeRef *visitProtocolTypeRef(const ProtocolTypeRef *P) {
+    return P;
+  }
+
+  const TypeRef *
+  visitProtocolCompositionTypeRef(const ProtocolCompositionTypeRef *PC) {
+    return Builder.createProtocolCompositionType(
+      substAll(PC->getProtocols()));
+  }
+
+  const TypeRef *visitMetatypeTypeRef(const MetatypeTypeRef *M) {
+    // Only metatypes of generic types get here. Remember that, since it
+    // decides how the result is stored.
+    return Builder.createMetatypeType(visit(M->getInstanceType()),
+                                      /*WasAbstract=*/true);
+  }
+
+  const TypeRef *
+  visitExistentialMetatypeTypeRef(const ExistentialMetatypeTypeRef *EM) {
+    return Builder.createExistentialMetatypeType(
+      visit(EM->getInstanceType()));
+  }
+
+  const TypeRef *
+  visitGenericTypeParameterTypeRef(const GenericTypeParameterTypeRef *GTP) {
+    auto Found = Substitutions.find({GTP->getDepth(), GTP->getIndex()});
+    if (Found == Substitutions.end())
+      return GTP;
+    return Found->second;
+  }
+
+  const TypeRef *visitDependentMemberTypeRef(const DependentMemberTypeRef *DM) {
+    return Builder.createDependentMemberType(DM->getMember(),
+                                             visit(DM->getBase()));
+  }
+
+  const TypeRef *visitAssociatedTypeRef(const AssociatedTypeRef *AT) {
+    return AT;
+  }
+};
+
+inline const TypeRef *TypeRef::subst(TypeRefBuilder &Builder,
+                                     const GenericArgumentMap &Subs) const {
+  return TypeRefSubstitution(Builder, Subs).visit(this);
+}
+
+} // end namespace reflection
+} // end namespace swift
+
+#endif // SWIFT_REFLECTION_TYPEREFBUILDER_H
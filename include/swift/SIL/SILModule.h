@@ -569,6 +569,9 @@ public:
   /// Allocate memory for an instruction using the module's internal allocator.
   void *allocateInst(unsigned Size, unsigned Align) const;
 
+  /// Returns the memory allocated by the module's internal allocator.
+  size_t getAllocatedMemory() const { return BPA.getTotalMemory(); }
+
   /// Deallocate memory of an instruction.
   void deallocateInst(SILInstruction *I);
 
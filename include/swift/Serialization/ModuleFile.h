@@ -373,6 +373,9 @@ public:
     return FileContext->getParentModule();
   }
 
+  /// Returns the number of declarations that have been deserialized so far.
+  unsigned getNumDeclsDeserialized() const;
+
   FileUnit *getFile() const {
     assert(FileContext && "no associated context yet");
     return FileContext;
@@ -109,6 +109,10 @@ class SerializedASTFile final : public LoadedFile {
 public:
   bool isSIB() const { return IsSIB; }
 
+  /// Returns the number of declarations that have been deserialized from
+  /// this file so far.
+  unsigned getNumDeclsDeserialized() const;
+
   virtual bool isSystemModule() const override;
 
   virtual void lookupValue(Module::AccessPathTy accessPath,
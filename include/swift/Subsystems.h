@@ -22,6 +22,7 @@
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/StringRef.h"
 
 #include <memory>
@@ -113,6 +114,27 @@ namespace swift {
                            PersistentParserState *PersistentState = nullptr,
                            DelayedParsingCallbacks *DelayedParseCB = nullptr);
 
+  /// \brief Parse each of \p Files completely, as \c parseIntoSourceFile
+  /// would, on up to \p NumThreads threads at once.
+  ///
+  /// The files are parsed into per-thread arenas of their ASTContext, which
+  /// nothing else may use in the meantime.
+  ///
+  /// \param PersistentStates the state to parse each file with, which must be
+  /// different for each file.
+  ///
+  /// \param DelayedParseCBs the delayed parsing callbacks for each file, or
+  /// null. They are used from several threads at once.
+  ///
+  /// \param FileParsed called for each file in order once all of them have
+  /// been parsed, right after the diagnostics for that file are emitted.
+  void parseSourceFilesInParallel(
+      ArrayRef<SourceFile *> Files,
+      ArrayRef<PersistentParserState *> PersistentStates,
+      ArrayRef<DelayedParsingCallbacks *> DelayedParseCBs,
+      unsigned NumThreads,
+      llvm::function_ref<void(SourceFile &)> FileParsed);
+
   /// \brief Finish the parsing by going over the nodes that were delayed
   /// during the first parsing pass.
   void performDelayedParsing(DeclContext *DC,
@@ -153,7 +175,16 @@ namespace swift {
 
     /// Indicates that the type checker is checking code that will be
     /// immediately executed.
-    ForImmediateMode = 1 << 2
+    ForImmediateMode = 1 << 2,
+
+    /// Keep completing the types SILGen needs after an error has been
+    /// diagnosed, because outputs are still going to be produced for files
+    /// without errors, as in batch mode.
+    CompleteTypesAfterErrors = 1 << 3,
+
+    /// If set, every function body and expression is treated as taking
+    /// longer than the limits given to performTypeChecking.
+    DebugAlwaysWarnLongTypeChecking = 1 << 4
   };
 
   /// Once parsing and name-binding are complete, this walks the AST to resolve
@@ -161,9 +192,18 @@ namespace swift {
   ///
   /// \param StartElem Where to start for incremental type-checking in the main
   ///                  source file.
+  ///
+  /// \param WarnLongFunctionBodies If non-zero, warn when a function body
+  ///                  takes longer than this many milliseconds to type-check.
+  ///
+  /// \param WarnLongExpressionTypeChecking If non-zero, warn when an
+  ///                  expression takes longer than this many milliseconds to
+  ///                  type-check.
   void performTypeChecking(SourceFile &SF, TopLevelContext &TLC,
                            OptionSet<TypeCheckingFlags> Options,
-                           unsigned StartElem = 0);
+                           unsigned StartElem = 0,
+                           unsigned WarnLongFunctionBodies = 0,
+                           unsigned WarnLongExpressionTypeChecking = 0);
 
   /// Now that we have type-checked an entire module, perform any type
   /// checking that requires the full module, e.g., Objective-C method
@@ -29,12 +29,15 @@
 #include "swift/AST/NameLookup.h"
 #include "swift/AST/RawComment.h"
 #include "swift/AST/TypeCheckerDebugConsumer.h"
+#include "swift/Basic/ConcurrentStringTable.h"
 #include "swift/Basic/SourceManager.h"
 #include "swift/Basic/StringExtras.h"
 #include "clang/AST/DeclObjC.h"
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Lex/Preprocessor.h"
 #include "llvm/Support/Allocator.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/Mutex.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringSwitch.h"
@@ -76,13 +79,33 @@ struct ASTContext::Implementation {
 
   llvm::BumpPtrAllocator Allocator; // used in later initializations
 
+  /// The allocators installed by \c ThreadArenaRAII objects, which live as
+  /// long as the context.
+  std::vector<std::unique_ptr<llvm::BumpPtrAllocator>> ThreadArenas;
+
+  /// The allocators in \c ThreadArenas that no \c ThreadArenaRAII is using,
+  /// and which the next one to be created will reuse.
+  std::vector<llvm::BumpPtrAllocator *> IdleThreadArenas;
+
+  /// Whether several threads may be using the context at once.
+  ///
+  /// \sa ConcurrentASTContextRAII
+  bool IsConcurrent = false;
+
+  /// Guards the tables that are shared between threads while
+  /// \c IsConcurrent is set, other than \c IdentifierTable, which does its
+  /// own locking.
+  llvm::sys::Mutex ConcurrentLock;
+
   /// The set of cleanups to be called when the ASTContext is destroyed.
   std::vector<std::function<void(void)>> Cleanups;
 
   /// The last resolver.
   LazyResolver *Resolver = nullptr;
 
-  llvm::StringMap<char, llvm::BumpPtrAllocator&> IdentifierTable;
+  /// The interned text of every identifier. Looking up an identifier that
+  /// already exists doesn't take a lock, even while \c IsConcurrent is set.
+  ConcurrentStringTable IdentifierTable;
 
   /// The declaration of Swift.Bool.
   NominalTypeDecl *BoolDecl = nullptr;
@@ -368,13 +391,76 @@ struct ASTContext::Implementation {
   }
 };
 
-ASTContext::Implementation::Implementation()
- : IdentifierTable(Allocator) {}
+ASTContext::Implementation::Implementation() {}
 ASTContext::Implementation::~Implementation() {
   for (auto &cleanup : Cleanups)
     cleanup();
 }
 
+namespace {
+  /// Holds the lock on the context's shared tables if several threads may be
+  /// using them, and does nothing otherwise.
+  class ConcurrentAccessLock {
+    llvm::sys::Mutex *Lock;
+
+  public:
+    explicit ConcurrentAccessLock(ASTContext::Implementation &impl)
+      : Lock(impl.IsConcurrent ? &impl.ConcurrentLock : nullptr) {
+      if (Lock)
+        Lock->lock();
+    }
+
+    ConcurrentAccessLock(const ConcurrentAccessLock &) = delete;
+    ConcurrentAccessLock &operator=(const ConcurrentAccessLock &) = delete;
+
+    ~ConcurrentAccessLock() {
+      if (Lock)
+        Lock->unlock();
+    }
+  };
+}
+
+/// The context whose permanent allocations this thread currently directs into
+/// its own arena, if any, and that arena.
+static LLVM_THREAD_LOCAL const ASTContext *ThreadArenaContext = nullptr;
+static LLVM_THREAD_LOCAL llvm::BumpPtrAllocator *ThreadArena = nullptr;
+
+ConcurrentASTContextRAII::ConcurrentASTContextRAII(ASTContext &self)
+  : Self(self) {
+  assert(!Self.Impl.IsConcurrent && "context is already used concurrently");
+  Self.Impl.IsConcurrent = true;
+  Self.Impl.IdentifierTable.setThreadSafe(true);
+}
+
+ConcurrentASTContextRAII::~ConcurrentASTContextRAII() {
+  Self.Impl.IdentifierTable.setThreadSafe(false);
+  Self.Impl.IsConcurrent = false;
+}
+
+ThreadArenaRAII::ThreadArenaRAII(ASTContext &self)
+  : Self(self), PrevContext(ThreadArenaContext), PrevAllocator(ThreadArena) {
+  {
+    ConcurrentAccessLock lock(self.Impl);
+    if (self.Impl.IdleThreadArenas.empty()) {
+      Allocator = new llvm::BumpPtrAllocator();
+      self.Impl.ThreadArenas.emplace_back(Allocator);
+    } else {
+      Allocator = self.Impl.IdleThreadArenas.back();
+      self.Impl.IdleThreadArenas.pop_back();
+    }
+  }
+  ThreadArenaContext = &self;
+  ThreadArena = Allocator;
+}
+
+ThreadArenaRAII::~ThreadArenaRAII() {
+  ThreadArenaContext = PrevContext;
+  ThreadArena = PrevAllocator;
+
+  ConcurrentAccessLock lock(Self.Impl);
+  Self.Impl.IdleThreadArenas.push_back(Allocator);
+}
+
 ConstraintCheckerArenaRAII::
 ConstraintCheckerArenaRAII(ASTContext &self, llvm::BumpPtrAllocator &allocator,
                            GetTypeVariableMemberCallback getTypeMember)
@@ -453,6 +539,11 @@ ASTContext::~ASTContext() {
 llvm::BumpPtrAllocator &ASTContext::getAllocator(AllocationArena arena) const {
   switch (arena) {
   case AllocationArena::Permanent:
+    if (Impl.IsConcurrent) {
+      assert(ThreadArenaContext == this &&
+             "allocating concurrently without a ThreadArenaRAII");
+      return *ThreadArena;
+    }
     return Impl.Allocator;
 
   case AllocationArena::ConstraintSolver:
@@ -483,8 +574,7 @@ Identifier ASTContext::getIdentifier(StringRef Str) const {
   // Make sure null pointers stay null.
   if (Str.data() == nullptr) return Identifier(0);
 
-  auto I = Impl.IdentifierTable.insert(std::make_pair(Str, char())).first;
-  return Identifier(I->getKeyData());
+  return Identifier(Impl.IdentifierTable.intern(Str));
 }
 
 void ASTContext::lookupInSwiftModule(
@@ -1187,6 +1277,7 @@ void ASTContext::addExternalDecl(Decl *decl) {
 }
 
 void ASTContext::addCleanup(std::function<void(void)> cleanup) {
+  ConcurrentAccessLock lock(Impl);
   Impl.Cleanups.push_back(std::move(cleanup));
 }
 
@@ -1462,6 +1553,7 @@ void ASTContext::setBriefComment(const Decl *D, StringRef Comment) {
 
 unsigned ValueDecl::getLocalDiscriminator() const {
   assert(getDeclContext()->isLocalContext());
+  ConcurrentAccessLock lock(getASTContext().Impl);
   auto &discriminators = getASTContext().Impl.LocalDiscriminators;
   auto it = discriminators.find(this);
   if (it == discriminators.end())
@@ -1475,12 +1567,16 @@ void ValueDecl::setLocalDiscriminator(unsigned index) {
     assert(!getASTContext().Impl.LocalDiscriminators.count(this));
     return;
   }
+  ConcurrentAccessLock lock(getASTContext().Impl);
   getASTContext().Impl.LocalDiscriminators.insert({this, index});
 }
 
 PatternBindingInitializer *
 ASTContext::createPatternBindingContext(DeclContext *parent) {
-  // Check for an existing context we can re-use.
+  // Check for an existing context we can re-use. There is only one, so
+  // threads parsing concurrently don't share it.
+  if (Impl.IsConcurrent)
+    return new (*this) PatternBindingInitializer(parent);
   if (auto existing = Impl.UnusedPatternBindingContext) {
     Impl.UnusedPatternBindingContext = nullptr;
     existing->reset(parent);
@@ -1491,12 +1587,15 @@ ASTContext::createPatternBindingContext(DeclContext *parent) {
 }
 void ASTContext::destroyPatternBindingContext(PatternBindingInitializer *DC) {
   // There isn't much value in caching more than one of these.
-  Impl.UnusedPatternBindingContext = DC;
+  if (!Impl.IsConcurrent)
+    Impl.UnusedPatternBindingContext = DC;
 }
 
 DefaultArgumentInitializer *
 ASTContext::createDefaultArgumentContext(DeclContext *fn, unsigned index) {
-  // Check for an existing context we can re-use.
+  // Check for an existing context we can re-use, as above.
+  if (Impl.IsConcurrent)
+    return new (*this) DefaultArgumentInitializer(fn, index);
   if (auto existing = Impl.UnusedDefaultArgumentContext) {
     Impl.UnusedDefaultArgumentContext = nullptr;
     existing->reset(fn, index);
@@ -1507,7 +1606,8 @@ ASTContext::createDefaultArgumentContext(DeclContext *fn, unsigned index) {
 }
 void ASTContext::destroyDefaultArgumentContext(DefaultArgumentInitializer *DC) {
   // There isn't much value in caching more than one of these.
-  Impl.UnusedDefaultArgumentContext = DC;
+  if (!Impl.IsConcurrent)
+    Impl.UnusedDefaultArgumentContext = DC;
 }
 
 NormalProtocolConformance *
@@ -1634,6 +1734,7 @@ size_t ASTContext::getTotalMemory() const {
     // RemappedTypes ?
     sizeof(Impl) +
     Impl.Allocator.getTotalMemory() +
+    Impl.IdentifierTable.getMemorySize() +
     Impl.Cleanups.capacity() +
     llvm::capacity_in_bytes(Impl.ModuleLoaders) +
     llvm::capacity_in_bytes(Impl.RawComments) +
@@ -1653,6 +1754,9 @@ size_t ASTContext::getTotalMemory() const {
     Impl.OpenedExistentialArchetypes.getMemorySize() +
     Impl.Permanent.getTotalMemory();
 
+    for (auto &arena : Impl.ThreadArenas)
+      Size += arena->getTotalMemory();
+
     Size += getSolverMemory();
 
     return Size;
@@ -3526,6 +3630,7 @@ void DeclName::initialize(ASTContext &C, Identifier baseName,
   llvm::FoldingSetNodeID id;
   CompoundDeclName::Profile(id, baseName, argumentNames);
 
+  ConcurrentAccessLock lock(C.Impl);
   void *insert = nullptr;
   if (CompoundDeclName *compoundName
         = C.Impl.CompoundNames.FindNodeOrInsertPos(id, insert)) {
@@ -562,6 +562,21 @@ void DiagnosticEngine::emitTentativeDiagnostics() {
   TentativeDiagnostics.clear();
 }
 
+void DiagnosticEngine::emitFormattedDiagnostic(SourceLoc loc, StringRef text,
+                                               const DiagnosticInfo &info) {
+  assert(!ActiveDiagnostic && "Already have an active diagnostic");
+  assert(TransactionCount == 0 &&
+         "formatted diagnostics can't be part of a transaction");
+  auto behavior = state.determineBehavior(info.ID);
+  if (behavior == DiagnosticState::Behavior::Ignore)
+    return;
+
+  for (auto &Consumer : Consumers) {
+    Consumer->handleDiagnostic(SourceMgr, loc, toDiagnosticKind(behavior), text,
+                               info);
+  }
+}
+
 void DiagnosticEngine::emitDiagnostic(const Diagnostic &diagnostic) {
   auto behavior = state.determineBehavior(diagnostic.getID());
   if (behavior == DiagnosticState::Behavior::Ignore)
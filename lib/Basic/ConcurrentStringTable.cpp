@@ -0,0 +1,222 @@
+//===--- ConcurrentStringTable.cpp - Thread-safe string interning ---------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// Each shard is an open-addressed hash table of pointers to entries. Readers
+// load the current bucket array and probe it without locking. Writers, which
+// are serialized by the shard's lock, publish a new entry by storing its
+// pointer into an empty bucket; when the array gets too full they publish a
+// bigger copy of it instead. Old arrays are kept until the table is
+// destroyed, since readers may still be probing them. A reader that probes
+// an old array may therefore miss a string that is being added at the same
+// time, which is no different from looking just before it was added; intern
+// looks again under the lock before adding anything, so it never adds a
+// string twice.
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/Basic/ConcurrentStringTable.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/Mutex.h"
+
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <vector>
+
+using namespace swift;
+
+namespace {
+  /// An interned string, which is stored right after the entry.
+  struct alignas(ConcurrentStringTable::StringAlignment) Entry {
+    uint32_t Hash;
+    uint32_t Length;
+
+    const char *getString() const {
+      return reinterpret_cast<const char *>(this + 1);
+    }
+
+    StringRef getKey() const {
+      return StringRef(getString(), Length);
+    }
+  };
+
+  static_assert(sizeof(Entry) % ConcurrentStringTable::StringAlignment == 0,
+                "strings must follow their entries at the right alignment");
+
+  /// A power-of-two sized array of buckets.
+  struct BucketArray {
+    unsigned Mask;
+    std::unique_ptr<std::atomic<const Entry *>[]> Buckets;
+
+    explicit BucketArray(unsigned numBuckets)
+      : Mask(numBuckets - 1),
+        Buckets(new std::atomic<const Entry *>[numBuckets]()) {}
+
+    /// Returns the entry for \p str, or null if it isn't in this array.
+    const Entry *find(StringRef str, uint32_t hash) const {
+      for (unsigned i = getFirstBucket(hash), probe = 1; ;
+           i = (i + probe++) & Mask) {
+        const Entry *entry = Buckets[i].load(std::memory_order_acquire);
+        if (!entry)
+          return nullptr;
+        if (entry->Hash == hash && entry->getKey() == str)
+          return entry;
+      }
+    }
+
+    /// Stores \p entry in the first empty bucket for its hash. Only one
+    /// thread may insert at a time.
+    void insert(const Entry *entry) {
+      for (unsigned i = getFirstBucket(entry->Hash), probe = 1; ;
+           i = (i + probe++) & Mask) {
+        if (!Buckets[i].load(std::memory_order_relaxed)) {
+          Buckets[i].store(entry, std::memory_order_release);
+          return;
+        }
+      }
+    }
+
+  private:
+    unsigned getFirstBucket(uint32_t hash) const {
+      // The low bits of the hash pick the shard.
+      return (hash / ConcurrentStringTable::NumShards) & Mask;
+    }
+  };
+
+  /// Holds a shard's lock if the table is in thread-safe mode, and does
+  /// nothing otherwise.
+  class ShardLock {
+    llvm::sys::Mutex *Lock;
+
+  public:
+    ShardLock(llvm::sys::Mutex &lock, bool threadSafe)
+      : Lock(threadSafe ? &lock : nullptr) {
+      if (Lock)
+        Lock->lock();
+    }
+
+    ShardLock(const ShardLock &) = delete;
+    ShardLock &operator=(const ShardLock &) = delete;
+
+    ~ShardLock() {
+      if (Lock)
+        Lock->unlock();
+    }
+  };
+}
+
+static uint32_t hashString(StringRef str) {
+  return static_cast<uint32_t>(llvm::hash_value(str));
+}
+
+struct ConcurrentStringTable::Shard {
+  enum : unsigned { InitialNumBuckets = 64 };
+
+  /// The array that lookups probe, which is the last one in \c Arrays.
+  std::atomic<const BucketArray *> Current;
+
+  /// Every bucket array the shard has had. Guarded by \c Lock.
+  std::vector<std::unique_ptr<BucketArray>> Arrays;
+
+  /// The number of entries in the shard. Guarded by \c Lock.
+  unsigned NumEntries = 0;
+
+  /// Holds the entries. Guarded by \c Lock.
+  llvm::BumpPtrAllocator Allocator;
+
+  llvm::sys::Mutex Lock;
+
+  Shard() {
+    Arrays.emplace_back(new BucketArray(InitialNumBuckets));
+    Current.store(Arrays.back().get(), std::memory_order_relaxed);
+  }
+
+  /// Replaces the current bucket array with one twice its size.
+  void grow() {
+    const BucketArray &old = *Arrays.back();
+    std::unique_ptr<BucketArray> bigger(new BucketArray((old.Mask + 1) * 2));
+    for (unsigned i = 0; i <= old.Mask; ++i)
+      if (const Entry *entry = old.Buckets[i].load(std::memory_order_relaxed))
+        bigger->insert(entry);
+    Arrays.push_back(std::move(bigger));
+    Current.store(Arrays.back().get(), std::memory_order_release);
+  }
+};
+
+ConcurrentStringTable::ConcurrentStringTable() : Shards(new Shard[NumShards]) {}
+
+ConcurrentStringTable::~ConcurrentStringTable() = default;
+
+const char *ConcurrentStringTable::lookup(StringRef str) const {
+  uint32_t hash = hashString(str);
+  const Shard &shard = Shards[hash % NumShards];
+  const BucketArray *array = shard.Current.load(std::memory_order_acquire);
+  if (const Entry *entry = array->find(str, hash))
+    return entry->getString();
+  return nullptr;
+}
+
+const char *ConcurrentStringTable::intern(StringRef str) {
+  uint32_t hash = hashString(str);
+  Shard &shard = Shards[hash % NumShards];
+
+  // Most strings are already in the table.
+  const BucketArray *array = shard.Current.load(std::memory_order_acquire);
+  if (const Entry *entry = array->find(str, hash))
+    return entry->getString();
+
+  ShardLock lock(shard.Lock, ThreadSafe);
+
+  // Another thread may have added the string, or grown the array, since.
+  BucketArray *current = shard.Arrays.back().get();
+  if (const Entry *entry = current->find(str, hash))
+    return entry->getString();
+
+  // Keep the array at most three quarters full, so that probes stay short
+  // and always reach an empty bucket.
+  if ((shard.NumEntries + 1) * 4 > (current->Mask + 1) * 3) {
+    shard.grow();
+    current = shard.Arrays.back().get();
+  }
+
+  void *mem = shard.Allocator.Allocate(sizeof(Entry) + str.size() + 1,
+                                       StringAlignment);
+  auto *entry = new (mem) Entry{hash, static_cast<uint32_t>(str.size())};
+  char *chars = const_cast<char *>(entry->getString());
+  if (!str.empty())
+    memcpy(chars, str.data(), str.size());
+  chars[str.size()] = '\0';
+
+  current->insert(entry);
+  ++shard.NumEntries;
+  return entry->getString();
+}
+
+size_t ConcurrentStringTable::size() const {
+  size_t result = 0;
+  for (unsigned i = 0; i != NumShards; ++i)
+    result += Shards[i].NumEntries;
+  return result;
+}
+
+size_t ConcurrentStringTable::getMemorySize() const {
+  size_t result = sizeof(Shard) * NumShards;
+  for (unsigned i = 0; i != NumShards; ++i) {
+    const Shard &shard = Shards[i];
+    result += shard.Allocator.getTotalMemory();
+    for (auto &array : shard.Arrays)
+      result += sizeof(BucketArray) +
+                (array->Mask + 1) * sizeof(std::atomic<const Entry *>);
+  }
+  return result;
+}
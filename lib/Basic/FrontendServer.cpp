@@ -0,0 +1,31 @@
+//===--- FrontendServer.cpp - Protocol of the frontend server -------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief This file includes the appropriate platform-specific implementation
+/// of the frontend server protocol (or a fallback that never connects if one
+/// is not available).
+///
+//===----------------------------------------------------------------------===//
+
+#include "swift/Basic/FrontendServer.h"
+#include "llvm/Config/config.h"
+
+using namespace swift;
+using namespace swift::sys;
+
+// Include the correct FrontendServer implementation.
+#if LLVM_ON_UNIX && !defined(__CYGWIN__)
+#include "Unix/FrontendServer.inc"
+#else
+#include "Default/FrontendServer.inc"
+#endif
@@ -0,0 +1,40 @@
+//===--- JobServer.cpp - Client for a make-compatible jobserver -----------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief This file includes the appropriate platform-specific JobServer
+/// implementation (or a fallback that never connects if one is not
+/// available), as well as any platform-agnostic JobServer functionality.
+///
+//===----------------------------------------------------------------------===//
+
+#include "swift/Basic/JobServer.h"
+#include "llvm/Config/config.h"
+
+#include <cstdlib>
+
+using namespace swift;
+using namespace swift::sys;
+
+// Include the correct JobServer implementation.
+#if LLVM_ON_UNIX && !defined(__CYGWIN__)
+#include "Unix/JobServer.inc"
+#else
+#include "Default/JobServer.inc"
+#endif
+
+std::unique_ptr<JobServer> JobServer::connectFromEnvironment() {
+  const char *MakeFlags = getenv("MAKEFLAGS");
+  if (!MakeFlags)
+    return nullptr;
+  return connect(MakeFlags);
+}
@@ -59,11 +59,36 @@ unsigned SourceManager::addMemBufferCopy(StringRef InputData,
   return addNewSourceBuffer(std::move(Buffer));
 }
 
+unsigned SourceManager::addMemBufferRef(const llvm::MemoryBuffer *Buffer) {
+  auto ID = addNewSourceBuffer(
+      llvm::MemoryBuffer::getMemBuffer(Buffer->getMemBufferRef(),
+                                       /*RequiresNullTerminator=*/true));
+  BorrowedBufferIDs.insert(ID);
+  return ID;
+}
+
+SourceManager::BufferMemoryUsage SourceManager::getBufferMemoryUsage() const {
+  BufferMemoryUsage Usage;
+  for (unsigned i = 1, e = LLVMSourceMgr.getNumBuffers(); i <= e; ++i) {
+    auto *Buffer = LLVMSourceMgr.getMemoryBuffer(i);
+    size_t Size = Buffer->getBufferSize();
+    if (BorrowedBufferIDs.count(i))
+      Usage.BorrowedBytes += Size;
+    else if (Buffer->getBufferKind() == llvm::MemoryBuffer::MemoryBuffer_MMap)
+      Usage.MMapBytes += Size;
+    else
+      Usage.MallocBytes += Size;
+  }
+  return Usage;
+}
+
 bool SourceManager::openVirtualFile(SourceLoc loc, StringRef name,
                                     int lineOffset) {
   CharSourceRange fullRange = getRangeForBuffer(findBufferContainingLoc(loc));
   SourceLoc end;
 
+  llvm::sys::ScopedLock Lock(LineLookupLock);
+
   auto nextRangeIter = VirtualFiles.upper_bound(loc.Value.getPointer());
   if (nextRangeIter != VirtualFiles.end() &&
       fullRange.contains(nextRangeIter->second.Range.getStart())) {
@@ -87,6 +112,7 @@ bool SourceManager::openVirtualFile(SourceLoc loc, StringRef name,
 }
 
 void SourceManager::closeVirtualFile(SourceLoc end) {
+  llvm::sys::ScopedLock Lock(LineLookupLock);
   auto *virtualFile = const_cast<VirtualFile *>(getVirtualFile(end));
   if (!virtualFile) {
 #ifndef NDEBUG
@@ -115,6 +141,7 @@ const SourceManager::VirtualFile *
 SourceManager::getVirtualFile(SourceLoc Loc) const {
   const char *p = Loc.Value.getPointer();
 
+  llvm::sys::ScopedLock Lock(LineLookupLock);
   if (CachedVFile.first == p)
     return CachedVFile.second;
 
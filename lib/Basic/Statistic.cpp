@@ -0,0 +1,137 @@
+//===--- Statistic.cpp - Counters collected for one compiler job ----------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/Basic/Statistic.h"
+#include "swift/Basic/JSONSerialization.h"
+#include "swift/Basic/Timer.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <cctype>
+
+using namespace swift;
+
+namespace {
+/// Everything that goes in a stats file, by name.
+struct StatsFile {
+  std::map<std::string, uint64_t> Counters;
+  std::map<std::string, double> Timers;
+};
+} // end anonymous namespace
+
+namespace swift {
+namespace json {
+template<>
+struct ObjectTraits<StatsFile> {
+  static void mapping(Output &out, StatsFile &file) {
+    for (auto &entry : file.Counters)
+      out.mapRequired(entry.first.c_str(), entry.second);
+    for (auto &entry : file.Timers)
+      out.mapRequired(entry.first.c_str(), entry.second);
+  }
+};
+} // end namespace json
+} // end namespace swift
+
+/// Replaces the characters of \p name that may not be safe in a file name.
+static std::string cleanForFilename(StringRef name) {
+  std::string result;
+  for (char c : name) {
+    if (isalnum(c) || c == '-' || c == '_' || c == '.')
+      result.push_back(c);
+    else
+      result.push_back('_');
+  }
+  return result;
+}
+
+UnifiedStatsReporter::UnifiedStatsReporter(StringRef programName,
+                                           StringRef moduleName,
+                                           StringRef inputName,
+                                           StringRef directory)
+  : ProgramName(programName.str()), Directory(directory.str()),
+    StartTime(std::chrono::steady_clock::now()) {
+  FilenameModel = "stats-" + cleanForFilename(programName) + "-" +
+                  cleanForFilename(moduleName) + "-" +
+                  cleanForFilename(llvm::sys::path::filename(inputName)) +
+                  "-%%%%%%%%.json";
+  SharedTimer::enableTotals();
+}
+
+UnifiedStatsReporter::~UnifiedStatsReporter() {
+  if (write()) {
+    llvm::errs() << "error: unable to write statistics to '" << Directory
+                 << "'\n";
+  }
+}
+
+UnifiedStatsReporter::DriverCounters &
+UnifiedStatsReporter::getDriverCounters() {
+  if (!Driver)
+    Driver.reset(new DriverCounters());
+  return *Driver;
+}
+
+UnifiedStatsReporter::FrontendCounters &
+UnifiedStatsReporter::getFrontendCounters() {
+  if (!Frontend)
+    Frontend.reset(new FrontendCounters());
+  return *Frontend;
+}
+
+void UnifiedStatsReporter::setCounter(StringRef name, uint64_t value) {
+  ExtraCounters[name.str()] = value;
+}
+
+bool UnifiedStatsReporter::write() {
+  StatsFile file;
+  if (Driver) {
+#define DRIVER_STATISTIC(ID) file.Counters["Driver." #ID] = Driver->ID;
+#include "swift/Basic/Statistics.def"
+  }
+  if (Frontend) {
+#define FRONTEND_STATISTIC(TYPE, ID) \
+    file.Counters[#TYPE "." #ID] = Frontend->ID;
+#include "swift/Basic/Statistics.def"
+  }
+  for (auto &entry : ExtraCounters)
+    file.Counters[entry.first] = entry.second;
+
+  SharedTimer::forEachTotal([&](StringRef name, double seconds) {
+    file.Timers["time.swift." + name.str() + ".wall"] = seconds;
+  });
+  std::chrono::duration<double> lifetime =
+    std::chrono::steady_clock::now() - StartTime;
+  file.Timers["time." + ProgramName + ".wall"] = lifetime.count();
+
+  if (llvm::sys::fs::create_directories(Directory))
+    return true;
+
+  SmallString<128> path(Directory);
+  llvm::sys::path::append(path, FilenameModel);
+  int fd;
+  if (llvm::sys::fs::createUniqueFile(path, fd, path))
+    return true;
+
+  llvm::raw_fd_ostream os(fd, /*shouldClose=*/true);
+  json::Output out(os);
+  out << file;
+  os << '\n';
+  os.close();
+  if (os.has_error()) {
+    os.clear_error();
+    return true;
+  }
+  return false;
+}
@@ -11,7 +11,193 @@
 //===----------------------------------------------------------------------===//
 
 #include "swift/Basic/Timer.h"
+#include "swift/Basic/JSONSerialization.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/Mutex.h"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <tuple>
+#include <vector>
 
 using namespace swift;
 
 SharedTimer::State SharedTimer::CompilationTimersEnabled = State::Initial;
+bool SharedTimer::TotalsEnabled = false;
+
+namespace {
+/// The time spent in the SharedTimers with each name.
+struct TimerTotals {
+  llvm::sys::Mutex Lock;
+  std::map<StringRef, std::chrono::steady_clock::duration> Totals;
+};
+} // end anonymous namespace
+
+static TimerTotals &getTimerTotals() {
+  static TimerTotals totals;
+  return totals;
+}
+
+void SharedTimer::addToTotal() {
+  auto duration = std::chrono::steady_clock::now() - TotalStart;
+  TimerTotals &totals = getTimerTotals();
+  llvm::sys::ScopedLock lock(totals.Lock);
+  totals.Totals[TotalName] += duration;
+}
+
+void SharedTimer::forEachTotal(
+    llvm::function_ref<void(StringRef name, double seconds)> fn) {
+  using namespace std::chrono;
+  TimerTotals &totals = getTimerTotals();
+  llvm::sys::ScopedLock lock(totals.Lock);
+  for (auto &entry : totals.Totals)
+    fn(entry.first, duration_cast<duration<double>>(entry.second).count());
+}
+
+namespace {
+/// A span recorded by a CompileTimeTraceScope. Times are in microseconds
+/// since the trace was enabled.
+struct TraceEvent {
+  std::string Name;
+  std::string Detail;
+  uint64_t Start;
+  uint64_t Duration;
+  uint32_t Thread;
+};
+
+/// The whole trace, as it is written out.
+struct Trace {
+  std::vector<TraceEvent> Events;
+};
+
+struct TraceEventArgs {
+  std::string Detail;
+};
+} // end anonymous namespace
+
+namespace swift {
+namespace json {
+template<>
+struct ObjectTraits<TraceEventArgs> {
+  static void mapping(Output &out, TraceEventArgs &args) {
+    out.mapRequired("detail", args.Detail);
+  }
+};
+
+template<>
+struct ObjectTraits<TraceEvent> {
+  static void mapping(Output &out, TraceEvent &event) {
+    // Every span is a "complete" event, with both a start and a duration.
+    std::string phase = "X";
+    uint32_t process = 1;
+    out.mapRequired("ph", phase);
+    out.mapRequired("name", event.Name);
+    out.mapRequired("ts", event.Start);
+    out.mapRequired("dur", event.Duration);
+    out.mapRequired("pid", process);
+    out.mapRequired("tid", event.Thread);
+    if (!event.Detail.empty()) {
+      TraceEventArgs args{event.Detail};
+      out.mapRequired("args", args);
+    }
+  }
+};
+
+template<>
+struct ArrayTraits<std::vector<TraceEvent>> {
+  static size_t size(Output &out, std::vector<TraceEvent> &seq) {
+    return seq.size();
+  }
+
+  static TraceEvent &element(Output &out, std::vector<TraceEvent> &seq,
+                             size_t index) {
+    return seq[index];
+  }
+};
+
+template<>
+struct ObjectTraits<Trace> {
+  static void mapping(Output &out, Trace &trace) {
+    out.mapRequired("traceEvents", trace.Events);
+  }
+};
+} // end namespace json
+} // end namespace swift
+
+bool CompileTimeTrace::Enabled = false;
+
+namespace {
+/// The spans recorded so far, and when the trace was started.
+struct TraceState {
+  std::chrono::steady_clock::time_point Start;
+  std::chrono::microseconds Granularity;
+  llvm::sys::Mutex Lock;
+  std::vector<TraceEvent> Events;
+};
+} // end anonymous namespace
+
+static TraceState &getTraceState() {
+  static TraceState state;
+  return state;
+}
+
+/// Numbers the threads that record spans, in the order they first do so.
+static std::atomic<uint32_t> NextTraceThread(1);
+static LLVM_THREAD_LOCAL uint32_t TraceThread = 0;
+
+void CompileTimeTrace::enable(unsigned granularity) {
+  TraceState &state = getTraceState();
+  state.Start = std::chrono::steady_clock::now();
+  state.Granularity = std::chrono::microseconds(granularity);
+  Enabled = true;
+}
+
+void CompileTimeTrace::write(raw_ostream &os) {
+  TraceState &state = getTraceState();
+  Trace trace;
+  {
+    llvm::sys::ScopedLock lock(state.Lock);
+    trace.Events = state.Events;
+  }
+
+  // Spans are recorded when they end, so inner spans come before the ones
+  // containing them. Put them in the order they started instead.
+  std::sort(trace.Events.begin(), trace.Events.end(),
+            [](const TraceEvent &lhs, const TraceEvent &rhs) {
+    return std::make_tuple(lhs.Thread, lhs.Start, rhs.Duration) <
+           std::make_tuple(rhs.Thread, rhs.Start, lhs.Duration);
+  });
+
+  json::Output out(os, /*PrettyPrint=*/false);
+  out << trace;
+  os << '\n';
+}
+
+void CompileTimeTraceScope::begin(StringRef name, std::string &&detail) {
+  Name = name.str();
+  Detail = std::move(detail);
+  Active = true;
+  Start = std::chrono::steady_clock::now();
+}
+
+void CompileTimeTraceScope::end() {
+  using namespace std::chrono;
+  TraceState &state = getTraceState();
+  auto duration = steady_clock::now() - Start;
+  if (duration < state.Granularity)
+    return;
+
+  if (TraceThread == 0)
+    TraceThread = NextTraceThread++;
+
+  TraceEvent event;
+  event.Name = std::move(Name);
+  event.Detail = std::move(Detail);
+  event.Start = duration_cast<microseconds>(Start - state.Start).count();
+  event.Duration = duration_cast<microseconds>(duration).count();
+  event.Thread = TraceThread;
+
+  llvm::sys::ScopedLock lock(state.Lock);
+  state.Events.push_back(std::move(event));
+}
@@ -0,0 +1,594 @@
+//===--- BinaryDependencies.cpp - Binary dependency file format -----------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/Driver/BinaryDependencies.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/YAMLParser.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <cstring>
+
+using namespace swift;
+using namespace swift::binary_deps;
+
+// The on-disk layout, shared by both kinds of file:
+//
+//   Header       magic[4], u16 version, u16 reserved,
+//                u32 numStrings, u32 numRecords, u32 stringDataSize,
+//                u32 reserved
+//   Info         kind-specific, fixed size
+//   Strings      numStrings x (u32 offset, u32 length)
+//   Records      numRecords x kind-specific, fixed size
+//   StringData   stringDataSize bytes; each string is followed by a NUL
+namespace {
+  const char DependencyFileMagic[4] = { 'S', 'D', 'E', 'P' };
+  const char BuildRecordMagic[4] = { 'S', 'R', 'E', 'C' };
+
+  const size_t HeaderSize = 24;
+  const size_t StringEntrySize = 8;
+
+  // Dependency file info: u32 interfaceHash, u32 sectionMask.
+  const size_t DependencyInfoSize = 8;
+  // Dependency record: u8 section, u8 isCascading, u16 reserved, u32 name,
+  //                    u32 fingerprint.
+  const size_t DependencyRecordSize = 12;
+
+  // Build record info: u32 version, u32 options,
+  //                    i64 buildSeconds, u32 buildNanoseconds, u32 reserved.
+  const size_t BuildRecordInfoSize = 24;
+  // Build record input: u32 path, u8 status, u8[3] reserved,
+  //                     i64 seconds, u32 nanoseconds, u32 durationMillis,
+  //                     u64 size, u64 device, u64 inode, u8[16] hash.
+  const size_t BuildRecordInputSize = 64;
+
+  const uint32_t NoString = ~0U;
+
+  using Writer = llvm::support::endian::Writer<llvm::support::little>;
+
+  template <typename T>
+  T readAt(StringRef data, size_t offset) {
+    using namespace llvm::support;
+    assert(offset + sizeof(T) <= data.size());
+    return endian::read<T, little, unaligned>(data.data() + offset);
+  }
+
+  /// The layout of a file's sections, as described by its header.
+  struct Layout {
+    unsigned NumStrings;
+    unsigned NumRecords;
+    size_t InfoOffset;
+    size_t StringsOffset;
+    size_t RecordsOffset;
+    size_t StringDataOffset;
+  };
+} // end anonymous namespace
+
+static bool hasMagic(StringRef data, const char (&magic)[4]) {
+  return data.size() >= HeaderSize &&
+         data.startswith(StringRef(magic, sizeof(magic)));
+}
+
+bool binary_deps::isBinaryDependencyFile(StringRef data) {
+  return hasMagic(data, DependencyFileMagic);
+}
+
+bool binary_deps::isBinaryBuildRecord(StringRef data) {
+  return hasMagic(data, BuildRecordMagic);
+}
+
+static void writeHeader(Writer &W, const char (&magic)[4],
+                        ArrayRef<StringRef> strings, unsigned numRecords) {
+  uint32_t stringDataSize = 0;
+  for (StringRef str : strings)
+    stringDataSize += str.size() + 1;
+
+  W.OS.write(magic, sizeof(magic));
+  W.write<uint16_t>(FormatVersion);
+  W.write<uint16_t>(0);
+  W.write<uint32_t>(strings.size());
+  W.write<uint32_t>(numRecords);
+  W.write<uint32_t>(stringDataSize);
+  W.write<uint32_t>(0);
+}
+
+static void writeStringTable(Writer &W, ArrayRef<StringRef> strings) {
+  uint32_t offset = 0;
+  for (StringRef str : strings) {
+    W.write<uint32_t>(offset);
+    W.write<uint32_t>(str.size());
+    offset += str.size() + 1;
+  }
+}
+
+static void writeStringData(Writer &W, ArrayRef<StringRef> strings) {
+  for (StringRef str : strings) {
+    W.OS << str;
+    W.OS << '\0';
+  }
+}
+
+/// Validates the header and section sizes of \p data, which must have the
+/// given magic number.
+static Optional<Layout> readLayout(StringRef data, const char (&magic)[4],
+                                   size_t infoSize, size_t recordSize) {
+  if (!hasMagic(data, magic))
+    return None;
+  if (readAt<uint16_t>(data, 4) != FormatVersion)
+    return None;
+
+  Layout result;
+  result.NumStrings = readAt<uint32_t>(data, 8);
+  result.NumRecords = readAt<uint32_t>(data, 12);
+  uint64_t stringDataSize = readAt<uint32_t>(data, 16);
+
+  result.InfoOffset = HeaderSize;
+  result.StringsOffset = result.InfoOffset + infoSize;
+  uint64_t recordsOffset =
+      result.StringsOffset + uint64_t(result.NumStrings) * StringEntrySize;
+  uint64_t stringDataOffset =
+      recordsOffset + uint64_t(result.NumRecords) * recordSize;
+  if (stringDataOffset + stringDataSize != data.size())
+    return None;
+  result.RecordsOffset = recordsOffset;
+  result.StringDataOffset = stringDataOffset;
+
+  // Check every string up front, so that accessors don't have to.
+  for (unsigned i = 0; i < result.NumStrings; ++i) {
+    size_t entry = result.StringsOffset + i * StringEntrySize;
+    uint64_t offset = readAt<uint32_t>(data, entry);
+    uint64_t length = readAt<uint32_t>(data, entry + 4);
+    if (offset + length >= stringDataSize)
+      return None;
+    if (data[result.StringDataOffset + offset + length] != '\0')
+      return None;
+  }
+
+  return result;
+}
+
+static StringRef getString(StringRef data, size_t stringsOffset,
+                           size_t stringDataOffset, uint32_t index) {
+  size_t entry = stringsOffset + index * StringEntrySize;
+  uint32_t offset = readAt<uint32_t>(data, entry);
+  uint32_t length = readAt<uint32_t>(data, entry + 4);
+  return data.substr(stringDataOffset + offset, length);
+}
+
+//===----------------------------------------------------------------------===//
+// Reference dependencies
+//===----------------------------------------------------------------------===//
+
+StringRef binary_deps::getSectionName(Section S) {
+  switch (S) {
+  case Section::ProvidesTopLevel: return "provides-top-level";
+  case Section::ProvidesNominal: return "provides-nominal";
+  case Section::ProvidesMember: return "provides-member";
+  case Section::ProvidesDynamicLookup: return "provides-dynamic-lookup";
+  case Section::DependsTopLevel: return "depends-top-level";
+  case Section::DependsMember: return "depends-member";
+  case Section::DependsNominal: return "depends-nominal";
+  case Section::DependsDynamicLookup: return "depends-dynamic-lookup";
+  case Section::DependsExternal: return "depends-external";
+  }
+  llvm_unreachable("unhandled section");
+}
+
+bool binary_deps::isMemberSection(Section S) {
+  return S == Section::ProvidesMember || S == Section::DependsMember;
+}
+
+bool binary_deps::canHaveFingerprints(Section S) {
+  return S == Section::ProvidesTopLevel || S == Section::ProvidesNominal ||
+         S == Section::ProvidesMember;
+}
+
+/// Returns the key under which the fingerprints of the entries in \p S are
+/// listed in the YAML form of a dependencies file.
+static StringRef getFingerprintSectionName(Section S) {
+  switch (S) {
+  case Section::ProvidesTopLevel: return "fingerprints-top-level";
+  case Section::ProvidesNominal: return "fingerprints-nominal";
+  case Section::ProvidesMember: return "fingerprints-member";
+  default: llvm_unreachable("section does not have fingerprints");
+  }
+}
+
+/// Returns true if the names in \p S are mangled type names, which are
+/// written to YAML without escaping.
+static bool hasMangledNames(Section S) {
+  return S == Section::ProvidesNominal || S == Section::DependsNominal;
+}
+
+/// Writes \p name as it appears in the YAML form of section \p S: a quoted
+/// scalar, or for member sections, the quoted type and member names
+/// separated by a comma.
+static void writeYAMLName(raw_ostream &out, Section S, StringRef name) {
+  if (isMemberSection(S)) {
+    auto baseAndMember = name.split('\0');
+    out << "\"" << baseAndMember.first << "\", \""
+        << llvm::yaml::escape(baseAndMember.second) << "\"";
+  } else if (hasMangledNames(S)) {
+    out << "\"" << name << "\"";
+  } else {
+    out << "\"" << llvm::yaml::escape(name) << "\"";
+  }
+}
+
+DependencyFileWriter::DependencyFileWriter() : InterfaceHash(NoString) {}
+
+unsigned DependencyFileWriter::intern(StringRef str) {
+  auto insertResult = StringIndices.insert({str, Strings.size()});
+  if (insertResult.second)
+    Strings.push_back(insertResult.first->getKey());
+  return insertResult.first->getValue();
+}
+
+void DependencyFileWriter::addEntry(Section S, StringRef name,
+                                    bool isCascading, StringRef fingerprint) {
+  assert((fingerprint.empty() || canHaveFingerprints(S)) &&
+         "section does not have fingerprints");
+  beginSection(S);
+  unsigned fingerprintIndex = NoString;
+  if (!fingerprint.empty())
+    fingerprintIndex = intern(fingerprint);
+  Entries.push_back({S, isCascading, intern(name), fingerprintIndex});
+}
+
+void DependencyFileWriter::addMemberEntry(Section S, StringRef mangledTypeName,
+                                          StringRef memberName,
+                                          bool isCascading,
+                                          StringRef fingerprint) {
+  assert(isMemberSection(S) && "not a member section");
+  SmallString<64> joined;
+  joined += mangledTypeName;
+  joined.push_back('\0');
+  joined += memberName;
+  addEntry(S, joined, isCascading, fingerprint);
+}
+
+void DependencyFileWriter::setInterfaceHash(StringRef hash) {
+  InterfaceHash = intern(hash);
+}
+
+void DependencyFileWriter::writeBinary(raw_ostream &out) const {
+  Writer W(out);
+  writeHeader(W, DependencyFileMagic, Strings, Entries.size());
+
+  W.write<uint32_t>(InterfaceHash);
+  W.write<uint32_t>(SectionMask);
+
+  writeStringTable(W, Strings);
+
+  // Write the records grouped by section, so that readers see them in the
+  // same order as in the YAML form.
+  for (unsigned i = 0; i < NumSections; ++i) {
+    for (const Entry &entry : Entries) {
+      if (entry.Kind != Section(i))
+        continue;
+      W.write<uint8_t>(uint8_t(entry.Kind));
+      W.write<uint8_t>(entry.IsCascading);
+      W.write<uint16_t>(0);
+      W.write<uint32_t>(entry.Name);
+      W.write<uint32_t>(entry.Fingerprint);
+    }
+  }
+
+  writeStringData(W, Strings);
+}
+
+void DependencyFileWriter::writeYAML(raw_ostream &out) const {
+  out << "### Swift dependencies file v0 ###\n";
+
+  for (unsigned i = 0; i < NumSections; ++i) {
+    auto S = Section(i);
+    if (!(SectionMask & (1U << i)))
+      continue;
+
+    out << getSectionName(S) << ":\n";
+    for (const Entry &entry : Entries) {
+      if (entry.Kind != S)
+        continue;
+
+      out << "- ";
+      if (!entry.IsCascading)
+        out << "!private ";
+
+      if (isMemberSection(S)) {
+        out << "[";
+        writeYAMLName(out, S, Strings[entry.Name]);
+        out << "]\n";
+      } else {
+        writeYAMLName(out, S, Strings[entry.Name]);
+        out << "\n";
+      }
+    }
+  }
+
+  // Fingerprints are listed separately, each section on a single line as a
+  // flow sequence of [name..., fingerprint] entries, so that the sections
+  // above look the same whether or not the declarations were fingerprinted.
+  for (unsigned i = 0; i < NumSections; ++i) {
+    auto S = Section(i);
+    if (!canHaveFingerprints(S))
+      continue;
+
+    bool printedKey = false;
+    for (const Entry &entry : Entries) {
+      if (entry.Kind != S || entry.Fingerprint == NoString)
+        continue;
+
+      if (!printedKey) {
+        out << getFingerprintSectionName(S) << ": [";
+        printedKey = true;
+      } else {
+        out << ", ";
+      }
+
+      out << "[";
+      writeYAMLName(out, S, Strings[entry.Name]);
+      out << ", \"" << Strings[entry.Fingerprint] << "\"]";
+    }
+    if (printedKey)
+      out << "]\n";
+  }
+
+  if (InterfaceHash != NoString)
+    out << "interface-hash: \"" << Strings[InterfaceHash] << "\"\n";
+}
+
+Optional<DependencyFileView> DependencyFileView::get(StringRef data) {
+  auto layout = readLayout(data, DependencyFileMagic, DependencyInfoSize,
+                           DependencyRecordSize);
+  if (!layout)
+    return None;
+
+  DependencyFileView result;
+  result.Data = data;
+  result.StringsOffset = layout->StringsOffset;
+  result.RecordsOffset = layout->RecordsOffset;
+  result.StringDataOffset = layout->StringDataOffset;
+  result.NumRecords = layout->NumRecords;
+  result.InterfaceHash = readAt<uint32_t>(data, layout->InfoOffset);
+  result.SectionMask = readAt<uint32_t>(data, layout->InfoOffset + 4);
+
+  if (result.InterfaceHash != NoString &&
+      result.InterfaceHash >= layout->NumStrings)
+    return None;
+
+  for (unsigned i = 0; i < result.NumRecords; ++i) {
+    size_t record = layout->RecordsOffset + i * DependencyRecordSize;
+    if (readAt<uint8_t>(data, record) >= NumSections)
+      return None;
+    if (readAt<uint32_t>(data, record + 4) >= layout->NumStrings)
+      return None;
+    uint32_t fingerprint = readAt<uint32_t>(data, record + 8);
+    if (fingerprint != NoString &&
+        (fingerprint >= layout->NumStrings ||
+         !canHaveFingerprints(Section(readAt<uint8_t>(data, record)))))
+      return None;
+  }
+
+  return result;
+}
+
+StringRef DependencyFileView::getInterfaceHash() const {
+  if (InterfaceHash == NoString)
+    return StringRef();
+  return getString(Data, StringsOffset, StringDataOffset, InterfaceHash);
+}
+
+DependencyEntry DependencyFileView::getEntry(unsigned i) const {
+  assert(i < NumRecords && "entry index out of range");
+  size_t record = RecordsOffset + i * DependencyRecordSize;
+
+  DependencyEntry result;
+  result.Kind = Section(readAt<uint8_t>(Data, record));
+  result.IsCascading = readAt<uint8_t>(Data, record + 1);
+  result.Name = getString(Data, StringsOffset, StringDataOffset,
+                          readAt<uint32_t>(Data, record + 4));
+
+  uint32_t fingerprint = readAt<uint32_t>(Data, record + 8);
+  if (fingerprint != NoString)
+    result.Fingerprint = getString(Data, StringsOffset, StringDataOffset,
+                                   fingerprint);
+  return result;
+}
+
+void DependencyFileView::printAsYAML(raw_ostream &out) const {
+  DependencyFileWriter writer;
+  for (unsigned i = 0; i < NumSections; ++i)
+    if (hasSection(Section(i)))
+      writer.beginSection(Section(i));
+
+  for (unsigned i = 0, e = getNumEntries(); i != e; ++i) {
+    DependencyEntry entry = getEntry(i);
+    writer.addEntry(entry.Kind, entry.Name, entry.IsCascading,
+                    entry.Fingerprint);
+  }
+
+  if (InterfaceHash != NoString)
+    writer.setInterfaceHash(getInterfaceHash());
+
+  writer.writeYAML(out);
+}
+
+//===----------------------------------------------------------------------===//
+// Build records
+//===----------------------------------------------------------------------===//
+
+void binary_deps::writeBuildRecord(raw_ostream &out, StringRef version,
+                                   StringRef options,
+                                   llvm::sys::TimeValue buildTime,
+                                   ArrayRef<BuildRecordInput> inputs) {
+  SmallVector<StringRef, 16> strings;
+  strings.push_back(version);
+  strings.push_back(options);
+  for (auto &input : inputs)
+    strings.push_back(input.Path);
+
+  Writer W(out);
+  writeHeader(W, BuildRecordMagic, strings, inputs.size());
+
+  W.write<uint32_t>(0);
+  W.write<uint32_t>(1);
+  W.write<int64_t>(buildTime.seconds());
+  W.write<uint32_t>(buildTime.nanoseconds());
+  W.write<uint32_t>(0);
+
+  writeStringTable(W, strings);
+
+  uint32_t pathIndex = 2;
+  for (auto &input : inputs) {
+    W.write<uint32_t>(pathIndex++);
+    W.write<uint8_t>(uint8_t(input.Status));
+    W.write<uint8_t>(0);
+    W.write<uint16_t>(0);
+    W.write<int64_t>(input.PreviousStamp.ModTime.seconds());
+    W.write<uint32_t>(input.PreviousStamp.ModTime.nanoseconds());
+    W.write<uint32_t>(input.PreviousDuration);
+    W.write<uint64_t>(input.PreviousStamp.Size);
+    W.write<uint64_t>(input.PreviousStamp.Device);
+    W.write<uint64_t>(input.PreviousStamp.Inode);
+    W.OS.write(reinterpret_cast<const char *>(input.PreviousStamp.Hash),
+               sizeof(input.PreviousStamp.Hash));
+  }
+
+  writeStringData(W, strings);
+}
+
+Optional<BuildRecordView> BuildRecordView::get(StringRef data) {
+  auto layout = readLayout(data, BuildRecordMagic, BuildRecordInfoSize,
+                           BuildRecordInputSize);
+  if (!layout)
+    return None;
+
+  BuildRecordView result;
+  result.Data = data;
+  result.StringsOffset = layout->StringsOffset;
+  result.RecordsOffset = layout->RecordsOffset;
+  result.StringDataOffset = layout->StringDataOffset;
+  result.NumRecords = layout->NumRecords;
+  result.Version = readAt<uint32_t>(data, layout->InfoOffset);
+  result.Options = readAt<uint32_t>(data, layout->InfoOffset + 4);
+  result.BuildTime.seconds(readAt<int64_t>(data, layout->InfoOffset + 8));
+  result.BuildTime.nanoseconds(readAt<uint32_t>(data,
+                                                layout->InfoOffset + 16));
+
+  if (result.Version >= layout->NumStrings ||
+      result.Options >= layout->NumStrings)
+    return None;
+
+  for (unsigned i = 0; i < result.NumRecords; ++i) {
+    size_t record = layout->RecordsOffset + i * BuildRecordInputSize;
+    if (readAt<uint32_t>(data, record) >= layout->NumStrings)
+      return None;
+    if (readAt<uint8_t>(data, record + 4) >
+          uint8_t(InputStatus::NeedsNonCascadingBuild))
+      return None;
+  }
+
+  return result;
+}
+
+StringRef BuildRecordView::getVersion() const {
+  return getString(Data, StringsOffset, StringDataOffset, Version);
+}
+
+StringRef BuildRecordView::getOptions() const {
+  return getString(Data, StringsOffset, StringDataOffset, Options);
+}
+
+BuildRecordInput BuildRecordView::getInput(unsigned i) const {
+  assert(i < NumRecords && "input index out of range");
+  size_t record = RecordsOffset + i * BuildRecordInputSize;
+
+  BuildRecordInput result;
+  result.Path = getString(Data, StringsOffset, StringDataOffset,
+                          readAt<uint32_t>(Data, record));
+  result.Status = InputStatus(readAt<uint8_t>(Data, record + 4));
+  result.PreviousStamp.ModTime.seconds(readAt<int64_t>(Data, record + 8));
+  result.PreviousStamp.ModTime.nanoseconds(readAt<uint32_t>(Data,
+                                                            record + 16));
+  result.PreviousDuration = readAt<uint32_t>(Data, record + 20);
+  result.PreviousStamp.Size = readAt<uint64_t>(Data, record + 24);
+  result.PreviousStamp.Device = readAt<uint64_t>(Data, record + 32);
+  result.PreviousStamp.Inode = readAt<uint64_t>(Data, record + 40);
+  memcpy(result.PreviousStamp.Hash, Data.data() + record + 48,
+         sizeof(result.PreviousStamp.Hash));
+  return result;
+}
+
+void BuildRecordView::printAsYAML(raw_ostream &out) const {
+  auto writeTimeValue = [&out](llvm::sys::TimeValue time) {
+    out << "[" << time.seconds() << ", " << time.nanoseconds() << "]";
+  };
+  auto writeStamp = [&out](const driver::FileStamp &stamp) {
+    out << "[" << stamp.Size << ", " << stamp.Device << ", " << stamp.Inode;
+    if (stamp.hasHash())
+      out << ", \"" << stamp.getHashString() << "\"";
+    out << "]";
+  };
+
+  out << "version: \"" << llvm::yaml::escape(getVersion()) << "\"\n";
+  out << "options: \"" << llvm::yaml::escape(getOptions()) << "\"\n";
+  out << "build_time: ";
+  writeTimeValue(getBuildTime());
+  out << "\n";
+  out << "inputs:\n";
+
+  for (unsigned i = 0, e = getNumInputs(); i != e; ++i) {
+    BuildRecordInput input = getInput(i);
+    out << "  \"" << llvm::yaml::escape(input.Path) << "\": ";
+
+    switch (input.Status) {
+    case InputStatus::UpToDate:
+      break;
+    case InputStatus::NeedsCascadingBuild:
+      out << "!dirty ";
+      break;
+    case InputStatus::NeedsNonCascadingBuild:
+      out << "!private ";
+      break;
+    }
+
+    writeTimeValue(input.PreviousStamp.ModTime);
+    out << "\n";
+  }
+
+  bool printedStamps = false;
+  for (unsigned i = 0, e = getNumInputs(); i != e; ++i) {
+    BuildRecordInput input = getInput(i);
+    if (!input.PreviousStamp.isKnown())
+      continue;
+    if (!printedStamps) {
+      out << "stamps:\n";
+      printedStamps = true;
+    }
+    out << "  \"" << llvm::yaml::escape(input.Path) << "\": ";
+    writeStamp(input.PreviousStamp);
+    out << "\n";
+  }
+
+  bool printedKey = false;
+  for (unsigned i = 0, e = getNumInputs(); i != e; ++i) {
+    BuildRecordInput input = getInput(i);
+    if (input.PreviousDuration == 0)
+      continue;
+    if (!printedKey) {
+      out << "durations:\n";
+      printedKey = true;
+    }
+    out << "  \"" << llvm::yaml::escape(input.Path) << "\": "
+        << input.PreviousDuration << "\n";
+  }
+}
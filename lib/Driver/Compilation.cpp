@@ -15,15 +15,21 @@
 #include "swift/AST/DiagnosticEngine.h"
 #include "swift/AST/DiagnosticsDriver.h"
 #include "swift/Basic/Fallthrough.h"
+#include "swift/Basic/JobServer.h"
 #include "swift/Basic/Program.h"
+#include "swift/Basic/Statistic.h"
 #include "swift/Basic/TaskQueue.h"
 #include "swift/Basic/Version.h"
 #include "swift/Basic/type_traits.h"
 #include "swift/Driver/Action.h"
+#include "swift/Driver/BinaryDependencies.h"
+#include "swift/Driver/CompilationCache.h"
 #include "swift/Driver/DependencyGraph.h"
 #include "swift/Driver/Driver.h"
+#include "swift/Driver/FileStamp.h"
 #include "swift/Driver/Job.h"
 #include "swift/Driver/ParseableOutput.h"
+#include "swift/Driver/ToolChain.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/StringExtras.h"
@@ -31,10 +37,14 @@
 #include "llvm/Option/Arg.h"
 #include "llvm/Option/ArgList.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/YAMLParser.h"
 
+#include <algorithm>
+#include <functional>
+
 using namespace swift;
 using namespace swift::sys;
 using namespace swift::driver;
@@ -62,6 +72,12 @@ Compilation::Compilation(DiagnosticEngine &Diags, OutputLevel Level,
 using CommandSet = llvm::SmallPtrSet<const Job *, 16>;
 
 namespace {
+  /// The resources used by a task, along with the name of what it did.
+  struct JobResourceUsage {
+    std::string Description;
+    TaskResourceUsage Usage;
+  };
+
   struct PerformJobsState {
     /// All jobs which have been scheduled for execution (whether or not
     /// they've finished execution), or which have been determined that they
@@ -83,9 +99,47 @@ namespace {
     ///
     /// Only intended for source files.
     llvm::SmallDenseMap<const Job *, bool, 16> UnfinishedCommands;
+
+    /// Compile jobs which are ready to run but which are being held back so
+    /// that they can be combined into BatchJobs.
+    ///
+    /// Only used when batch mode is enabled.
+    SmallVector<const Job *, 16> PendingBatchableCommands;
+
+    /// All BatchJobs which have been formed, keyed by themselves so that they
+    /// stay alive until the TaskQueue is done with them.
+    llvm::SmallDenseMap<const Job *, std::unique_ptr<const BatchJob>, 4>
+        BatchJobs;
+
+    /// When each task that is currently running began.
+    llvm::SmallDenseMap<const Job *, llvm::sys::TimeValue, 16> StartTimes;
+
+    /// How long each job that finished successfully took, in milliseconds.
+    ///
+    /// The time taken by a BatchJob is divided evenly among its jobs.
+    llvm::SmallDenseMap<const Job *, unsigned, 16> Durations;
+
+    /// The resources used by each task that ran, in the order in which they
+    /// finished.
+    ///
+    /// Only collected when the summary is requested with
+    /// -driver-time-compilation.
+    std::vector<JobResourceUsage> ResourceUsage;
+
+    /// Jobs whose outputs have been written from the compilation cache, along
+    /// with what they printed when they ran, which have yet to be treated as
+    /// finished.
+    std::vector<std::pair<const Job *, std::string>> CachedCommands;
   };
 }
 
+void Compilation::enableBatchMode(const ToolChain &TC, const OutputInfo &OI,
+                                  unsigned Count) {
+  BatchModeToolChain = &TC;
+  BatchModeOutputInfo.reset(new OutputInfo(OI));
+  BatchCount = std::max(Count, 1U);
+}
+
 Compilation::~Compilation() = default;
 
 Job *Compilation::addJob(std::unique_ptr<Job> J) {
@@ -103,6 +157,15 @@ static const Job *findUnfinishedJob(ArrayRef<const Job *> JL,
   return nullptr;
 }
 
+/// Returns how long \p job took in the previous build, in milliseconds, or 0
+/// if that isn't known.
+static unsigned getPreviousDuration(const Job *job) {
+  const auto *compileAction = dyn_cast<CompileJobAction>(&job->getSource());
+  if (!compileAction)
+    return 0;
+  return compileAction->getInputInfo().previousDuration;
+}
+
 using InputInfoMap =
   llvm::SmallMapVector<const llvm::opt::Arg *, CompileJobAction::InputInfo, 16>;
 
@@ -113,10 +176,11 @@ static void populateInputInfoMap(InputInfoMap &inputs,
       auto inputFile = cast<InputAction>(action);
 
       CompileJobAction::InputInfo info;
-      info.previousModTime = entry.first->getInputModTime();
+      info.previousStamp = entry.first->getInputStamp();
       info.status = entry.second ?
           CompileJobAction::InputInfo::NeedsCascadingBuild :
           CompileJobAction::InputInfo::NeedsNonCascadingBuild;
+      info.previousDuration = getPreviousDuration(entry.first);
       inputs[&inputFile->getInputArg()] = info;
     }
   }
@@ -130,8 +194,15 @@ static void populateInputInfoMap(InputInfoMap &inputs,
       auto inputFile = cast<InputAction>(action);
 
       CompileJobAction::InputInfo info;
-      info.previousModTime = entry->getInputModTime();
+      info.previousStamp = entry->getInputStamp();
       info.status = CompileJobAction::InputInfo::UpToDate;
+      // Jobs that didn't need to run keep the duration from the last time
+      // they did.
+      auto duration = endState.Durations.find(entry);
+      if (duration != endState.Durations.end())
+        info.previousDuration = duration->second;
+      else
+        info.previousDuration = getPreviousDuration(entry);
       inputs[&inputFile->getInputArg()] = info;
     }
   }
@@ -149,32 +220,80 @@ static void populateInputInfoMap(InputInfoMap &inputs,
   });
 }
 
+/// Diagnoses any of \p inputs that have changed since their jobs were built.
+///
+/// If \p changedFiles is given, inputs not on the list aren't looked at.
 static void checkForOutOfDateInputs(DiagnosticEngine &diags,
-                                    const InputInfoMap &inputs) {
+                                    const InputInfoMap &inputs,
+                                    const ChangedFileList *changedFiles,
+                                    bool useHashes) {
+  std::vector<FileStampCheck> checks;
   for (const auto &inputPair : inputs) {
-    auto recordedModTime = inputPair.second.previousModTime;
-    if (recordedModTime == llvm::sys::TimeValue::MaxTime())
+    const FileStamp &recordedStamp = inputPair.second.previousStamp;
+    if (!recordedStamp.isKnown())
       continue;
 
-    const char *input = inputPair.first->getValue();
+    FileStampCheck check;
+    check.Path = inputPair.first->getValue();
+    check.Previous = recordedStamp;
+    check.AssumeUnchanged =
+        changedFiles && !changedFiles->contains(check.Path);
+    checks.push_back(check);
+  }
 
-    llvm::sys::fs::file_status inputStatus;
-    if (auto statError = llvm::sys::fs::status(input, inputStatus)) {
+  checkFileStamps(checks, useHashes);
+
+  for (const FileStampCheck &check : checks) {
+    switch (check.Status) {
+    case FileStampCheck::Unchanged:
+      break;
+    case FileStampCheck::Changed:
+      diags.diagnose(SourceLoc(), diag::error_input_changed_during_build,
+                     llvm::sys::path::filename(check.Path));
+      break;
+    case FileStampCheck::Missing:
       diags.diagnose(SourceLoc(), diag::warn_cannot_stat_input,
-                     llvm::sys::path::filename(input), statError.message());
-      continue;
+                     llvm::sys::path::filename(check.Path),
+                     check.Error.message());
+      break;
     }
+  }
+}
 
-    if (recordedModTime != inputStatus.getLastModificationTime()) {
-      diags.diagnose(SourceLoc(), diag::error_input_changed_during_build,
-                     llvm::sys::path::filename(input));
+static void writeBinaryCompilationRecord(llvm::raw_ostream &out,
+                                         StringRef argsHash,
+                                         llvm::sys::TimeValue buildTime,
+                                         const InputInfoMap &inputs) {
+  using binary_deps::InputStatus;
+
+  SmallVector<binary_deps::BuildRecordInput, 16> records;
+  for (auto &entry : inputs) {
+    InputStatus status;
+    switch (entry.second.status) {
+    case CompileJobAction::InputInfo::UpToDate:
+      status = InputStatus::UpToDate;
+      break;
+    case CompileJobAction::InputInfo::NewlyAdded:
+    case CompileJobAction::InputInfo::NeedsCascadingBuild:
+      status = InputStatus::NeedsCascadingBuild;
+      break;
+    case CompileJobAction::InputInfo::NeedsNonCascadingBuild:
+      status = InputStatus::NeedsNonCascadingBuild;
+      break;
     }
+    records.push_back({entry.first->getValue(), status,
+                       entry.second.previousStamp,
+                       entry.second.previousDuration});
   }
+
+  binary_deps::writeBuildRecord(out, version::getSwiftFullVersion(), argsHash,
+                                buildTime, records);
 }
 
 static void writeCompilationRecord(StringRef path, StringRef argsHash,
                                    llvm::sys::TimeValue buildTime,
-                                   const InputInfoMap &inputs) {
+                                   const InputInfoMap &inputs,
+                                   bool binary) {
   std::error_code error;
   llvm::raw_fd_ostream out(path, error, llvm::sys::fs::F_None);
   if (out.has_error()) {
@@ -183,6 +302,11 @@ static void writeCompilationRecord(StringRef path, StringRef argsHash,
     return;
   }
 
+  if (binary) {
+    writeBinaryCompilationRecord(out, argsHash, buildTime, inputs);
+    return;
+  }
+
   auto writeTimeValue = [](llvm::raw_ostream &out, llvm::sys::TimeValue time) {
     out << "[" << time.seconds() << ", " << time.nanoseconds() << "]";
   };
@@ -210,9 +334,136 @@ static void writeCompilationRecord(StringRef path, StringRef argsHash,
       break;
     }
 
-    writeTimeValue(out, entry.second.previousModTime);
+    writeTimeValue(out, entry.second.previousStamp.ModTime);
     out << "\n";
   }
+
+  bool printedStamps = false;
+  for (auto &entry : inputs) {
+    const FileStamp &stamp = entry.second.previousStamp;
+    if (!stamp.isKnown())
+      continue;
+    if (!printedStamps) {
+      out << "stamps:\n";
+      printedStamps = true;
+    }
+    out << "  \"" << llvm::yaml::escape(entry.first->getValue()) << "\": ["
+        << stamp.Size << ", " << stamp.Device << ", " << stamp.Inode;
+    if (stamp.hasHash())
+      out << ", \"" << stamp.getHashString() << "\"";
+    out << "]\n";
+  }
+
+  bool printedDurations = false;
+  for (auto &entry : inputs) {
+    if (entry.second.previousDuration == 0)
+      continue;
+    if (!printedDurations) {
+      out << "durations:\n";
+      printedDurations = true;
+    }
+    out << "  \"" << llvm::yaml::escape(entry.first->getValue()) << "\": "
+        << entry.second.previousDuration << "\n";
+  }
+}
+
+/// Prints a table of the resources used by each task in \p usage, slowest
+/// first, followed by the total CPU time and the largest peak memory use.
+static void printJobResourceUsage(raw_ostream &out,
+                                  MutableArrayRef<JobResourceUsage> usage) {
+  std::stable_sort(usage.begin(), usage.end(),
+                   [](const JobResourceUsage &lhs,
+                      const JobResourceUsage &rhs) {
+    return lhs.Usage.WallTime > rhs.Usage.WallTime;
+  });
+
+  auto seconds = [](uint64_t microseconds) -> double {
+    return microseconds / 1000000.0;
+  };
+  auto megabytes = [](uint64_t bytes) -> double {
+    return bytes / (1024.0 * 1024.0);
+  };
+
+  TaskResourceUsage total;
+  out << "===---------------------------------------------------------===\n"
+      << "                      Driver Job Resource Usage\n"
+      << "===---------------------------------------------------------===\n"
+      << "   Wall Time    User Time  System Time      Max RSS  Job\n";
+  for (const JobResourceUsage &entry : usage) {
+    const TaskResourceUsage &job = entry.Usage;
+    out << llvm::format("  %9.4fs   %9.4fs   %9.4fs  %8.1f MB  ",
+                        seconds(job.WallTime), seconds(job.UserTime),
+                        seconds(job.SystemTime), megabytes(job.MaxRSS))
+        << entry.Description << "\n";
+
+    total.WallTime += job.WallTime;
+    total.UserTime += job.UserTime;
+    total.SystemTime += job.SystemTime;
+    total.MaxRSS = std::max(total.MaxRSS, job.MaxRSS);
+  }
+  out << llvm::format("  %9.4fs   %9.4fs   %9.4fs  %8.1f MB  Total\n",
+                      seconds(total.WallTime), seconds(total.UserTime),
+                      seconds(total.SystemTime), megabytes(total.MaxRSS));
+}
+
+using JobPriorityMap = llvm::DenseMap<const Job *, unsigned>;
+
+/// Fills in \p priorities with the length of the critical path starting at
+/// each of \p jobs: how long, in milliseconds, it is expected to take from
+/// when the job begins until the last of the jobs that depend on it finishes.
+///
+/// The estimates come from how long each input took to compile in the
+/// previous build. Jobs without a recorded duration count as taking no time.
+template <typename JobList>
+static void computeJobPriorities(JobPriorityMap &priorities,
+                                 const JobList &jobs) {
+  llvm::DenseMap<const Job *, TinyPtrVector<const Job *>> dependents;
+  for (const Job *job : jobs)
+    for (const Job *input : job->getInputs())
+      dependents[input].push_back(job);
+
+  std::function<unsigned(const Job *)> getCriticalPath =
+      [&](const Job *job) -> unsigned {
+    auto known = priorities.find(job);
+    if (known != priorities.end())
+      return known->second;
+
+    unsigned longestDependentPath = 0;
+    for (const Job *dependent : dependents.lookup(job)) {
+      longestDependentPath = std::max(longestDependentPath,
+                                      getCriticalPath(dependent));
+    }
+
+    unsigned result = getPreviousDuration(job) + longestDependentPath;
+    priorities[job] = result;
+    return result;
+  };
+
+  for (const Job *job : jobs)
+    (void)getCriticalPath(job);
+}
+
+/// Returns true if \p job can be combined with other compile jobs into a
+/// single frontend invocation.
+static bool isBatchable(const Job *job) {
+  if (!isa<CompileJobAction>(job->getSource()))
+    return false;
+  if (!job->getFilelistInfo().path.empty())
+    return false;
+  if (!job->getExtraEnvironment().empty())
+    return false;
+
+  const CommandOutput &output = job->getOutput();
+  if (output.getPrimaryOutputFilenames().size() != 1)
+    return false;
+
+  // These outputs cannot be named per-file in a batch's output file map.
+  for (auto type : {types::TY_SerializedDiagnostics, types::TY_Remapping,
+                    types::TY_ObjCHeader}) {
+    if (!output.getAdditionalOutputForType(type).empty())
+      return false;
+  }
+  return true;
 }
 
 static bool writeFilelistIfNecessary(const Job *job, DiagnosticEngine &diags) {
@@ -252,15 +503,81 @@ static bool writeFilelistIfNecessary(const Job *job, DiagnosticEngine &diags) {
   return true;
 }
 
+/// Writes the output file map naming the supplementary outputs of each of the
+/// jobs combined in \p job, keyed by its primary input.
+static bool writeBatchOutputFileMap(const BatchJob *job,
+                                    DiagnosticEngine &diags) {
+  std::error_code error;
+  llvm::raw_fd_ostream out(job->getOutputFileMapPath(), error,
+                           llvm::sys::fs::F_None);
+  if (out.has_error()) {
+    out.clear_error();
+    diags.diagnose(SourceLoc(), diag::error_unable_to_make_temporary_file,
+                   error.message());
+    return false;
+  }
+
+  static const types::ID supplementaryTypes[] = {
+    types::TY_SwiftDeps,
+    types::TY_Dependencies,
+    types::TY_SwiftModuleFile,
+    types::TY_SwiftModuleDocFile,
+  };
+
+  out << "{";
+  bool firstJob = true;
+  for (const Job *combined : job->getCombinedJobs()) {
+    if (!firstJob)
+      out << ",";
+    firstJob = false;
+
+    const CommandOutput &output = combined->getOutput();
+    out << "\n  \"" << llvm::yaml::escape(output.getBaseInput(0)) << "\": {";
+    bool first = true;
+    for (types::ID type : supplementaryTypes) {
+      const std::string &path = output.getAdditionalOutputForType(type);
+      if (path.empty())
+        continue;
+      if (!first)
+        out << ",";
+      out << " \"" << types::getTypeName(type) << "\": \""
+          << llvm::yaml::escape(path) << "\"";
+      first = false;
+    }
+    out << " }";
+  }
+  out << "\n}\n";
+
+  return true;
+}
+
 int Compilation::performJobsImpl() {
   // Create a TaskQueue for execution.
   std::unique_ptr<TaskQueue> TQ;
-  if (SkipTaskExecution)
+  if (SkipTaskExecution) {
     TQ.reset(new DummyTaskQueue(NumberOfParallelCommands));
-  else
+  } else {
     TQ.reset(new TaskQueue(NumberOfParallelCommands));
 
+    // When run by make or a compatible build system, take part in its
+    // jobserver, so that parallel drivers don't oversubscribe the machine.
+    if (NumberOfParallelCommands > 1)
+      if (auto JS = JobServer::connectFromEnvironment())
+        TQ->setJobServer(std::move(JS));
+
+    if (!FrontendServerPath.empty())
+      TQ->setFrontendServer(FrontendServerPath);
+  }
+
   PerformJobsState State;
+  int Result = EXIT_SUCCESS;
+
+  // Among the jobs that are ready to run, start those on the longest path
+  // through the job graph first, so that a slow file doesn't get left until
+  // the end.
+  JobPriorityMap JobPriorities;
+  if (UseJobPriorities)
+    computeJobPriorities(JobPriorities, getJobs());
 
   using DependencyGraph = DependencyGraph<const Job *>;
   DependencyGraph DepGraph;
@@ -307,8 +624,89 @@ int Compilation::performJobsImpl() {
     assert(Cmd->getExtraEnvironment().empty() &&
            "not implemented for compilations with multiple jobs");
     State.ScheduledCommands.insert(Cmd);
+
+    // There's no need to run a job whose outputs are already in the cache.
+    if (Cache && CompilationCache::isCacheable(*Cmd)) {
+      std::string CachedOutput;
+      if (Cache->materialize(*this, *Cmd, CachedOutput)) {
+        State.CachedCommands.push_back({Cmd, std::move(CachedOutput)});
+        return;
+      }
+    }
+
+    if (getBatchModeEnabled() && isBatchable(Cmd)) {
+      State.PendingBatchableCommands.push_back(Cmd);
+      return;
+    }
+
     TQ->addTask(Cmd->getExecutable(), Cmd->getArguments(), llvm::None,
-                (void *)Cmd);
+                (void *)Cmd, JobPriorities.lookup(Cmd));
+  };
+
+  // Partition the batchable commands which are ready to run into at most
+  // BatchCount contiguous batches, and hand each one to the TaskQueue as a
+  // single frontend invocation.
+  // Returns the Jobs on whose behalf a task ran: the combined Jobs if it is a
+  // BatchJob, or else the task's Job itself.
+  auto getConstituentJobs =
+      [&] (const Job *const &Cmd) -> ArrayRef<const Job *> {
+    auto Found = State.BatchJobs.find(Cmd);
+    if (Found != State.BatchJobs.end())
+      return Found->second->getCombinedJobs();
+    return Cmd;
+  };
+
+  auto schedulePendingBatches = [&] {
+    auto &Pending = State.PendingBatchableCommands;
+    if (Pending.empty())
+      return;
+
+    size_t NumBatches = std::min<size_t>(BatchCount, Pending.size());
+    ArrayRef<const Job *> Remaining = Pending;
+    for (size_t i = 0; i < NumBatches; ++i) {
+      size_t Size = Remaining.size() / (NumBatches - i);
+      ArrayRef<const Job *> Batch = Remaining.take_front(Size);
+      Remaining = Remaining.drop_front(Size);
+
+      if (Batch.size() == 1) {
+        const Job *Cmd = Batch.front();
+        TQ->addTask(Cmd->getExecutable(), Cmd->getArguments(), llvm::None,
+                    (void *)Cmd, JobPriorities.lookup(Cmd));
+        continue;
+      }
+
+      // A batch runs its jobs one after another, and then whatever depends on
+      // the slowest of them can start.
+      unsigned BatchDuration = 0;
+      unsigned LongestDependentPath = 0;
+      for (const Job *Cmd : Batch) {
+        unsigned Duration = UseJobPriorities ? getPreviousDuration(Cmd) : 0;
+        BatchDuration += Duration;
+        LongestDependentPath = std::max(LongestDependentPath,
+                                        JobPriorities.lookup(Cmd) - Duration);
+      }
+
+      std::unique_ptr<const BatchJob> BJ =
+          BatchModeToolChain->constructBatchJob(Batch, *this,
+                                                *BatchModeOutputInfo);
+      const Job *Cmd = BJ.get();
+
+      // A batch with many primaries names its outputs in a filelist. If
+      // either file can't be written, the batch fails without running, and
+      // its jobs are left unfinished to be rebuilt next time.
+      if (!writeBatchOutputFileMap(BJ.get(), Diags) ||
+          !writeFilelistIfNecessary(Cmd, Diags)) {
+        if (Result == EXIT_SUCCESS)
+          Result = EXIT_FAILURE;
+        continue;
+      }
+
+      TQ->addTask(Cmd->getExecutable(), Cmd->getArguments(), llvm::None,
+                  (void *)Cmd, BatchDuration + LongestDependentPath);
+      State.BatchJobs[Cmd] = std::move(BJ);
+    }
+    assert(Remaining.empty() && "not all pending commands were batched");
+    Pending.clear();
   };
 
   // When a task finishes, we need to reevaluate the other commands that
@@ -325,6 +723,77 @@ int Compilation::performJobsImpl() {
     }
   };
 
+  // Updates the dependency graph after \p FinishedCmds have produced their
+  // outputs, and schedules whatever they turn out to affect.
+  auto finishSuccessfulJobs = [&] (ArrayRef<const Job *> FinishedCmds) {
+    for (const Job *FinishedCmd : FinishedCmds) {
+      // When a task finishes, we need to reevaluate the other commands that
+      // might have been blocked.
+      markFinished(FinishedCmd);
+
+      // In order to handle both old dependencies that have disappeared and new
+      // dependencies that have arisen, we need to reload the dependency file.
+      if (getIncrementalBuildEnabled()) {
+        const CommandOutput &Output = FinishedCmd->getOutput();
+        StringRef DependenciesFile =
+          Output.getAdditionalOutputForType(types::TY_SwiftDeps);
+        if (!DependenciesFile.empty()) {
+          SmallVector<const Job *, 16> Dependents;
+          bool wasCascading = DepGraph.isMarked(FinishedCmd);
+
+          switch (DepGraph.loadFromPath(FinishedCmd, DependenciesFile)) {
+          case DependencyGraphImpl::LoadResult::HadError:
+            disableIncrementalBuild();
+            for (const Job *Cmd : DeferredCommands)
+              scheduleCommandIfNecessaryAndPossible(Cmd);
+            DeferredCommands.clear();
+            Dependents.clear();
+            break;
+          case DependencyGraphImpl::LoadResult::UpToDate:
+            if (!wasCascading)
+              break;
+            SWIFT_FALLTHROUGH;
+          case DependencyGraphImpl::LoadResult::AffectsDownstream:
+            // If the file was only rebuilt because it changed, anything that
+            // depends on declarations whose fingerprints did not change can
+            // be left alone.
+            if (!wasCascading && UseFingerprints)
+              DepGraph.markTransitiveFromChangedProvides(Dependents,
+                                                         FinishedCmd);
+            else
+              DepGraph.markTransitive(Dependents, FinishedCmd);
+            break;
+          }
+
+          for (const Job *Cmd : Dependents) {
+            DeferredCommands.erase(Cmd);
+            noteBuilding(Cmd, "because of dependencies discovered later");
+            scheduleCommandIfNecessaryAndPossible(Cmd);
+          }
+        }
+      }
+    }
+  };
+
+  // Finishes the jobs whose outputs came from the compilation cache as if
+  // they had just run. Any jobs this makes ready that are also in the cache
+  // are finished in turn.
+  auto finishCachedCommands = [&] {
+    while (!State.CachedCommands.empty()) {
+      auto CachedCommands = std::move(State.CachedCommands);
+      State.CachedCommands.clear();
+      for (auto &Cached : CachedCommands) {
+        if (Level == OutputLevel::Parseable)
+          parseable_output::emitSkippedMessage(llvm::errs(), *Cached.first);
+        else
+          llvm::errs() << Cached.second;
+        if (Stats)
+          ++Stats->getDriverCounters().NumDriverJobsCached;
+        finishSuccessfulJobs(Cached.first);
+      }
+    }
+  };
+
   // Schedule all jobs we can.
   for (const Job *Cmd : getJobs()) {
     if (!getIncrementalBuildEnabled()) {
@@ -396,6 +865,9 @@ int Compilation::performJobsImpl() {
 
     // Check all cross-module dependencies as well.
     for (StringRef dependency : DepGraph.getExternalDependencies()) {
+      if (ChangedFiles && !ChangedFiles->contains(dependency))
+        continue;
+
       llvm::sys::fs::file_status depStatus;
       if (!llvm::sys::fs::status(dependency, depStatus))
         if (depStatus.getLastModificationTime() < LastBuildTime)
@@ -420,20 +892,49 @@ int Compilation::performJobsImpl() {
     }
   }
 
-  int Result = EXIT_SUCCESS;
+  finishCachedCommands();
+  schedulePendingBatches();
+
+  // Remembers the resources used by a task for the summary printed at the
+  // end, naming it after the inputs of the jobs it performed.
+  auto recordResourceUsage = [&] (const Job *Cmd,
+                                  Optional<TaskResourceUsage> Usage) {
+    if (!ShowJobResourceUsage || !Usage)
+      return;
+
+    JobResourceUsage Entry;
+    llvm::raw_string_ostream Description(Entry.Description);
+    Description << Cmd->getSource().getClassName();
+    const char *Separator = " ";
+    for (const Job *Constituent : getConstituentJobs(Cmd)) {
+      const CommandOutput &Output = Constituent->getOutput();
+      if (Output.getPrimaryOutputFilenames().empty())
+        continue;
+      Description << Separator
+                  << llvm::sys::path::filename(Output.getBaseInput(0));
+      Separator = ", ";
+    }
+    Description.flush();
+
+    Entry.Usage = Usage.getValue();
+    State.ResourceUsage.push_back(std::move(Entry));
+  };
 
   // Set up a callback which will be called immediately after a task has
   // started. This callback may be used to provide output indicating that the
   // task began.
-  auto taskBegan = [this] (ProcessId Pid, void *Context) {
+  auto taskBegan = [&] (ProcessId Pid, void *Context) {
     // TODO: properly handle task began.
     const Job *BeganCmd = (const Job *)Context;
+    State.StartTimes[BeganCmd] = llvm::sys::TimeValue::now();
 
     // For verbose output, print out each command as it begins execution.
-    if (Level == OutputLevel::Verbose)
+    if (Level == OutputLevel::Verbose) {
       BeganCmd->printCommandLine(llvm::errs());
-    else if (Level == OutputLevel::Parseable)
-      parseable_output::emitBeganMessage(llvm::errs(), *BeganCmd, Pid);
+    } else if (Level == OutputLevel::Parseable) {
+      for (const Job *Cmd : getConstituentJobs(BeganCmd))
+        parseable_output::emitBeganMessage(llvm::errs(), *Cmd, Pid);
+    }
   };
 
   // Set up a callback which will be called immediately after a task has
@@ -442,13 +943,25 @@ int Compilation::performJobsImpl() {
   // it should also schedule any additional commands which we now know need
   // to run.
   auto taskFinished = [&] (ProcessId Pid, int ReturnCode, StringRef Output,
+                           Optional<TaskResourceUsage> Usage,
                            void *Context) -> TaskFinishedResponse {
     const Job *FinishedCmd = (const Job *)Context;
+    ArrayRef<const Job *> FinishedCmds = getConstituentJobs(FinishedCmd);
+    recordResourceUsage(FinishedCmd, Usage);
+    if (Stats)
+      Stats->getDriverCounters().NumDriverJobsRun += FinishedCmds.size();
 
     if (Level == OutputLevel::Parseable) {
-      // Parseable output was requested.
-      parseable_output::emitFinishedMessage(llvm::errs(), *FinishedCmd, Pid,
-                                            ReturnCode, Output);
+      // Parseable output was requested. A batch's output and resource usage
+      // are attributed to the first of its combined jobs.
+      StringRef CmdOutput = Output;
+      Optional<TaskResourceUsage> CmdUsage = Usage;
+      for (const Job *Cmd : FinishedCmds) {
+        parseable_output::emitFinishedMessage(llvm::errs(), *Cmd, Pid,
+                                              ReturnCode, CmdOutput, CmdUsage);
+        CmdOutput = StringRef();
+        CmdUsage = None;
+      }
     } else {
       // Otherwise, send the buffered output to stderr, though only if we
       // support getting buffered output.
@@ -477,56 +990,53 @@ int Compilation::performJobsImpl() {
           TaskFinishedResponse::StopExecution;
     }
 
-    // When a task finishes, we need to reevaluate the other commands that
-    // might have been blocked.
-    markFinished(FinishedCmd);
-
-    // In order to handle both old dependencies that have disappeared and new
-    // dependencies that have arisen, we need to reload the dependency file.
-    if (getIncrementalBuildEnabled()) {
-      const CommandOutput &Output = FinishedCmd->getOutput();
-      StringRef DependenciesFile =
-        Output.getAdditionalOutputForType(types::TY_SwiftDeps);
-      if (!DependenciesFile.empty()) {
-        SmallVector<const Job *, 16> Dependents;
-        bool wasCascading = DepGraph.isMarked(FinishedCmd);
-
-        switch (DepGraph.loadFromPath(FinishedCmd, DependenciesFile)) {
-        case DependencyGraphImpl::LoadResult::HadError:
-          disableIncrementalBuild();
-          for (const Job *Cmd : DeferredCommands)
-            scheduleCommandIfNecessaryAndPossible(Cmd);
-          DeferredCommands.clear();
-          Dependents.clear();
-          break;
-        case DependencyGraphImpl::LoadResult::UpToDate:
-          if (!wasCascading)
-            break;
-          SWIFT_FALLTHROUGH;
-        case DependencyGraphImpl::LoadResult::AffectsDownstream:
-          DepGraph.markTransitive(Dependents, FinishedCmd);
-          break;
-        }
+    // Record how long the task took, so that the next build can start it
+    // earlier if it was slow.
+    auto StartTime = State.StartTimes.find(FinishedCmd);
+    if (StartTime != State.StartTimes.end()) {
+      llvm::sys::TimeValue Now = llvm::sys::TimeValue::now();
+      uint64_t Elapsed = 0;
+      if (Now > StartTime->second)
+        Elapsed = (Now - StartTime->second).msec();
+      State.StartTimes.erase(StartTime);
+
+      // Zero means "unknown", so round very fast jobs up to a millisecond.
+      uint64_t PerJob = std::max<uint64_t>(Elapsed / FinishedCmds.size(), 1);
+      for (const Job *Cmd : FinishedCmds)
+        State.Durations[Cmd] = std::min<uint64_t>(PerJob, UINT32_MAX);
+    }
 
-        for (const Job *Cmd : Dependents) {
-          DeferredCommands.erase(Cmd);
-          noteBuilding(Cmd, "because of dependencies discovered later");
-          scheduleCommandIfNecessaryAndPossible(Cmd);
-        }
-      }
+    // Jobs whose outputs can be reused in later builds go in the cache. A
+    // batch's output can't be divided among its jobs, so they're only stored
+    // if there wasn't any.
+    if (Cache && (FinishedCmds.size() == 1 || Output.empty())) {
+      for (const Job *Cmd : FinishedCmds)
+        if (CompilationCache::isCacheable(*Cmd))
+          Cache->store(*this, *Cmd, Output);
     }
 
+    finishSuccessfulJobs(FinishedCmds);
+    finishCachedCommands();
+    schedulePendingBatches();
     return TaskFinishedResponse::ContinueExecution;
   };
 
   auto taskSignalled = [&] (ProcessId Pid, StringRef ErrorMsg, StringRef Output,
+                            Optional<TaskResourceUsage> Usage,
                             void *Context) -> TaskFinishedResponse {
     const Job *SignalledCmd = (const Job *)Context;
+    recordResourceUsage(SignalledCmd, Usage);
 
     if (Level == OutputLevel::Parseable) {
       // Parseable output was requested.
-      parseable_output::emitSignalledMessage(llvm::errs(), *SignalledCmd, Pid,
-                                             ErrorMsg, Output);
+      StringRef CmdOutput = Output;
+      Optional<TaskResourceUsage> CmdUsage = Usage;
+      for (const Job *Cmd : getConstituentJobs(SignalledCmd)) {
+        parseable_output::emitSignalledMessage(llvm::errs(), *Cmd, Pid,
+                                               ErrorMsg, CmdOutput, CmdUsage);
+        CmdOutput = StringRef();
+        CmdUsage = None;
+      }
     } else {
       // Otherwise, send the buffered output to stderr, though only if we
       // support getting buffered output.
@@ -564,8 +1074,19 @@ int Compilation::performJobsImpl() {
     }
 
     // ...which may allow us to go on and do later tasks.
+    finishCachedCommands();
+    schedulePendingBatches();
   } while (Result == 0 && TQ->hasRemainingTasks());
 
+  if (!State.ResourceUsage.empty())
+    printJobResourceUsage(llvm::errs(), State.ResourceUsage);
+
+  if (Cache) {
+    Cache->trim();
+    if (Level == OutputLevel::Verbose)
+      Cache->printStatistics(llvm::errs());
+  }
+
   if (Result == 0) {
     assert(State.BlockingCommands.empty() &&
            "some blocking commands never finished properly");
@@ -594,9 +1115,19 @@ int Compilation::performJobsImpl() {
   if (!CompilationRecordPath.empty() && !SkipTaskExecution) {
     InputInfoMap InputInfo;
     populateInputInfoMap(InputInfo, State);
-    checkForOutOfDateInputs(Diags, InputInfo);
+    checkForOutOfDateInputs(Diags, InputInfo, ChangedFiles.get(),
+                            CompareInputHashes);
     writeCompilationRecord(CompilationRecordPath, ArgsHash, BuildStartTime,
-                           InputInfo);
+                           InputInfo, BinaryCompilationRecord);
+  }
+
+  if (Stats) {
+    auto &Counters = Stats->getDriverCounters();
+    Counters.NumDriverJobs = Jobs.size();
+    uint64_t NumHandled = Counters.NumDriverJobsRun +
+                          Counters.NumDriverJobsCached;
+    if (NumHandled < Counters.NumDriverJobs)
+      Counters.NumDriverJobsSkipped = Counters.NumDriverJobs - NumHandled;
   }
 
   if (Result == 0)
@@ -665,8 +1196,8 @@ int Compilation::performJobs() {
   // If we don't have to do any cleanup work, just exec the subprocess.
   if (Level < OutputLevel::Parseable &&
       (SaveTemps || TempFilePaths.empty()) &&
-      CompilationRecordPath.empty() &&
-      Jobs.size() == 1) {
+      CompilationRecordPath.empty() && !Cache && !Stats &&
+      FrontendServerPath.empty() && Jobs.size() == 1) {
     return performSingleCommand(Jobs.front().get());
   }
 
@@ -0,0 +1,417 @@
+//===--- CompilationCache.cpp - Local cache of compile job outputs --------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/Driver/CompilationCache.h"
+
+#include "swift/Basic/Version.h"
+#include "swift/Driver/Action.h"
+#include "swift/Driver/Compilation.h"
+#include "swift/Driver/DependencyGraph.h"
+#include "swift/Driver/Job.h"
+#include "swift/Driver/Types.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Option/Arg.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+
+using namespace swift;
+using namespace swift::driver;
+
+/// The first line of every entry. Changing it invalidates existing entries,
+/// since it is also part of every key.
+static const char EntrySignature[] = "swift-compilation-cache-entry 1\n";
+
+/// The name under which an entry records what its job printed.
+static const char OutputBlobName[] = "output";
+
+static const char EntryExtension[] = ".entry";
+
+namespace {
+/// The contents of a cache entry.
+///
+/// After the signature, an entry consists of lines of the form
+///
+///     external <hash> <path>
+///
+/// naming the external dependencies of the job, followed by blobs of the form
+///
+///     blob <name> <size>
+///     <size bytes of data>
+///
+/// holding what the job printed (named "output") and each of its output
+/// files (named after their types).
+struct CacheEntry {
+  SmallVector<std::pair<StringRef, StringRef>, 8> ExternalDependencies;
+  StringRef Output;
+  SmallVector<std::pair<types::ID, StringRef>, 4> Files;
+
+  /// Fills in this entry from \p data, returning false if \p data is not a
+  /// well-formed entry.
+  bool parse(StringRef data);
+};
+} // end anonymous namespace
+
+bool CacheEntry::parse(StringRef data) {
+  if (!data.startswith(EntrySignature))
+    return false;
+  data = data.drop_front(strlen(EntrySignature));
+
+  while (!data.empty()) {
+    StringRef line;
+    std::tie(line, data) = data.split('\n');
+
+    StringRef kind;
+    std::tie(kind, line) = line.split(' ');
+    if (kind == "external") {
+      StringRef hash, path;
+      std::tie(hash, path) = line.split(' ');
+      if (hash.empty() || path.empty())
+        return false;
+      ExternalDependencies.push_back({path, hash});
+      continue;
+    }
+
+    if (kind != "blob")
+      return false;
+
+    StringRef name, sizeString;
+    std::tie(name, sizeString) = line.split(' ');
+    size_t size;
+    if (sizeString.getAsInteger(10, size) || size > data.size())
+      return false;
+    StringRef blob = data.substr(0, size);
+    data = data.drop_front(size);
+
+    if (name == OutputBlobName) {
+      Output = blob;
+      continue;
+    }
+    types::ID type = types::lookupTypeForName(name);
+    if (type == types::TY_INVALID)
+      return false;
+    Files.push_back({type, blob});
+  }
+
+  return true;
+}
+
+/// Returns the path \p Cmd writes its output of type \p type to, or an empty
+/// string if it doesn't produce that type of output.
+static StringRef getOutputPath(const Job &Cmd, types::ID type) {
+  const CommandOutput &output = Cmd.getOutput();
+  if (type == output.getPrimaryOutputType())
+    return output.getPrimaryOutputFilename();
+  return output.getAdditionalOutputForType(type);
+}
+
+/// Writes \p data to \p path by way of a temporary file, so that no other
+/// process can see a partially-written file.
+static std::error_code writeFileAtomically(StringRef path, StringRef data) {
+  SmallString<128> tmpPath(path);
+  tmpPath += "-%%%%%%";
+  int tmpFD;
+  if (auto err = llvm::sys::fs::createUniqueFile(tmpPath, tmpFD, tmpPath))
+    return err;
+
+  {
+    llvm::raw_fd_ostream out(tmpFD, /*shouldClose=*/true);
+    out << data;
+    out.flush();
+    if (out.has_error()) {
+      out.clear_error();
+      llvm::sys::fs::remove(tmpPath);
+      return std::make_error_code(std::errc::io_error);
+    }
+  }
+
+  return llvm::sys::fs::rename(tmpPath, path);
+}
+
+StringRef CompilationCache::getContentHash(StringRef path) {
+  auto known = ContentHashes.find(path);
+  if (known != ContentHashes.end())
+    return known->second;
+
+  std::string &result = ContentHashes[path];
+  auto buffer = llvm::MemoryBuffer::getFile(path);
+  if (!buffer)
+    return result;
+
+  llvm::MD5 hash;
+  hash.update(buffer.get()->getBuffer());
+  llvm::MD5::MD5Result hashBuf;
+  hash.final(hashBuf);
+  SmallString<32> hashString;
+  llvm::MD5::stringifyResult(hashBuf, hashString);
+  result = hashString.str();
+  return result;
+}
+
+StringRef CompilationCache::getKey(const Compilation &C, const Job &Cmd) {
+  auto known = Keys.find(&Cmd);
+  if (known != Keys.end())
+    return known->second;
+
+  // Leave an empty key in place if the job turns out not to be cacheable.
+  Keys[&Cmd] = std::string();
+  if (!isCacheable(Cmd))
+    return StringRef();
+
+  llvm::MD5 hash;
+  auto addString = [&hash](StringRef str) {
+    hash.update(str);
+    hash.update(StringRef("", 1));
+  };
+
+  addString(EntrySignature);
+  addString(version::getSwiftFullVersion());
+
+  // A rebuilt frontend may produce different output without its version
+  // changing, so its size and modification time are part of the key too.
+  llvm::sys::fs::file_status executableStatus;
+  if (llvm::sys::fs::status(Cmd.getExecutable(), executableStatus))
+    return StringRef();
+  addString(Cmd.getExecutable());
+  addString(llvm::utostr(executableStatus.getSize()));
+  addString(llvm::utostr(
+      executableStatus.getLastModificationTime().toEpochTime()));
+
+  // Relative paths on the command line are resolved against the working
+  // directory, and absolute paths end up in debug info.
+  SmallString<128> workingDirectory;
+  if (llvm::sys::fs::current_path(workingDirectory))
+    return StringRef();
+  addString(workingDirectory);
+
+  // Filelists get fresh temporary names in every build, so it's what they
+  // list that goes into the key, not where they are.
+  bool isFilelistPath = false;
+  for (const char *arg : Cmd.getArguments()) {
+    if (isFilelistPath) {
+      isFilelistPath = false;
+      auto buffer = llvm::MemoryBuffer::getFile(arg);
+      if (!buffer)
+        return StringRef();
+      addString(buffer.get()->getBuffer());
+      continue;
+    }
+    addString(arg);
+    isFilelistPath = StringRef(arg) == "-filelist" ||
+                     StringRef(arg) == "-output-filelist";
+  }
+
+  // Every source file in the module can affect the job, not just the
+  // primary file.
+  for (const InputPair &input : C.getInputFiles()) {
+    if (!types::isPartOfSwiftCompilation(input.first))
+      continue;
+    StringRef path = input.second->getValue();
+    StringRef contentHash = getContentHash(path);
+    if (contentHash.empty())
+      return StringRef();
+    addString(path);
+    addString(contentHash);
+  }
+
+  llvm::MD5::MD5Result hashBuf;
+  hash.final(hashBuf);
+  SmallString<32> key;
+  llvm::MD5::stringifyResult(hashBuf, key);
+  return Keys[&Cmd] = key.str();
+}
+
+std::string CompilationCache::getEntryPath(StringRef key) const {
+  SmallString<128> path(Directory);
+  llvm::sys::path::append(path, key);
+  path += EntryExtension;
+  return path.str();
+}
+
+bool CompilationCache::isCacheable(const Job &Cmd) {
+  if (!isa<CompileJobAction>(Cmd.getSource()))
+    return false;
+  if (!Cmd.getExtraEnvironment().empty())
+    return false;
+
+  // Multi-threaded compilation produces several primary outputs, which aren't
+  // worth handling.
+  const CommandOutput &output = Cmd.getOutput();
+  if (output.getPrimaryOutputFilenames().size() != 1)
+    return false;
+
+  // Without the external dependencies listed in the reference dependencies
+  // file, there'd be no way to tell whether an entry is still valid.
+  return !output.getAdditionalOutputForType(types::TY_SwiftDeps).empty();
+}
+
+bool CompilationCache::materialize(const Compilation &C, const Job &Cmd,
+                                   std::string &Output) {
+  StringRef key = getKey(C, Cmd);
+  if (key.empty())
+    return false;
+
+  std::string entryPath = getEntryPath(key);
+  auto buffer = llvm::MemoryBuffer::getFile(entryPath);
+  CacheEntry entry;
+  if (!buffer || !entry.parse(buffer.get()->getBuffer())) {
+    ++Stats.Misses;
+    return false;
+  }
+
+  // The entry can only be used if the modules and headers the job depended
+  // on haven't changed, and if it has every file the job would produce.
+  bool isValid = std::all_of(entry.ExternalDependencies.begin(),
+                             entry.ExternalDependencies.end(),
+                             [&](std::pair<StringRef, StringRef> dependency) {
+    return getContentHash(dependency.first) == dependency.second;
+  });
+  isValid &= std::all_of(entry.Files.begin(), entry.Files.end(),
+                         [&](std::pair<types::ID, StringRef> file) {
+    return !getOutputPath(Cmd, file.first).empty();
+  });
+  if (!isValid) {
+    ++Stats.Misses;
+    return false;
+  }
+
+  for (auto &file : entry.Files) {
+    if (writeFileAtomically(getOutputPath(Cmd, file.first), file.second)) {
+      // Whatever was written will be overwritten when the job runs.
+      ++Stats.Misses;
+      return false;
+    }
+  }
+
+  // Mark the entry as recently used, so that it's the last to be trimmed.
+  int entryFD;
+  if (!llvm::sys::fs::openFileForWrite(entryPath, entryFD,
+                                       llvm::sys::fs::F_Append)) {
+    (void)llvm::sys::fs::setLastModificationAndAccessTime(
+        entryFD, llvm::sys::TimeValue::now());
+    llvm::sys::Process::SafelyCloseFileDescriptor(entryFD);
+  }
+
+  Output = entry.Output;
+  ++Stats.Hits;
+  return true;
+}
+
+void CompilationCache::store(const Compilation &C, const Job &Cmd,
+                             StringRef Output) {
+  StringRef key = getKey(C, Cmd);
+  if (key.empty())
+    return;
+
+  // Use a scratch graph to find the job's external dependencies.
+  StringRef dependenciesPath =
+      Cmd.getOutput().getAdditionalOutputForType(types::TY_SwiftDeps);
+  DependencyGraph<const Job *> graph;
+  if (graph.loadFromPath(&Cmd, dependenciesPath) ==
+      DependencyGraphImpl::LoadResult::HadError)
+    return;
+
+  std::string data;
+  llvm::raw_string_ostream out(data);
+  out << EntrySignature;
+
+  for (StringRef dependency : graph.getExternalDependencies()) {
+    StringRef contentHash = getContentHash(dependency);
+    if (contentHash.empty())
+      return;
+    out << "external " << contentHash << " " << dependency << "\n";
+  }
+
+  out << "blob " << OutputBlobName << " " << Output.size() << "\n" << Output;
+
+  // Don't store a partial set of outputs.
+  bool missingOutput = false;
+  auto addFile = [&](types::ID type, StringRef path) {
+    auto buffer = llvm::MemoryBuffer::getFile(path);
+    if (!buffer) {
+      missingOutput = true;
+      return;
+    }
+    StringRef contents = buffer.get()->getBuffer();
+    out << "blob " << types::getTypeName(type) << " " << contents.size()
+        << "\n" << contents;
+  };
+  const CommandOutput &outputs = Cmd.getOutput();
+  addFile(outputs.getPrimaryOutputType(), outputs.getPrimaryOutputFilename());
+  types::forAllTypes([&](types::ID type) {
+    if (type == outputs.getPrimaryOutputType())
+      return;
+    StringRef path = outputs.getAdditionalOutputForType(type);
+    if (!path.empty())
+      addFile(type, path);
+  });
+  if (missingOutput)
+    return;
+  out.flush();
+
+  if (llvm::sys::fs::create_directories(Directory))
+    return;
+  if (writeFileAtomically(getEntryPath(key), data))
+    return;
+  ++Stats.Stores;
+}
+
+void CompilationCache::trim() {
+  struct EntryInfo {
+    std::string Path;
+    uint64_t Size;
+    llvm::sys::TimeValue LastUsed;
+  };
+  std::vector<EntryInfo> entries;
+  uint64_t totalSize = 0;
+
+  std::error_code EC;
+  for (llvm::sys::fs::directory_iterator I(Directory, EC), E;
+       I != E && !EC; I.increment(EC)) {
+    if (llvm::sys::path::extension(I->path()) != EntryExtension)
+      continue;
+    llvm::sys::fs::file_status status;
+    if (I->status(status))
+      continue;
+    entries.push_back({I->path(), status.getSize(),
+                       status.getLastModificationTime()});
+    totalSize += status.getSize();
+  }
+
+  if (totalSize <= SizeLimit)
+    return;
+
+  std::sort(entries.begin(), entries.end(),
+            [](const EntryInfo &lhs, const EntryInfo &rhs) {
+    return lhs.LastUsed < rhs.LastUsed;
+  });
+  for (const EntryInfo &entry : entries) {
+    if (totalSize <= SizeLimit)
+      break;
+    if (llvm::sys::fs::remove(entry.Path))
+      continue;
+    totalSize -= entry.Size;
+    ++Stats.Evictions;
+  }
+}
+
+void CompilationCache::printStatistics(raw_ostream &out) const {
+  out << "Compilation cache: " << Stats.Hits << " hits, " << Stats.Misses
+      << " misses, " << Stats.Stores << " stored, " << Stats.Evictions
+      << " evicted\n";
+}
@@ -12,6 +12,7 @@
 
 #include "swift/Driver/DependencyGraph.h"
 #include "swift/Basic/DemangleWrappers.h"
+#include "swift/Driver/BinaryDependencies.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringSwitch.h"
@@ -48,15 +49,118 @@ using LoadResult = DependencyGraphImpl::LoadResult;
 using DependencyKind = DependencyGraphImpl::DependencyKind;
 using DependencyCallbackTy = LoadResult(StringRef, DependencyKind, bool);
 using InterfaceHashCallbackTy = LoadResult(StringRef);
+using FingerprintCallbackTy = LoadResult(StringRef, DependencyKind, StringRef);
+
+static LoadResult
+parseBinaryDependencyFile(StringRef data,
+                          llvm::function_ref<DependencyCallbackTy> providesCallback,
+                          llvm::function_ref<DependencyCallbackTy> dependsCallback,
+                          llvm::function_ref<InterfaceHashCallbackTy> interfaceHashCallback,
+                          llvm::function_ref<FingerprintCallbackTy> fingerprintCallback) {
+  using binary_deps::Section;
+
+  auto file = binary_deps::DependencyFileView::get(data);
+  if (!file)
+    return LoadResult::HadError;
+
+  LoadResult result = LoadResult::UpToDate;
+  auto updateResult = [&result](LoadResult update) -> bool {
+    switch (update) {
+    case LoadResult::HadError:
+      return true;
+    case LoadResult::UpToDate:
+      break;
+    case LoadResult::AffectsDownstream:
+      result = LoadResult::AffectsDownstream;
+      break;
+    }
+    return false;
+  };
+
+  // Entries are stored in the order of the YAML form, so the callbacks see
+  // the same sequence of updates either way. Member entries are already keyed
+  // as "{MangledBaseName}\0memberName".
+  for (unsigned i = 0, e = file->getNumEntries(); i != e; ++i) {
+    binary_deps::DependencyEntry entry = file->getEntry(i);
+
+    DependencyKind kind;
+    bool isDepends;
+    switch (entry.Kind) {
+    case Section::ProvidesTopLevel:
+      kind = DependencyKind::TopLevelName;
+      isDepends = false;
+      break;
+    case Section::ProvidesNominal:
+      kind = DependencyKind::NominalType;
+      isDepends = false;
+      break;
+    case Section::ProvidesMember:
+      kind = DependencyKind::NominalTypeMember;
+      isDepends = false;
+      break;
+    case Section::ProvidesDynamicLookup:
+      kind = DependencyKind::DynamicLookupName;
+      isDepends = false;
+      break;
+    case Section::DependsTopLevel:
+      kind = DependencyKind::TopLevelName;
+      isDepends = true;
+      break;
+    case Section::DependsMember:
+      kind = DependencyKind::NominalTypeMember;
+      isDepends = true;
+      break;
+    case Section::DependsNominal:
+      kind = DependencyKind::NominalType;
+      isDepends = true;
+      break;
+    case Section::DependsDynamicLookup:
+      kind = DependencyKind::DynamicLookupName;
+      isDepends = true;
+      break;
+    case Section::DependsExternal:
+      kind = DependencyKind::ExternalFile;
+      isDepends = true;
+      break;
+    }
+
+    // Provided names are always cascading.
+    if (!isDepends && !entry.IsCascading)
+      return LoadResult::HadError;
+
+    auto &callback = isDepends ? dependsCallback : providesCallback;
+    if (updateResult(callback(entry.Name, kind, entry.IsCascading)))
+      return LoadResult::HadError;
+
+    if (!entry.Fingerprint.empty())
+      if (updateResult(fingerprintCallback(entry.Name, kind,
+                                           entry.Fingerprint)))
+        return LoadResult::HadError;
+  }
+
+  StringRef interfaceHash = file->getInterfaceHash();
+  if (!interfaceHash.empty())
+    if (updateResult(interfaceHashCallback(interfaceHash)))
+      return LoadResult::HadError;
+
+  return result;
+}
 
 static LoadResult
 parseDependencyFile(llvm::MemoryBuffer &buffer,
                     llvm::function_ref<DependencyCallbackTy> providesCallback,
                     llvm::function_ref<DependencyCallbackTy> dependsCallback,
-                    llvm::function_ref<InterfaceHashCallbackTy> interfaceHashCallback) {
+                    llvm::function_ref<InterfaceHashCallbackTy> interfaceHashCallback,
+                    llvm::function_ref<FingerprintCallbackTy> fingerprintCallback) {
   namespace yaml = llvm::yaml;
 
-  // FIXME: Switch to a format other than YAML.
+  if (binary_deps::isBinaryDependencyFile(buffer.getBuffer())) {
+    return parseBinaryDependencyFile(buffer.getBuffer(), providesCallback,
+                                     dependsCallback, interfaceHashCallback,
+                                     fingerprintCallback);
+  }
+
+  // FIXME: Drop the YAML form once the binary format is the only one in use.
   llvm::SourceMgr SM;
   yaml::Stream stream(buffer.getMemBufferRef(), SM);
   auto I = stream.begin();
@@ -105,6 +209,52 @@ parseDependencyFile(llvm::MemoryBuffer &buffer,
       StringRef valueString = value->getValue(scratch);
       UPDATE_RESULT(interfaceHashCallback(valueString));
 
+    } else if (keyString.startswith("fingerprints-")) {
+      DependencyKind kind = llvm::StringSwitch<DependencyKind>(keyString)
+        .Case("fingerprints-top-level", DependencyKind::TopLevelName)
+        .Case("fingerprints-nominal", DependencyKind::NominalType)
+        .Case("fingerprints-member", DependencyKind::NominalTypeMember)
+        .Default(DependencyKind());
+      if (kind == DependencyKind())
+        return LoadResult::HadError;
+
+      auto *entries = dyn_cast<yaml::SequenceNode>(i->getValue());
+      if (!entries)
+        return LoadResult::HadError;
+
+      // Each entry is the name as written in the corresponding "provides"
+      // section, followed by the fingerprint: ["name", "fingerprint"], or
+      // ["{MangledBaseName}", "memberName", "fingerprint"] for members.
+      unsigned numNameParts = kind == DependencyKind::NominalTypeMember ? 2 : 1;
+      for (yaml::Node &rawEntry : *entries) {
+        auto *entry = dyn_cast<yaml::SequenceNode>(&rawEntry);
+        if (!entry)
+          return LoadResult::HadError;
+
+        SmallString<64> name;
+        SmallString<32> fingerprintScratch;
+        StringRef fingerprint;
+        unsigned numParts = 0;
+        for (yaml::Node &rawPart : *entry) {
+          auto *part = dyn_cast<yaml::ScalarNode>(&rawPart);
+          if (!part)
+            return LoadResult::HadError;
+
+          if (numParts == numNameParts) {
+            fingerprint = part->getValue(fingerprintScratch);
+          } else if (numParts < numNameParts) {
+            if (numParts != 0)
+              name.push_back('\0');
+            name += part->getValue(scratch);
+          }
+          ++numParts;
+        }
+        if (numParts != numNameParts + 1 || fingerprint.empty())
+          return LoadResult::HadError;
+
+        UPDATE_RESULT(fingerprintCallback(name.str(), kind, fingerprint));
+      }
+
     } else {
       enum class DependencyDirection : bool {
         Depends,
@@ -223,6 +373,18 @@ LoadResult DependencyGraphImpl::loadFromBuffer(const void *node,
                                                llvm::MemoryBuffer &buffer) {
   auto &provides = Provides[node];
 
+  // Set aside the fingerprints from the previous load, so that we can tell
+  // which provided names have changed once this one is done.
+  std::vector<std::string> previousFingerprints;
+  previousFingerprints.reserve(provides.size());
+  for (auto &entry : provides) {
+    previousFingerprints.push_back(std::move(entry.fingerprint));
+    entry.fingerprint.clear();
+    entry.loadedKinds = DependencyMaskTy();
+    entry.fingerprintedKinds = DependencyMaskTy();
+    entry.isUnchanged = false;
+  }
+
   auto dependsCallback = [this, node](StringRef name, DependencyKind kind,
                                       bool isCascading) -> LoadResult {
     if (kind == DependencyKind::ExternalFile)
@@ -259,11 +421,33 @@ LoadResult DependencyGraphImpl::loadFromBuffer(const void *node,
       return name == entry.name;
     });
 
-    if (iter == provides.end())
-      provides.push_back({name, kind});
-    else
+    if (iter == provides.end()) {
+      provides.push_back({name, kind, {}, {}, {}, false});
+      iter = std::prev(provides.end());
+    } else {
       iter->kindMask |= kind;
+    }
 
+    iter->loadedKinds |= kind;
+    return LoadResult::UpToDate;
+  };
+
+  auto fingerprintCallback =
+      [&provides](StringRef name, DependencyKind kind,
+                  StringRef fingerprint) -> LoadResult {
+    auto iter = std::find_if(provides.begin(), provides.end(),
+                             [name](const ProvidesEntryTy &entry) -> bool {
+      return name == entry.name;
+    });
+
+    // A fingerprint must follow the entry it belongs to.
+    if (iter == provides.end() || !(iter->loadedKinds & kind))
+      return LoadResult::HadError;
+
+    iter->fingerprintedKinds |= kind;
+    if (!iter->fingerprint.empty())
+      iter->fingerprint.push_back(',');
+    iter->fingerprint += fingerprint;
     return LoadResult::UpToDate;
   };
 
@@ -285,8 +469,25 @@ LoadResult DependencyGraphImpl::loadFromBuffer(const void *node,
     return LoadResult::UpToDate;
   };
 
-  return parseDependencyFile(buffer, providesCallback, dependsCallback,
-                             interfaceHashCallback);
+  LoadResult result = parseDependencyFile(buffer, providesCallback,
+                                          dependsCallback,
+                                          interfaceHashCallback,
+                                          fingerprintCallback);
+  if (result == LoadResult::HadError)
+    return result;
+
+  // A name is unchanged only if it was fingerprinted under every kind it was
+  // provided as, both now and in the previous load. Names that are no longer
+  // provided at all are left with an empty fingerprint, and so count as
+  // changed.
+  for (size_t i = 0, e = previousFingerprints.size(); i != e; ++i) {
+    auto &entry = provides[i];
+    entry.isUnchanged = !entry.fingerprint.empty() &&
+                        entry.fingerprintedKinds.contains(entry.loadedKinds) &&
+                        entry.fingerprint == previousFingerprints[i];
+  }
+
+  return result;
 }
 
 void DependencyGraphImpl::markExternal(SmallVectorImpl<const void *> &visited,
@@ -308,7 +509,8 @@ void DependencyGraphImpl::markExternal(SmallVectorImpl<const void *> &visited,
 
 void
 DependencyGraphImpl::markTransitive(SmallVectorImpl<const void *> &visited,
-                                    const void *node, MarkTracerImpl *tracer) {
+                                    const void *node, MarkTracerImpl *tracer,
+                                    bool onlyChangedProvides) {
   assert(Provides.count(node) && "node is not in the graph");
   llvm::SpecificBumpPtrAllocator<MarkTracerImpl::Entry> scratchAlloc;
 
@@ -322,12 +524,16 @@ DependencyGraphImpl::markTransitive(SmallVectorImpl<const void *> &visited,
   SmallPtrSet<const void *, 16> visitedSet;
 
   auto addDependentsToWorklist = [&](const void *next,
-                                     ArrayRef<MarkTracerImpl::Entry> reason) {
+                                     ArrayRef<MarkTracerImpl::Entry> reason,
+                                     bool skipUnchanged) {
     auto allProvided = Provides.find(next);
     if (allProvided == Provides.end())
       return;
 
     for (const auto &provided : allProvided->second) {
+      if (skipUnchanged && provided.isUnchanged)
+        continue;
+
       auto allDependents = Dependencies.find(provided.name);
       if (allDependents == Dependencies.end())
         continue;
@@ -374,7 +580,7 @@ DependencyGraphImpl::markTransitive(SmallVectorImpl<const void *> &visited,
 
   // Always mark through the starting node, even if it's already marked.
   markIntransitive(node);
-  addDependentsToWorklist(node, {});
+  addDependentsToWorklist(node, {}, onlyChangedProvides);
 
   while (!worklist.empty()) {
     auto next = worklist.pop_back_val();
@@ -386,7 +592,7 @@ DependencyGraphImpl::markTransitive(SmallVectorImpl<const void *> &visited,
       continue;
     }
 
-    addDependentsToWorklist(next.Node, next.Reason);
+    addDependentsToWorklist(next.Node, next.Reason, /*skipUnchanged=*/false);
     if (!markIntransitive(next.Node))
       continue;
     record(next);
@@ -26,8 +26,12 @@
 #include "swift/Basic/TaskQueue.h"
 #include "swift/Basic/Version.h"
 #include "swift/Basic/Range.h"
+#include "swift/Basic/Statistic.h"
 #include "swift/Driver/Action.h"
+#include "swift/Driver/BinaryDependencies.h"
 #include "swift/Driver/Compilation.h"
+#include "swift/Driver/CompilationCache.h"
+#include "swift/Driver/FileStamp.h"
 #include "swift/Driver/Job.h"
 #include "swift/Driver/OutputFileMap.h"
 #include "swift/Driver/ToolChain.h"
@@ -190,6 +194,74 @@ class Driver::InputInfoMap
 };
 using InputInfoMap = Driver::InputInfoMap;
 
+/// Fills in \p map from the inputs of the previous build, returning true if
+/// any of those inputs have since been removed.
+static bool
+matchPreviousInputs(InputInfoMap &map, const InputFileList &inputs,
+                    const llvm::StringMap<CompileJobAction::InputInfo> &
+                      previousInputs) {
+  using InputInfo = CompileJobAction::InputInfo;
+
+  size_t numInputsFromPrevious = 0;
+  for (auto &inputPair : inputs) {
+    auto iter = previousInputs.find(inputPair.second->getValue());
+    if (iter == previousInputs.end()) {
+      map[inputPair.second] = InputInfo::makeNewlyAdded();
+      continue;
+    }
+    ++numInputsFromPrevious;
+    map[inputPair.second] = iter->getValue();
+  }
+
+  // If a file was removed, we've lost its dependency info. Rebuild everything.
+  // FIXME: Can we do better?
+  return numInputsFromPrevious != previousInputs.size();
+}
+
+static bool populateOutOfDateMapFromBinary(InputInfoMap &map,
+                                           StringRef argsHashStr,
+                                           const InputFileList &inputs,
+                                           StringRef data) {
+  using InputInfo = CompileJobAction::InputInfo;
+  using binary_deps::InputStatus;
+
+  auto record = binary_deps::BuildRecordView::get(data);
+  if (!record)
+    return true;
+
+  if (record->getVersion() != version::getSwiftFullVersion())
+    return true;
+  if (record->getOptions() != argsHashStr)
+    return true;
+
+  map[nullptr] = { InputInfo::NeedsCascadingBuild, record->getBuildTime() };
+
+  llvm::StringMap<InputInfo> previousInputs;
+  for (unsigned i = 0, e = record->getNumInputs(); i != e; ++i) {
+    binary_deps::BuildRecordInput input = record->getInput(i);
+
+    InputInfo::Status status;
+    switch (input.Status) {
+    case InputStatus::UpToDate:
+      status = InputInfo::UpToDate;
+      break;
+    case InputStatus::NeedsCascadingBuild:
+      status = InputInfo::NeedsCascadingBuild;
+      break;
+    case InputStatus::NeedsNonCascadingBuild:
+      status = InputInfo::NeedsNonCascadingBuild;
+      break;
+    }
+    InputInfo info;
+    info.status = status;
+    info.previousStamp = input.PreviousStamp;
+    info.previousDuration = input.PreviousDuration;
+    previousInputs[input.Path] = info;
+  }
+
+  return matchPreviousInputs(map, inputs, previousInputs);
+}
+
 static bool populateOutOfDateMap(InputInfoMap &map, StringRef argsHashStr,
                                  const InputFileList &inputs,
                                  StringRef buildRecordPath) {
@@ -198,6 +270,11 @@ static bool populateOutOfDateMap(InputInfoMap &map, StringRef argsHashStr,
   if (!buffer)
     return false;
 
+  if (binary_deps::isBinaryBuildRecord(buffer.get()->getBuffer())) {
+    return populateOutOfDateMapFromBinary(map, argsHashStr, inputs,
+                                          buffer.get()->getBuffer());
+  }
+
   namespace yaml = llvm::yaml;
   using InputInfo = CompileJobAction::InputInfo;
 
@@ -214,6 +291,8 @@ static bool populateOutOfDateMap(InputInfoMap &map, StringRef argsHashStr,
   SmallString<64> scratch;
 
   llvm::StringMap<InputInfo> previousInputs;
+  llvm::StringMap<FileStamp> previousStamps;
+  llvm::StringMap<unsigned> previousDurations;
   bool versionValid = false;
   bool optionsMatch = true;
 
@@ -254,6 +333,44 @@ static bool populateOutOfDateMap(InputInfoMap &map, StringRef argsHashStr,
     return false;
   };
 
+  // Reads "[size, device, inode]" or "[size, device, inode, hash]".
+  auto readStamp = [&scratch](yaml::Node *node, FileStamp &stamp) -> bool {
+    auto *seq = dyn_cast<yaml::SequenceNode>(node);
+    if (!seq)
+      return true;
+
+    unsigned index = 0;
+    for (auto seqI = seq->begin(), seqE = seq->end(); seqI != seqE;
+         ++seqI, ++index) {
+      auto *value = dyn_cast<yaml::ScalarNode>(&*seqI);
+      if (!value)
+        return true;
+      StringRef valueStr = value->getValue(scratch);
+
+      switch (index) {
+      case 0:
+        if (valueStr.getAsInteger(10, stamp.Size))
+          return true;
+        break;
+      case 1:
+        if (valueStr.getAsInteger(10, stamp.Device))
+          return true;
+        break;
+      case 2:
+        if (valueStr.getAsInteger(10, stamp.Inode))
+          return true;
+        break;
+      case 3:
+        if (stamp.setHashString(valueStr))
+          return true;
+        break;
+      default:
+        return true;
+      }
+    }
+    return index < 3;
+  };
+
   // FIXME: LLVM's YAML support does incremental parsing in such a way that
   // for-range loops break.
   for (auto i = topLevelMap->begin(), e = topLevelMap->end(); i != e; ++i) {
@@ -315,26 +432,103 @@ static bool populateOutOfDateMap(InputInfoMap &map, StringRef argsHashStr,
         auto inputName = key->getValue(scratch);
         previousInputs[inputName] = { *previousBuildState, timeValue };
       }
+
+    } else if (keyStr == "stamps") {
+      auto *stampMap = dyn_cast<yaml::MappingNode>(i->getValue());
+      if (!stampMap)
+        return true;
+
+      // FIXME: LLVM's YAML support does incremental parsing in such a way that
+      // for-range loops break.
+      for (auto i = stampMap->begin(), e = stampMap->end(); i != e; ++i) {
+        auto *key = dyn_cast<yaml::ScalarNode>(i->getKey());
+        if (!key)
+          return true;
+
+        FileStamp stamp;
+        if (readStamp(i->getValue(), stamp))
+          return true;
+
+        previousStamps[key->getValue(scratch)] = stamp;
+      }
+
+    } else if (keyStr == "durations") {
+      auto *durationMap = dyn_cast<yaml::MappingNode>(i->getValue());
+      if (!durationMap)
+        return true;
+
+      // FIXME: LLVM's YAML support does incremental parsing in such a way that
+      // for-range loops break.
+      for (auto i = durationMap->begin(), e = durationMap->end(); i != e; ++i) {
+        auto *key = dyn_cast<yaml::ScalarNode>(i->getKey());
+        if (!key)
+          return true;
+
+        auto *value = dyn_cast<yaml::ScalarNode>(i->getValue());
+        if (!value)
+          return true;
+
+        unsigned duration;
+        if (value->getValue(scratch).getAsInteger(10, duration))
+          return true;
+
+        previousDurations[key->getValue(scratch)] = duration;
+      }
     }
   }
 
   if (!versionValid || !optionsMatch)
     return true;
 
-  size_t numInputsFromPrevious = 0;
-  for (auto &inputPair : inputs) {
-    auto iter = previousInputs.find(inputPair.second->getValue());
-    if (iter == previousInputs.end()) {
-      map[inputPair.second] = InputInfo::makeNewlyAdded();
+  for (auto &entry : previousStamps) {
+    auto iter = previousInputs.find(entry.getKey());
+    if (iter == previousInputs.end())
       continue;
-    }
-    ++numInputsFromPrevious;
-    map[inputPair.second] = iter->getValue();
+    // The modification time comes from the "inputs" section.
+    FileStamp &stamp = iter->getValue().previousStamp;
+    llvm::sys::TimeValue modTime = stamp.ModTime;
+    stamp = entry.getValue();
+    stamp.ModTime = modTime;
   }
 
-  // If a file was removed, we've lost its dependency info. Rebuild everything.
-  // FIXME: Can we do better?
-  return numInputsFromPrevious != previousInputs.size();
+  for (auto &entry : previousDurations) {
+    auto iter = previousInputs.find(entry.getKey());
+    if (iter != previousInputs.end())
+      iter->getValue().previousDuration = entry.getValue();
+  }
+
+  return matchPreviousInputs(map, inputs, previousInputs);
+}
+
+/// Checks which of \p inputs have changed since the previous build, filling
+/// in the current stamp of each one's entry in \p map.
+///
+/// If \p changedFiles is given, inputs not on the list aren't looked at.
+static void checkInputStamps(InputInfoMap &map, const InputFileList &inputs,
+                             const ChangedFileList *changedFiles,
+                             bool useHashes) {
+  SmallVector<const Arg *, 16> checkedInputs;
+  std::vector<FileStampCheck> checks;
+  for (const InputPair &inputPair : inputs) {
+    if (!types::isPartOfSwiftCompilation(inputPair.first))
+      continue;
+
+    FileStampCheck check;
+    check.Path = inputPair.second->getValue();
+    check.Previous = map[inputPair.second].previousStamp;
+    check.AssumeUnchanged =
+        changedFiles && !changedFiles->contains(check.Path);
+    checks.push_back(check);
+    checkedInputs.push_back(inputPair.second);
+  }
+
+  checkFileStamps(checks, useHashes);
+
+  for (size_t i = 0, e = checks.size(); i != e; ++i) {
+    CompileJobAction::InputInfo &info = map[checkedInputs[i]];
+    info.currentStamp = checks[i].Current;
+    info.hasChanged = (checks[i].Status != FileStampCheck::Unchanged);
+  }
 }
 
 std::unique_ptr<Compilation> Driver::buildCompilation(
@@ -425,6 +619,15 @@ std::unique_ptr<Compilation> Driver::buildCompilation(
   SmallString<32> ArgsHash;
   computeArgsHash(ArgsHash, *TranslatedArgList);
 
+  StringRef buildRecordPath;
+  if (OFM) {
+    if (auto *masterOutputMap = OFM->getOutputMapForSingleOutput()) {
+      auto iter = masterOutputMap->find(types::TY_SwiftDeps);
+      if (iter != masterOutputMap->end())
+        buildRecordPath = iter->second;
+    }
+  }
+
   InputInfoMap outOfDateMap;
   bool rebuildEverything = true;
   if (Incremental) {
@@ -434,13 +637,6 @@ std::unique_ptr<Compilation> Driver::buildCompilation(
       Diags.diagnose(SourceLoc(), diag::incremental_requires_output_file_map);
 
     } else {
-      StringRef buildRecordPath;
-      if (auto *masterOutputMap = OFM->getOutputMapForSingleOutput()) {
-        auto iter = masterOutputMap->find(types::TY_SwiftDeps);
-        if (iter != masterOutputMap->end())
-          buildRecordPath = iter->second;
-      }
-
       if (buildRecordPath.empty()) {
         Diags.diagnose(SourceLoc(),
                        diag::incremental_requires_build_record_entry,
@@ -458,10 +654,44 @@ std::unique_ptr<Compilation> Driver::buildCompilation(
     }
   }
 
+  // If there will be a build record, find out which inputs have changed since
+  // the last build, and what they look like now so that the next build can
+  // tell the same.
+  bool checkedInputStamps = false;
+  std::unique_ptr<ChangedFileList> changedFiles;
+  if (!buildRecordPath.empty()) {
+    if (const Arg *A = ArgList->getLastArg(options::OPT_driver_changed_files)) {
+      std::error_code error;
+      changedFiles = ChangedFileList::load(A->getValue(), error);
+      if (!changedFiles) {
+        Diags.diagnose(SourceLoc(), diag::error_unable_to_load_changed_files,
+                       A->getValue(), error.message());
+        return nullptr;
+      }
+    }
+
+    if (rebuildEverything) {
+      // Nothing from the previous build can be used, but the stamps still
+      // need to be recorded for the next one.
+      for (const InputPair &inputPair : Inputs) {
+        outOfDateMap[inputPair.second] = {
+          CompileJobAction::InputInfo::NeedsCascadingBuild,
+          llvm::sys::TimeValue::MaxTime()
+        };
+      }
+    }
+
+    checkInputStamps(outOfDateMap, Inputs, changedFiles.get(),
+                     ArgList->hasArg(options::OPT_driver_compare_input_hashes));
+    checkedInputStamps = true;
+  }
+
   // Construct the graph of Actions.
   ActionList Actions;
   buildActions(*TC, *TranslatedArgList, Inputs, OI, OFM.get(),
-               rebuildEverything ? nullptr : &outOfDateMap, Actions);
+               (rebuildEverything && !checkedInputStamps) ? nullptr
+                                                          : &outOfDateMap,
+               Actions);
 
   if (Diags.hadAnyError())
     return nullptr;
@@ -480,6 +710,29 @@ std::unique_ptr<Compilation> Driver::buildCompilation(
     }
   }
 
+  bool BatchMode = ArgList->hasFlag(options::OPT_enable_batch_mode,
+                                    options::OPT_disable_batch_mode,
+                                    false);
+  unsigned BatchCount = NumberOfParallelCommands;
+  if (const Arg *A = ArgList->getLastArg(options::OPT_driver_batch_count)) {
+    if (StringRef(A->getValue()).getAsInteger(10, BatchCount)) {
+      Diags.diagnose(SourceLoc(), diag::error_invalid_arg_value,
+                     A->getAsString(*ArgList), A->getValue());
+      return nullptr;
+    }
+  }
+
+  uint64_t CacheSizeLimit = CompilationCache::DefaultSizeLimit;
+  if (const Arg *A =
+        ArgList->getLastArg(options::OPT_driver_compilation_cache_size_limit)) {
+    if (StringRef(A->getValue()).getAsInteger(10, CacheSizeLimit)) {
+      Diags.diagnose(SourceLoc(), diag::error_invalid_arg_value,
+                     A->getAsString(*ArgList), A->getValue());
+      return nullptr;
+    }
+    CacheSizeLimit *= 1024 * 1024;
+  }
+
   OutputLevel Level = OutputLevel::Normal;
   if (const Arg *A = ArgList->getLastArg(options::OPT_v,
                                          options::OPT_parseable_output)) {
@@ -513,6 +766,42 @@ std::unique_ptr<Compilation> Driver::buildCompilation(
   if (ShowIncrementalBuildDecisions)
     C->setShowsIncrementalBuildDecisions();
 
+  if (C->getArgs().hasArg(options::OPT_driver_ignore_fingerprints))
+    C->disableFingerprints();
+
+  if (C->getArgs().hasArg(options::OPT_driver_ignore_job_durations))
+    C->disableJobPriorities();
+
+  if (C->getArgs().hasArg(options::OPT_driver_time_compilation))
+    C->setShowsJobResourceUsage();
+
+  if (const Arg *A =
+        C->getArgs().getLastArg(options::OPT_driver_compilation_cache_path)) {
+    if (!DriverSkipExecution)
+      C->setCompilationCache(std::unique_ptr<CompilationCache>(
+          new CompilationCache(A->getValue(), CacheSizeLimit)));
+  }
+
+  if (const Arg *A =
+        C->getArgs().getLastArg(options::OPT_driver_use_frontend_server))
+    C->setFrontendServer(A->getValue());
+
+  if (changedFiles)
+    C->setChangedFileList(std::move(changedFiles));
+  if (C->getArgs().hasArg(options::OPT_driver_compare_input_hashes))
+    C->setComparesInputHashes();
+
+  if (const Arg *A = C->getArgs().getLastArg(options::OPT_stats_output_dir)) {
+    C->setStatsReporter(std::unique_ptr<UnifiedStatsReporter>(
+        new UnifiedStatsReporter("swift-driver", OI.ModuleName, "all",
+                                 A->getValue())));
+  }
+
+  // Batch mode only applies to compilations that would otherwise run one
+  // frontend job per primary file.
+  if (BatchMode && OI.CompilerMode == OutputInfo::Mode::StandardCompile)
+    C->enableBatchMode(*TC, OI, BatchCount);
+
   // This has to happen after building jobs, because otherwise we won't even
   // emit .swiftdeps files for the next build.
   if (rebuildEverything)
@@ -521,10 +810,12 @@ std::unique_ptr<Compilation> Driver::buildCompilation(
   if (OFM) {
     if (auto *masterOutputMap = OFM->getOutputMapForSingleOutput()) {
       C->setCompilationRecordPath(masterOutputMap->lookup(types::TY_SwiftDeps));
+      if (C->getArgs().hasArg(options::OPT_enable_binary_dependencies))
+        C->setBinaryCompilationRecord();
 
       auto buildEntry = outOfDateMap.find(nullptr);
       if (buildEntry != outOfDateMap.end())
-        C->setLastBuildTime(buildEntry->second.previousModTime);
+        C->setLastBuildTime(buildEntry->second.previousStamp.ModTime);
     }
   }
 
@@ -1582,11 +1873,17 @@ static void addAuxiliaryOutput(Compilation &C, CommandOutput &output,
   }
 }
 
-/// If the file at \p input has not been modified since the last build (i.e. its
-/// mtime has not changed), adjust the Job's condition accordingly.
+/// If the input has not been modified since the last build (as found by
+/// checkInputStamps), adjust the Job's condition accordingly.
+///
+/// If \p trustChangedFiles is set, the build system has said which files have
+/// changed, so the Job's output is assumed to still be there.
 static void
 handleCompileJobCondition(Job *J, CompileJobAction::InputInfo inputInfo,
-                          StringRef input, bool alwaysRebuildDependents) {
+                          bool alwaysRebuildDependents,
+                          bool trustChangedFiles) {
+  J->setInputStamp(inputInfo.currentStamp);
+
   if (inputInfo.status == CompileJobAction::InputInfo::NewlyAdded) {
     J->setCondition(Job::Condition::NewlyAdded);
     return;
@@ -1597,18 +1894,14 @@ handleCompileJobCondition(Job *J, CompileJobAction::InputInfo inputInfo,
     J->setCondition(Job::Condition::RunWithoutCascading);
   }
 
-  llvm::sys::fs::file_status inputStatus;
-  if (llvm::sys::fs::status(input, inputStatus))
-    return;
-
-  J->setInputModTime(inputStatus.getLastModificationTime());
-  if (J->getInputModTime() != inputInfo.previousModTime)
+  if (inputInfo.hasChanged)
     return;
 
   Job::Condition condition;
   switch (inputInfo.status) {
   case CompileJobAction::InputInfo::UpToDate:
-    if (!llvm::sys::fs::exists(J->getOutput().getPrimaryOutputFilename()))
+    if (!trustChangedFiles &&
+        !llvm::sys::fs::exists(J->getOutput().getPrimaryOutputFilename()))
       condition = Job::Condition::RunWithoutCascading;
     else
       condition = Job::Condition::CheckDependencies;
@@ -1871,8 +2164,10 @@ Job *Driver::buildJobsForAction(Compilation &C, const JobAction *JA,
       auto compileJob = cast<CompileJobAction>(JA);
       bool alwaysRebuildDependents =
           C.getArgs().hasArg(options::OPT_driver_always_rebuild_dependents);
-      handleCompileJobCondition(J, compileJob->getInputInfo(), BaseInput,
-                                alwaysRebuildDependents);
+      bool trustChangedFiles =
+          C.getArgs().hasArg(options::OPT_driver_changed_files);
+      handleCompileJobCondition(J, compileJob->getInputInfo(),
+                                alwaysRebuildDependents, trustChangedFiles);
     }
   }
 
@@ -0,0 +1,195 @@
+//===--- FileStamp.cpp - Recorded state of input files --------------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/Driver/FileStamp.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace swift;
+using namespace swift::driver;
+
+bool FileStamp::hasHash() const {
+  return std::any_of(std::begin(Hash), std::end(Hash),
+                     [](uint8_t byte) { return byte != 0; });
+}
+
+bool FileStamp::hasSameHash(const FileStamp &other) const {
+  return hasHash() && memcmp(Hash, other.Hash, sizeof(Hash)) == 0;
+}
+
+std::string FileStamp::getHashString() const {
+  if (!hasHash())
+    return std::string();
+
+  static const char digits[] = "0123456789abcdef";
+  std::string result;
+  result.reserve(2 * sizeof(Hash));
+  for (uint8_t byte : Hash) {
+    result.push_back(digits[byte >> 4]);
+    result.push_back(digits[byte & 0xF]);
+  }
+  return result;
+}
+
+bool FileStamp::setHashString(StringRef str) {
+  if (str.size() != 2 * sizeof(Hash))
+    return true;
+
+  uint8_t parsed[sizeof(Hash)];
+  for (size_t i = 0; i != sizeof(Hash); ++i) {
+    unsigned high = llvm::hexDigitValue(str[2 * i]);
+    unsigned low = llvm::hexDigitValue(str[2 * i + 1]);
+    if (high == -1U || low == -1U)
+      return true;
+    parsed[i] = (high << 4) | low;
+  }
+  memcpy(Hash, parsed, sizeof(Hash));
+  return false;
+}
+
+/// Returns \p path resolved against \p workingDirectory, without any "."
+/// components, so that different spellings of the same path compare equal.
+static SmallString<128> makeAbsolute(StringRef workingDirectory,
+                                     StringRef path) {
+  SmallString<128> result;
+  if (!llvm::sys::path::is_absolute(path))
+    result = workingDirectory;
+  llvm::sys::path::append(result, path);
+  llvm::sys::path::remove_dots(result);
+  return result;
+}
+
+std::unique_ptr<ChangedFileList>
+ChangedFileList::load(StringRef path, std::error_code &error) {
+  auto buffer = llvm::MemoryBuffer::getFile(path);
+  if (!buffer) {
+    error = buffer.getError();
+    return nullptr;
+  }
+
+  SmallString<128> workingDirectory;
+  if ((error = llvm::sys::fs::current_path(workingDirectory)))
+    return nullptr;
+
+  std::unique_ptr<ChangedFileList> result(new ChangedFileList());
+  SmallVector<StringRef, 64> lines;
+  buffer.get()->getBuffer().split(lines, '\n', /*MaxSplit=*/-1,
+                                  /*KeepEmpty=*/false);
+  for (StringRef line : lines) {
+    line = line.rtrim("\r");
+    if (line.empty())
+      continue;
+
+    result->Paths.insert(makeAbsolute(workingDirectory, line));
+  }
+  result->WorkingDirectory = workingDirectory.str();
+  return result;
+}
+
+bool ChangedFileList::contains(StringRef path) const {
+  return Paths.count(makeAbsolute(WorkingDirectory, path));
+}
+
+/// Reads the file at \p path and stores the hash of its contents in \p stamp.
+///
+/// \returns true on error, false on success
+static bool computeHash(StringRef path, FileStamp &stamp) {
+  auto buffer = llvm::MemoryBuffer::getFile(path, /*FileSize=*/-1,
+                                            /*RequiresNullTerminator=*/false);
+  if (!buffer)
+    return true;
+
+  llvm::MD5 hash;
+  hash.update(buffer.get()->getBuffer());
+  llvm::MD5::MD5Result hashBuf;
+  hash.final(hashBuf);
+  memcpy(stamp.Hash, &hashBuf, sizeof(stamp.Hash));
+  return false;
+}
+
+static void checkFileStamp(FileStampCheck &check, bool useHashes) {
+  if (check.AssumeUnchanged && check.Previous.isKnown()) {
+    check.Current = check.Previous;
+    check.Status = FileStampCheck::Unchanged;
+    return;
+  }
+
+  llvm::sys::fs::file_status status;
+  if ((check.Error = llvm::sys::fs::status(check.Path, status))) {
+    check.Status = FileStampCheck::Missing;
+    return;
+  }
+
+  FileStamp &current = check.Current;
+  current.ModTime = status.getLastModificationTime();
+  current.Size = status.getSize();
+  current.Device = status.getUniqueID().getDevice();
+  current.Inode = status.getUniqueID().getFile();
+
+  if (check.Previous.isKnown() && current.hasSameAttributes(check.Previous)) {
+    memcpy(current.Hash, check.Previous.Hash, sizeof(current.Hash));
+    check.Status = FileStampCheck::Unchanged;
+    return;
+  }
+
+  // The file may only have been touched (or copied over with the same
+  // contents), which shouldn't cause a rebuild. A file that can't be read
+  // counts as changed; the frontend will report the problem.
+  if (!useHashes || computeHash(check.Path, current)) {
+    check.Status = FileStampCheck::Changed;
+    return;
+  }
+  check.Status = current.hasSameHash(check.Previous) ?
+      FileStampCheck::Unchanged : FileStampCheck::Changed;
+}
+
+void driver::checkFileStamps(MutableArrayRef<FileStampCheck> checks,
+                             bool useHashes) {
+  // Give each thread enough files that starting it is worthwhile. stat() on a
+  // network filesystem mostly waits, so use more threads than there are
+  // cores.
+  const size_t minChecksPerThread = 32;
+  size_t numThreads = std::max(1U, std::thread::hardware_concurrency()) * 2;
+  numThreads = std::min(numThreads,
+                        (checks.size() + minChecksPerThread - 1) /
+                          minChecksPerThread);
+
+  if (numThreads <= 1) {
+    for (FileStampCheck &check : checks)
+      checkFileStamp(check, useHashes);
+    return;
+  }
+
+  std::atomic<size_t> next(0);
+  auto worker = [&] {
+    for (size_t i = next++; i < checks.size(); i = next++)
+      checkFileStamp(checks[i], useHashes);
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(numThreads - 1);
+  for (size_t i = 1; i != numThreads; ++i)
+    threads.emplace_back(worker);
+  worker();
+  for (std::thread &thread : threads)
+    thread.join();
+}
@@ -106,3 +106,17 @@ void Job::printCommandLine(raw_ostream &os, StringRef Terminator) const {
   printArguments(os, Arguments);
   os << Terminator;
 }
+
+BatchJob::BatchJob(const JobAction &Source,
+                   std::unique_ptr<CommandOutput> Output,
+                   const char *Executable,
+                   llvm::opt::ArgStringList Arguments,
+                   EnvironmentVector ExtraEnvironment,
+                   FilelistInfo Info,
+                   ArrayRef<const Job *> Combined,
+                   const char *OutputFileMapPath)
+    : Job(Source, SmallVector<const Job *, 4>(), std::move(Output),
+          Executable, std::move(Arguments), std::move(ExtraEnvironment),
+          std::move(Info)),
+      CombinedJobs(Combined.begin(), Combined.end()),
+      OutputFileMapPath(OutputFileMapPath) {}
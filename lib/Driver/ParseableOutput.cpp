@@ -61,6 +61,16 @@ namespace json {
     }
   };
 
+  template<>
+  struct ObjectTraits<sys::TaskResourceUsage> {
+    static void mapping(Output &out, sys::TaskResourceUsage &value) {
+      out.mapRequired("wall-time", value.WallTime);
+      out.mapRequired("user-time", value.UserTime);
+      out.mapRequired("system-time", value.SystemTime);
+      out.mapRequired("max-rss", value.MaxRSS);
+    }
+  };
+
   template<typename T, unsigned N>
   struct ArrayTraits<SmallVector<T, N>> {
     static size_t size(Output &out, SmallVector<T, N> &seq) {
@@ -174,14 +184,16 @@ public:
 
 class TaskOutputMessage : public TaskBasedMessage {
   std::string Output;
+  Optional<sys::TaskResourceUsage> Usage;
 public:
   TaskOutputMessage(StringRef Kind, const Job &Cmd, ProcessId Pid,
-                    StringRef Output) : TaskBasedMessage(Kind, Cmd, Pid),
-                                        Output(Output) {}
+                    StringRef Output, Optional<sys::TaskResourceUsage> Usage)
+      : TaskBasedMessage(Kind, Cmd, Pid), Output(Output), Usage(Usage) {}
 
   virtual void provideMapping(swift::json::Output &out) {
     TaskBasedMessage::provideMapping(out);
     out.mapOptional("output", Output, std::string());
+    out.mapOptional("usage", Usage);
   }
 };
 
@@ -189,9 +201,9 @@ class FinishedMessage : public TaskOutputMessage {
   int ExitStatus;
 public:
   FinishedMessage(const Job &Cmd, ProcessId Pid, StringRef Output,
-                  int ExitStatus) : TaskOutputMessage("finished", Cmd, Pid,
-                                                      Output),
-                                    ExitStatus(ExitStatus) {}
+                  Optional<sys::TaskResourceUsage> Usage, int ExitStatus)
+      : TaskOutputMessage("finished", Cmd, Pid, Output, Usage),
+        ExitStatus(ExitStatus) {}
 
   virtual void provideMapping(swift::json::Output &out) {
     TaskOutputMessage::provideMapping(out);
@@ -203,9 +215,9 @@ class SignalledMessage : public TaskOutputMessage {
   std::string ErrorMsg;
 public:
   SignalledMessage(const Job &Cmd, ProcessId Pid, StringRef Output,
-                   StringRef ErrorMsg) : TaskOutputMessage("signalled", Cmd,
-                                                           Pid, Output),
-                                         ErrorMsg(ErrorMsg) {}
+                   Optional<sys::TaskResourceUsage> Usage, StringRef ErrorMsg)
+      : TaskOutputMessage("signalled", Cmd, Pid, Output, Usage),
+        ErrorMsg(ErrorMsg) {}
 
   virtual void provideMapping(swift::json::Output &out) {
     TaskOutputMessage::provideMapping(out);
@@ -252,16 +264,18 @@ void parseable_output::emitBeganMessage(raw_ostream &os,
 
 void parseable_output::emitFinishedMessage(raw_ostream &os,
                                            const Job &Cmd, ProcessId Pid,
-                                           int ExitStatus, StringRef Output) {
-  FinishedMessage msg(Cmd, Pid, Output, ExitStatus);
+                                           int ExitStatus, StringRef Output,
+                                           Optional<TaskResourceUsage> Usage) {
+  FinishedMessage msg(Cmd, Pid, Output, Usage, ExitStatus);
   emitMessage(os, msg);
 }
 
 void parseable_output::emitSignalledMessage(raw_ostream &os,
                                             const Job &Cmd, ProcessId Pid,
                                             StringRef ErrorMsg,
-                                            StringRef Output) {
-  SignalledMessage msg(Cmd, Pid, Output, ErrorMsg);
+                                            StringRef Output,
+                                            Optional<TaskResourceUsage> Usage) {
+  SignalledMessage msg(Cmd, Pid, Output, Usage, ErrorMsg);
   emitMessage(os, msg);
 }
 
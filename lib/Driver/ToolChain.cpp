@@ -121,6 +121,44 @@ ToolChain::constructJob(const JobAction &JA,
                                 std::move(invocationInfo.FilelistInfo));
 }
 
+std::unique_ptr<BatchJob>
+ToolChain::constructBatchJob(ArrayRef<const Job *> jobs,
+                             Compilation &C,
+                             const OutputInfo &OI) const {
+  assert(jobs.size() > 1 && "a batch must combine several jobs");
+  const Job *first = jobs.front();
+  auto &JA = cast<CompileJobAction>(first->getSource());
+
+  ActionList inputActions;
+  auto output = llvm::make_unique<CommandOutput>(
+    first->getOutput().getPrimaryOutputType());
+  for (const Job *job : jobs) {
+    assert(isa<CompileJobAction>(job->getSource()) &&
+           "only compile jobs can be batched");
+    for (Action *input : job->getSource().getInputs())
+      inputActions.push_back(input);
+
+    const CommandOutput &jobOutput = job->getOutput();
+    output->addPrimaryOutput(jobOutput.getPrimaryOutputFilename(),
+                             jobOutput.getBaseInput(0));
+  }
+
+  JobContext context{C, {}, inputActions, *output, OI};
+  InvocationInfo invocationInfo = constructInvocation(JA, context);
+
+  const char *outputFileMapPath =
+    context.getTemporaryFilePath("batch-outputs", "json");
+  invocationInfo.Arguments.push_back("-batch-output-file-map");
+  invocationInfo.Arguments.push_back(outputFileMapPath);
+
+  return llvm::make_unique<BatchJob>(JA, std::move(output),
+                                     first->getExecutable(),
+                                     std::move(invocationInfo.Arguments),
+                                     std::move(invocationInfo.ExtraEnvironment),
+                                     std::move(invocationInfo.FilelistInfo),
+                                     jobs, outputFileMapPath);
+}
+
 std::string
 ToolChain::findProgramRelativeToSwift(StringRef executableName) const {
   auto insertionResult =
@@ -126,6 +126,7 @@ static void addCommonFrontendArgs(const ToolChain &TC,
   inputArgs.AddLastArg(arguments, options::OPT_parse_stdlib);
   inputArgs.AddLastArg(arguments, options::OPT_resource_dir);
   inputArgs.AddLastArg(arguments, options::OPT_solver_memory_threshold);
+  inputArgs.AddLastArg(arguments, options::OPT_stats_output_dir);
   inputArgs.AddLastArg(arguments, options::OPT_suppress_warnings);
   inputArgs.AddLastArg(arguments, options::OPT_profile_generate);
   inputArgs.AddLastArg(arguments, options::OPT_profile_coverage_mapping);
@@ -244,30 +245,35 @@ ToolChain::constructInvocation(const CompileJobAction &job,
   switch (context.OI.CompilerMode) {
   case OutputInfo::Mode::StandardCompile:
   case OutputInfo::Mode::UpdateCode: {
-    assert(context.InputActions.size() == 1 &&
-           "The Swift frontend expects exactly one input (the primary file)!");
-
-    auto *IA = cast<InputAction>(context.InputActions[0]);
-    const Arg &PrimaryInputArg = IA->getInputArg();
+    // There is more than one primary file only for a batch mode job.
+    assert(!context.InputActions.empty() &&
+           "The Swift frontend expects at least one input (the primary file)!");
 
     if (context.Args.hasArg(options::OPT_driver_use_filelists) ||
         context.getTopLevelInputFiles().size() > TOO_MANY_FILES) {
       Arguments.push_back("-filelist");
       Arguments.push_back(context.getAllSourcesPath());
-      Arguments.push_back("-primary-file");
-      PrimaryInputArg.render(context.Args, Arguments);
+      for (const Action *A : context.InputActions) {
+        Arguments.push_back("-primary-file");
+        cast<InputAction>(A)->getInputArg().render(context.Args, Arguments);
+      }
     } else {
-      bool FoundPrimaryInput = false;
+      auto isPrimaryInput = [&](const Arg *InputArg) -> bool {
+        return std::any_of(context.InputActions.begin(),
+                           context.InputActions.end(),
+                           [&](const Action *A) {
+          return cast<InputAction>(A)->getInputArg().getIndex() ==
+                   InputArg->getIndex();
+        });
+      };
+
       for (auto inputPair : context.getTopLevelInputFiles()) {
         if (!types::isPartOfSwiftCompilation(inputPair.first))
           continue;
 
         // See if this input should be passed with -primary-file.
-        if (!FoundPrimaryInput &&
-            PrimaryInputArg.getIndex() == inputPair.second->getIndex()) {
+        if (isPrimaryInput(inputPair.second))
           Arguments.push_back("-primary-file");
-          FoundPrimaryInput = true;
-        }
         Arguments.push_back(inputPair.second->getValue());
       }
     }
@@ -348,6 +354,11 @@ ToolChain::constructInvocation(const CompileJobAction &job,
     Arguments.push_back(ReferenceDependenciesPath.c_str());
   }
 
+  // Batch jobs name their dependencies files in an output file map, so pass
+  // this along even without a path on the command line.
+  if (context.Args.hasArg(options::OPT_enable_binary_dependencies))
+    Arguments.push_back("-binary-reference-dependencies");
+
   const std::string &FixitsPath =
     context.Output.getAdditionalOutputForType(types::TY_Remapping);
   if (!FixitsPath.empty()) {
@@ -361,6 +372,10 @@ ToolChain::constructInvocation(const CompileJobAction &job,
         context.Args.MakeArgString(Twine(context.OI.numThreads)));
   }
 
+  // Only the primary files' function bodies are type-checked and emitted.
+  if (context.OI.CompilerMode == OutputInfo::Mode::StandardCompile)
+    Arguments.push_back("-skip-secondary-function-bodies");
+
   // Add the output file argument if necessary.
   if (context.Output.getPrimaryOutputType() != types::TY_Nothing) {
     if (context.Args.hasArg(options::OPT_driver_use_filelists) ||
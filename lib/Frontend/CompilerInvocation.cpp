@@ -111,32 +111,14 @@ static void debugFailWithCrash() {
   LLVM_BUILTIN_TRAP;
 }
 
-static unsigned readFileList(std::vector<std::string> &inputFiles,
-                             const llvm::opt::Arg *filelistPath,
-                             const llvm::opt::Arg *primaryFileArg = nullptr) {
-  bool foundPrimaryFile = false;
-  unsigned primaryFileIndex = 0;
-  StringRef primaryFile;
-  if (primaryFileArg)
-    primaryFile = primaryFileArg->getValue();
-
+static void readFileList(std::vector<std::string> &inputFiles,
+                         const llvm::opt::Arg *filelistPath) {
   llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer =
       llvm::MemoryBuffer::getFile(filelistPath->getValue());
   assert(buffer && "can't read filelist; unrecoverable");
 
-  for (StringRef line : make_range(llvm::line_iterator(*buffer.get()), {})) {
+  for (StringRef line : make_range(llvm::line_iterator(*buffer.get()), {}))
     inputFiles.push_back(line);
-    if (foundPrimaryFile)
-      continue;
-    if (line == primaryFile)
-      foundPrimaryFile = true;
-    else
-      ++primaryFileIndex;
-  }
-
-  if (primaryFileArg)
-    assert(foundPrimaryFile && "primary file not found in filelist");
-  return primaryFileIndex;
 }
 
 static bool ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
@@ -172,13 +154,52 @@ static bool ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
   Opts.EmitSortedSIL |= Args.hasArg(OPT_emit_sorted_sil);
 
   Opts.DelayedFunctionBodyParsing |= Args.hasArg(OPT_delayed_function_body_parsing);
+  Opts.SkipSecondaryFunctionBodies |=
+    Args.hasArg(OPT_skip_secondary_function_bodies);
+  if (const Arg *A = Args.getLastArg(OPT_num_parsing_threads)) {
+    if (StringRef(A->getValue()).getAsInteger(10, Opts.NumParsingThreads)) {
+      Diags.diagnose(SourceLoc(), diag::error_invalid_arg_value,
+                     A->getAsString(Args), A->getValue());
+      return true;
+    }
+  }
   Opts.EnableTesting |= Args.hasArg(OPT_enable_testing);
   Opts.EnableResilience |= Args.hasArg(OPT_enable_resilience);
 
   Opts.PrintStats |= Args.hasArg(OPT_print_stats);
   Opts.PrintClangStats |= Args.hasArg(OPT_print_clang_stats);
   Opts.DebugTimeFunctionBodies |= Args.hasArg(OPT_debug_time_function_bodies);
+  if (const Arg *A = Args.getLastArg(OPT_warn_long_function_bodies)) {
+    StringRef value = A->getValue();
+    if (value.getAsInteger(10, Opts.WarnLongFunctionBodies)) {
+      Diags.diagnose(SourceLoc(), diag::error_invalid_arg_value,
+                     A->getAsString(Args), A->getValue());
+      return true;
+    }
+  }
+  if (const Arg *A = Args.getLastArg(OPT_warn_long_expression_type_checking)) {
+    StringRef value = A->getValue();
+    if (value.getAsInteger(10, Opts.WarnLongExpressionTypeChecking)) {
+      Diags.diagnose(SourceLoc(), diag::error_invalid_arg_value,
+                     A->getAsString(Args), A->getValue());
+      return true;
+    }
+  }
+  Opts.DebugAlwaysWarnLongTypeChecking |=
+    Args.hasArg(OPT_debug_always_warn_long_type_checking);
   Opts.DebugTimeCompilation |= Args.hasArg(OPT_debug_time_compilation);
+  if (const Arg *A = Args.getLastArg(OPT_trace_compile_time))
+    Opts.CompileTimeTracePath = A->getValue();
+  if (const Arg *A = Args.getLastArg(OPT_trace_compile_time_granularity)) {
+    StringRef value = A->getValue();
+    if (value.getAsInteger(10, Opts.CompileTimeTraceGranularity)) {
+      Diags.diagnose(SourceLoc(), diag::error_invalid_arg_value,
+                     A->getAsString(Args), A->getValue());
+      return true;
+    }
+  }
+  if (const Arg *A = Args.getLastArg(OPT_stats_output_dir))
+    Opts.StatsOutputDir = A->getValue();
 
   Opts.PlaygroundTransform |= Args.hasArg(OPT_playground);
   if (Args.hasArg(OPT_disable_playground_transform))
@@ -196,12 +217,16 @@ static bool ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
     }
   }
 
+  std::vector<SelectedInput> primaryInputs;
   if (const Arg *A = Args.getLastArg(OPT_filelist)) {
-    const Arg *primaryFileArg = Args.getLastArg(OPT_primary_file);
-    auto primaryFileIndex = readFileList(Opts.InputFilenames, A,
-                                         primaryFileArg);
-    if (primaryFileArg)
-      Opts.PrimaryInput = SelectedInput(primaryFileIndex);
+    readFileList(Opts.InputFilenames, A);
+    for (const Arg *primaryFileArg : Args.filtered(OPT_primary_file)) {
+      auto begin = Opts.InputFilenames.begin();
+      auto end = Opts.InputFilenames.end();
+      auto found = std::find(begin, end, primaryFileArg->getValue());
+      assert(found != end && "primary file not found in filelist");
+      primaryInputs.push_back(SelectedInput(found - begin));
+    }
     assert(!Args.hasArg(OPT_INPUT) && "mixing -filelist with inputs");
   } else {
     for (const Arg *A : make_range(Args.filtered_begin(OPT_INPUT,
@@ -210,7 +235,7 @@ static bool ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
       if (A->getOption().matches(OPT_INPUT)) {
         Opts.InputFilenames.push_back(A->getValue());
       } else if (A->getOption().matches(OPT_primary_file)) {
-        Opts.PrimaryInput = SelectedInput(Opts.InputFilenames.size());
+        primaryInputs.push_back(SelectedInput(Opts.InputFilenames.size()));
         Opts.InputFilenames.push_back(A->getValue());
       } else {
         llvm_unreachable("Unknown input-related argument!");
@@ -218,6 +243,19 @@ static bool ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
     }
   }
 
+  if (!primaryInputs.empty())
+    Opts.PrimaryInput = primaryInputs.front();
+  if (primaryInputs.size() > 1) {
+    Opts.BatchPrimaryInputs = std::move(primaryInputs);
+    if (const Arg *A = Args.getLastArg(OPT_batch_output_file_map)) {
+      Opts.BatchOutputFileMapPath = A->getValue();
+    } else {
+      Diags.diagnose(SourceLoc(),
+                     diag::error_batch_mode_requires_output_file_map);
+      return true;
+    }
+  }
+
   Opts.ParseStdlib |= Args.hasArg(OPT_parse_stdlib);
 
   // Determine what the user has asked the frontend to do.
@@ -276,6 +314,32 @@ static bool ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
     return true;
   }
 
+  if (Opts.isBatchMode()) {
+    switch (Opts.RequestedAction) {
+    case FrontendOptions::NoneAction:
+    case FrontendOptions::DumpParse:
+    case FrontendOptions::DumpInterfaceHash:
+    case FrontendOptions::DumpAST:
+    case FrontendOptions::PrintAST:
+    case FrontendOptions::DumpTypeRefinementContexts:
+    case FrontendOptions::Immediate:
+    case FrontendOptions::REPL:
+    case FrontendOptions::EmitSIBGen:
+    case FrontendOptions::EmitSIB:
+      Diags.diagnose(SourceLoc(), diag::error_batch_mode_unsupported_action);
+      return true;
+    case FrontendOptions::Parse:
+    case FrontendOptions::EmitSILGen:
+    case FrontendOptions::EmitSIL:
+    case FrontendOptions::EmitModuleOnly:
+    case FrontendOptions::EmitAssembly:
+    case FrontendOptions::EmitIR:
+    case FrontendOptions::EmitBC:
+    case FrontendOptions::EmitObject:
+      break;
+    }
+  }
+
   bool TreatAsSIL = Args.hasArg(OPT_parse_sil);
   if (!TreatAsSIL && Opts.InputFilenames.size() == 1) {
     // If we have exactly one input filename, and its extension is "sil",
@@ -526,6 +590,13 @@ static bool ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
     }
   }
 
+  if (Opts.isBatchMode() && Opts.actionHasOutput() &&
+      Opts.OutputFilenames.size() != Opts.BatchPrimaryInputs.size()) {
+    Diags.diagnose(SourceLoc(), diag::error_batch_mode_output_count,
+                   Opts.BatchPrimaryInputs.size());
+    return true;
+  }
+
   auto determineOutputFilename = [&](std::string &output,
                                      OptSpecifier optWithoutPath,
                                      OptSpecifier optWithPath,
@@ -575,6 +646,8 @@ static bool ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
                           OPT_emit_reference_dependencies,
                           OPT_emit_reference_dependencies_path,
                           "swiftdeps", false);
+  Opts.BinaryReferenceDependencies =
+    Args.hasArg(OPT_binary_reference_dependencies);
   determineOutputFilename(Opts.SerializedDiagnosticsPath,
                           OPT_serialize_diagnostics,
                           OPT_serialize_diagnostics_path,
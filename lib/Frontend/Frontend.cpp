@@ -27,6 +27,7 @@
 #include "swift/Parse/Lexer.h"
 #include "swift/SIL/SILModule.h"
 #include "swift/Serialization/SerializedModuleLoader.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Support/CommandLine.h"
@@ -42,9 +43,35 @@ void CompilerInstance::createSILModule(bool WholeModule) {
                                               WholeModule);
 }
 
+bool CompilerInstance::isPrimaryBuffer(unsigned BufferID) const {
+  if (BatchPrimaryBufferIDs.empty())
+    return BufferID == PrimaryBufferID;
+  return std::find(BatchPrimaryBufferIDs.begin(), BatchPrimaryBufferIDs.end(),
+                   BufferID) != BatchPrimaryBufferIDs.end();
+}
+
 void CompilerInstance::setPrimarySourceFile(SourceFile *SF) {
   assert(SF);
   assert(MainModule && "main module not created yet");
+
+  if (!BatchPrimaryBufferIDs.empty()) {
+    unsigned BufferID = SF->getBufferID().getValue();
+    auto Found = std::find(BatchPrimaryBufferIDs.begin(),
+                           BatchPrimaryBufferIDs.end(), BufferID);
+    assert(Found != BatchPrimaryBufferIDs.end() && "not a primary buffer");
+    BatchPrimarySourceFiles[Found - BatchPrimaryBufferIDs.begin()] = SF;
+
+    // Every primary file records its own references, so that each can have
+    // its own dependencies file.
+    if (BufferID != PrimaryBufferID) {
+      if (NameTracker) {
+        BatchNameTrackers.emplace_back();
+        SF->setReferencedNameTracker(&BatchNameTrackers.back());
+      }
+      return;
+    }
+  }
+
   assert(!PrimarySourceFile && "already has a primary source file");
   assert(PrimaryBufferID == NO_SUCH_BUFFER || !SF->getBufferID().hasValue() ||
          SF->getBufferID().getValue() == PrimaryBufferID);
@@ -52,20 +79,9 @@ void CompilerInstance::setPrimarySourceFile(SourceFile *SF) {
   PrimarySourceFile->setReferencedNameTracker(NameTracker);
 }
 
-bool CompilerInstance::setup(const CompilerInvocation &Invok) {
+void CompilerInstance::setInvocation(const CompilerInvocation &Invok) {
   Invocation = Invok;
 
-  // Honor -Xllvm.
-  if (!Invok.getFrontendOptions().LLVMArgs.empty()) {
-    llvm::SmallVector<const char *, 4> Args;
-    Args.push_back("swift (LLVM option parsing)");
-    for (unsigned i = 0, e = Invok.getFrontendOptions().LLVMArgs.size(); i != e;
-         ++i)
-      Args.push_back(Invok.getFrontendOptions().LLVMArgs[i].c_str());
-    Args.push_back(nullptr);
-    llvm::cl::ParseCommandLineOptions(Args.size()-1, Args.data());
-  }
-
   if (Invocation.getDiagnosticOptions().ShowDiagnosticsAfterFatalError) {
     Diagnostics.setShowDiagnosticsAfterFatalError();
   }
@@ -80,6 +96,22 @@ bool CompilerInstance::setup(const CompilerInvocation &Invok) {
   // parsing to remember comments.
   if (!Invocation.getFrontendOptions().ModuleDocOutputPath.empty())
     Invocation.getLangOptions().AttachCommentsToDecls = true;
+}
+
+bool CompilerInstance::setupASTContext(const CompilerInvocation &Invok) {
+  assert(!Context && "ASTContext already set up");
+  setInvocation(Invok);
+
+  // Honor -Xllvm.
+  if (!Invok.getFrontendOptions().LLVMArgs.empty()) {
+    llvm::SmallVector<const char *, 4> Args;
+    Args.push_back("swift (LLVM option parsing)");
+    for (unsigned i = 0, e = Invok.getFrontendOptions().LLVMArgs.size(); i != e;
+         ++i)
+      Args.push_back(Invok.getFrontendOptions().LLVMArgs[i].c_str());
+    Args.push_back(nullptr);
+    llvm::cl::ParseCommandLineOptions(Args.size()-1, Args.data());
+  }
 
   Context.reset(new ASTContext(Invocation.getLangOptions(),
                                Invocation.getSearchPathOptions(),
@@ -110,6 +142,18 @@ bool CompilerInstance::setup(const CompilerInvocation &Invok) {
   }
 
   Context->addModuleLoader(std::move(clangImporter), /*isClang*/true);
+  return false;
+}
+
+bool CompilerInstance::setup(const CompilerInvocation &Invok) {
+  if (Context) {
+    // Reuse the context created by setupASTContext(). The new invocation
+    // differs only in its inputs and outputs, so the context's references to
+    // the language and search path options stay valid.
+    setInvocation(Invok);
+  } else if (setupASTContext(Invok)) {
+    return true;
+  }
 
   assert(Lexer::isIdentifier(Invocation.getModuleName()));
 
@@ -117,8 +161,12 @@ bool CompilerInstance::setup(const CompilerInvocation &Invok) {
   auto CodeCompletePoint = Invocation.getCodeCompletionPoint();
   if (CodeCompletePoint.first) {
     auto MemBuf = CodeCompletePoint.first;
-    // CompilerInvocation doesn't own the buffers, copy to a new buffer.
-    CodeCompletionBufferID = SourceMgr.addMemBufferCopy(MemBuf);
+    // CompilerInvocation doesn't own the buffers; copy to a new buffer unless
+    // the client promised to keep it alive.
+    if (Invocation.getBuffersOutliveInstance())
+      CodeCompletionBufferID = SourceMgr.addMemBufferRef(MemBuf);
+    else
+      CodeCompletionBufferID = SourceMgr.addMemBufferCopy(MemBuf);
     BufferIDs.push_back(*CodeCompletionBufferID);
     SourceMgr.setCodeCompletionPoint(*CodeCompletionBufferID,
                                      CodeCompletePoint.second);
@@ -133,18 +181,29 @@ bool CompilerInstance::setup(const CompilerInvocation &Invok) {
   const Optional<SelectedInput> &PrimaryInput =
     Invocation.getFrontendOptions().PrimaryInput;
 
+  // The buffer for each input filename, so that batch mode primary inputs
+  // can be found once all inputs are loaded.
+  std::vector<unsigned> FilenameBufferIDs(
+    Invocation.getInputFilenames().size(), NO_SUCH_BUFFER);
+
   // Add the memory buffers first, these will be associated with a filename
   // and they can replace the contents of an input filename.
   for (unsigned i = 0, e = Invocation.getInputBuffers().size(); i != e; ++i) {
-    // CompilerInvocation doesn't own the buffers, copy to a new buffer.
     auto *InputBuffer = Invocation.getInputBuffers()[i];
-    auto Copy = std::unique_ptr<llvm::MemoryBuffer>(
-        llvm::MemoryBuffer::getMemBufferCopy(
-            InputBuffer->getBuffer(), InputBuffer->getBufferIdentifier()));
-    if (serialization::isSerializedAST(Copy->getBuffer())) {
-      PartialModules.push_back({ std::move(Copy), nullptr });
+    if (serialization::isSerializedAST(InputBuffer->getBuffer())) {
+      // CompilerInvocation doesn't own the buffers, copy to a new buffer.
+      PartialModules.push_back({
+        std::unique_ptr<llvm::MemoryBuffer>(
+            llvm::MemoryBuffer::getMemBufferCopy(
+                InputBuffer->getBuffer(), InputBuffer->getBufferIdentifier())),
+        nullptr });
     } else {
-      unsigned BufferID = SourceMgr.addNewSourceBuffer(std::move(Copy));
+      // Likewise, unless the client promised to keep it alive.
+      unsigned BufferID;
+      if (Invocation.getBuffersOutliveInstance())
+        BufferID = SourceMgr.addMemBufferRef(InputBuffer);
+      else
+        BufferID = SourceMgr.addMemBufferCopy(InputBuffer);
       BufferIDs.push_back(BufferID);
 
       if (SILMode)
@@ -170,6 +229,7 @@ bool CompilerInstance::setup(const CompilerInvocation &Invok) {
           PrimaryInput->Index == i)
         PrimaryBufferID = ExistingBufferID.getValue();
 
+      FilenameBufferIDs[i] = ExistingBufferID.getValue();
       continue; // replaced by a memory buffer.
     }
 
@@ -211,7 +271,17 @@ bool CompilerInstance::setup(const CompilerInvocation &Invok) {
 
     if (PrimaryInput && PrimaryInput->isFilename() && PrimaryInput->Index == i)
       PrimaryBufferID = BufferID;
+
+    FilenameBufferIDs[i] = BufferID;
+  }
+
+  for (auto &BatchInput : Invocation.getFrontendOptions().BatchPrimaryInputs) {
+    assert(BatchInput.isFilename() && "batch mode requires input files");
+    unsigned BufferID = FilenameBufferIDs[BatchInput.Index];
+    assert(BufferID != NO_SUCH_BUFFER && "primary input is not a source file");
+    BatchPrimaryBufferIDs.push_back(BufferID);
   }
+  BatchPrimarySourceFiles.assign(BatchPrimaryBufferIDs.size(), nullptr);
 
   // Set the primary file to the code-completion point if one exists.
   if (CodeCompletionBufferID.hasValue())
@@ -380,6 +450,17 @@ void CompilerInstance::performSema() {
     DelayedCB.reset(new AlwaysDelayedCallbacks);
   }
 
+  // Only the declarations in files other than the primary files are needed,
+  // so their function bodies don't have to be parsed.
+  SkipSecondaryFunctionBodies SecondaryCB;
+  auto getDelayedCallbacks = [&](unsigned BufferID) {
+    if (DelayedCB || PrimaryBufferID == NO_SUCH_BUFFER ||
+        isPrimaryBuffer(BufferID) ||
+        !Invocation.getFrontendOptions().SkipSecondaryFunctionBodies)
+      return DelayedCB.get();
+    return static_cast<DelayedParsingCallbacks *>(&SecondaryCB);
+  };
+
   PersistentParserState PersistentState;
 
   // Make sure the main file is the first file in the module. This may only be
@@ -398,7 +479,7 @@ void CompilerInstance::performSema() {
     MainModule->addFile(*MainFile);
     addAdditionalInitialImports(MainFile);
 
-    if (MainBufferID == PrimaryBufferID)
+    if (isPrimaryBuffer(MainBufferID))
       setPrimarySourceFile(MainFile);
   }
 
@@ -413,6 +494,7 @@ void CompilerInstance::performSema() {
   }
 
   // Then parse all the library files.
+  SmallVector<SourceFile *, 16> LibraryFiles;
   for (auto BufferID : BufferIDs) {
     if (BufferID == MainBufferID)
       continue;
@@ -424,15 +506,42 @@ void CompilerInstance::performSema() {
     MainModule->addFile(*NextInput);
     addAdditionalInitialImports(NextInput);
 
-    if (BufferID == PrimaryBufferID)
+    if (isPrimaryBuffer(BufferID))
       setPrimarySourceFile(NextInput);
 
+    LibraryFiles.push_back(NextInput);
+  }
+
+  // Files parsed in parallel each need a parser state of their own.
+  llvm::DenseMap<SourceFile *, std::unique_ptr<PersistentParserState>>
+    FileParserStates;
+
+  // Code completion needs to see the files parsed in order.
+  unsigned NumParsingThreads =
+    Invocation.getFrontendOptions().NumParsingThreads;
+  if (NumParsingThreads > 1 && LibraryFiles.size() > 1 && !DelayedCB) {
+    SmallVector<PersistentParserState *, 16> States;
+    SmallVector<DelayedParsingCallbacks *, 16> Callbacks;
+    for (SourceFile *SF : LibraryFiles) {
+      auto &State = FileParserStates[SF];
+      State.reset(new PersistentParserState());
+      States.push_back(State.get());
+      Callbacks.push_back(getDelayedCallbacks(*SF->getBufferID()));
+    }
+    parseSourceFilesInParallel(LibraryFiles, States, Callbacks,
+                               NumParsingThreads,
+                               [](SourceFile &SF) { performNameBinding(SF); });
+    LibraryFiles.clear();
+  }
+
+  for (SourceFile *NextInput : LibraryFiles) {
+    unsigned BufferID = *NextInput->getBufferID();
     bool Done;
     do {
       // Parser may stop at some erroneous constructions like #else, #endif
       // or '}' in some cases, continue parsing until we are done
       parseIntoSourceFile(*NextInput, BufferID, &Done, nullptr,
-                          &PersistentState, DelayedCB.get());
+                          &PersistentState, getDelayedCallbacks(BufferID));
     } while (!Done);
 
     performNameBinding(*NextInput);
@@ -460,11 +569,17 @@ void CompilerInstance::performSema() {
   if (Invocation.getFrontendOptions().actionIsImmediate()) {
     TypeCheckOptions |= TypeCheckingFlags::ForImmediateMode;
   }
+  if (Invocation.getFrontendOptions().isBatchMode()) {
+    TypeCheckOptions |= TypeCheckingFlags::CompleteTypesAfterErrors;
+  }
+  if (Invocation.getFrontendOptions().DebugAlwaysWarnLongTypeChecking) {
+    TypeCheckOptions |= TypeCheckingFlags::DebugAlwaysWarnLongTypeChecking;
+  }
 
   // Parse the main file last.
   if (MainBufferID != NO_SUCH_BUFFER) {
     bool mainIsPrimary =
-      (PrimaryBufferID == NO_SUCH_BUFFER || MainBufferID == PrimaryBufferID);
+      (PrimaryBufferID == NO_SUCH_BUFFER || isPrimaryBuffer(MainBufferID));
 
     SourceFile &MainFile =
       MainModule->getMainSourceFile(Invocation.getSourceFileKind());
@@ -478,10 +593,15 @@ void CompilerInstance::performSema() {
       // with 'sil' definitions.
       parseIntoSourceFile(MainFile, MainFile.getBufferID().getValue(), &Done,
                           TheSILModule ? &SILContext : nullptr,
-                          &PersistentState, DelayedCB.get());
+                          &PersistentState,
+                          Kind == InputFileKind::IFK_Swift ?
+                            getDelayedCallbacks(MainBufferID) :
+                            DelayedCB.get());
       if (mainIsPrimary) {
         performTypeChecking(MainFile, PersistentState.getTopLevelContext(),
-                            TypeCheckOptions, CurTUElem);
+                            TypeCheckOptions, CurTUElem,
+                            options.WarnLongFunctionBodies,
+                            options.WarnLongExpressionTypeChecking);
       }
       CurTUElem = MainFile.Decls.size();
     } while (!Done);
@@ -496,9 +616,12 @@ void CompilerInstance::performSema() {
   // Type-check each top-level input besides the main source file.
   for (auto File : MainModule->getFiles())
     if (auto SF = dyn_cast<SourceFile>(File))
-      if (PrimaryBufferID == NO_SUCH_BUFFER || SF == PrimarySourceFile)
+      if (PrimaryBufferID == NO_SUCH_BUFFER ||
+          (SF->getBufferID() && isPrimaryBuffer(*SF->getBufferID())))
         performTypeChecking(*SF, PersistentState.getTopLevelContext(),
-                            TypeCheckOptions);
+                            TypeCheckOptions, /*StartElem*/0,
+                            options.WarnLongFunctionBodies,
+                            options.WarnLongExpressionTypeChecking);
 
   // Even if there were no source files, we should still record known
   // protocols.
@@ -18,6 +18,7 @@
 #include "swift/AST/Decl.h"
 #include "swift/AST/IRGenOptions.h"
 #include "swift/AST/ProtocolConformance.h"
+#include "swift/Reflection/Records.h"
 
 #include "ConstantBuilder.h"
 #include "IRGenModule.h"
@@ -44,6 +45,10 @@ class AssociatedTypeMetadataBuilder : public ReflectionMetadataBuilder {
   ArrayRef<const NominalTypeDecl *> NominalTypeDecls;
 
   void addDecl(const NominalTypeDecl *Decl) {
+    // Protocols do not conform to protocols.
+    if (isa<ProtocolDecl>(Decl))
+      return;
+
     for (auto Conformance : Decl->getAllConformances()) {
       SmallVector<std::pair<StringRef, CanType>, 2> AssociatedTypes;
 
@@ -120,7 +125,7 @@ public:
 
 class FieldTypeMetadataBuilder : public ReflectionMetadataBuilder {
 
-  const uint32_t fieldRecordSize = 8;
+  const uint16_t fieldRecordSize = 8;
   ArrayRef<const NominalTypeDecl *> NominalTypeDecls;
 
   void addFieldDecl(const ValueDecl *value) {
@@ -136,15 +141,20 @@ class FieldTypeMetadataBuilder : public ReflectionMetadataBuilder {
   }
 
   void addDecl(const NominalTypeDecl *decl) {
+    using swift::reflection::FieldDescriptorKind;
+
     auto type = decl->getDeclaredInterfaceType()->getCanonicalType();
     addTypeRef(decl->getModuleContext(), type);
 
     switch (decl->getKind()) {
     case DeclKind::Class:
     case DeclKind::Struct: {
+      auto kind = isa<ClassDecl>(decl) ? FieldDescriptorKind::Class
+                                       : FieldDescriptorKind::Struct;
       auto properties = decl->getStoredProperties();
+      addConstantInt16(uint16_t(kind));
+      addConstantInt16(fieldRecordSize);
       addConstantInt32(std::distance(properties.begin(), properties.end()));
-      addConstantInt32(fieldRecordSize);
       for (auto property : properties)
         addFieldDecl(property);
       break;
@@ -152,12 +162,29 @@ class FieldTypeMetadataBuilder : public ReflectionMetadataBuilder {
     case DeclKind::Enum: {
       auto enumDecl = cast<EnumDecl>(decl);
       auto cases = enumDecl->getAllElements();
+      addConstantInt16(uint16_t(FieldDescriptorKind::Enum));
+      addConstantInt16(fieldRecordSize);
       addConstantInt32(std::distance(cases.begin(), cases.end()));
-      addConstantInt32(fieldRecordSize);
       for (auto enumCase : cases)
         addFieldDecl(enumCase);
       break;
     }
+    case DeclKind::Protocol: {
+      // Protocols have no fields; the kind tells reflection how their
+      // existentials are laid out.
+      auto protocolDecl = cast<ProtocolDecl>(decl);
+      FieldDescriptorKind kind;
+      if (protocolDecl->isObjC())
+        kind = FieldDescriptorKind::ObjCProtocol;
+      else if (protocolDecl->requiresClass())
+        kind = FieldDescriptorKind::ClassProtocol;
+      else
+        kind = FieldDescriptorKind::Protocol;
+      addConstantInt16(uint16_t(kind));
+      addConstantInt16(fieldRecordSize);
+      addConstantInt32(0);
+      break;
+    }
     default:
       llvm_unreachable("Not a nominal type");
       break;
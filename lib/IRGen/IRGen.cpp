@@ -23,6 +23,7 @@
 #include "swift/SIL/SILModule.h"
 #include "swift/Basic/Dwarf.h"
 #include "swift/Basic/Platform.h"
+#include "swift/Basic/Statistic.h"
 #include "swift/Basic/Timer.h"
 #include "swift/Basic/Version.h"
 #include "swift/ClangImporter/ClangImporter.h"
@@ -171,9 +172,14 @@ void swift::performLLVMOptimizations(IRGenOptions &Opts, llvm::Module *Module,
 
   // Run the function passes.
   FunctionPasses.doInitialization();
-  for (auto I = Module->begin(), E = Module->end(); I != E; ++I)
-    if (!I->isDeclaration())
-      FunctionPasses.run(*I);
+  for (auto I = Module->begin(), E = Module->end(); I != E; ++I) {
+    if (I->isDeclaration())
+      continue;
+    CompileTimeTraceScope Trace("LLVM function passes", [&] {
+      return I->getName().str();
+    });
+    FunctionPasses.run(*I);
+  }
   FunctionPasses.doFinalization();
 
   // Configure the module passes.
@@ -204,6 +210,7 @@ void swift::performLLVMOptimizations(IRGenOptions &Opts, llvm::Module *Module,
     ModulePasses.add(createInlineTreePrinterPass());
 
   // Do it.
+  CompileTimeTraceScope Trace("LLVM module passes");
   ModulePasses.run(*Module);
 }
 
@@ -512,6 +519,21 @@ static void initLLVMModule(const IRGenModule &IGM) {
   Module->setDataLayout(IGM.DataLayout.getStringRepresentation());
 }
 
+/// Adds the size of \p Module to the statistics.
+static void countStatsOfLLVMModule(UnifiedStatsReporter &Stats,
+                                   const llvm::Module &Module) {
+  auto &Counters = Stats.getFrontendCounters();
+  Counters.NumIRGlobals += Module.getGlobalList().size();
+  for (const llvm::Function &F : Module) {
+    if (F.isDeclaration())
+      continue;
+    ++Counters.NumIRFunctions;
+    Counters.NumIRBasicBlocks += F.size();
+    for (const llvm::BasicBlock &BB : F)
+      Counters.NumIRInstructions += BB.size();
+  }
+}
+
 /// Generates LLVM IR, runs the LLVM passes and produces the output file.
 /// All this is done in a single thread.
 static std::unique_ptr<llvm::Module> performIRGeneration(IRGenOptions &Opts,
@@ -616,6 +638,9 @@ static std::unique_ptr<llvm::Module> performIRGeneration(IRGenOptions &Opts,
   if (performLLVM(IGM.Opts, IGM.Context.Diags, nullptr, IGM.ModuleHash,
                   IGM.getModule(), IGM.TargetMachine, IGM.OutputFilename))
     return nullptr;
+
+  if (Ctx.Stats)
+    countStatsOfLLVMModule(*Ctx.Stats, *IGM.getModule());
   return std::unique_ptr<llvm::Module>(IGM.releaseModule());
 }
 
@@ -813,6 +838,8 @@ static void performParallelIRGeneration(IRGenOptions &Opts,
   // Cleanup.
   for (auto it = dispatcher.begin(); it != dispatcher.end(); ++it) {
     IRGenModule *IGM = it->second;
+    if (Ctx.Stats)
+      countStatsOfLLVMModule(*Ctx.Stats, *IGM->getModule());
     LLVMContext *Context = &IGM->LLVMContext;
     delete IGM;
     delete Context;
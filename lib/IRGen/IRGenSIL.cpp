@@ -28,6 +28,7 @@
 #include "swift/Basic/Fallthrough.h"
 #include "swift/Basic/Range.h"
 #include "swift/Basic/STLExtras.h"
+#include "swift/Basic/Timer.h"
 #include "swift/AST/ASTContext.h"
 #include "swift/AST/IRGenOptions.h"
 #include "swift/AST/Pattern.h"
@@ -1333,6 +1334,9 @@ void IRGenModule::emitSILFunction(SILFunction *f) {
     return;
 
   PrettyStackTraceSILFunction stackTrace("emitting IR", f);
+  CompileTimeTraceScope trace("IRGen function", [&] {
+    return f->getName().str();
+  });
   IRGenSILFunction(*this, f).emitSILFunction();
 }
 
@@ -28,6 +28,11 @@
 // FIXME: Figure out if this can be migrated to LLVM.
 #include "clang/Basic/CharInfo.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define SWIFT_LEXER_USE_SSE2 1
+#endif
+
 using namespace swift;
 
 // clang::isIdentifierHead and clang::isIdentifierBody are deliberately not in
@@ -163,6 +168,152 @@ static uint32_t validateUTF8CharacterAndAdvance(const char *&Ptr,
   return EncodedBytes == 4 ? CharValue : ~0U;
 }
 
+//===----------------------------------------------------------------------===//
+// Scanning helper functions
+//===----------------------------------------------------------------------===//
+//
+// Most of the bytes in comments, whitespace, string literals and identifiers
+// only need to be stepped over. The functions below skip a run of such bytes
+// and return a pointer to the first one that needs a closer look. Where SSE2
+// is available, they look at 16 bytes at a time until fewer than that are
+// left in the buffer.
+//
+// Bytes that aren't ASCII are never skipped, so that the callers still
+// validate UTF-8 one character at a time.
+
+namespace {
+/// \brief A single byte of source, classified with the same operations as a
+/// \c ByteVector.
+///
+/// Comparisons are signed, so bytes that aren't ASCII compare less than any
+/// ASCII character. They set all bits of the result if they are true.
+struct ScalarByte {
+  signed char Value;
+
+  ScalarByte(signed char value) : Value(value) {}
+
+  static ScalarByte load(const char *ptr) { return *ptr; }
+
+  ScalarByte operator==(char c) const { return Value == c ? -1 : 0; }
+  ScalarByte operator<(char c) const { return Value < c ? -1 : 0; }
+  ScalarByte operator>(char c) const { return Value > c ? -1 : 0; }
+  ScalarByte operator|(char c) const { return Value | c; }
+  ScalarByte operator|(ScalarByte other) const { return Value | other.Value; }
+  ScalarByte operator&(ScalarByte other) const { return Value & other.Value; }
+  ScalarByte operator~() const { return ~Value; }
+
+  /// Returns 1 if the result of a comparison is true, 0 otherwise.
+  unsigned getMask() const { return Value & 1; }
+};
+
+#if SWIFT_LEXER_USE_SSE2
+/// \brief Sixteen bytes of source, compared all at once.
+struct ByteVector {
+  __m128i Value;
+
+  static const ptrdiff_t Size = 16;
+
+  ByteVector(__m128i value) : Value(value) {}
+
+  static ByteVector load(const char *ptr) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr));
+  }
+
+  ByteVector operator==(char c) const {
+    return _mm_cmpeq_epi8(Value, _mm_set1_epi8(c));
+  }
+  ByteVector operator<(char c) const {
+    return _mm_cmplt_epi8(Value, _mm_set1_epi8(c));
+  }
+  ByteVector operator>(char c) const {
+    return _mm_cmpgt_epi8(Value, _mm_set1_epi8(c));
+  }
+  ByteVector operator|(char c) const {
+    return _mm_or_si128(Value, _mm_set1_epi8(c));
+  }
+  ByteVector operator|(ByteVector other) const {
+    return _mm_or_si128(Value, other.Value);
+  }
+  ByteVector operator&(ByteVector other) const {
+    return _mm_and_si128(Value, other.Value);
+  }
+  ByteVector operator~() const {
+    return _mm_xor_si128(Value, _mm_set1_epi8(-1));
+  }
+
+  /// Returns a mask with bit \c i set if the result of a comparison is true
+  /// for byte \c i.
+  unsigned getMask() const { return _mm_movemask_epi8(Value); }
+};
+#endif
+
+/// Matches the bytes that end a // comment or need validating.
+struct IsLineCommentSpecial {
+  template <typename Bytes>
+  Bytes operator()(Bytes b) const {
+    return (b < 1) | (b == '\n') | (b == '\r');
+  }
+};
+
+/// Matches the bytes that may start or end a nested /* comment, in addition
+/// to those matched by \c IsLineCommentSpecial.
+struct IsBlockCommentSpecial {
+  template <typename Bytes>
+  Bytes operator()(Bytes b) const {
+    return IsLineCommentSpecial()(b) | (b == '*') | (b == '/');
+  }
+};
+
+/// Matches anything but ' ', '\t', '\f' and '\v'.
+struct IsNotHorizontalWhitespace {
+  template <typename Bytes>
+  Bytes operator()(Bytes b) const {
+    return ~((b == ' ') | (b == '\t') | (b == '\f') | (b == '\v'));
+  }
+};
+
+/// Matches anything but ASCII identifier characters, [a-zA-Z0-9_$].
+struct IsNotASCIIIdentifierChar {
+  template <typename Bytes>
+  Bytes operator()(Bytes b) const {
+    // Setting 0x20 maps upper-case letters to lower-case ones, and nothing
+    // else onto a letter.
+    Bytes lower = b | 0x20;
+    Bytes isLetter = (lower > 'a' - 1) & (lower < 'z' + 1);
+    Bytes isDigit = (b > '0' - 1) & (b < '9' + 1);
+    return ~(isLetter | isDigit | (b == '_') | (b == '$'));
+  }
+};
+
+/// Matches the bytes in a string literal that lexCharacter does more with
+/// than return them: anything that isn't printable ASCII, quotes and
+/// backslashes.
+struct IsStringLiteralSpecial {
+  template <typename Bytes>
+  Bytes operator()(Bytes b) const {
+    return ~((b > 0x1F) & (b < 0x7F)) |
+           (b == '"') | (b == '\'') | (b == '\\');
+  }
+};
+
+/// \brief Returns the first byte in [Ptr, End) matched by \p IsSpecial, or
+/// \p End if there is none.
+template <typename IsSpecial>
+const char *skipToSpecialByte(const char *Ptr, const char *End) {
+  IsSpecial isSpecial;
+#if SWIFT_LEXER_USE_SSE2
+  while (End - Ptr >= ByteVector::Size) {
+    if (unsigned Mask = isSpecial(ByteVector::load(Ptr)).getMask())
+      return Ptr + llvm::countTrailingZeros(Mask);
+    Ptr += ByteVector::Size;
+  }
+#endif
+  while (Ptr != End && !isSpecial(ScalarByte::load(Ptr)).getMask())
+    ++Ptr;
+  return Ptr;
+}
+} // end anonymous namespace
+
 //===----------------------------------------------------------------------===//
 // Setup and Helper Methods
 //===----------------------------------------------------------------------===//
@@ -308,6 +459,7 @@ static void diagnoseEmbeddedNul(DiagnosticEngine *Diags, const char *Ptr) {
 
 void Lexer::skipToEndOfLine() {
   while (1) {
+    CurPtr = skipToSpecialByte<IsLineCommentSpecial>(CurPtr, BufferEnd);
     switch (*CurPtr++) {
     case '\n':
     case '\r':
@@ -361,6 +513,7 @@ void Lexer::skipSlashStarComment() {
   unsigned Depth = 1;
   
   while (1) {
+    CurPtr = skipToSpecialByte<IsBlockCommentSpecial>(CurPtr, BufferEnd);
     switch (*CurPtr++) {
     case '*':
       // Check for a '*/'
@@ -569,6 +722,8 @@ void Lexer::lexIdentifier() {
   (void) didStart;
 
   // Lex [a-zA-Z_$0-9[[:XID_Continue:]]]*
+  do
+    CurPtr = skipToSpecialByte<IsNotASCIIIdentifierChar>(CurPtr, BufferEnd);
   while (advanceIfValidContinuationOfIdentifier(CurPtr, BufferEnd));
 
   tok Kind = kindOfIdentifier(StringRef(TokStart, CurPtr-TokStart), InSILMode);
@@ -1220,6 +1375,10 @@ void Lexer::lexStringLiteral() {
   bool wasErroneous = false;
   
   while (true) {
+    // Printable ASCII characters other than quotes and backslashes stand for
+    // themselves.
+    CurPtr = skipToSpecialByte<IsStringLiteralSpecial>(CurPtr, BufferEnd);
+
     if (*CurPtr == '\\' && *(CurPtr + 1) == '(') {
       // Consume tokens until we hit the corresponding ')'.
       CurPtr += 2;
@@ -1582,6 +1741,7 @@ Restart:
   case '\t':
   case '\f':
   case '\v':
+    CurPtr = skipToSpecialByte<IsNotHorizontalWhitespace>(CurPtr, BufferEnd);
     goto Restart;  // Skip whitespace.
 
   case -1:
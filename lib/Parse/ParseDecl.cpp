@@ -3387,7 +3387,7 @@ bool Parser::parseGetSetImpl(ParseDeclOptions Flags, ParameterList *Indices,
       SmallVector<ASTNode, 16> Entries;
       {
         llvm::SaveAndRestore<bool> T(IsParsingInterfaceTokens, false);
-        if (!isDelayedParsingEnabled())
+        if (!shouldConsumeFunctionBody(TheDecl->getAttrs()))
           parseBraceItems(Entries);
         else
           consumeGetSetBody(TheDecl, LBLoc);
@@ -3401,7 +3401,7 @@ bool Parser::parseGetSetImpl(ParseDeclOptions Flags, ParameterList *Indices,
         RBLoc = Tok.is(tok::r_brace) ? Tok.getLoc() : PreviousLoc;
       }
 
-      if (!isDelayedParsingEnabled()) {
+      if (!shouldConsumeFunctionBody(TheDecl->getAttrs())) {
         BraceStmt *Body = BraceStmt::create(Context, LBLoc, Entries, RBLoc);
         TheDecl->setBody(Body);
       }
@@ -4033,6 +4033,11 @@ ParserStatus Parser::parseDeclVar(ParseDeclOptions Flags,
   return Status;
 }
 
+bool Parser::shouldConsumeFunctionBody(const DeclAttributes &Attrs) const {
+  return isDelayedParsingEnabled() &&
+         !DelayedParseCB->shouldParseFunctionBodyNow(Attrs);
+}
+
 void Parser::consumeAbstractFunctionBody(AbstractFunctionDecl *AFD,
                                          const DeclAttributes &Attrs) {
   auto BeginParserPosition = getParserPosition();
@@ -4247,7 +4252,7 @@ Parser::parseDeclFunc(SourceLoc StaticLoc, StaticSpellingKind StaticSpelling,
       if (Flags.contains(PD_InProtocol)) {
         diagnose(Tok, diag::protocol_method_with_body);
         skipUntilDeclRBrace();
-      } else if (!isDelayedParsingEnabled()) {
+      } else if (!shouldConsumeFunctionBody(Attributes)) {
         ParserResult<BraceStmt> Body =
             parseBraceItemList(diag::func_decl_without_brace);
         if (Body.isNull()) {
@@ -5064,7 +5069,7 @@ Parser::parseDeclInit(ParseDeclOptions Flags, DeclAttributes &Attributes) {
       // Parse the body.
       ParseFunctionBody CC(*this, CD);
 
-      if (!isDelayedParsingEnabled()) {
+      if (!shouldConsumeFunctionBody(Attributes)) {
         ParserResult<BraceStmt> Body =
           parseBraceItemList(diag::invalid_diagnostic);
 
@@ -5129,7 +5134,7 @@ parseDeclDeinit(ParseDeclOptions Flags, DeclAttributes &Attributes) {
     llvm::SaveAndRestore<bool> T(IsParsingInterfaceTokens, false);
 
     ParseFunctionBody CC(*this, DD);
-    if (!isDelayedParsingEnabled()) {
+    if (!shouldConsumeFunctionBody(Attributes)) {
       ParserResult<BraceStmt> Body=parseBraceItemList(diag::invalid_diagnostic);
 
       if (!Body.isNull())
@@ -30,6 +30,11 @@
 #include "llvm/ADT/PointerUnion.h"
 #include "llvm/ADT/Twine.h"
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
 using namespace swift;
 
 void DelayedParsingCallbacks::anchor() { }
@@ -131,14 +136,14 @@ static void parseDelayedDecl(
 }
 } // unnamed namespace
 
-bool swift::parseIntoSourceFile(SourceFile &SF,
-                                unsigned BufferID,
-                                bool *Done,
-                                SILParserState *SIL,
-                                PersistentParserState *PersistentState,
-                                DelayedParsingCallbacks *DelayedParseCB) {
-  SharedTimer timer("Parsing");
-  Parser P(BufferID, SF, SIL, PersistentState);
+static bool parseIntoSourceFileImpl(SourceFile &SF,
+                                    unsigned BufferID,
+                                    bool *Done,
+                                    SILParserState *SIL,
+                                    PersistentParserState *PersistentState,
+                                    DelayedParsingCallbacks *DelayedParseCB,
+                                    DiagnosticEngine *Diags) {
+  Parser P(BufferID, SF, SIL, PersistentState, Diags);
   PrettyStackTraceParser StackTrace(P);
 
   llvm::SaveAndRestore<bool> S(P.IsParsingInterfaceTokens, true);
@@ -152,6 +157,124 @@ bool swift::parseIntoSourceFile(SourceFile &SF,
   return FoundSideEffects;
 }
 
+bool swift::parseIntoSourceFile(SourceFile &SF,
+                                unsigned BufferID,
+                                bool *Done,
+                                SILParserState *SIL,
+                                PersistentParserState *PersistentState,
+                                DelayedParsingCallbacks *DelayedParseCB) {
+  SharedTimer timer("Parsing", [&] { return SF.getFilename().str(); });
+  return parseIntoSourceFileImpl(SF, BufferID, Done, SIL, PersistentState,
+                                 DelayedParseCB, /*Diags=*/nullptr);
+}
+
+namespace {
+/// \brief Keeps the diagnostics emitted while a file is parsed on another
+/// thread, so that they can be emitted in order once all files are parsed.
+class CollectingDiagnosticConsumer : public DiagnosticConsumer {
+  struct CollectedDiagnostic {
+    SourceLoc Loc;
+    std::string Text;
+    DiagID ID;
+    std::vector<CharSourceRange> Ranges;
+    std::vector<DiagnosticInfo::FixIt> FixIts;
+  };
+
+  std::vector<CollectedDiagnostic> Diagnostics;
+
+public:
+  void handleDiagnostic(SourceManager &SM, SourceLoc Loc,
+                        DiagnosticKind Kind, StringRef Text,
+                        const DiagnosticInfo &Info) override {
+    Diagnostics.emplace_back();
+    CollectedDiagnostic &Diag = Diagnostics.back();
+    Diag.Loc = Loc;
+    Diag.Text = Text.str();
+    Diag.ID = Info.ID;
+    Diag.Ranges.assign(Info.Ranges.begin(), Info.Ranges.end());
+    Diag.FixIts.assign(Info.FixIts.begin(), Info.FixIts.end());
+  }
+
+  /// \brief Emit the collected diagnostics through \p Diags and forget them.
+  void emitInto(DiagnosticEngine &Diags) {
+    for (auto &Diag : Diagnostics) {
+      DiagnosticInfo Info;
+      Info.ID = Diag.ID;
+      Info.Ranges = Diag.Ranges;
+      Info.FixIts = Diag.FixIts;
+      Diags.emitFormattedDiagnostic(Diag.Loc, Diag.Text, Info);
+    }
+    Diagnostics.clear();
+  }
+};
+} // unnamed namespace
+
+/// \brief Parse all of \p SF, reporting diagnostics to \p Collector.
+static void parseCollectingDiagnostics(SourceFile &SF,
+                                       PersistentParserState *PersistentState,
+                                       DelayedParsingCallbacks *DelayedParseCB,
+                                       CollectingDiagnosticConsumer &Collector) {
+  CompileTimeTraceScope Trace("Parsing", [&] {
+    return SF.getFilename().str();
+  });
+  ASTContext &Ctx = SF.getASTContext();
+  DiagnosticEngine Diags(Ctx.SourceMgr);
+  // Whether a diagnostic is shown is decided when it is emitted again.
+  Diags.setShowDiagnosticsAfterFatalError(true);
+  Diags.addConsumer(Collector);
+
+  bool Done;
+  do {
+    // Parser may stop at some erroneous constructions like #else, #endif
+    // or '}' in some cases, continue parsing until we are done
+    parseIntoSourceFileImpl(SF, SF.getBufferID().getValue(), &Done, nullptr,
+                            PersistentState, DelayedParseCB, &Diags);
+  } while (!Done);
+}
+
+void swift::parseSourceFilesInParallel(
+    ArrayRef<SourceFile *> Files,
+    ArrayRef<PersistentParserState *> PersistentStates,
+    ArrayRef<DelayedParsingCallbacks *> DelayedParseCBs,
+    unsigned NumThreads,
+    llvm::function_ref<void(SourceFile &)> FileParsed) {
+  assert(PersistentStates.size() == Files.size());
+  assert(DelayedParseCBs.size() == Files.size());
+  if (Files.empty())
+    return;
+
+  SharedTimer timer("Parsing");
+  ASTContext &Ctx = Files.front()->getASTContext();
+  std::vector<CollectingDiagnosticConsumer> Collectors(Files.size());
+  {
+    ConcurrentASTContextRAII ConcurrentContext(Ctx);
+
+    std::atomic<size_t> Next(0);
+    auto Worker = [&] {
+      ThreadArenaRAII Arena(Ctx);
+      for (size_t i = Next++; i < Files.size(); i = Next++)
+        parseCollectingDiagnostics(*Files[i], PersistentStates[i],
+                                   DelayedParseCBs[i], Collectors[i]);
+    };
+
+    NumThreads = std::min<size_t>(std::max(NumThreads, 1U), Files.size());
+    std::vector<std::thread> Threads;
+    Threads.reserve(NumThreads - 1);
+    for (unsigned i = 1; i != NumThreads; ++i)
+      Threads.emplace_back(Worker);
+    Worker();
+    for (std::thread &Thread : Threads)
+      Thread.join();
+  }
+
+  // Report each file's diagnostics in the order the files were given, as if
+  // they had been parsed one after another.
+  for (size_t i = 0, e = Files.size(); i != e; ++i) {
+    Collectors[i].emitInto(Ctx.Diags);
+    FileParsed(*Files[i]);
+  }
+}
+
 void swift::performDelayedParsing(
     DeclContext *DC, PersistentParserState &PersistentState,
     CodeCompletionCallbacksFactory *CodeCompletionFactory) {
@@ -280,20 +403,23 @@ std::vector<Token> swift::tokenize(const LangOptions &LangOpts,
 //===----------------------------------------------------------------------===//
 
 Parser::Parser(unsigned BufferID, SourceFile &SF, SILParserState *SIL,
-               PersistentParserState *PersistentState)
+               PersistentParserState *PersistentState,
+               DiagnosticEngine *Diags)
   : Parser(std::unique_ptr<Lexer>(
              new Lexer(SF.getASTContext().LangOpts, SF.getASTContext().SourceMgr,
-                   BufferID, &SF.getASTContext().Diags,
+                   BufferID, Diags ? Diags : &SF.getASTContext().Diags,
                    /*InSILMode=*/SIL != nullptr,
                    SF.getASTContext().LangOpts.AttachCommentsToDecls
                    ? CommentRetentionMode::AttachToNextToken
-                   : CommentRetentionMode::None)), SF, SIL, PersistentState) {
+                   : CommentRetentionMode::None)), SF, SIL, PersistentState,
+           Diags) {
 }
 
 Parser::Parser(std::unique_ptr<Lexer> Lex, SourceFile &SF,
-               SILParserState *SIL, PersistentParserState *PersistentState)
+               SILParserState *SIL, PersistentParserState *PersistentState,
+               DiagnosticEngine *Diags)
   : SourceMgr(SF.getASTContext().SourceMgr),
-    Diags(SF.getASTContext().Diags),
+    Diags(Diags ? *Diags : SF.getASTContext().Diags),
     SF(SF),
     L(Lex.release()),
     SIL(SIL),
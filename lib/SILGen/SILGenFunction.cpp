@@ -34,6 +34,7 @@ using namespace Lowering;
 
 SILGenFunction::SILGenFunction(SILGenModule &SGM, SILFunction &F)
   : SGM(SGM), F(F),
+    Trace("SILGen function", [&] { return F.getName().str(); }),
     B(*this, createBasicBlock()),
     CurrentSILLoc(F.getLocation()),
     Cleanups(*this)
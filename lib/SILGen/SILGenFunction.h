@@ -17,6 +17,7 @@
 #include "JumpDest.h"
 #include "Initialization.h"
 #include "swift/AST/AnyFunctionRef.h"
+#include "swift/Basic/Timer.h"
 #include "swift/SIL/SILBuilder.h"
 #include "llvm/ADT/PointerIntPair.h"
 
@@ -278,6 +279,9 @@ public:
     
   /// The SILFunction being constructed.
   SILFunction &F;
+
+  /// The span of the compile-time trace covering the function's emission.
+  CompileTimeTraceScope Trace;
   
   /// The name of the function currently being emitted, as presented to user
   /// code by #function.
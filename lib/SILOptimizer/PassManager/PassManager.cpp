@@ -13,6 +13,7 @@
 #define DEBUG_TYPE "sil-passmanager"
 
 #include "swift/Basic/DemangleWrappers.h"
+#include "swift/Basic/Timer.h"
 #include "swift/SILOptimizer/PassManager/PassManager.h"
 #include "swift/SIL/SILFunction.h"
 #include "swift/SIL/SILModule.h"
@@ -229,7 +230,12 @@ void SILPassManager::runPassesOnFunction(PassList FuncTransforms,
 
     llvm::sys::TimeValue StartTime = llvm::sys::TimeValue::now();
     Mod->registerDeleteNotificationHandler(SFT);
-    SFT->run();
+    {
+      CompileTimeTraceScope Trace(SFT->getName(), [&] {
+        return F->getName().str();
+      });
+      SFT->run();
+    }
     assert(analysesUnlocked() && "Expected all analyses to be unlocked!");
     Mod->removeDeleteNotificationHandler(SFT);
 
@@ -370,7 +376,10 @@ void SILPassManager::runModulePass(SILModuleTransform *SMT) {
   llvm::sys::TimeValue StartTime = llvm::sys::TimeValue::now();
   assert(analysesUnlocked() && "Expected all analyses to be unlocked!");
   Mod->registerDeleteNotificationHandler(SMT);
-  SMT->run();
+  {
+    CompileTimeTraceScope Trace(SMT->getName());
+    SMT->run();
+  }
   Mod->removeDeleteNotificationHandler(SMT);
   assert(analysesUnlocked() && "Expected all analyses to be unlocked!");
 
@@ -16,6 +16,7 @@
 #include "swift/SIL/PatternMatch.h"
 #include "swift/SIL/Projection.h"
 #include "swift/SIL/SILBuilder.h"
+#include "swift/SIL/SILUndef.h"
 #include "swift/SIL/SILVisitor.h"
 #include "swift/SIL/DebugUtils.h"
 #include "swift/SILOptimizer/Analysis/AliasAnalysis.h"
@@ -46,10 +47,22 @@ SILCombiner::visitAllocExistentialBoxInst(AllocExistentialBoxInst *AEBI) {
   StoreInst *SingleStore = nullptr;
   StrongReleaseInst *SingleRelease = nullptr;
   ProjectExistentialBoxInst *SingleProjection = nullptr;
+  llvm::SmallVector<Operand *, 2> DeadBranchArgs;
 
   // For each user U of the alloc_existential_box...
   for (auto U : getNonDebugUses(AEBI)) {
 
+    // Ignore branches that pass the box to a block argument that is only
+    // used by debug instructions. These are left behind when the release of
+    // a caught error has been sunk into the throwing blocks by
+    // visitStrongReleaseInst.
+    if (auto *BI = dyn_cast<BranchInst>(U->getUser())) {
+      auto *DestArg = BI->getDestBB()->getBBArg(U->getOperandNumber());
+      if (!onlyHaveDebugUses(DestArg)) return nullptr;
+      DeadBranchArgs.push_back(U);
+      continue;
+    }
+
     if (auto *PEBI = dyn_cast<ProjectExistentialBoxInst>(U->getUser())) {
       if (SingleProjection) return nullptr;
       SingleProjection = PEBI;
@@ -91,6 +104,14 @@ SILCombiner::visitAllocExistentialBoxInst(AllocExistentialBoxInst *AEBI) {
     eraseInstFromFunction(*SingleRelease);
     eraseInstFromFunction(*SingleStore);
     eraseInstFromFunction(*SingleProjection);
+    for (auto *Op : DeadBranchArgs) {
+      auto *BI = cast<BranchInst>(Op->getUser());
+      auto *DestArg = BI->getDestBB()->getBBArg(Op->getOperandNumber());
+      for (Operand *DU : getDebugUses(DestArg))
+        Worklist.remove(DU->getUser());
+      deleteAllDebugUses(DestArg);
+      Op->set(SILUndef::get(AEBI->getType(), AEBI->getModule()));
+    }
     return eraseInstFromFunction(*AEBI);
   }
 
@@ -942,7 +963,54 @@ SILInstruction *SILCombiner::visitStrongReleaseInst(StrongReleaseInst *SRI) {
       isa<ObjCMetatypeToObjectInst>(SRI->getOperand()))
     return eraseInstFromFunction(*SRI);
 
-  return nullptr;
+  // Sink the release of a caught error into the blocks that throw it, so
+  // that the boxes can be removed by visitAllocExistentialBoxInst. This is
+  // the pattern left behind by a 'catch _' or an unused 'try?' after the
+  // throwing callee has been inlined:
+  //
+  //   bb1:
+  //     %1 = alloc_existential_box $ErrorType, $ColorError
+  //     ...
+  //     br bb3(%1 : $ErrorType)
+  //   bb2:
+  //     %2 = alloc_existential_box $ErrorType, $ColorError
+  //     ...
+  //     br bb3(%2 : $ErrorType)
+  //   bb3(%3 : $ErrorType):
+  //     strong_release %3 : $ErrorType
+  auto *Arg = dyn_cast<SILArgument>(SRI->getOperand());
+  if (!Arg || Arg->isFunctionArg())
+    return nullptr;
+
+  for (auto *Use : getNonDebugUses(Arg))
+    if (Use->getUser() != SRI)
+      return nullptr;
+
+  auto *ParentBB = Arg->getParent();
+  if (ParentBB->pred_empty())
+    return nullptr;
+
+  // Every incoming value must be a fresh box, coming from a plain branch.
+  llvm::SmallVector<std::pair<BranchInst *, AllocExistentialBoxInst *>, 4>
+    Incoming;
+  for (auto *PredBB : ParentBB->getPreds()) {
+    auto *BI = dyn_cast<BranchInst>(PredBB->getTerminator());
+    if (!BI)
+      return nullptr;
+    auto *AEBI = dyn_cast<AllocExistentialBoxInst>(
+      BI->getArg(Arg->getIndex()));
+    if (!AEBI)
+      return nullptr;
+    Incoming.push_back({BI, AEBI});
+  }
+
+  for (auto &Entry : Incoming) {
+    Builder.setInsertionPoint(Entry.first);
+    Builder.createStrongRelease(SRI->getLoc(), Entry.second);
+    Worklist.add(Entry.second);
+  }
+
+  return eraseInstFromFunction(*SRI);
 }
 
 SILInstruction *SILCombiner::visitCondBranchInst(CondBranchInst *CBI) {
@@ -15,6 +15,7 @@
 //===----------------------------------------------------------------------===//
 #include "ConstraintSystem.h"
 #include "ConstraintGraph.h"
+#include "swift/Basic/Statistic.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/SaveAndRestore.h"
@@ -418,6 +419,18 @@ ConstraintSystem::SolverState::~SolverState() {
   #define CS_STATISTIC(Name, Description) JOIN2(Overall,Name) += Name;
   #include "ConstraintSolverStats.def"
 
+  // Add them to the job's statistics too, if they're being collected.
+  ASTContext &ctx = CS.getTypeChecker().Context;
+  if (ctx.Stats) {
+    auto &counters = ctx.Stats->getFrontendCounters();
+    ++counters.NumConstraintSystemsSolved;
+    #define CS_STATISTIC(Name, Description) counters.Name += Name;
+    #include "ConstraintSolverStats.def"
+    counters.PeakConstraintSolverBytes =
+      std::max<uint64_t>(counters.PeakConstraintSolverBytes,
+                         ctx.getSolverMemory());
+  }
+
   // Update the "largest" statistics if this system is larger than the
   // previous one.  
   // FIXME: This is not at all thread-safe.
@@ -25,6 +25,7 @@
 #include "swift/AST/PrettyStackTrace.h"
 #include "swift/AST/TypeCheckerDebugConsumer.h"
 #include "swift/Basic/Fallthrough.h"
+#include "swift/Basic/Timer.h"
 #include "swift/Parse/Lexer.h"
 #include "llvm/ADT/APInt.h"
 #include "llvm/ADT/DenseMap.h"
@@ -36,6 +37,7 @@
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/SaveAndRestore.h"
+#include "llvm/Support/Timer.h"
 #include <iterator>
 #include <map>
 #include <memory>
@@ -1106,6 +1108,35 @@ static bool preCheckExpression(TypeChecker &tc, Expr *&expr, DeclContext *dc) {
   return true;
 }
 
+namespace {
+  /// Warns if type-checking an expression takes longer than the limit set
+  /// with -warn-long-expression-type-checking, or always with
+  /// -debug-always-warn-long-type-checking.
+  class ExpressionTimer {
+    Expr *E;
+    unsigned WarnLimit;
+    bool AlwaysWarn;
+    ASTContext &Context;
+    llvm::TimeRecord StartTime = llvm::TimeRecord::getCurrentTime();
+
+  public:
+    ExpressionTimer(Expr *E, unsigned warnLimit, bool alwaysWarn,
+                    ASTContext &Context)
+      : E(E), WarnLimit(warnLimit), AlwaysWarn(alwaysWarn), Context(Context) {}
+
+    ~ExpressionTimer() {
+      llvm::TimeRecord endTime = llvm::TimeRecord::getCurrentTime(false);
+      auto elapsed = endTime.getProcessTime() - StartTime.getProcessTime();
+      if (!AlwaysWarn && elapsed * 1000 <= WarnLimit)
+        return;
+
+      Context.Diags.diagnose(E->getLoc(), diag::debug_long_expression,
+                             static_cast<unsigned>(elapsed * 1000), WarnLimit)
+        .highlight(E->getSourceRange());
+    }
+  };
+}
+
 ExprTypeCheckListener::~ExprTypeCheckListener() { }
 
 bool ExprTypeCheckListener::builtConstraints(ConstraintSystem &cs, Expr *expr) {
@@ -1122,6 +1153,13 @@ solveForExpression(Expr *&expr, DeclContext *dc, Type convertType,
                    ExprTypeCheckListener *listener, ConstraintSystem &cs,
                    SmallVectorImpl<Solution> &viable,
                    TypeCheckExprOptions options) {
+  // Subexpressions re-checked with diagnostics suppressed, as when diagnosing
+  // a failure, are covered by the timer of the enclosing expression.
+  Optional<ExpressionTimer> timer;
+  if (WarnLongExpressionTypeChecking &&
+      !options.contains(TypeCheckExprFlags::SuppressDiagnostics))
+    timer.emplace(expr, WarnLongExpressionTypeChecking,
+                  DebugAlwaysWarnLongTypeChecking, Context);
 
   // First, pre-check the expression, validating any types that occur in the
   // expression and folding sequence expressions.
@@ -1274,6 +1312,9 @@ bool TypeChecker::typeCheckExpression(Expr *&expr, DeclContext *dc,
                                       TypeCheckExprOptions options,
                                       ExprTypeCheckListener *listener) {
   PrettyStackTraceExpr stackTrace(Context, "type-checking", expr);
+  CompileTimeTraceScope trace("Type-check expression", [&] {
+    return getCompileTimeTraceDetail(Context, expr->getLoc());
+  });
 
   // Construct a constraint system from this expression.
   ConstraintSystem cs(*this, dc, ConstraintSystemFlags::AllowFixes);
@@ -35,6 +35,7 @@
 #include "swift/Serialization/SerializedModuleLoader.h"
 #include "swift/Strings.h"
 #include "swift/Basic/Defer.h"
+#include "swift/Basic/Timer.h"
 #include "llvm/ADT/APFloat.h"
 #include "llvm/ADT/APInt.h"
 #include "llvm/ADT/APSInt.h"
@@ -5926,6 +5927,9 @@ bool TypeChecker::isAvailabilitySafeForConformance(
 
 void TypeChecker::typeCheckDecl(Decl *D, bool isFirstPass) {
   PrettyStackTraceDecl StackTrace("type-checking", D);
+  CompileTimeTraceScope Trace("Type-check declaration", [&] {
+    return getCompileTimeTraceDetail(D);
+  });
   checkForForbiddenPrefix(D);
   bool isSecondPass =
     !isFirstPass && D->getDeclContext()->isModuleScopeContext();
@@ -26,6 +26,7 @@
 #include "swift/Basic/Range.h"
 #include "swift/Basic/STLExtras.h"
 #include "swift/Basic/SourceManager.h"
+#include "swift/Basic/Timer.h"
 #include "swift/Parse/Lexer.h"
 #include "swift/Parse/LocalContext.h"
 #include "llvm/ADT/DenseMap.h"
@@ -124,29 +125,58 @@ namespace {
     }
   };
 
+  /// Measures the time taken to type-check a function body, to dump it with
+  /// -debug-time-function-bodies, or to warn about it if it exceeds the limit
+  /// set with -warn-long-function-bodies (or always, with
+  /// -debug-always-warn-long-type-checking).
   class FunctionBodyTimer {
     PointerUnion<const AbstractFunctionDecl *,
                  const AbstractClosureExpr *> Function;
+    bool ShouldDump;
+    unsigned WarnLimit;
+    bool AlwaysWarn;
     llvm::TimeRecord StartTime = llvm::TimeRecord::getCurrentTime();
 
   public:
-    FunctionBodyTimer(decltype(Function) Fn) : Function(Fn) {}
+    FunctionBodyTimer(decltype(Function) Fn, bool shouldDump,
+                      unsigned warnLimit, bool alwaysWarn)
+      : Function(Fn), ShouldDump(shouldDump), WarnLimit(warnLimit),
+        AlwaysWarn(alwaysWarn) {}
+
     ~FunctionBodyTimer() {
       llvm::TimeRecord endTime = llvm::TimeRecord::getCurrentTime(false);
 
       auto elapsed = endTime.getProcessTime() - StartTime.getProcessTime();
-      llvm::errs() << llvm::format("%0.1f", elapsed * 1000) << "ms\t";
-
-      if (auto *AFD = Function.dyn_cast<const AbstractFunctionDecl *>()) {
-        AFD->getLoc().print(llvm::errs(), AFD->getASTContext().SourceMgr);
-        llvm::errs() << "\t";
-        AFD->print(llvm::errs(), PrintOptions());
-      } else {
-        auto *ACE = Function.get<const AbstractClosureExpr *>();
-        ACE->getLoc().print(llvm::errs(), ACE->getASTContext().SourceMgr);
-        llvm::errs() << "\t(closure)";
+      unsigned elapsedMS = static_cast<unsigned>(elapsed * 1000);
+
+      if (ShouldDump) {
+        llvm::errs() << llvm::format("%0.1f", elapsed * 1000) << "ms\t";
+
+        if (auto *AFD = Function.dyn_cast<const AbstractFunctionDecl *>()) {
+          AFD->getLoc().print(llvm::errs(), AFD->getASTContext().SourceMgr);
+          llvm::errs() << "\t";
+          AFD->print(llvm::errs(), PrintOptions());
+        } else {
+          auto *ACE = Function.get<const AbstractClosureExpr *>();
+          ACE->getLoc().print(llvm::errs(), ACE->getASTContext().SourceMgr);
+          llvm::errs() << "\t(closure)";
+        }
+        llvm::errs() << "\n";
+      }
+
+      if (WarnLimit != 0 && (AlwaysWarn || elapsed * 1000 > WarnLimit)) {
+        if (auto *AFD = Function.dyn_cast<const AbstractFunctionDecl *>()) {
+          AFD->getASTContext().Diags.diagnose(
+              AFD->getLoc(), diag::debug_long_function_body,
+              AFD->getDescriptiveKind(), AFD->getFullName(), elapsedMS,
+              WarnLimit);
+        } else {
+          auto *ACE = Function.get<const AbstractClosureExpr *>();
+          ACE->getASTContext().Diags.diagnose(
+              ACE->getLoc(), diag::debug_long_closure_body, elapsedMS,
+              WarnLimit);
+        }
       }
-      llvm::errs() << "\n";
     }
   };
 }
@@ -1170,9 +1200,13 @@ bool TypeChecker::typeCheckAbstractFunctionBody(AbstractFunctionDecl *AFD) {
   if (!AFD->getBody())
     return false;
 
+  CompileTimeTraceScope trace("Type-check function body", [&] {
+    return getCompileTimeTraceDetail(AFD);
+  });
   Optional<FunctionBodyTimer> timer;
-  if (DebugTimeFunctionBodies)
-    timer.emplace(AFD);
+  if (DebugTimeFunctionBodies || WarnLongFunctionBodies)
+    timer.emplace(AFD, DebugTimeFunctionBodies, WarnLongFunctionBodies,
+                  DebugAlwaysWarnLongTypeChecking);
 
   if (typeCheckAbstractFunctionBodyUntil(AFD, SourceLoc()))
     return true;
@@ -1412,9 +1446,13 @@ bool TypeChecker::typeCheckDestructorBodyUntil(DestructorDecl *DD,
 void TypeChecker::typeCheckClosureBody(ClosureExpr *closure) {
   BraceStmt *body = closure->getBody();
 
+  CompileTimeTraceScope trace("Type-check closure body", [&] {
+    return getCompileTimeTraceDetail(Context, closure->getLoc());
+  });
   Optional<FunctionBodyTimer> timer;
-  if (DebugTimeFunctionBodies)
-    timer.emplace(closure);
+  if (DebugTimeFunctionBodies || WarnLongFunctionBodies)
+    timer.emplace(closure, DebugTimeFunctionBodies, WarnLongFunctionBodies,
+                  DebugAlwaysWarnLongTypeChecking);
 
   StmtChecker(*this, closure).typeCheckBody(body);
   if (body) {
@@ -412,7 +412,9 @@ static void typeCheckFunctionsAndExternalDecls(TypeChecker &TC) {
     // FIXME: If we're not planning to run SILGen, this is wasted effort.
     while (!TC.ValidatedTypes.empty()) {
       auto nominal = TC.ValidatedTypes.pop_back_val();
-      if (nominal->isInvalid() || TC.Context.hadError())
+      if (nominal->isInvalid())
+        continue;
+      if (TC.Context.hadError() && !TC.getCompleteTypesAfterErrors())
         continue;
 
       Optional<bool> lazyVarsAlreadyHaveImplementation;
@@ -504,9 +506,31 @@ void swift::typeCheckExternalDefinitions(SourceFile &SF) {
   typeCheckFunctionsAndExternalDecls(TC);
 }
 
+std::string swift::getCompileTimeTraceDetail(const Decl *D) {
+  std::string Result;
+  llvm::raw_string_ostream OS(Result);
+  if (auto *VD = dyn_cast<ValueDecl>(D))
+    OS << VD->getFullName();
+  else
+    OS << Decl::getKindName(D->getKind());
+  OS << " at ";
+  D->getLoc().print(OS, D->getASTContext().SourceMgr);
+  return OS.str();
+}
+
+std::string swift::getCompileTimeTraceDetail(const ASTContext &Ctx,
+                                             SourceLoc Loc) {
+  std::string Result;
+  llvm::raw_string_ostream OS(Result);
+  Loc.print(OS, Ctx.SourceMgr);
+  return OS.str();
+}
+
 void swift::performTypeChecking(SourceFile &SF, TopLevelContext &TLC,
                                 OptionSet<TypeCheckingFlags> Options,
-                                unsigned StartElem) {
+                                unsigned StartElem,
+                                unsigned WarnLongFunctionBodies,
+                                unsigned WarnLongExpressionTypeChecking) {
   if (SF.ASTStage == SourceFile::TypeChecked)
     return;
 
@@ -522,13 +546,23 @@ void swift::performTypeChecking(SourceFile &SF, TopLevelContext &TLC,
     // NOTE: The type checker is scoped to be torn down before AST
     // verification.
     TypeChecker TC(Ctx);
-    SharedTimer timer("Type checking / Semantic analysis");
+    SharedTimer timer("Type checking / Semantic analysis", [&] {
+      return SF.getFilename().str();
+    });
 
     if (Options.contains(TypeCheckingFlags::DebugTimeFunctionBodies))
       TC.enableDebugTimeFunctionBodies();
 
+    TC.setWarnLongFunctionBodies(WarnLongFunctionBodies);
+    TC.setWarnLongExpressionTypeChecking(WarnLongExpressionTypeChecking);
+    if (Options.contains(TypeCheckingFlags::DebugAlwaysWarnLongTypeChecking))
+      TC.enableDebugAlwaysWarnLongTypeChecking();
+
     if (Options.contains(TypeCheckingFlags::ForImmediateMode))
       TC.setInImmediateMode(true);
+
+    if (Options.contains(TypeCheckingFlags::CompleteTypesAfterErrors))
+      TC.setCompleteTypesAfterErrors(true);
     
     // Lookup the swift module.  This ensures that we record all known
     // protocols in the AST.
@@ -547,11 +547,27 @@ private:
   /// to llvm::errs().
   bool DebugTimeFunctionBodies = false;
 
+  /// If non-zero, warn when a function body takes longer than this many
+  /// milliseconds to type-check.
+  unsigned WarnLongFunctionBodies = 0;
+
+  /// If non-zero, warn when an expression takes longer than this many
+  /// milliseconds to type-check.
+  unsigned WarnLongExpressionTypeChecking = 0;
+
+  /// If true, every function body and expression is treated as exceeding the
+  /// limits above.
+  bool DebugAlwaysWarnLongTypeChecking = false;
+
   /// Indicate that the type checker is checking code that will be
   /// immediately executed. This will suppress certain warnings
   /// when executing scripts.
   bool InImmediateMode = false;
 
+  /// If true, the types referenced by the module are completed for SILGen
+  /// even after an error has been diagnosed.
+  bool CompleteTypesAfterErrors = false;
+
   /// A helper to construct and typecheck call to super.init().
   ///
   /// \returns NULL if the constructed expression does not typecheck.
@@ -569,6 +585,24 @@ public:
     DebugTimeFunctionBodies = true;
   }
 
+  /// Warn when a function body takes longer than \p ms milliseconds to
+  /// type-check, or never if \p ms is zero.
+  void setWarnLongFunctionBodies(unsigned ms) {
+    WarnLongFunctionBodies = ms;
+  }
+
+  /// Warn when an expression takes longer than \p ms milliseconds to
+  /// type-check, or never if \p ms is zero.
+  void setWarnLongExpressionTypeChecking(unsigned ms) {
+    WarnLongExpressionTypeChecking = ms;
+  }
+
+  /// Warn about every function body and expression for which a limit is
+  /// set, however long it took to type-check.
+  void enableDebugAlwaysWarnLongTypeChecking() {
+    DebugAlwaysWarnLongTypeChecking = true;
+  }
+
   bool getInImmediateMode() {
     return InImmediateMode;
   }
@@ -577,6 +611,14 @@ public:
     this->InImmediateMode = InImmediateMode;
   }
 
+  bool getCompleteTypesAfterErrors() const {
+    return CompleteTypesAfterErrors;
+  }
+
+  void setCompleteTypesAfterErrors(bool value) {
+    CompleteTypesAfterErrors = value;
+  }
+
   template<typename ...ArgTypes>
   InFlightDiagnostic diagnose(ArgTypes &&...Args) {
     return Diags.diagnose(std::forward<ArgTypes>(Args)...);
@@ -1829,6 +1871,12 @@ public:
   }
 };
 
+/// Describes \p D in the compile-time trace, by its name and location.
+std::string getCompileTimeTraceDetail(const Decl *D);
+
+/// Describes \p Loc in the compile-time trace.
+std::string getCompileTimeTraceDetail(const ASTContext &Ctx, SourceLoc Loc);
+
 /// Temporary on-stack storage and unescaping for encoded diagnostic
 /// messages.
 ///
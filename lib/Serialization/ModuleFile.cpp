@@ -1125,6 +1125,13 @@ Status ModuleFile::associateWithFileContext(FileUnit *file,
 
 ModuleFile::~ModuleFile() = default;
 
+unsigned ModuleFile::getNumDeclsDeserialized() const {
+  return std::count_if(Decls.begin(), Decls.end(),
+                       [](const Serialized<Decl *> &decl) {
+    return decl.isComplete();
+  });
+}
+
 void ModuleFile::lookupValue(DeclName name,
                              SmallVectorImpl<ValueDecl*> &results) {
   PrettyModuleFileDeserialization stackEntry(*this);
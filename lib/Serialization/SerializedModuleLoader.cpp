@@ -436,6 +436,10 @@ void SerializedASTFile::collectLinkLibraries(
   }
 }
 
+unsigned SerializedASTFile::getNumDeclsDeserialized() const {
+  return File.getNumDeclsDeserialized();
+}
+
 bool SerializedASTFile::isSystemModule() const {
   if (auto Mod = File.getShadowedModule()) {
     return Mod->isSystemModule();
@@ -18,8 +18,11 @@
 //===----------------------------------------------------------------------===//
 
 #include <stdio.h>
+#include <pthread.h>
 #include "swift/Runtime/Debug.h"
+#include "swift/Runtime/Once.h"
 #include "ErrorObject.h"
+#include "Leaks.h"
 #include "Private.h"
 
 #if !SWIFT_OBJC_INTEROP
@@ -43,6 +46,98 @@ _getErrorAllocatedSizeAndAlignmentMask(const Metadata *type) {
   return {size, alignMask};
 }
 
+/// Recently freed ErrorType boxes are kept in a per-thread cache, so that
+/// code that throws and catches in a loop doesn't go through malloc for
+/// every error. Boxes are grouped in size classes of
+/// ErrorBoxSizeClassGranularity bytes.
+static const size_t ErrorBoxSizeClassGranularity = 16;
+static const unsigned NumErrorBoxSizeClasses = 8;
+static const unsigned MaxCachedErrorBoxesPerSizeClass = 4;
+static const size_t MaxCachedErrorBoxAlignMask = 15;
+
+namespace {
+struct ErrorBoxCache {
+  void *Boxes[NumErrorBoxSizeClasses][MaxCachedErrorBoxesPerSizeClass];
+  unsigned Count[NumErrorBoxSizeClasses];
+};
+} // end anonymous namespace
+
+static pthread_key_t ErrorBoxCacheKey;
+static swift_once_t ErrorBoxCacheKeyOnce;
+
+static size_t _getErrorBoxSizeClassSize(unsigned sizeClass) {
+  return (sizeClass + 1) * ErrorBoxSizeClassGranularity;
+}
+
+/// Returns the size class of a box with the given size and alignment, or
+/// NumErrorBoxSizeClasses if boxes of that shape are not cached.
+static unsigned _getErrorBoxSizeClass(size_t size, size_t alignMask) {
+  if (alignMask > MaxCachedErrorBoxAlignMask || size == 0)
+    return NumErrorBoxSizeClasses;
+  size_t sizeClass = (size - 1) / ErrorBoxSizeClassGranularity;
+  if (sizeClass >= NumErrorBoxSizeClasses)
+    return NumErrorBoxSizeClasses;
+  return sizeClass;
+}
+
+/// Free the boxes cached by a thread when it exits.
+static void _destroyErrorBoxCache(void *arg) {
+  auto cache = static_cast<ErrorBoxCache *>(arg);
+  for (unsigned sizeClass = 0; sizeClass < NumErrorBoxSizeClasses;
+       ++sizeClass) {
+    for (unsigned i = 0; i < cache->Count[sizeClass]; ++i)
+      swift_slowDealloc(cache->Boxes[sizeClass][i],
+                        _getErrorBoxSizeClassSize(sizeClass),
+                        MaxCachedErrorBoxAlignMask);
+  }
+  swift_slowDealloc(cache, sizeof(ErrorBoxCache), alignof(ErrorBoxCache) - 1);
+}
+
+static ErrorBoxCache *_getErrorBoxCache() {
+  swift_once(&ErrorBoxCacheKeyOnce, [](void *) {
+    pthread_key_create(&ErrorBoxCacheKey, _destroyErrorBoxCache);
+  });
+
+  auto cache =
+    static_cast<ErrorBoxCache *>(pthread_getspecific(ErrorBoxCacheKey));
+  if (cache)
+    return cache;
+
+  cache = static_cast<ErrorBoxCache *>(
+    swift_slowAlloc(sizeof(ErrorBoxCache), alignof(ErrorBoxCache) - 1));
+  for (unsigned sizeClass = 0; sizeClass < NumErrorBoxSizeClasses;
+       ++sizeClass)
+    cache->Count[sizeClass] = 0;
+  pthread_setspecific(ErrorBoxCacheKey, cache);
+  return cache;
+}
+
+/// Deallocate an ErrorType box, keeping it in the current thread's cache if
+/// there is room.
+static void _deallocErrorObject(HeapObject *object, size_t size,
+                                size_t alignMask) {
+  unsigned sizeClass = _getErrorBoxSizeClass(size, alignMask);
+  if (sizeClass == NumErrorBoxSizeClasses) {
+    swift_deallocObject(object, size, alignMask);
+    return;
+  }
+
+  // Boxes with outstanding unowned references can't be reused; let
+  // swift_deallocObject arrange for them to be freed.
+  auto cache = _getErrorBoxCache();
+  if (cache->Count[sizeClass] == MaxCachedErrorBoxesPerSizeClass ||
+      object->weakRefCount.getCount() != 1) {
+    swift_deallocObject(object, _getErrorBoxSizeClassSize(sizeClass),
+                        MaxCachedErrorBoxAlignMask);
+    return;
+  }
+
+  // If we are tracking leaks, stop tracking this object.
+  SWIFT_LEAKS_STOP_TRACKING_OBJECT(object);
+
+  cache->Boxes[sizeClass][cache->Count[sizeClass]++] = object;
+}
+
 /// Destructor for an ErrorType box.
 static void _destroyErrorObject(HeapObject *obj) {
   auto error = static_cast<SwiftError *>(obj);
@@ -53,7 +148,7 @@ static void _destroyErrorObject(HeapObject *obj) {
   
   // Deallocate the buffer.
   auto sizeAndAlign = _getErrorAllocatedSizeAndAlignmentMask(type);
-  swift_deallocObject(obj, sizeAndAlign.first, sizeAndAlign.second);
+  _deallocErrorObject(obj, sizeAndAlign.first, sizeAndAlign.second);
 }
 
 /// Heap metadata for ErrorType boxes.
@@ -62,6 +157,31 @@ static const FullMetadata<HeapMetadata> ErrorTypeMetadata{
   Metadata{MetadataKind::ErrorObject},
 };
 
+/// Allocate an ErrorType box, reusing a cached box of the same size class
+/// if one is available.
+static HeapObject *_allocErrorObject(size_t size, size_t alignMask) {
+  unsigned sizeClass = _getErrorBoxSizeClass(size, alignMask);
+  if (sizeClass == NumErrorBoxSizeClasses)
+    return swift_allocObject(&ErrorTypeMetadata, size, alignMask);
+
+  auto cache = _getErrorBoxCache();
+  if (cache->Count[sizeClass] == 0)
+    return swift_allocObject(&ErrorTypeMetadata,
+                             _getErrorBoxSizeClassSize(sizeClass),
+                             MaxCachedErrorBoxAlignMask);
+
+  auto object = static_cast<HeapObject *>(
+    cache->Boxes[sizeClass][--cache->Count[sizeClass]]);
+  object->metadata = &ErrorTypeMetadata;
+  object->refCount.init();
+  object->weakRefCount.init();
+
+  // If leak tracking is enabled, start tracking this object.
+  SWIFT_LEAKS_START_TRACKING_OBJECT(object);
+
+  return object;
+}
+
 BoxPair::Return
 swift::swift_allocError(const swift::Metadata *type,
                         const swift::WitnessTable *errorConformance,
@@ -69,8 +189,7 @@ swift::swift_allocError(const swift::Metadata *type,
                         bool isTake) {
   auto sizeAndAlign = _getErrorAllocatedSizeAndAlignmentMask(type);
   
-  auto allocated = swift_allocObject(&ErrorTypeMetadata,
-                                     sizeAndAlign.first, sizeAndAlign.second);
+  auto allocated = _allocErrorObject(sizeAndAlign.first, sizeAndAlign.second);
   
   auto error = reinterpret_cast<SwiftError*>(allocated);
   
@@ -92,7 +211,7 @@ swift::swift_allocError(const swift::Metadata *type,
 void
 swift::swift_deallocError(SwiftError *error, const Metadata *type) {
   auto sizeAndAlign = _getErrorAllocatedSizeAndAlignmentMask(type);
-  swift_deallocObject(error, sizeAndAlign.first, sizeAndAlign.second);
+  _deallocErrorObject(error, sizeAndAlign.first, sizeAndAlign.second);
 }
 
 void
@@ -0,0 +1,171 @@
+//===--- ImageInspection.cpp - Image inspection routines ------------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// Implements the registry of loaded images used to find protocol conformance
+// and type metadata records on ELF and Cygwin. On Darwin, dyld notifies the
+// runtime of every image directly and this registry is not used.
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/Basic/Lazy.h"
+#include "ImageInspection.h"
+#include "Private.h"
+
+#if defined(__ELF__)
+#include <elf.h>
+#include <link.h>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <dlfcn.h>
+#include <string>
+#include <vector>
+
+using namespace swift;
+
+static std::atomic<uint64_t> ImageInspectionTime{0};
+
+uint64_t swift::swift_getImageInspectionTime() {
+  return ImageInspectionTime.load(std::memory_order_relaxed);
+}
+
+#if !(defined(__APPLE__) && defined(__MACH__))
+
+#if defined(__ELF__)
+static const char * const SectionNames[NumImageSectionKinds] = {
+  ".swift2_protocol_conformances_start",
+  ".swift2_type_metadata_start",
+};
+#elif defined(__CYGWIN__)
+static const char * const SectionNames[NumImageSectionKinds] = {
+  ".sw2prtc",
+  ".sw2tymd",
+};
+#else
+# error No known mechanism to inspect dynamic libraries on this platform.
+#endif
+
+namespace {
+
+/// Accumulates the time spent in a scope into ImageInspectionTime.
+class InspectionTimer {
+  std::chrono::steady_clock::time_point Start;
+
+public:
+  InspectionTimer() : Start(std::chrono::steady_clock::now()) {}
+
+  ~InspectionTimer() {
+    auto Elapsed = std::chrono::steady_clock::now() - Start;
+    ImageInspectionTime.fetch_add(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(Elapsed).count(),
+      std::memory_order_relaxed);
+  }
+};
+
+struct SectionRange {
+  const uint8_t *Data;
+  size_t Size;
+};
+
+struct ImageInfo {
+  /// The path of the image, or empty for the main executable.
+  std::string Name;
+
+  SectionRange Sections[NumImageSectionKinds];
+};
+
+struct ImageRegistry {
+  std::vector<ImageInfo> Images;
+
+  ImageRegistry() {
+    InspectionTimer Timer;
+    // Record the images first and open them afterwards, outside the
+    // loader's iteration.
+    // FIXME: Images loaded after this point are not registered.
+    // rdar://problem/19045112
+#if defined(__ELF__)
+    dl_iterate_phdr(recordImage, this);
+#elif defined(__CYGWIN__)
+    _swift_dl_iterate_phdr(recordImage, this);
+#endif
+    for (auto &image : Images)
+      resolve(image);
+  }
+
+  static int recordImage(struct dl_phdr_info *info, size_t size,
+                         void *data) {
+    auto registry = static_cast<ImageRegistry *>(data);
+    ImageInfo image;
+    if (info->dlpi_name)
+      image.Name = info->dlpi_name;
+    registry->Images.push_back(image);
+    return 0;
+  }
+
+  /// Locate every Swift metadata section of the given image, opening it
+  /// only once for all section kinds.
+  static void resolve(ImageInfo &image) {
+    void *handle;
+    if (image.Name.empty())
+      handle = dlopen(nullptr, RTLD_LAZY);
+    else
+      handle = dlopen(image.Name.c_str(), RTLD_LAZY | RTLD_NOLOAD);
+
+    for (unsigned kind = 0; kind < NumImageSectionKinds; ++kind) {
+      image.Sections[kind] = SectionRange{nullptr, 0};
+      if (!handle)
+        continue;
+#if defined(__ELF__)
+      auto data = reinterpret_cast<const uint8_t *>(
+        dlsym(handle, SectionNames[kind]));
+      if (!data)
+        continue;
+      // The size of the section is stored at its head.
+      auto size = *reinterpret_cast<const uint64_t *>(data);
+      image.Sections[kind] = SectionRange{data + sizeof(size), size_t(size)};
+#elif defined(__CYGWIN__)
+      unsigned long size;
+      const uint8_t *data =
+        _swift_getSectionDataPE(handle, SectionNames[kind], &size);
+      if (data)
+        image.Sections[kind] = SectionRange{data, size_t(size)};
+#endif
+    }
+
+    if (handle)
+      dlclose(handle);
+  }
+};
+
+} // end anonymous namespace
+
+static Lazy<ImageRegistry> Registry;
+
+void swift::_swift_forEachImageSection(ImageSectionKind kind,
+                                       void (*fn)(const uint8_t *sectionData,
+                                                  size_t sectionSize,
+                                                  void *context),
+                                       void *context) {
+  // The registry is not modified after it is built, so it can be read
+  // without a lock.
+  auto &R = Registry.get();
+  auto kindIndex = static_cast<unsigned>(kind);
+
+  for (auto &image : R.Images) {
+    auto &section = image.Sections[kindIndex];
+    if (section.Data)
+      fn(section.Data, section.Size, context);
+  }
+}
+
+#endif
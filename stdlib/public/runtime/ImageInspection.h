@@ -0,0 +1,57 @@
+//===--- ImageInspection.h - Image inspection routines ----------*- C++ -*-===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// A registry of loaded images and the Swift metadata sections they contain,
+// shared by protocol conformance and type metadata lookup on platforms
+// without a dynamic loader callback.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SWIFT_RUNTIME_IMAGEINSPECTION_H
+#define SWIFT_RUNTIME_IMAGEINSPECTION_H
+
+#include "swift/Runtime/Config.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace swift {
+
+/// The Swift metadata sections looked up by the runtime.
+enum class ImageSectionKind : unsigned {
+  ProtocolConformances,
+  TypeMetadataRecords,
+};
+
+enum : unsigned { NumImageSectionKinds = 2 };
+
+#if !(defined(__APPLE__) && defined(__MACH__))
+/// Call \p fn with the contents of the given section of every loaded image
+/// that has one.
+///
+/// The first call for any section kind walks the loaded images once and
+/// opens each image once to locate all of its Swift metadata sections.
+/// Later calls, for any kind, reuse that result.
+void _swift_forEachImageSection(ImageSectionKind kind,
+                                void (*fn)(const uint8_t *sectionData,
+                                           size_t sectionSize,
+                                           void *context),
+                                void *context);
+#endif
+
+/// Returns the total time, in nanoseconds, that the runtime has spent
+/// enumerating loaded images and locating their Swift metadata sections.
+SWIFT_RUNTIME_EXPORT
+extern "C" uint64_t swift_getImageInspectionTime();
+
+} // end namespace swift
+
+#endif // SWIFT_RUNTIME_IMAGEINSPECTION_H
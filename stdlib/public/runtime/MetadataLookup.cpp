@@ -23,14 +23,12 @@
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/PointerIntPair.h"
 #include "llvm/ADT/StringExtras.h"
+#include "ImageInspection.h"
 #include "Private.h"
 
 #if defined(__APPLE__) && defined(__MACH__)
 #include <mach-o/dyld.h>
 #include <mach-o/getsect.h>
-#elif defined(__ELF__)
-#include <elf.h>
-#include <link.h>
 #endif
 
 #include <dlfcn.h>
@@ -47,10 +45,6 @@ using namespace Demangle;
 
 #if defined(__APPLE__) && defined(__MACH__)
 #define SWIFT_TYPE_METADATA_SECTION "__swift2_types"
-#elif defined(__ELF__)
-#define SWIFT_TYPE_METADATA_SECTION ".swift2_type_metadata_start"
-#elif defined(__CYGWIN__)
-#define SWIFT_TYPE_METADATA_SECTION ".sw2tymd"
 #endif
 
 // Type Metadata Cache.
@@ -155,52 +149,6 @@ static void _addImageTypeMetadataRecords(const mach_header *mh,
 
   _addImageTypeMetadataRecordsBlock(records, recordsSize);
 }
-#elif defined(__ELF__)
-static int _addImageTypeMetadataRecords(struct dl_phdr_info *info,
-                                        size_t size, void * /*data*/) {
-  void *handle;
-  if (!info->dlpi_name || info->dlpi_name[0] == '\0') {
-    handle = dlopen(nullptr, RTLD_LAZY);
-  } else
-    handle = dlopen(info->dlpi_name, RTLD_LAZY | RTLD_NOLOAD);
-  auto records = reinterpret_cast<const uint8_t*>(
-      dlsym(handle, SWIFT_TYPE_METADATA_SECTION));
-
-  if (!records) {
-    // if there are no type metadata records, don't hold this handle open.
-    dlclose(handle);
-    return 0;
-  }
-
-  // Extract the size of the type metadata block from the head of the section
-  auto recordsSize = *reinterpret_cast<const uint64_t*>(records);
-  records += sizeof(recordsSize);
-
-  _addImageTypeMetadataRecordsBlock(records, recordsSize);
-
-  dlclose(handle);
-  return 0;
-}
-#elif defined(__CYGWIN__)
-static int _addImageTypeMetadataRecords(struct dl_phdr_info *info,
-                                        size_t size, void * /*data*/) {
-  void *handle;
-  if (!info->dlpi_name || info->dlpi_name[0] == '\0') {
-    handle = dlopen(nullptr, RTLD_LAZY);
-  } else
-    handle = dlopen(info->dlpi_name, RTLD_LAZY | RTLD_NOLOAD);
-
-  unsigned long recordsSize;
-  const uint8_t *records =
-    _swift_getSectionDataPE(handle, SWIFT_TYPE_METADATA_SECTION,
-                           &recordsSize);
-
-  if (records) {
-    _addImageTypeMetadataRecordsBlock(records, recordsSize);
-  }
-  dlclose(handle);
-  return 0;
-}
 #endif
 
 static void _initializeCallbacksToInspectDylib() {
@@ -209,16 +157,13 @@ static void _initializeCallbacksToInspectDylib() {
   // Dyld will invoke this on our behalf for all images that have already
   // been loaded.
   _dyld_register_func_for_add_image(_addImageTypeMetadataRecords);
-#elif defined(__ELF__)
-  // Search the loaded dls. Unlike the above, this only searches the already
-  // loaded ones.
-  // FIXME: Find a way to have this continue to happen after.
-  // rdar://problem/19045112
-  dl_iterate_phdr(_addImageTypeMetadataRecords, nullptr);
-#elif defined(__CYGWIN__)
-  _swift_dl_iterate_phdr(_addImageTypeMetadataRecords, nullptr);
 #else
-# error No known mechanism to inspect dynamic libraries on this platform.
+  // Enumerate the sections recorded in the shared image registry. Unlike the
+  // above, this only finds images loaded before the first lookup.
+  _swift_forEachImageSection(ImageSectionKind::TypeMetadataRecords,
+                             [](const uint8_t *data, size_t size, void *) {
+                               _addImageTypeMetadataRecordsBlock(data, size);
+                             }, nullptr);
 #endif
 }
 
@@ -0,0 +1,4 @@
+# Dependencies after compilation:
+provides-top-level: [a, b]
+fingerprints-top-level: [[a, a1], [b, b2]]
+interface-hash: "after"
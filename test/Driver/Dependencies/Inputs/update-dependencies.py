@@ -45,7 +45,11 @@ if '-primary-file' in sys.argv:
 else:
     primaryFile = None
 
-outputFile = sys.argv[sys.argv.index('-o') + 1]
+if '-output-filelist' in sys.argv:
+    with open(sys.argv[sys.argv.index('-output-filelist') + 1]) as f:
+        outputFile = f.readline().strip()
+else:
+    outputFile = sys.argv[sys.argv.index('-o') + 1]
 
 # Update the output file mtime, or create it if necessary.
 # From http://stackoverflow.com/a/1160227.
@@ -0,0 +1,39 @@
+/// other ==> main
+
+// RUN: rm -rf %t && cp -r %S/Inputs/one-way/ %t
+// RUN: touch -t 201401240005 %t/*
+
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental -enable-binary-dependencies ./main.swift ./other.swift -module-name main -j1 -v 2>&1 | FileCheck -check-prefix=CHECK-FIRST %s
+
+// CHECK-FIRST-NOT: warning
+// CHECK-FIRST: -binary-reference-dependencies
+// CHECK-FIRST: Handled main.swift
+// CHECK-FIRST: Handled other.swift
+
+// RUN: swift-dependency-tool %t/main~buildrecord.swiftdeps | FileCheck -check-prefix=CHECK-RECORD %s
+
+// CHECK-RECORD: version: "{{.+}}"
+// CHECK-RECORD-NEXT: options: "{{.+}}"
+// CHECK-RECORD-NEXT: build_time: [{{[0-9]+}}, {{[0-9]+}}]
+// CHECK-RECORD-NEXT: inputs:
+// CHECK-RECORD-DAG: "./main.swift": [{{[0-9]+}}, {{[0-9]+}}]
+// CHECK-RECORD-DAG: "./other.swift": [{{[0-9]+}}, {{[0-9]+}}]
+// CHECK-RECORD: stamps:
+// CHECK-RECORD-DAG: "./main.swift": [{{[0-9]+}}, {{[0-9]+}}, {{[0-9]+}}]
+// CHECK-RECORD-DAG: "./other.swift": [{{[0-9]+}}, {{[0-9]+}}, {{[0-9]+}}]
+
+// The binary build record is read back in for a no-op build.
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental -enable-binary-dependencies ./main.swift ./other.swift -module-name main -j1 -v 2>&1 | FileCheck -check-prefix=CHECK-SECOND %s
+
+// CHECK-SECOND-NOT: Handled
+
+// RUN: touch -t 201401240006 %t/other.swift
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental -enable-binary-dependencies ./main.swift ./other.swift -module-name main -j1 -v 2>&1 | FileCheck -check-prefix=CHECK-THIRD %s
+
+// CHECK-THIRD-NOT: Handled main.swift
+// CHECK-THIRD: Handled other.swift
+// CHECK-THIRD-NOT: Handled main.swift
+
+// A YAML build record from an earlier build is still understood.
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./main.swift ./other.swift -module-name main -j1 -v 2>&1 | FileCheck -check-prefix=CHECK-SECOND %s
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental -enable-binary-dependencies ./main.swift ./other.swift -module-name main -j1 -v 2>&1 | FileCheck -check-prefix=CHECK-SECOND %s
@@ -0,0 +1,49 @@
+// main | other
+
+// RUN: rm -rf %t && cp -r %S/Inputs/independent/ %t
+// RUN: touch -t 201401240005 %t/*
+
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./main.swift ./other.swift -module-name main -j1 -v -driver-compilation-cache-path %t/cache 2>&1 | FileCheck -check-prefix=CHECK-FIRST %s
+
+// CHECK-FIRST-DAG: Handled main.swift
+// CHECK-FIRST-DAG: Handled other.swift
+// CHECK-FIRST: Compilation cache: 0 hits, 2 misses, 2 stored, 0 evicted
+
+// A clean build gets everything from the cache, replaying what each job
+// printed.
+// RUN: rm %t/*.o %t/*.swiftdeps
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./main.swift ./other.swift -module-name main -j1 -v -driver-compilation-cache-path %t/cache 2>&1 | FileCheck -check-prefix=CHECK-CLEAN %s
+// RUN: ls %t/main.o %t/other.o %t/main.swiftdeps %t/other.swiftdeps
+
+// CHECK-CLEAN-NOT: -frontend
+// CHECK-CLEAN-DAG: Handled main.swift
+// CHECK-CLEAN-DAG: Handled other.swift
+// CHECK-CLEAN: Compilation cache: 2 hits, 0 misses, 0 stored, 0 evicted
+
+// Changing any file in the module changes the key of every job.
+// RUN: echo '# changed' >> %t/other.swift
+// RUN: rm %t/*.o %t/*.swiftdeps
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./main.swift ./other.swift -module-name main -j1 -v -driver-compilation-cache-path %t/cache 2>&1 | FileCheck -check-prefix=CHECK-FIRST %s
+
+// With parseable output, jobs that come from the cache are skipped.
+// RUN: rm %t/*.o %t/*.swiftdeps
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./main.swift ./other.swift -module-name main -j1 -parseable-output -driver-compilation-cache-path %t/cache 2>&1 | FileCheck -check-prefix=CHECK-PARSEABLE %s
+
+// CHECK-PARSEABLE-NOT: "kind": "began"
+// CHECK-PARSEABLE: "kind": "skipped"
+// CHECK-PARSEABLE: "kind": "skipped"
+// CHECK-PARSEABLE-NOT: "kind": "began"
+
+// The least recently used entries are removed to stay within the size limit.
+// RUN: touch -t 201401240006 %t/main.swift
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./main.swift ./other.swift -module-name main -j1 -v -driver-compilation-cache-path %t/cache -driver-compilation-cache-size-limit 0 2>&1 | FileCheck -check-prefix=CHECK-TRIM %s
+// RUN: ls %t/cache | FileCheck -check-prefix=CHECK-EMPTY %s
+
+// CHECK-TRIM: Compilation cache: 1 hits, 0 misses, 0 stored, 4 evicted
+// CHECK-EMPTY-NOT: .entry
+
+// Filelists get fresh names in every build, but what they list is the same.
+// RUN: rm -rf %t/cache %t/*.o %t/*.swiftdeps
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./main.swift ./other.swift -module-name main -j1 -v -driver-compilation-cache-path %t/cache -driver-use-filelists 2>&1 | FileCheck -check-prefix=CHECK-FIRST %s
+// RUN: rm %t/*.o %t/*.swiftdeps
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./main.swift ./other.swift -module-name main -j1 -v -driver-compilation-cache-path %t/cache -driver-use-filelists 2>&1 | FileCheck -check-prefix=CHECK-CLEAN %s
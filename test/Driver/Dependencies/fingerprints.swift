@@ -0,0 +1,34 @@
+/// changes ==> uses-a, uses-b
+/// Only the fingerprint of "b" changes.
+
+// RUN: rm -rf %t && cp -r %S/Inputs/fingerprints/ %t
+// RUN: touch -t 201401240005 %t/*
+
+// Generate the build record...
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./changes.swift ./uses-a.swift ./uses-b.swift -module-name main -j1 -v
+
+// ...then reset the .swiftdeps files.
+// RUN: cp -r %S/Inputs/fingerprints/*.swiftdeps %t
+
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./changes.swift ./uses-a.swift ./uses-b.swift -module-name main -j1 -v 2>&1 | FileCheck -check-prefix=CHECK-CLEAN %s
+
+// CHECK-CLEAN-NOT: Handled
+
+// RUN: touch -t 201401240006 %t/changes.swift
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./changes.swift ./uses-a.swift ./uses-b.swift -module-name main -j1 -v 2>&1 | FileCheck -check-prefix=CHECK-FINGERPRINTS %s
+
+// CHECK-FINGERPRINTS-NOT: Handled uses-a.swift
+// CHECK-FINGERPRINTS: Handled changes.swift
+// CHECK-FINGERPRINTS-NOT: Handled uses-a.swift
+// CHECK-FINGERPRINTS: Handled uses-b.swift
+// CHECK-FINGERPRINTS-NOT: Handled uses-a.swift
+
+
+// RUN: cp -r %S/Inputs/fingerprints/*.swiftdeps %t
+
+// RUN: touch -t 201401240007 %t/changes.swift
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental -driver-ignore-fingerprints ./changes.swift ./uses-a.swift ./uses-b.swift -module-name main -j1 -v 2>&1 | FileCheck -check-prefix=CHECK-IGNORE-FINGERPRINTS %s
+
+// CHECK-IGNORE-FINGERPRINTS: Handled changes.swift
+// CHECK-IGNORE-FINGERPRINTS-DAG: Handled uses-a.swift
+// CHECK-IGNORE-FINGERPRINTS-DAG: Handled uses-b.swift
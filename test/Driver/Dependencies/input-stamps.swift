@@ -0,0 +1,53 @@
+// main | other
+
+// RUN: rm -rf %t && cp -r %S/Inputs/independent/ %t
+// RUN: touch -t 201401240005 %t/*
+
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./main.swift ./other.swift -module-name main -j1 -v -driver-compare-input-hashes 2>&1 | FileCheck -check-prefix=CHECK-FIRST %s
+// RUN: FileCheck -check-prefix=CHECK-RECORD %s < %t/main~buildrecord.swiftdeps
+
+// CHECK-FIRST-NOT: warning
+// CHECK-FIRST-DAG: Handled main.swift
+// CHECK-FIRST-DAG: Handled other.swift
+
+// CHECK-RECORD: stamps:
+// CHECK-RECORD-NEXT: "./main.swift": [{{[0-9]+}}, {{[0-9]+}}, {{[0-9]+}}, "{{[0-9a-f]+}}"]
+// CHECK-RECORD-NEXT: "./other.swift": [{{[0-9]+}}, {{[0-9]+}}, {{[0-9]+}}, "{{[0-9a-f]+}}"]
+
+// Touching a file without changing it doesn't rebuild it when comparing
+// hashes...
+// RUN: touch -t 201401240006 %t/main.swift
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./main.swift ./other.swift -module-name main -j1 -v -driver-compare-input-hashes 2>&1 | FileCheck -check-prefix=CHECK-NONE %s
+
+// CHECK-NONE-NOT: Handled
+
+// ...but does otherwise.
+// RUN: touch -t 201401240007 %t/main.swift
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./main.swift ./other.swift -module-name main -j1 -v 2>&1 | FileCheck -check-prefix=CHECK-MAIN %s
+
+// CHECK-MAIN-NOT: Handled other.swift
+// CHECK-MAIN: Handled main.swift
+// CHECK-MAIN-NOT: Handled other.swift
+
+// A file whose contents changed is rebuilt, even if its modification time
+// is the same.
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./main.swift ./other.swift -module-name main -j1 -v -driver-compare-input-hashes 2>&1 | FileCheck -check-prefix=CHECK-NONE %s
+// RUN: echo '# changed' >> %t/main.swift
+// RUN: touch -t 201401240007 %t/main.swift
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./main.swift ./other.swift -module-name main -j1 -v -driver-compare-input-hashes 2>&1 | FileCheck -check-prefix=CHECK-MAIN %s
+
+// With a list of changed files, only the files on it are checked.
+// RUN: touch -t 201401240008 %t/main.swift %t/other.swift
+// RUN: echo './other.swift' > %t/changed.txt
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./main.swift ./other.swift -module-name main -j1 -v -driver-changed-files %t/changed.txt 2>&1 | FileCheck -check-prefix=CHECK-OTHER %s
+
+// CHECK-OTHER-NOT: Handled main.swift
+// CHECK-OTHER: Handled other.swift
+// CHECK-OTHER-NOT: Handled main.swift
+
+// RUN: echo 'main.swift' > %t/changed.txt
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./main.swift ./other.swift -module-name main -j1 -v -driver-changed-files %t/changed.txt 2>&1 | FileCheck -check-prefix=CHECK-MAIN %s
+
+// RUN: not %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./main.swift ./other.swift -module-name main -j1 -driver-changed-files %t/missing.txt 2>&1 | FileCheck -check-prefix=CHECK-MISSING-LIST %s
+
+// CHECK-MISSING-LIST: error: unable to load list of changed files '{{.*}}missing.txt'
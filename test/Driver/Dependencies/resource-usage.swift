@@ -0,0 +1,34 @@
+// main | other
+
+// RUN: rm -rf %t && cp -r %S/Inputs/independent/ %t
+// RUN: touch -t 201401240005 %t/*
+
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./main.swift ./other.swift -module-name main -j1 -parseable-output 2>&1 | FileCheck -check-prefix=CHECK-PARSEABLE %s
+
+// CHECK-PARSEABLE: {{^{$}}
+// CHECK-PARSEABLE: "kind": "finished"
+// CHECK-PARSEABLE: "name": "compile"
+// CHECK-PARSEABLE: "output": "Handled main.swift\n"
+// CHECK-PARSEABLE: "usage": {
+// CHECK-PARSEABLE-NEXT: "wall-time": {{[1-9][0-9]*}},
+// CHECK-PARSEABLE-NEXT: "user-time": {{[0-9]+}},
+// CHECK-PARSEABLE-NEXT: "system-time": {{[0-9]+}},
+// CHECK-PARSEABLE-NEXT: "max-rss": {{[1-9][0-9]*}}
+// CHECK-PARSEABLE: "exit-status": 0
+// CHECK-PARSEABLE: {{^}$}}
+
+// RUN: touch -t 201401240006 %t/*
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./main.swift ./other.swift -module-name main -j1 -driver-time-compilation 2>&1 | FileCheck -check-prefix=CHECK-SUMMARY %s
+
+// CHECK-SUMMARY-DAG: Handled main.swift
+// CHECK-SUMMARY-DAG: Handled other.swift
+// CHECK-SUMMARY: Driver Job Resource Usage
+// CHECK-SUMMARY: Wall Time    User Time  System Time      Max RSS  Job
+// CHECK-SUMMARY-DAG: {{[0-9.]+s +[0-9.]+s +[0-9.]+s +[0-9.]+ MB  compile main.swift$}}
+// CHECK-SUMMARY-DAG: {{[0-9.]+s +[0-9.]+s +[0-9.]+s +[0-9.]+ MB  compile other.swift$}}
+// CHECK-SUMMARY: {{[0-9.]+s +[0-9.]+s +[0-9.]+s +[0-9.]+ MB  Total$}}
+
+// Nothing is printed if no jobs run.
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./main.swift ./other.swift -module-name main -j1 -driver-time-compilation 2>&1 | FileCheck -check-prefix=CHECK-NONE %s
+
+// CHECK-NONE-NOT: Resource Usage
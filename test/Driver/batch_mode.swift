@@ -0,0 +1,41 @@
+// RUN: rm -rf %t && mkdir %t
+// RUN: touch %t/file-01.swift %t/file-02.swift %t/file-03.swift %t/file-04.swift
+
+// RUN: %swiftc_driver_plain -enable-batch-mode -driver-batch-count 2 -j 2 -c %t/file-01.swift %t/file-02.swift %t/file-03.swift %t/file-04.swift -module-name main -target x86_64-apple-macosx10.9 -driver-skip-execution -v 2>&1 | FileCheck %s
+
+// CHECK: -frontend -c
+// CHECK-SAME: -primary-file {{[^ ]*}}/file-01.swift -primary-file {{[^ ]*}}/file-02.swift {{[^ ]*}}/file-03.swift {{[^ ]*}}/file-04.swift
+// CHECK-SAME: -o {{[^ ]*}}/file-01-{{[a-z0-9]+}}.o -o {{[^ ]*}}/file-02-{{[a-z0-9]+}}.o
+// CHECK-SAME: -batch-output-file-map {{[^ ]*}}/batch-outputs-{{[a-z0-9]+}}.json
+// CHECK: -frontend -c
+// CHECK-SAME: {{[^ ]*}}/file-01.swift {{[^ ]*}}/file-02.swift -primary-file {{[^ ]*}}/file-03.swift -primary-file {{[^ ]*}}/file-04.swift
+// CHECK-SAME: -batch-output-file-map
+// CHECK-NOT: -frontend
+
+// RUN: %swiftc_driver_plain -enable-batch-mode -driver-batch-count 2 -j 2 -c %t/file-01.swift %t/file-02.swift %t/file-03.swift %t/file-04.swift -module-name main -target x86_64-apple-macosx10.9 -driver-skip-execution -parseable-output 2>&1 | FileCheck -check-prefix=PARSEABLE %s
+
+// PARSEABLE: "kind": "began"
+// PARSEABLE: "inputs": [
+// PARSEABLE-NEXT: "{{[^"]*}}/file-01.swift"
+// PARSEABLE: "pid": [[PID1:[0-9]+]]
+// PARSEABLE: "kind": "began"
+// PARSEABLE: "inputs": [
+// PARSEABLE-NEXT: "{{[^"]*}}/file-02.swift"
+// PARSEABLE: "pid": [[PID1]]
+
+// A batch that names its outputs in a filelist must write that filelist.
+// RUN: mkdir %t/tmp
+// RUN: env TMPDIR=%t/tmp/ %swiftc_driver_plain -enable-batch-mode -driver-batch-count 1 -c %t/file-01.swift %t/file-02.swift %t/file-03.swift %t/file-04.swift -module-name main -target x86_64-apple-macosx10.9 -driver-use-filelists -save-temps -driver-skip-execution
+// RUN: cat %t/tmp/outputs-* | FileCheck -check-prefix=FILELIST %s
+
+// FILELIST: file-01{{.*}}.o
+// FILELIST-NEXT: file-02{{.*}}.o
+// FILELIST-NEXT: file-03{{.*}}.o
+// FILELIST-NEXT: file-04{{.*}}.o
+
+// Batch mode does not apply to whole-module compilations, and is off unless
+// requested.
+// RUN: %swiftc_driver_plain -enable-batch-mode -disable-batch-mode -c %t/file-01.swift %t/file-02.swift -module-name main -target x86_64-apple-macosx10.9 -driver-skip-execution -v 2>&1 | FileCheck -check-prefix=DISABLED %s
+// RUN: %swiftc_driver_plain -enable-batch-mode -whole-module-optimization -c %t/file-01.swift %t/file-02.swift -module-name main -target x86_64-apple-macosx10.9 -driver-skip-execution -v 2>&1 | FileCheck -check-prefix=DISABLED %s
+
+// DISABLED-NOT: -batch-output-file-map
@@ -51,6 +51,7 @@
 // RUN: %swiftc_driver -driver-print-jobs -whole-module-optimization -incremental %s 2>&1 > %t.wmo-inc.txt
 // RUN: FileCheck %s < %t.wmo-inc.txt
 // RUN: FileCheck -check-prefix NO-REFERENCE-DEPENDENCIES %s < %t.wmo-inc.txt
+// RUN: FileCheck -check-prefix WMO %s < %t.wmo-inc.txt
 
 // RUN: %swiftc_driver -driver-print-jobs -embed-bitcode -incremental %s 2>&1 > %t.embed-inc.txt
 // RUN: FileCheck %s < %t.embed-inc.txt
@@ -74,6 +75,7 @@
 // COMPLEX-DAG: -I /path/to/headers -I path/to/more/headers
 // COMPLEX-DAG: -module-cache-path /tmp/modules
 // COMPLEX-DAG: -emit-reference-dependencies-path {{(.*/)?driver-compile[^ /]+}}.swiftdeps
+// COMPLEX-DAG: -skip-secondary-function-bodies
 // COMPLEX: -o {{.+}}.o
 
 
@@ -127,3 +129,6 @@
 
 // NO-REFERENCE-DEPENDENCIES: bin/swift
 // NO-REFERENCE-DEPENDENCIES-NOT: -emit-reference-dependencies
+
+// WMO: bin/swift
+// WMO-NOT: -skip-secondary-function-bodies
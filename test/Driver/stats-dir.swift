@@ -0,0 +1,44 @@
+// The driver and each frontend job write a file of statistics.
+// RUN: rm -rf %t && mkdir %t
+// RUN: %target-swiftc_driver -c %s -module-name main -o %t/main.o -stats-output-dir %t/stats
+// RUN: cat %t/stats/stats-swift-driver-main-all-*.json | FileCheck -check-prefix=CHECK-DRIVER %s
+// RUN: cat %t/stats/stats-swift-frontend-main-stats-dir.swift-*.json | FileCheck -check-prefix=CHECK-FRONTEND %s
+
+// CHECK-DRIVER-DAG: "Driver.NumDriverJobs": 1,
+// CHECK-DRIVER-DAG: "Driver.NumDriverJobsRun": 1,
+// CHECK-DRIVER-DAG: "Driver.NumDriverJobsCached": 0,
+// CHECK-DRIVER-DAG: "time.swift-driver.wall": {{[0-9.e-]+}}
+
+// CHECK-FRONTEND-DAG: "AST.NumSourceBuffers": 1,
+// CHECK-FRONTEND-DAG: "AST.NumDecls": {{[1-9][0-9]*}},
+// CHECK-FRONTEND-DAG: "Sema.NumConstraintSystemsSolved": {{[1-9][0-9]*}},
+// CHECK-FRONTEND-DAG: "Serialization.NumDeclsDeserialized.Swift": {{[1-9][0-9]*}},
+// CHECK-FRONTEND-DAG: "SILModule.NumSILGenFunctions": {{[1-9][0-9]*}},
+// CHECK-FRONTEND-DAG: "SILModule.NumSILOptInstructions": {{[1-9][0-9]*}},
+// CHECK-FRONTEND-DAG: "IRModule.NumIRInstructions": {{[1-9][0-9]*}},
+// CHECK-FRONTEND-DAG: "Memory.ASTContextBytes": {{[1-9][0-9]*}},
+// CHECK-FRONTEND-DAG: "Memory.SourceBufferMallocBytes": {{[1-9][0-9]*}},
+// CHECK-FRONTEND-DAG: "time.swift.SILGen.wall": {{[0-9.e-]+}}
+// CHECK-FRONTEND-DAG: "time.swift-frontend.wall": {{[0-9.e-]+}}
+
+func square(x: Int) -> Int {
+  return x * x
+}
+
+// The files of two builds can be summed and compared.
+// RUN: %S/../../utils/process-stats-dir.py aggregate %t/stats | FileCheck -check-prefix=CHECK-AGGREGATE %s
+// CHECK-AGGREGATE: 2 stats files
+// CHECK-AGGREGATE: Driver.NumDriverJobs {{ +}}1
+
+// RUN: %S/../../utils/process-stats-dir.py --exclude-timers compare %t/stats %t/stats | FileCheck -check-prefix=CHECK-COMPARE %s
+// CHECK-COMPARE: counter
+// CHECK-COMPARE-NOT: AST.
+
+// Peaks are not summed; the largest one is kept.
+// RUN: mkdir %t/peaks
+// RUN: echo '{"AST.NumDecls": 1, "Memory.PeakSILModuleBytes": 100}' > %t/peaks/stats-a.json
+// RUN: echo '{"AST.NumDecls": 2, "Memory.PeakSILModuleBytes": 300}' > %t/peaks/stats-b.json
+// RUN: %S/../../utils/process-stats-dir.py aggregate %t/peaks | FileCheck -check-prefix=CHECK-PEAK %s
+// CHECK-PEAK: 2 stats files
+// CHECK-PEAK: AST.NumDecls {{ +}}3
+// CHECK-PEAK: Memory.PeakSILModuleBytes {{ +}}300
@@ -0,0 +1,3 @@
+func errorFunc() -> Int {
+  return "not an Int"
+}
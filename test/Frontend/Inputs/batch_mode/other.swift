@@ -0,0 +1,5 @@
+struct OtherStruct {
+  var value: Int
+}
+
+func otherFunc() -> OtherStruct { return OtherStruct(value: 1) }
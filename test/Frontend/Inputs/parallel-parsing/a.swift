@@ -0,0 +1,7 @@
+struct A {
+  var value: Int { return a() }
+}
+
+func a() -> Int {
+  return 1
+}
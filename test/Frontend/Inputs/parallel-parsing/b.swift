@@ -0,0 +1,7 @@
+#line 100 "virtual.swift"
+func b() -> Int {
+  return 2
+}
+#line
+
+func b2() -> Int { return b() + A().value }
@@ -0,0 +1,7 @@
+func c(_ x: Int) -> Int {
+  struct Local {
+    func get(_ y: Int) -> Int { return y }
+  }
+  let closure = { (y: Int) -> Int in Local().get(x + y) }
+  return closure(x)
+}
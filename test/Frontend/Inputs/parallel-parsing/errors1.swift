@@ -0,0 +1,3 @@
+func errors1() -> Int {
+  return 1 +
+}
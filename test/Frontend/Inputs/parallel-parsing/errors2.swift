@@ -0,0 +1,4 @@
+#line 100 "virtual.swift"
+func errors2() -> Int {
+  return 2 +
+}
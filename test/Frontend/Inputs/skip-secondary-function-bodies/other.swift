@@ -0,0 +1,3 @@
+func other() -> Int {
+  return 1 +
+}
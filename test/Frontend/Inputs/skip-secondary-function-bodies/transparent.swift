@@ -0,0 +1,4 @@
+@_transparent
+func transparentOther() -> Int {
+  return 2 +
+}
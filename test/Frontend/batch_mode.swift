@@ -0,0 +1,43 @@
+// RUN: rm -rf %t && mkdir %t
+// RUN: echo "{\"%s\": {\"swift-dependencies\": \"%t/main.swiftdeps\"}, \"%S/Inputs/batch_mode/other.swift\": {\"swift-dependencies\": \"%t/other.swiftdeps\"}}" > %t/batch.json
+
+// RUN: %target-swift-frontend -emit-sil -primary-file %s -primary-file %S/Inputs/batch_mode/other.swift -o %t/main.sil -o %t/other.sil -batch-output-file-map %t/batch.json -module-name main
+// RUN: FileCheck -check-prefix=MAIN-SIL %s < %t/main.sil
+// RUN: FileCheck -check-prefix=OTHER-SIL %s < %t/other.sil
+// RUN: FileCheck -check-prefix=MAIN-DEPS %s < %t/main.swiftdeps
+// RUN: FileCheck -check-prefix=OTHER-DEPS %s < %t/other.swiftdeps
+
+// The per-file outputs must match those of separate invocations.
+// RUN: %target-swift-frontend -emit-sil -primary-file %s %S/Inputs/batch_mode/other.swift -o %t/main-single.sil -emit-reference-dependencies-path %t/main-single.swiftdeps -module-name main
+// RUN: diff %t/main.swiftdeps %t/main-single.swiftdeps
+
+// An error in one primary file doesn't stop the others from producing their
+// outputs.
+// RUN: not %target-swift-frontend -emit-sil -primary-file %s %S/Inputs/batch_mode/other.swift -primary-file %S/Inputs/batch_mode/error.swift -o %t/main-with-error.sil -o %t/error.sil -batch-output-file-map %t/batch.json -module-name main 2>&1 | FileCheck -check-prefix=ERROR %s
+// RUN: FileCheck -check-prefix=MAIN-SIL %s < %t/main-with-error.sil
+// RUN: not ls %t/error.sil
+
+// ERROR: error.swift:2:10: error: cannot convert return expression
+
+// RUN: not %target-swift-frontend -emit-sil -primary-file %s -primary-file %S/Inputs/batch_mode/other.swift -o %t/main.sil -o %t/other.sil -module-name main 2>&1 | FileCheck -check-prefix=NO-MAP %s
+// RUN: not %target-swift-frontend -emit-sil -primary-file %s -primary-file %S/Inputs/batch_mode/other.swift -o %t/main.sil -batch-output-file-map %t/batch.json -module-name main 2>&1 | FileCheck -check-prefix=OUTPUT-COUNT %s
+
+// NO-MAP: error: multiple -primary-file inputs require -batch-output-file-map
+// OUTPUT-COUNT: error: expected one output filename for each of the 2 -primary-file inputs
+
+// MAIN-SIL: sil hidden @_TF4main8mainFuncFT_T_
+// MAIN-SIL-NOT: sil hidden @_TF4main9otherFuncFT_VS_11OtherStruct
+// OTHER-SIL: sil hidden @_TF4main9otherFuncFT_VS_11OtherStruct
+// OTHER-SIL-NOT: sil hidden @_TF4main8mainFuncFT_T_
+
+// MAIN-DEPS-LABEL: provides-top-level:
+// MAIN-DEPS: "mainFunc"
+// MAIN-DEPS-LABEL: depends-top-level:
+// MAIN-DEPS: "otherFunc"
+// OTHER-DEPS-LABEL: provides-top-level:
+// OTHER-DEPS: "otherFunc"
+// OTHER-DEPS-NOT: "mainFunc"
+
+func mainFunc() {
+  _ = otherFunc().value
+}
@@ -0,0 +1,25 @@
+// A trace of the compilation is written in the Chrome trace event format.
+// RUN: rm -rf %t && mkdir %t
+// RUN: %target-swift-frontend -emit-ir %s -module-name main -o /dev/null -trace-compile-time %t/trace.json -trace-compile-time-granularity 0
+// RUN: FileCheck %s < %t/trace.json
+
+// CHECK: {"traceEvents":[
+// CHECK-DAG: {"ph":"X","name":"Compile","ts":{{[0-9]+}},"dur":{{[0-9]+}},"pid":1,"tid":{{[0-9]+}},"args":{"detail":"main"}}
+// CHECK-DAG: "name":"Parsing",{{[^}]*}}"args":{"detail":"{{[^"]*}}compile-time-trace.swift"}
+// CHECK-DAG: "name":"Name binding",{{[^}]*}}"args":{"detail":"{{[^"]*}}compile-time-trace.swift"}
+// CHECK-DAG: "name":"Type-check function body",{{[^}]*}}"args":{"detail":"square(_:) at {{[^"]*}}compile-time-trace.swift:[[@LINE+7]]:6"}
+// CHECK-DAG: "name":"Type-check expression",{{[^}]*}}"args":{"detail":"{{[^"]*}}compile-time-trace.swift:[[@LINE+7]]:{{[0-9]+}}"}
+// CHECK-DAG: "name":"SILGen function",{{[^}]*}}"args":{"detail":"_TF4main6squareFSiSi"}
+// CHECK-DAG: "name":"SIL optimization"
+// CHECK-DAG: "name":"IRGen function",{{[^}]*}}"args":{"detail":"_TF4main6squareFSiSi"}
+// CHECK-DAG: "name":"LLVM module passes"
+
+func square(x: Int) -> Int {
+  return x * x
+}
+
+// RUN: not %target-swift-frontend -parse %s -trace-compile-time %t/missing/trace.json 2>&1 | FileCheck -check-prefix=CHECK-UNWRITABLE %s
+// CHECK-UNWRITABLE: error: cannot open file '{{.*}}trace.json'
+
+// RUN: not %target-swift-frontend -parse %s -trace-compile-time %t/trace.json -trace-compile-time-granularity soon 2>&1 | FileCheck -check-prefix=CHECK-GRANULARITY %s
+// CHECK-GRANULARITY: error: invalid value 'soon' in '-trace-compile-time-granularity soon'
@@ -0,0 +1,19 @@
+// Files parsed on several threads are reported on in the same order as when
+// they are parsed one after another, and produce the same code.
+// RUN: rm -rf %t && mkdir %t
+
+// RUN: not %target-swift-frontend -parse %s %S/Inputs/parallel-parsing/errors1.swift %S/Inputs/parallel-parsing/a.swift %S/Inputs/parallel-parsing/errors2.swift -module-name main 2> %t/serial.txt
+// RUN: not %target-swift-frontend -parse %s %S/Inputs/parallel-parsing/errors1.swift %S/Inputs/parallel-parsing/a.swift %S/Inputs/parallel-parsing/errors2.swift -module-name main -num-parsing-threads 4 2> %t/parallel.txt
+// RUN: diff %t/serial.txt %t/parallel.txt
+// RUN: FileCheck %s < %t/parallel.txt
+
+// CHECK: errors1.swift:{{[0-9]+}}:{{[0-9]+}}: error: expected expression after operator
+// CHECK: virtual.swift:{{[0-9]+}}:{{[0-9]+}}: error: expected expression after operator
+
+// RUN: %target-swift-frontend -emit-silgen %s %S/Inputs/parallel-parsing/a.swift %S/Inputs/parallel-parsing/b.swift %S/Inputs/parallel-parsing/c.swift -module-name main -o %t/serial.sil
+// RUN: %target-swift-frontend -emit-silgen %s %S/Inputs/parallel-parsing/a.swift %S/Inputs/parallel-parsing/b.swift %S/Inputs/parallel-parsing/c.swift -module-name main -num-parsing-threads 4 -o %t/parallel.sil
+// RUN: diff %t/serial.sil %t/parallel.sil
+
+func useOthers() -> Int {
+  return b2() + c(3)
+}
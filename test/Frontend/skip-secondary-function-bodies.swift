@@ -0,0 +1,25 @@
+// With -skip-secondary-function-bodies, function bodies in non-primary files
+// are skipped, except for those of transparent functions.
+// RUN: not %target-swift-frontend -parse -primary-file %s %S/Inputs/skip-secondary-function-bodies/other.swift %S/Inputs/skip-secondary-function-bodies/transparent.swift -module-name main -skip-secondary-function-bodies 2>&1 | FileCheck -check-prefix=SKIPPED %s
+
+// SKIPPED-NOT: other.swift
+// SKIPPED: transparent.swift:{{[0-9]+}}:{{[0-9]+}}: error: expected expression after operator
+// SKIPPED-NOT: other.swift
+
+// Bodies are parsed by default, and always when there is no primary file.
+// RUN: not %target-swift-frontend -parse -primary-file %s %S/Inputs/skip-secondary-function-bodies/other.swift %S/Inputs/skip-secondary-function-bodies/transparent.swift -module-name main 2>&1 | FileCheck -check-prefix=PARSED %s
+// RUN: not %target-swift-frontend -parse %s %S/Inputs/skip-secondary-function-bodies/other.swift %S/Inputs/skip-secondary-function-bodies/transparent.swift -module-name main -skip-secondary-function-bodies 2>&1 | FileCheck -check-prefix=PARSED %s
+
+// PARSED-DAG: other.swift:{{[0-9]+}}:{{[0-9]+}}: error: expected expression after operator
+// PARSED-DAG: transparent.swift:{{[0-9]+}}:{{[0-9]+}}: error: expected expression after operator
+
+// The skipped bodies are counted.
+// RUN: rm -rf %t && mkdir %t
+// RUN: %target-swift-frontend -parse -primary-file %s %S/Inputs/skip-secondary-function-bodies/other.swift -module-name main -skip-secondary-function-bodies -stats-output-dir %t/stats
+// RUN: cat %t/stats/*.json | FileCheck -check-prefix=STATS %s
+
+// STATS: "AST.NumSkippedFunctionBodies": 1,
+
+func useOthers() -> Int {
+  return other() + transparentOther()
+}
@@ -0,0 +1,17 @@
+// RUN: %target-parse-verify-swift -warn-long-expression-type-checking 1 -debug-always-warn-long-type-checking
+// RUN: %target-swift-frontend -parse %s -warn-long-expression-type-checking 1 -debug-always-warn-long-type-checking 2>&1 | FileCheck %s
+
+func makeInt() -> Int {
+  return 1 // expected-warning {{expression took}}
+}
+// CHECK: warn-long-expression-type-checking.swift:[[@LINE-2]]:10: warning: expression took {{[0-9]+}}ms to type-check (limit: 1ms)
+// CHECK-NEXT: return 1
+// CHECK-NEXT: {{^ *}}^{{$}}
+
+// The whole expression is highlighted.
+func useInt() -> Int {
+  return makeInt() // expected-warning {{expression took}}
+}
+// CHECK: warn-long-expression-type-checking.swift:[[@LINE-2]]:10: warning: expression took {{[0-9]+}}ms to type-check (limit: 1ms)
+// CHECK-NEXT: return makeInt()
+// CHECK-NEXT: {{^ *}}^~~~~~~~{{$}}
@@ -0,0 +1,26 @@
+// RUN: %target-parse-verify-swift -warn-long-function-bodies 1 -debug-always-warn-long-type-checking
+// RUN: %target-swift-frontend -parse %s -warn-long-function-bodies 1 -debug-always-warn-long-type-checking 2>&1 | FileCheck %s
+
+func square() -> Int { // expected-warning {{global function 'square()' took}}
+  let x = 3
+  return x * x
+}
+// CHECK: warn-long-function-bodies.swift:[[@LINE-4]]:6: warning: global function 'square()' took {{[0-9]+}}ms to type-check (limit: 1ms)
+// CHECK-NEXT: func square() -> Int {
+// CHECK-NEXT: {{^ *}}^{{$}}
+
+// A closure is reported before the function it is in, since it is checked
+// while the function body is.
+func sumOfSquares() -> Int { // expected-warning {{global function 'sumOfSquares()' took}}
+  let squares = [1, 2, 3].map { (value: Int) -> Int in // expected-warning {{closure took}}
+    let squared = value * value
+    return squared
+  }
+  return squares.reduce(0, combine: +)
+}
+// CHECK: warn-long-function-bodies.swift:[[@LINE-6]]:31: warning: closure took {{[0-9]+}}ms to type-check (limit: 1ms)
+// CHECK-NEXT: let squares = [1, 2, 3].map { (value: Int) -> Int in
+// CHECK-NEXT: {{^ *}}^{{$}}
+// CHECK: warn-long-function-bodies.swift:[[@LINE-10]]:6: warning: global function 'sumOfSquares()' took {{[0-9]+}}ms to type-check (limit: 1ms)
+// CHECK-NEXT: func sumOfSquares() -> Int {
+// CHECK-NEXT: {{^ *}}^{{$}}
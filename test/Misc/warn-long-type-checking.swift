@@ -0,0 +1,11 @@
+// Nothing here comes close to a generous limit, so there are no warnings.
+// RUN: %target-parse-verify-swift -warn-long-function-bodies 100000 -warn-long-expression-type-checking 100000
+
+// RUN: not %target-swift-frontend -parse %s -warn-long-function-bodies slow 2>&1 | FileCheck -check-prefix=CHECK-INVALID %s
+// CHECK-INVALID: error: invalid value 'slow' in '-warn-long-function-bodies slow'
+
+func square(x: Int) -> Int {
+  return x * x
+}
+
+let total = [1, 2, 3].map { $0 * $0 }.reduce(0, combine: +)
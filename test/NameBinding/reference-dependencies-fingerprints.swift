@@ -0,0 +1,62 @@
+// RUN: rm -rf %t && mkdir %t
+// RUN: cp %s %t/main.swift
+// RUN: %target-swift-frontend -parse -primary-file %t/main.swift -emit-reference-dependencies-path - > %t.swiftdeps
+// RUN: %target-swift-frontend -parse -primary-file %t/main.swift -emit-reference-dependencies-path - -DCHANGED >> %t.swiftdeps
+// RUN: FileCheck %s < %t.swiftdeps
+
+// CHECK: {{^}}fingerprints-top-level: [
+// CHECK-SAME: ["bodyChanges", "[[BODY:[0-9a-f]+]]"]
+// CHECK-SAME: ["signatureChanges", "[[SIGNATURE:[0-9a-f]+]]"]
+// CHECK-SAME: ["Alias", "[[ALIAS:[0-9a-f]+]]"]
+// CHECK-SAME: ["usesAlias", "[[USES_ALIAS:[0-9a-f]+]]"]
+// CHECK-SAME: ["S", "[[S:[0-9a-f]+]]"]
+// CHECK: {{^}}fingerprints-nominal: [
+// CHECK-SAME: ["V4main1S", "[[S_NOMINAL:[0-9a-f]+]]"]
+
+// With CHANGED defined, only the declarations whose signatures changed get
+// new fingerprints; the edits inside function bodies don't count.
+// CHECK: {{^}}fingerprints-top-level: [
+// CHECK-SAME: ["bodyChanges", "[[BODY]]"]
+// CHECK-SAME: ["signatureChanges",
+// CHECK-NOT: [[SIGNATURE]]
+// CHECK-SAME: ["Alias",
+// CHECK-NOT: [[ALIAS]]
+// CHECK-SAME: ["usesAlias",
+// CHECK-NOT: [[USES_ALIAS]]
+// CHECK-SAME: ["S", "[[S]]"]
+// CHECK: {{^}}fingerprints-nominal: [
+// CHECK-SAME: ["V4main1S", "[[S_NOMINAL]]"]
+
+func bodyChanges() -> Int {
+#if CHANGED
+  return 1
+#else
+  return 0
+#endif
+}
+
+#if CHANGED
+func signatureChanges(x: Int) {}
+#else
+func signatureChanges() {}
+#endif
+
+#if CHANGED
+typealias Alias = String
+#else
+typealias Alias = Int
+#endif
+
+// The tokens of this declaration are the same either way, but its type is
+// not.
+func usesAlias() -> Alias { fatalError() }
+
+struct S {
+  func method() -> Int {
+#if CHANGED
+    return 1
+#else
+    return 0
+#endif
+  }
+}
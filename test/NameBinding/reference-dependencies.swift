@@ -4,6 +4,12 @@
 // RUN: FileCheck %s < %t.swiftdeps
 // RUN: FileCheck -check-prefix=NEGATIVE %s < %t.swiftdeps
 
+// The binary format must describe exactly the same dependencies.
+// RUN: %target-swift-frontend -parse -primary-file %t/main.swift %S/Inputs/reference-dependencies-helper.swift -emit-reference-dependencies-path %t-binary.swiftdeps -binary-reference-dependencies
+// RUN: swift-dependency-tool %t-binary.swiftdeps > %t-binary.yaml
+// RUN: FileCheck %s < %t-binary.yaml
+// RUN: FileCheck -check-prefix=NEGATIVE %s < %t-binary.yaml
+
 // CHECK-LABEL: {{^provides-top-level:$}}
 // CHECK-NEXT: "IntWrapper"
 // CHECK-NEXT: "=="
@@ -0,0 +1,60 @@
+import Swift
+
+public struct Pair {
+  public let first: Builtin.Int64
+  public let second: Builtin.Int8
+}
+
+public class Node {
+  public let next: Node
+  public let pair: Pair
+  public let state: State
+
+  public init(next: Node, pair: Pair, state: State) {
+    self.next = next
+    self.pair = pair
+    self.state = state
+  }
+}
+
+public enum State {
+  case Idle
+  case Running
+  case Stopped
+}
+
+public enum Link {
+  case Next(Node)
+  case End
+}
+
+public protocol Opaque {}
+public protocol ClassBound : class {}
+
+public enum MaybeClassBound {
+  case Some(ClassBound)
+  case None
+}
+
+public struct Existentials {
+  public let any: Opaque
+  public let classBound: ClassBound
+  public let anyObject: AnyObject
+  public let error: ErrorType
+  public let composition: protocol<Opaque, ClassBound>
+  public let maybeClassBound: MaybeClassBound
+}
+
+public struct Box<T> {
+  public let type: T.Type
+}
+
+public struct Metatypes {
+  public let int: Int.Type
+  public let node: Node.Type
+  public let opaque: Opaque.Type
+  public let classBound: ClassBound.Type
+  public let anyObject: AnyObject.Type
+  public let opaqueProtocol: Opaque.Protocol
+  public let boxedInt: Box<Int>
+}
@@ -0,0 +1,10 @@
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: %gyb %S/Inputs/ManyTypes.swift.gyb -o %t/ManyTypes.swift
+// RUN: %target-swiftc_driver %t/ManyTypes.swift -emit-library -module-name ManyTypes -Xfrontend -enable-reflection-metadata -o %t/libManyTypes
+// RUN: %target-swift-reflection-test -binary-filename %t/libManyTypes -benchmark-field-descriptor-lookup -iterations 1 | FileCheck %s
+
+// CHECK: Iterations: 1
+// CHECK-NEXT: Types: 4000
+// CHECK-NEXT: Linear scan time (us): {{[0-9]+}}
+// CHECK-NEXT: Index build time (us): {{[0-9]+}}
+// CHECK-NEXT: Indexed lookup time (us): {{[0-9]+}}
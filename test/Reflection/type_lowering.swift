@@ -0,0 +1,66 @@
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: %target-swiftc_driver %S/Inputs/TypeLowering.swift -parse-stdlib -emit-library -module-name TypeLowering -Xfrontend -enable-reflection-metadata -o %t/libTypeLowering
+// RUN: %target-swift-reflection-test -binary-filename %t/libTypeLowering -dump-type-layouts | FileCheck %s
+
+// REQUIRES: CPU=x86_64
+
+// CHECK: TypeLowering.Pair
+// CHECK-NEXT: (struct size=9 alignment=8 stride=16 num_extra_inhabitants=0
+// CHECK-NEXT:   (field name=first offset=0
+// CHECK-NEXT:     (builtin size=8 alignment=8 stride=8 num_extra_inhabitants=0))
+// CHECK-NEXT:   (field name=second offset=8
+// CHECK-NEXT:     (builtin size=1 alignment=1 stride=1 num_extra_inhabitants=0)))
+
+// CHECK: TypeLowering.Node
+// CHECK-NEXT: (class_instance size=34 alignment=8 stride=40 num_extra_inhabitants=4096
+// CHECK-NEXT:   (field name=next offset=16
+// CHECK-NEXT:     (reference size=8 alignment=8 stride=8 num_extra_inhabitants=4096))
+// CHECK-NEXT:   (field name=pair offset=24
+// CHECK-NEXT:     (struct size=9 alignment=8 stride=16 num_extra_inhabitants=0
+// CHECK:        (field name=state offset=33
+// CHECK-NEXT:     (no_payload_enum size=1 alignment=1 stride=1 num_extra_inhabitants=253)))
+
+// CHECK: TypeLowering.State
+// CHECK-NEXT: (no_payload_enum size=1 alignment=1 stride=1 num_extra_inhabitants=253)
+
+// CHECK: TypeLowering.Link
+// CHECK-NEXT: (single_payload_enum size=8 alignment=8 stride=8 num_extra_inhabitants=4095
+// CHECK-NEXT:   (field name=Next offset=0
+// CHECK-NEXT:     (reference size=8 alignment=8 stride=8 num_extra_inhabitants=4096)))
+
+// CHECK: TypeLowering.Existentials
+// CHECK-NEXT: (struct size=112 alignment=8 stride=112 num_extra_inhabitants=4096
+// CHECK-NEXT:   (field name=any offset=0
+// CHECK-NEXT:     (existential size=40 alignment=8 stride=40 num_extra_inhabitants=4096))
+// CHECK-NEXT:   (field name=classBound offset=40
+// CHECK-NEXT:     (class_existential size=16 alignment=8 stride=16 num_extra_inhabitants=4096))
+// CHECK-NEXT:   (field name=anyObject offset=56
+// CHECK-NEXT:     (class_existential size=8 alignment=8 stride=8 num_extra_inhabitants=4096))
+// CHECK-NEXT:   (field name=error offset=64
+// CHECK-NEXT:     (error_existential size=8 alignment=8 stride=8 num_extra_inhabitants=4096))
+// CHECK-NEXT:   (field name=composition offset=72
+// CHECK-NEXT:     (class_existential size=24 alignment=8 stride=24 num_extra_inhabitants=4096))
+// CHECK-NEXT:   (field name=maybeClassBound offset=96
+// CHECK-NEXT:     (single_payload_enum size=16 alignment=8 stride=16 num_extra_inhabitants=4095
+// CHECK-NEXT:       (field name=Some offset=0
+// CHECK-NEXT:         (class_existential size=16 alignment=8 stride=16 num_extra_inhabitants=4096)))))
+
+// Metatypes of structs and of protocols are thin and take no space.
+// CHECK: TypeLowering.Metatypes
+// CHECK-NEXT: (struct size=56 alignment=8 stride=56 num_extra_inhabitants=4096
+// CHECK-NEXT:   (field name=int offset=0
+// CHECK-NEXT:     (builtin size=0 alignment=1 stride=1 num_extra_inhabitants=0))
+// CHECK-NEXT:   (field name=node offset=0
+// CHECK-NEXT:     (builtin size=8 alignment=8 stride=8 num_extra_inhabitants=4096))
+// CHECK-NEXT:   (field name=opaque offset=8
+// CHECK-NEXT:     (existential_metatype size=16 alignment=8 stride=16 num_extra_inhabitants=4096))
+// CHECK-NEXT:   (field name=classBound offset=24
+// CHECK-NEXT:     (existential_metatype size=16 alignment=8 stride=16 num_extra_inhabitants=4096))
+// CHECK-NEXT:   (field name=anyObject offset=40
+// CHECK-NEXT:     (existential_metatype size=8 alignment=8 stride=8 num_extra_inhabitants=4096))
+// CHECK-NEXT:   (field name=opaqueProtocol offset=48
+// CHECK-NEXT:     (builtin size=0 alignment=1 stride=1 num_extra_inhabitants=0))
+// CHECK-NEXT:   (field name=boxedInt offset=48
+// CHECK-NEXT:     (struct size=8 alignment=8 stride=8 num_extra_inhabitants=4096
+// CHECK-NEXT:       (field name=type offset=0
+// CHECK-NEXT:         (builtin size=8 alignment=8 stride=8 num_extra_inhabitants=4096)))))
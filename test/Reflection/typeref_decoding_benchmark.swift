@@ -0,0 +1,11 @@
+// Decodes every type reference in the standard library's reflection
+// sections, which needs a stdlib built with SWIFT_STDLIB_ENABLE_REFLECTION_METADATA.
+// RUN: %target-swift-reflection-test -binary-filename %platform-module-dir/../libswiftCore%target-shared-library-suffix -benchmark-typeref-decoding -iterations 3 | FileCheck %s
+
+// REQUIRES: stdlib_reflection_metadata
+
+// CHECK: Iterations: 3
+// CHECK-NEXT: Mangled names decoded: {{[1-9][0-9]*}}
+// CHECK-NEXT: Unique TypeRefs: {{[1-9][0-9]*}}
+// CHECK-NEXT: TypeRef arena bytes: {{[1-9][0-9]*}}
+// CHECK-NEXT: Time per iteration (us): {{[0-9]+}}
@@ -157,6 +157,10 @@ namespace SourceKit {
   struct ASTUnit::Implementation {
     const uint64_t Generation;
     SmallVector<ImmutableTextSnapshotRef, 4> Snapshots;
+    /// The input buffers, which the CompilerInstance uses without copying,
+    /// and the text buffers of the snapshots some of them point into.
+    SmallVector<ImmutableTextBufferRef, 4> TextBuffers;
+    SmallVector<std::unique_ptr<llvm::MemoryBuffer>, 4> InputBuffers;
     EditorDiagConsumer CollectDiagConsumer;
     CompilerInstance CompInst;
     OwnedResolver TypeResolver{ nullptr, nullptr };
@@ -217,13 +221,17 @@ typedef uint64_t BufferStamp;
 
 struct FileContent {
   ImmutableTextSnapshotRef Snapshot;
+  /// The snapshot's text, which \c Buffer refers to, if there is a snapshot.
+  ImmutableTextBufferRef TextBuffer;
   std::unique_ptr<llvm::MemoryBuffer> Buffer;
   BufferStamp Stamp;
 
   FileContent(ImmutableTextSnapshotRef Snapshot,
+              ImmutableTextBufferRef TextBuffer,
               std::unique_ptr<llvm::MemoryBuffer> Buffer,
               BufferStamp Stamp)
     : Snapshot(std::move(Snapshot)),
+      TextBuffer(std::move(TextBuffer)),
       Buffer(std::move(Buffer)),
       Stamp(Stamp) {}
 };
@@ -510,9 +518,14 @@ SwiftASTManager::Implementation::getASTProducer(SwiftInvocationRef InvokRef) {
 
 static FileContent getFileContentFromSnap(ImmutableTextSnapshotRef Snap,
                                           StringRef FilePath) {
-  auto Buf = llvm::MemoryBuffer::getMemBufferCopy(
-      Snap->getBuffer()->getText(), FilePath);
-  return FileContent(Snap, std::move(Buf), Snap->getStamp());
+  // Refer to the snapshot's text rather than copying it; the FileContent
+  // keeps the text buffer alive.
+  ImmutableTextBufferRef TextBuf = Snap->getBuffer();
+  auto Buf = llvm::MemoryBuffer::getMemBuffer(
+      TextBuf->getText(), FilePath,
+      /*RequiresNullTerminator=*/true);
+  return FileContent(Snap, std::move(TextBuf), std::move(Buf),
+                     Snap->getStamp());
 }
 
 FileContent
@@ -525,7 +538,7 @@ SwiftASTManager::Implementation::getFileContent(StringRef UnresolvedPath,
   // FIXME: Is there a way to get timestamp and buffer for a file atomically ?
   auto Stamp = getBufferStamp(FilePath);
   auto Buffer = getMemoryBuffer(FilePath, Error);
-  return FileContent(nullptr, std::move(Buffer), Stamp);
+  return FileContent(nullptr, nullptr, std::move(Buffer), Stamp);
 }
 
 BufferStamp SwiftASTManager::Implementation::getBufferStamp(StringRef FilePath){
@@ -545,8 +558,13 @@ BufferStamp SwiftASTManager::Implementation::getBufferStamp(StringRef FilePath){
 std::unique_ptr<llvm::MemoryBuffer>
 SwiftASTManager::Implementation::getMemoryBuffer(StringRef Filename,
                                                  std::string &Error) {
+  // Files here may be open in an editor and change under us, so read them
+  // rather than mapping them; a mapped file that shrinks would crash the
+  // service when the missing pages are touched.
   llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> FileBufOrErr =
-    llvm::MemoryBuffer::getFile(Filename);
+    llvm::MemoryBuffer::getFile(Filename, /*FileSize=*/-1,
+                                /*RequiresNullTerminator=*/true,
+                                /*IsVolatileSize=*/true);
   if (FileBufOrErr)
     return std::move(FileBufOrErr.get());
 
@@ -775,8 +793,15 @@ ASTUnitRef ASTProducer::createASTUnit(SwiftASTManager::Implementation &MgrImpl,
   CompilerInvocation Invocation;
   Opts.applyTo(Invocation);
 
-  for (auto &Content : Contents)
+  // The ASTUnit keeps the buffers alive for as long as its CompilerInstance,
+  // so they needn't be copied.
+  for (auto &Content : Contents) {
     Invocation.addInputBuffer(Content.Buffer.get());
+    if (Content.TextBuffer)
+      ASTRef->Impl.TextBuffers.push_back(std::move(Content.TextBuffer));
+    ASTRef->Impl.InputBuffers.push_back(std::move(Content.Buffer));
+  }
+  Invocation.setBuffersOutliveInstance();
 
   if (CompIns.setup(Invocation)) {
     // FIXME: Report the diagnostic.
@@ -18,6 +18,8 @@
 //===----------------------------------------------------------------------===//
 
 #include "swift/Subsystems.h"
+#include "swift/AST/ASTWalker.h"
+#include "swift/AST/DiagnosticsDriver.h"
 #include "swift/AST/DiagnosticsFrontend.h"
 #include "swift/AST/DiagnosticsSema.h"
 #include "swift/AST/IRGenOptions.h"
@@ -29,21 +31,27 @@
 #include "swift/Basic/Fallthrough.h"
 #include "swift/Basic/FileSystem.h"
 #include "swift/Basic/SourceManager.h"
+#include "swift/Basic/Statistic.h"
 #include "swift/Basic/Timer.h"
+#include "swift/Driver/BinaryDependencies.h"
+#include "swift/Driver/OutputFileMap.h"
 #include "swift/Frontend/DiagnosticVerifier.h"
 #include "swift/Frontend/Frontend.h"
 #include "swift/Frontend/PrintingDiagnosticConsumer.h"
 #include "swift/Frontend/SerializedDiagnosticConsumer.h"
 #include "swift/Immediate/Immediate.h"
 #include "swift/Option/Options.h"
+#include "swift/Parse/Lexer.h"
 #include "swift/PrintAsObjC/PrintAsObjC.h"
 #include "swift/Serialization/SerializationOptions.h"
+#include "swift/Serialization/SerializedModuleLoader.h"
 #include "swift/SILOptimizer/PassManager/Passes.h"
 
 // FIXME: We're just using CompilerInstance::createOutputFile.
 // This API should be sunk down to LLVM.
 #include "clang/Frontend/CompilerInstance.h"
 
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
@@ -51,12 +59,14 @@
 #include "llvm/Option/Option.h"
 #include "llvm/Option/OptTable.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/YAMLParser.h"
 
+#include <algorithm>
 #include <memory>
 #include <unordered_set>
 
@@ -175,6 +185,135 @@ static std::string mangleTypeAsContext(const NominalTypeDecl *type) {
   return mangler.finalize();
 }
 
+/// Returns the members of \p D if it is a type or an extension, or an empty
+/// range otherwise.
+static DeclRange getMembersIfAny(const Decl *D) {
+  if (auto *NTD = dyn_cast<NominalTypeDecl>(D))
+    return NTD->getMembers(/*forceDelayed=*/false);
+  if (auto *ED = dyn_cast<ExtensionDecl>(D))
+    return ED->getMembers(/*forceDelayed=*/false);
+  return DeclRange(DeclIterator(), DeclIterator());
+}
+
+namespace {
+/// Computes fingerprints for the declarations a source file provides.
+///
+/// Like the file's interface hash, a fingerprint covers the tokens of a
+/// declaration outside of function bodies, so editing a body leaves it alone.
+/// It also covers the attributes and interface types of the declaration and
+/// its members, so that a change to what a name in a signature refers to is
+/// noticed even if the declaration's own tokens are the same.
+class DeclFingerprinter {
+  const SourceManager &SM;
+  unsigned BufferID;
+
+  /// The offsets and text of the tokens outside of function bodies, in
+  /// source order.
+  std::vector<std::pair<unsigned, StringRef>> InterfaceTokens;
+
+  Optional<std::pair<unsigned, unsigned>> getOffsets(SourceRange R) const {
+    if (R.isInvalid() || SM.findBufferContainingLoc(R.Start) != BufferID)
+      return None;
+    SourceLoc end = Lexer::getLocForEndOfToken(SM, R.End);
+    return std::make_pair(SM.getLocOffsetInBuffer(R.Start, BufferID),
+                          SM.getLocOffsetInBuffer(end, BufferID));
+  }
+
+  void collectBodies(const Decl *D,
+                     SmallVectorImpl<std::pair<unsigned, unsigned>> &bodies) {
+    if (auto *AFD = dyn_cast<AbstractFunctionDecl>(D)) {
+      if (auto offsets = getOffsets(AFD->getBodySourceRange()))
+        bodies.push_back(*offsets);
+    }
+
+    for (const Decl *member : getMembersIfAny(D))
+      collectBodies(member, bodies);
+  }
+
+  void addTokens(llvm::MD5 &hash, SourceRange R) const {
+    auto offsets = getOffsets(R);
+    if (!offsets)
+      return;
+
+    auto I = std::lower_bound(InterfaceTokens.begin(), InterfaceTokens.end(),
+                              std::make_pair(offsets->first, StringRef()));
+    for (auto E = InterfaceTokens.end(); I != E; ++I) {
+      if (I->first >= offsets->second)
+        break;
+      hash.update(I->second);
+      uint8_t separator[1] = {0};
+      hash.update(separator);
+    }
+  }
+
+  void addAttributesAndTypes(llvm::MD5 &hash, const Decl *D) const {
+    if (auto *VD = dyn_cast<ValueDecl>(D)) {
+      SmallString<64> buffer;
+      llvm::raw_svector_ostream out(buffer);
+      for (auto *attr : VD->getAttrs())
+        attr->print(out);
+      if (VD->hasInterfaceType())
+        out << VD->getInterfaceType()->getCanonicalType();
+      hash.update(out.str());
+    }
+
+    for (const Decl *member : getMembersIfAny(D))
+      addAttributesAndTypes(hash, member);
+  }
+
+public:
+  explicit DeclFingerprinter(const SourceFile &SF)
+      : SM(SF.getASTContext().SourceMgr), BufferID(*SF.getBufferID()) {
+    SmallVector<std::pair<unsigned, unsigned>, 64> bodies;
+    for (const Decl *D : SF.Decls)
+      collectBodies(D, bodies);
+    std::sort(bodies.begin(), bodies.end());
+
+    std::vector<Token> tokens =
+        tokenize(SF.getASTContext().LangOpts, SM, BufferID, /*Offset=*/0,
+                 /*EndOffset=*/0, /*KeepComments=*/false,
+                 /*TokenizeInterpolatedString=*/false);
+
+    // Both lists are in source order. Bodies may nest (a type inside a
+    // function body), in which case the outer one covers the inner one.
+    auto nextBody = bodies.begin();
+    unsigned bodyEnd = 0;
+    for (const Token &token : tokens) {
+      if (token.is(tok::eof))
+        break;
+      unsigned offset = SM.getLocOffsetInBuffer(token.getLoc(), BufferID);
+      for (; nextBody != bodies.end() && nextBody->first <= offset; ++nextBody)
+        bodyEnd = std::max(bodyEnd, nextBody->second);
+      if (offset < bodyEnd)
+        continue;
+      InterfaceTokens.push_back({offset, token.getText()});
+    }
+  }
+
+  /// Adds the interface of \p D to \p hash.
+  void addDecl(llvm::MD5 &hash, const Decl *D) const {
+    // The declaration of a variable only covers its name; the type and
+    // initial value are part of the pattern binding, and any accessors
+    // follow in braces.
+    if (auto *VD = dyn_cast<VarDecl>(D)) {
+      if (auto *PBD = VD->getParentPatternBinding())
+        addTokens(hash, PBD->getSourceRange());
+      addTokens(hash, VD->getBracesRange());
+    }
+    addTokens(hash, D->getSourceRange());
+    addAttributesAndTypes(hash, D);
+  }
+
+  static std::string finalize(llvm::MD5 &hash) {
+    llvm::MD5::MD5Result result;
+    hash.final(result);
+    SmallString<32> str;
+    llvm::MD5::stringifyResult(result, str);
+    return str.str();
+  }
+};
+} // end anonymous namespace
+
 /// Emits a Swift-style dependencies file.
 static bool emitReferenceDependencies(DiagnosticEngine &diags,
                                       SourceFile *SF,
@@ -197,16 +336,20 @@ static bool emitReferenceDependencies(DiagnosticEngine &diags,
     return true;
   }
 
-  auto escape = [](Identifier name) -> std::string {
-    return llvm::yaml::escape(name.str());
-  };
-
-  out << "### Swift dependencies file v0 ###\n";
+  using binary_deps::Section;
+  binary_deps::DependencyFileWriter writer;
 
   llvm::MapVector<const NominalTypeDecl *, bool> extendedNominals;
   llvm::SmallVector<const ExtensionDecl *, 8> extensionsWithJustMembers;
 
-  out << "provides-top-level:\n";
+  // The provided names are collected first and written out afterwards, since
+  // a name's fingerprint covers every declaration in the file that provides
+  // it: all overloads of a top-level name, and a type together with all of
+  // its extensions.
+  SmallVector<std::pair<StringRef, const Decl *>, 16> topLevelDecls;
+  llvm::MapVector<const NominalTypeDecl *, SmallVector<const Decl *, 2>>
+    nominalDecls;
+
   for (const Decl *D : SF->Decls) {
     switch (D->getKind()) {
     case DeclKind::Module:
@@ -238,6 +381,7 @@ static bool emitReferenceDependencies(DiagnosticEngine &diags,
         }
       }
       extendedNominals[NTD] |= !justMembers;
+      nominalDecls[NTD].push_back(ED);
       findNominals(extendedNominals, ED->getMembers());
       break;
     }
@@ -245,7 +389,7 @@ static bool emitReferenceDependencies(DiagnosticEngine &diags,
     case DeclKind::InfixOperator:
     case DeclKind::PrefixOperator:
     case DeclKind::PostfixOperator:
-      out << "- \"" << escape(cast<OperatorDecl>(D)->getName()) << "\"\n";
+      topLevelDecls.push_back({cast<OperatorDecl>(D)->getName().str(), D});
       break;
 
     case DeclKind::Enum:
@@ -259,7 +403,8 @@ static bool emitReferenceDependencies(DiagnosticEngine &diags,
           NTD->getFormalAccess() == Accessibility::Private) {
         break;
       }
-      out << "- \"" << escape(NTD->getName()) << "\"\n";
+      topLevelDecls.push_back({NTD->getName().str(), NTD});
+      nominalDecls[NTD].push_back(NTD);
       extendedNominals[NTD] |= true;
       findNominals(extendedNominals, NTD->getMembers());
       break;
@@ -275,7 +420,7 @@ static bool emitReferenceDependencies(DiagnosticEngine &diags,
           VD->getFormalAccess() == Accessibility::Private) {
         break;
       }
-      out << "- \"" << escape(VD->getName()) << "\"\n";
+      topLevelDecls.push_back({VD->getName().str(), VD});
       break;
     }
 
@@ -297,35 +442,98 @@ static bool emitReferenceDependencies(DiagnosticEngine &diags,
     }
   }
 
-  out << "provides-nominal:\n";
+  DeclFingerprinter fingerprinter(*SF);
+
+  // Nested types are provided on their own, without any extensions.
+  for (auto entry : extendedNominals)
+    if (entry.first->getDeclContext()->getParentSourceFile() == SF &&
+        !entry.first->getDeclContext()->isModuleScopeContext())
+      nominalDecls[entry.first].push_back(entry.first);
+
+  llvm::DenseMap<const NominalTypeDecl *, std::string> nominalFingerprints;
+  for (auto &entry : nominalDecls) {
+    llvm::MD5 hash;
+    for (const Decl *D : entry.second)
+      fingerprinter.addDecl(hash, D);
+    nominalFingerprints[entry.first] = DeclFingerprinter::finalize(hash);
+  }
+
+  llvm::StringMap<llvm::MD5> topLevelHashes;
+  for (auto &entry : topLevelDecls) {
+    llvm::MD5 &hash = topLevelHashes[entry.first];
+    if (auto *NTD = dyn_cast<NominalTypeDecl>(entry.second)) {
+      for (const Decl *D : nominalDecls[NTD])
+        fingerprinter.addDecl(hash, D);
+    } else {
+      fingerprinter.addDecl(hash, entry.second);
+    }
+  }
+  llvm::StringMap<std::string> topLevelFingerprints;
+  for (auto &entry : topLevelHashes)
+    topLevelFingerprints[entry.getKey()] =
+      DeclFingerprinter::finalize(entry.getValue());
+
+  writer.beginSection(Section::ProvidesTopLevel);
+  for (auto &entry : topLevelDecls) {
+    writer.addEntry(Section::ProvidesTopLevel, entry.first,
+                    /*isCascading=*/true, topLevelFingerprints[entry.first]);
+  }
+
+  writer.beginSection(Section::ProvidesNominal);
   for (auto entry : extendedNominals) {
     if (!entry.second)
       continue;
-    out << "- \"";
-    out << mangleTypeAsContext(entry.first);
-    out << "\"\n";
+    writer.addEntry(Section::ProvidesNominal,
+                    mangleTypeAsContext(entry.first), /*isCascading=*/true,
+                    nominalFingerprints.lookup(entry.first));
   }
 
-  out << "provides-member:\n";
+  writer.beginSection(Section::ProvidesMember);
   for (auto entry : extendedNominals) {
-    out << "- [\"";
-    out << mangleTypeAsContext(entry.first);
-    out << "\", \"\"]\n";
+    writer.addMemberEntry(Section::ProvidesMember,
+                          mangleTypeAsContext(entry.first), "",
+                          /*isCascading=*/true,
+                          nominalFingerprints.lookup(entry.first));
   }
 
-  // This is also part of "provides-member".
-  for (auto *ED : extensionsWithJustMembers) {
-    auto mangledName = mangleTypeAsContext(
-                                        ED->getExtendedType()->getAnyNominal());
+  // This is also part of "provides-member". A member's fingerprint covers
+  // every member with that name in this file's extensions of the type.
+  auto getMemberKey = [](StringRef mangledName, const ValueDecl *VD) {
+    std::string key = mangledName;
+    key.push_back('\0');
+    key += VD->getName().str();
+    return key;
+  };
 
+  std::vector<std::string> justMembersMangledNames;
+  llvm::StringMap<llvm::MD5> memberHashes;
+  for (auto *ED : extensionsWithJustMembers) {
+    justMembersMangledNames.push_back(mangleTypeAsContext(
+                                      ED->getExtendedType()->getAnyNominal()));
     for (auto *member : ED->getMembers()) {
+      auto *VD = dyn_cast<ValueDecl>(member);
+      if (!VD || !VD->hasName())
+        continue;
+      llvm::MD5 &hash =
+        memberHashes[getMemberKey(justMembersMangledNames.back(), VD)];
+      fingerprinter.addDecl(hash, VD);
+    }
+  }
+
+  for (unsigned i = 0, e = extensionsWithJustMembers.size(); i != e; ++i) {
+    StringRef mangledName = justMembersMangledNames[i];
+    for (auto *member : extensionsWithJustMembers[i]->getMembers()) {
       auto *VD = dyn_cast<ValueDecl>(member);
       if (!VD || !VD->hasName() ||
           VD->getFormalAccess() == Accessibility::Private) {
         continue;
       }
-      out << "- [\"" << mangledName << "\", \""
-          << escape(VD->getName()) << "\"]\n";
+      // Copy the hash, since finalizing it is destructive and overloads
+      // share an entry.
+      llvm::MD5 hash = memberHashes[getMemberKey(mangledName, VD)];
+      writer.addMemberEntry(Section::ProvidesMember, mangledName,
+                            VD->getName().str(), /*isCascading=*/true,
+                            DeclFingerprinter::finalize(hash));
     }
   }
 
@@ -333,36 +541,33 @@ static bool emitReferenceDependencies(DiagnosticEngine &diags,
     // FIXME: This requires a traversal of the whole file to compute.
     // We should (a) see if there's a cheaper way to keep it up to date,
     // and/or (b) see if we can fast-path cases where there's no ObjC involved.
-    out << "provides-dynamic-lookup:\n";
+    writer.beginSection(Section::ProvidesDynamicLookup);
     class ValueDeclPrinter : public VisibleDeclConsumer {
     private:
-      raw_ostream &out;
-      std::string (*escape)(Identifier);
+      binary_deps::DependencyFileWriter &writer;
     public:
-      ValueDeclPrinter(raw_ostream &out, decltype(escape) escape)
-        : out(out), escape(escape) {}
+      ValueDeclPrinter(binary_deps::DependencyFileWriter &writer)
+        : writer(writer) {}
 
       void foundDecl(ValueDecl *VD, DeclVisibilityKind Reason) override {
-        out << "- \"" << escape(VD->getName()) << "\"\n";
+        writer.addEntry(Section::ProvidesDynamicLookup, VD->getName().str());
       }
     };
-    ValueDeclPrinter printer(out, escape);
+    ValueDeclPrinter printer(writer);
     SF->lookupClassMembers({}, printer);
   }
 
   ReferencedNameTracker *tracker = SF->getReferencedNameTracker();
 
   // FIXME: Sort these?
-  out << "depends-top-level:\n";
+  writer.beginSection(Section::DependsTopLevel);
   for (auto &entry : tracker->getTopLevelNames()) {
     assert(!entry.first.empty());
-    out << "- ";
-    if (!entry.second)
-      out << "!private ";
-    out << "\"" << escape(entry.first) << "\"\n";
+    writer.addEntry(Section::DependsTopLevel, entry.first.str(),
+                    entry.second);
   }
 
-  out << "depends-member:\n";
+  writer.beginSection(Section::DependsMember);
   auto &memberLookupTable = tracker->getUsedMembers();
   using TableEntryTy = std::pair<ReferencedNameTracker::MemberPair, bool>;
   std::vector<TableEntryTy> sortedMembers{
@@ -389,18 +594,15 @@ static bool emitReferenceDependencies(DiagnosticEngine &diags,
         entry.first.first->getFormalAccess() == Accessibility::Private)
       continue;
 
-    out << "- ";
-    if (!entry.second)
-      out << "!private ";
-    out << "[\"";
-    out << mangleTypeAsContext(entry.first.first);
-    out << "\", \"";
+    StringRef memberName;
     if (!entry.first.second.empty())
-      out << escape(entry.first.second);
-    out << "\"]\n";
+      memberName = entry.first.second.str();
+    writer.addMemberEntry(Section::DependsMember,
+                          mangleTypeAsContext(entry.first.first), memberName,
+                          entry.second);
   }
 
-  out << "depends-nominal:\n";
+  writer.beginSection(Section::DependsNominal);
   for (auto i = sortedMembers.begin(), e = sortedMembers.end(); i != e; ++i) {
     bool isCascading = i->second;
     while (i+1 != e && i[0].first.first == i[1].first.first) {
@@ -412,33 +614,31 @@ static bool emitReferenceDependencies(DiagnosticEngine &diags,
         i->first.first->getFormalAccess() == Accessibility::Private)
       continue;
 
-    out << "- ";
-    if (!isCascading)
-      out << "!private ";
-    out << "\"";
-    out <<  mangleTypeAsContext(i->first.first);
-    out << "\"\n";
+    writer.addEntry(Section::DependsNominal,
+                    mangleTypeAsContext(i->first.first), isCascading);
   }
 
   // FIXME: Sort these?
-  out << "depends-dynamic-lookup:\n";
+  writer.beginSection(Section::DependsDynamicLookup);
   for (auto &entry : tracker->getDynamicLookupNames()) {
     assert(!entry.first.empty());
-    out << "- ";
-    if (!entry.second)
-      out << "!private ";
-    out << "\"" << escape(entry.first) << "\"\n";
+    writer.addEntry(Section::DependsDynamicLookup, entry.first.str(),
+                    entry.second);
   }
 
-  out << "depends-external:\n";
+  writer.beginSection(Section::DependsExternal);
   for (auto &entry : depTracker.getDependencies()) {
-    out << "- \"" << llvm::yaml::escape(entry) << "\"\n";
+    writer.addEntry(Section::DependsExternal, entry);
   }
 
   llvm::SmallString<32> interfaceHash;
   SF->getInterfaceHash(interfaceHash);
-  out << "interface-hash: \"" << interfaceHash << "\"\n";
+  writer.setInterfaceHash(interfaceHash);
 
+  if (opts.BinaryReferenceDependencies)
+    writer.writeBinary(out);
+  else
+    writer.writeYAML(out);
   return false;
 }
 
@@ -590,6 +790,68 @@ private:
   }
 };
 
+/// Attributes the errors of a batch mode invocation to its primary files, so
+/// that an error in one primary file doesn't stop the others from producing
+/// their outputs.
+///
+/// An error is attributed to the primary file it is located in. Errors that
+/// are reported while a primary file's outputs are being produced belong to
+/// that file, wherever they are located. Any other error belongs to every
+/// primary file.
+class BatchErrorTracker : public DiagnosticConsumer {
+  /// The buffers of the primary files.
+  llvm::SmallVector<unsigned, 8> PrimaryBufferIDs;
+
+  /// The buffers that errors were attributed to.
+  llvm::SmallDenseSet<unsigned, 4> BuffersWithErrors;
+
+  /// Whether an error was reported without a location.
+  bool HadErrorWithoutLoc = false;
+
+  /// The buffer of the primary file whose outputs are being produced.
+  Optional<unsigned> CurrentBufferID;
+
+public:
+  void setPrimarySourceFiles(ArrayRef<SourceFile *> Files) {
+    PrimaryBufferIDs.clear();
+    for (auto *SF : Files)
+      PrimaryBufferIDs.push_back(SF->getBufferID().getValue());
+  }
+
+  /// Attributes the errors reported from now on to \p SF.
+  void setCurrentPrimarySourceFile(const SourceFile *SF) {
+    CurrentBufferID = SF->getBufferID();
+  }
+
+  /// Returns true if there was an error that belongs to \p SF.
+  bool hadError(const SourceFile *SF) const {
+    if (HadErrorWithoutLoc)
+      return true;
+    for (unsigned BufferID : BuffersWithErrors) {
+      if (BufferID == SF->getBufferID())
+        return true;
+      if (std::find(PrimaryBufferIDs.begin(), PrimaryBufferIDs.end(),
+                    BufferID) == PrimaryBufferIDs.end())
+        return true;
+    }
+    return false;
+  }
+
+private:
+  void handleDiagnostic(SourceManager &SM, SourceLoc Loc,
+                        DiagnosticKind Kind, StringRef Text,
+                        const DiagnosticInfo &Info) override {
+    if (Kind != DiagnosticKind::Error)
+      return;
+    if (CurrentBufferID)
+      BuffersWithErrors.insert(CurrentBufferID.getValue());
+    else if (Loc.isValid())
+      BuffersWithErrors.insert(SM.findBufferContainingLoc(Loc));
+    else
+      HadErrorWithoutLoc = true;
+  }
+};
+
 } // anonymous namespace
 
 // This is a separate function so that it shows up in stack traces.
@@ -606,12 +868,28 @@ static void debugFailWithCrash() {
   LLVM_BUILTIN_TRAP;
 }
 
+static bool performCompileStepsPostSema(CompilerInstance &Instance,
+                                        CompilerInvocation &Invocation,
+                                        const FrontendOptions &opts,
+                                        IRGenOptions &IRGenOpts,
+                                        SourceFile *PrimarySourceFile,
+                                        int &ReturnValue,
+                                        const BatchErrorTracker *BatchErrors);
+static bool performBatchCompileStepsPostSema(CompilerInstance &Instance,
+                                             CompilerInvocation &Invocation,
+                                             const FrontendOptions &opts,
+                                             BatchErrorTracker &BatchErrors);
+
 /// Performs the compile requested by the user.
+///
+/// \p BatchErrors must be a consumer of \p Instance's diagnostics in batch
+/// mode.
 /// \returns true on error
 static bool performCompile(CompilerInstance &Instance,
                            CompilerInvocation &Invocation,
                            ArrayRef<const char *> Args,
-                           int &ReturnValue) {
+                           int &ReturnValue,
+                           BatchErrorTracker &BatchErrors) {
   FrontendOptions opts = Invocation.getFrontendOptions();
   FrontendOptions::ActionType Action = opts.RequestedAction;
 
@@ -656,7 +934,8 @@ static bool performCompile(CompilerInstance &Instance,
   }
 
   ReferencedNameTracker nameTracker;
-  bool shouldTrackReferences = !opts.ReferenceDependenciesFilePath.empty();
+  bool shouldTrackReferences = !opts.ReferenceDependenciesFilePath.empty() ||
+                               opts.isBatchMode();
   if (shouldTrackReferences)
     Instance.setReferencedNameTracker(&nameTracker);
 
@@ -710,15 +989,71 @@ static bool performCompile(CompilerInstance &Instance,
   if (opts.PrintClangStats && Context.getClangModuleLoader())
     Context.getClangModuleLoader()->printStatistics();
 
+  if (opts.isBatchMode())
+    return performBatchCompileStepsPostSema(Instance, Invocation, opts,
+                                            BatchErrors);
+
+  return performCompileStepsPostSema(Instance, Invocation, opts,
+                                     IRGenOpts, PrimarySourceFile,
+                                     ReturnValue, /*BatchErrors=*/nullptr);
+}
+
+/// Adds the number of functions and instructions in \p SM to the statistics
+/// for either before or after optimization.
+static void countStatsOfSILModule(UnifiedStatsReporter &Stats,
+                                  const SILModule &SM,
+                                  bool AfterOptimization) {
+  uint64_t NumFunctions = 0;
+  uint64_t NumInstructions = 0;
+  for (const SILFunction &F : SM) {
+    ++NumFunctions;
+    for (const SILBasicBlock &BB : F)
+      NumInstructions += std::distance(BB.begin(), BB.end());
+  }
+
+  auto &Counters = Stats.getFrontendCounters();
+  if (AfterOptimization) {
+    Counters.NumSILOptFunctions += NumFunctions;
+    Counters.NumSILOptInstructions += NumInstructions;
+  } else {
+    Counters.NumSILGenFunctions += NumFunctions;
+    Counters.NumSILGenInstructions += NumInstructions;
+  }
+  Counters.PeakSILModuleBytes =
+    std::max<uint64_t>(Counters.PeakSILModuleBytes, SM.getAllocatedMemory());
+}
+
+/// Performs the steps of a compile after type-checking, for the primary file
+/// described by \p opts, or for the whole module if there is none.
+///
+/// In batch mode, \p BatchErrors tells which errors belong to the primary
+/// file; otherwise any error stops the compile.
+/// \returns true on error
+static bool performCompileStepsPostSema(CompilerInstance &Instance,
+                                        CompilerInvocation &Invocation,
+                                        const FrontendOptions &opts,
+                                        IRGenOptions &IRGenOpts,
+                                        SourceFile *PrimarySourceFile,
+                                        int &ReturnValue,
+                                        const BatchErrorTracker *BatchErrors) {
+  FrontendOptions::ActionType Action = opts.RequestedAction;
+  ASTContext &Context = Instance.getASTContext();
+
+  auto hadError = [&]() -> bool {
+    if (BatchErrors)
+      return BatchErrors->hadError(PrimarySourceFile);
+    return Context.hadError();
+  };
+
   if (!opts.DependenciesFilePath.empty())
     (void)emitMakeDependencies(Context.Diags, *Instance.getDependencyTracker(),
                                opts);
 
-  if (shouldTrackReferences)
-    emitReferenceDependencies(Context.Diags, Instance.getPrimarySourceFile(),
+  if (!opts.ReferenceDependenciesFilePath.empty())
+    emitReferenceDependencies(Context.Diags, PrimarySourceFile,
                               *Instance.getDependencyTracker(), opts);
 
-  if (Context.hadError())
+  if (hadError())
     return true;
 
   // FIXME: This is still a lousy approximation of whether the module file will
@@ -756,6 +1091,9 @@ static bool performCompile(CompilerInstance &Instance,
     }
   }
 
+  if (Context.Stats)
+    countStatsOfSILModule(*Context.Stats, *SM, /*AfterOptimization=*/false);
+
   // We've been told to emit SIL after SILGen, so write it now.
   if (Action == FrontendOptions::EmitSILGen) {
     // If we are asked to link all, link all.
@@ -784,9 +1122,11 @@ static bool performCompile(CompilerInstance &Instance,
   }
 
   // Perform "stable" optimizations that are invariant across compiler versions.
-  if (!Invocation.getDiagnosticOptions().SkipDiagnosticPasses &&
-      runSILDiagnosticPasses(*SM))
-    return true;
+  if (!Invocation.getDiagnosticOptions().SkipDiagnosticPasses) {
+    runSILDiagnosticPasses(*SM);
+    if (hadError())
+      return true;
+  }
 
   // Now if we are asked to link all, link all.
   if (Invocation.getSILOptions().LinkMode == SILOptions::LinkAll)
@@ -820,6 +1160,9 @@ static bool performCompile(CompilerInstance &Instance,
     SM->verify();
   }
 
+  if (Context.Stats)
+    countStatsOfSILModule(*Context.Stats, *SM, /*AfterOptimization=*/true);
+
   // Gather instruction counts if we are asked to do so.
   if (SM->getOptions().PrintInstCounts) {
     performSILInstCount(&*SM);
@@ -897,7 +1240,7 @@ static bool performCompile(CompilerInstance &Instance,
          "REPL mode must be handled immediately after Instance.performSema()");
 
   // Check if we had any errors; if we did, don't proceed to IRGen.
-  if (Context.hadError())
+  if (hadError())
     return true;
 
   // Cleanup instructions/builtin calls not suitable for IRGen.
@@ -931,6 +1274,74 @@ static bool performCompile(CompilerInstance &Instance,
   return false;
 }
 
+/// Performs the steps of a compile after type-checking for each primary file
+/// of a batch mode invocation in turn, sharing the type-checked module.
+/// \returns true on error
+static bool performBatchCompileStepsPostSema(CompilerInstance &Instance,
+                                             CompilerInvocation &Invocation,
+                                             const FrontendOptions &opts,
+                                             BatchErrorTracker &BatchErrors) {
+  using driver::OutputFileMap;
+  DiagnosticEngine &Diags = Instance.getASTContext().Diags;
+
+  std::unique_ptr<OutputFileMap> OFM =
+    OutputFileMap::loadFromPath(opts.BatchOutputFileMapPath);
+  if (!OFM) {
+    Diags.diagnose(SourceLoc(), diag::error_unable_to_load_output_file_map,
+                   opts.BatchOutputFileMapPath);
+    return true;
+  }
+
+  ArrayRef<SourceFile *> PrimarySourceFiles =
+    Instance.getBatchPrimarySourceFiles();
+  assert(PrimarySourceFiles.size() == opts.BatchPrimaryInputs.size());
+  BatchErrors.setPrimarySourceFiles(PrimarySourceFiles);
+
+  bool HadError = false;
+  for (unsigned i = 0, e = PrimarySourceFiles.size(); i != e; ++i) {
+    const SelectedInput &Input = opts.BatchPrimaryInputs[i];
+
+    // Describe this primary file as if it were the only one.
+    FrontendOptions PrimaryOpts = opts;
+    PrimaryOpts.PrimaryInput = Input;
+    PrimaryOpts.BatchPrimaryInputs.clear();
+    if (opts.actionHasOutput())
+      PrimaryOpts.setSingleOutputFilename(opts.OutputFilenames[i]);
+
+    PrimaryOpts.DependenciesFilePath.clear();
+    PrimaryOpts.ReferenceDependenciesFilePath.clear();
+    PrimaryOpts.ModuleOutputPath.clear();
+    PrimaryOpts.ModuleDocOutputPath.clear();
+    if (auto *Outputs =
+          OFM->getOutputMapForInput(opts.InputFilenames[Input.Index])) {
+      PrimaryOpts.DependenciesFilePath =
+        Outputs->lookup(driver::types::TY_Dependencies);
+      PrimaryOpts.ReferenceDependenciesFilePath =
+        Outputs->lookup(driver::types::TY_SwiftDeps);
+      PrimaryOpts.ModuleOutputPath =
+        Outputs->lookup(driver::types::TY_SwiftModuleFile);
+      PrimaryOpts.ModuleDocOutputPath =
+        Outputs->lookup(driver::types::TY_SwiftModuleDocFile);
+    }
+    if (opts.RequestedAction == FrontendOptions::EmitModuleOnly &&
+        PrimaryOpts.ModuleOutputPath.empty())
+      PrimaryOpts.ModuleOutputPath = PrimaryOpts.getSingleOutputFilename();
+
+    // Each primary file gets its own debug flags.
+    IRGenOptions PrimaryIRGenOpts = Invocation.getIRGenOptions();
+
+    // An error in one primary file doesn't stop the others from producing
+    // their outputs.
+    BatchErrors.setCurrentPrimarySourceFile(PrimarySourceFiles[i]);
+    int ReturnValue = 0;
+    HadError |= performCompileStepsPostSema(Instance, Invocation, PrimaryOpts,
+                                            PrimaryIRGenOpts,
+                                            PrimarySourceFiles[i],
+                                            ReturnValue, &BatchErrors);
+  }
+  return HadError;
+}
+
 /// Returns true if an error occurred.
 static bool dumpAPI(Module *Mod, StringRef OutDir) {
   using namespace llvm::sys;
@@ -993,14 +1404,110 @@ static bool dumpAPI(Module *Mod, StringRef OutDir) {
   return false;
 }
 
+namespace {
+/// Counts the declarations, expressions and skipped function bodies in the
+/// files it walks.
+class ASTStatsCounter : public ASTWalker {
+public:
+  uint64_t NumDecls = 0;
+  uint64_t NumExprs = 0;
+  uint64_t NumSkippedFunctionBodies = 0;
+
+  bool walkToDeclPre(Decl *D) override {
+    ++NumDecls;
+    if (auto *AFD = dyn_cast<AbstractFunctionDecl>(D))
+      if (AFD->getBodyKind() == AbstractFunctionDecl::BodyKind::Skipped)
+        ++NumSkippedFunctionBodies;
+    return true;
+  }
+
+  std::pair<bool, Expr *> walkToExprPre(Expr *E) override {
+    ++NumExprs;
+    return { true, E };
+  }
+};
+} // end anonymous namespace
+
+/// Returns the name of the input a stats file is written for: the primary
+/// file, "batch" for several primary files, or "all" if the whole module is
+/// being compiled.
+static StringRef getStatsInputName(const FrontendOptions &opts) {
+  if (opts.isBatchMode())
+    return "batch";
+  if (opts.PrimaryInput.hasValue() && opts.PrimaryInput.getValue().isFilename())
+    return opts.InputFilenames[opts.PrimaryInput.getValue().Index];
+  return "all";
+}
+
+/// Adds the statistics that describe the AST and the loaded modules at the
+/// end of the compile to \p Stats.
+static void countStatsOfAST(UnifiedStatsReporter &Stats,
+                            CompilerInstance &Instance) {
+  auto &Counters = Stats.getFrontendCounters();
+  ASTContext &Context = Instance.getASTContext();
+  SourceManager &SourceMgr = Instance.getSourceMgr();
+
+  for (unsigned BufferID : Instance.getInputBufferIDs()) {
+    StringRef Text =
+      SourceMgr.extractText(SourceMgr.getRangeForBuffer(BufferID), BufferID);
+    ++Counters.NumSourceBuffers;
+    Counters.NumSourceLines += Text.count('\n');
+  }
+
+  ASTStatsCounter Walker;
+  for (FileUnit *File : Instance.getMainModule()->getFiles())
+    if (auto *SF = dyn_cast<SourceFile>(File))
+      SF->walk(Walker);
+  Counters.NumDecls = Walker.NumDecls;
+  Counters.NumExprs = Walker.NumExprs;
+  Counters.NumSkippedFunctionBodies = Walker.NumSkippedFunctionBodies;
+
+  Counters.NumLoadedModules = Context.LoadedModules.size();
+  for (auto &Entry : Context.LoadedModules) {
+    uint64_t NumDeclsDeserialized = 0;
+    for (FileUnit *File : Entry.second->getFiles())
+      if (auto *AST = dyn_cast<SerializedASTFile>(File))
+        NumDeclsDeserialized += AST->getNumDeclsDeserialized();
+    if (NumDeclsDeserialized == 0)
+      continue;
+    Stats.setCounter("Serialization.NumDeclsDeserialized." +
+                       Entry.first.str().str(),
+                     NumDeclsDeserialized);
+    Counters.NumDeclsDeserialized += NumDeclsDeserialized;
+  }
+
+  Counters.ASTContextBytes = Context.getTotalMemory();
+
+  auto BufferUsage = SourceMgr.getBufferMemoryUsage();
+  Counters.SourceBufferMallocBytes = BufferUsage.MallocBytes;
+  Counters.SourceBufferMMapBytes = BufferUsage.MMapBytes;
+  Counters.SourceBufferBorrowedBytes = BufferUsage.BorrowedBytes;
+}
+
+/// Writes the spans recorded by the compile-time trace to \p path.
+///
+/// \returns true on error
+static bool writeCompileTimeTrace(StringRef path, DiagnosticEngine &diags) {
+  std::error_code EC;
+  llvm::raw_fd_ostream out(path, EC, llvm::sys::fs::F_None);
+  if (EC) {
+    diags.diagnose(SourceLoc(), diag::cannot_open_file, path, EC.message());
+    return true;
+  }
+  CompileTimeTrace::write(out);
+  return false;
+}
+
+/// Performs the frontend job described by \p Args using \p Instance, which
+/// may already have been prepared with CompilerInstance::setupASTContext().
 int frontend_main(ArrayRef<const char *>Args,
-                  const char *Argv0, void *MainAddr) {
+                  const char *Argv0, void *MainAddr,
+                  CompilerInstance &Instance) {
   llvm::InitializeAllTargets();
   llvm::InitializeAllTargetMCs();
   llvm::InitializeAllAsmPrinters();
   llvm::InitializeAllAsmParsers();
 
-  CompilerInstance Instance;
   PrintingDiagnosticConsumer PDC;
   Instance.addDiagnosticConsumer(&PDC);
 
@@ -1098,12 +1605,34 @@ int frontend_main(ArrayRef<const char *>Args,
     }
   }
 
+  BatchErrorTracker BatchErrors;
+  if (Invocation.getFrontendOptions().isBatchMode())
+    Instance.addDiagnosticConsumer(&BatchErrors);
+
   if (Invocation.getDiagnosticOptions().UseColor)
     PDC.forceColors();
 
   if (Invocation.getFrontendOptions().DebugTimeCompilation)
     SharedTimer::enableCompilationTimers();
 
+  // The reporter writes its file when it is destroyed, at the end of this
+  // function, so it must outlive every use of the ASTContext's Stats.
+  std::unique_ptr<UnifiedStatsReporter> StatsReporter;
+  const std::string &StatsOutputDir =
+    Invocation.getFrontendOptions().StatsOutputDir;
+  if (!StatsOutputDir.empty()) {
+    StatsReporter.reset(new UnifiedStatsReporter(
+      "swift-frontend", Invocation.getModuleName(),
+      getStatsInputName(Invocation.getFrontendOptions()), StatsOutputDir));
+  }
+
+  const std::string &CompileTimeTracePath =
+    Invocation.getFrontendOptions().CompileTimeTracePath;
+  if (!CompileTimeTracePath.empty()) {
+    CompileTimeTrace::enable(
+      Invocation.getFrontendOptions().CompileTimeTraceGranularity);
+  }
+
   if (Invocation.getFrontendOptions().PrintStats) {
     llvm::EnableStatistics();
   }
@@ -1112,9 +1641,13 @@ int frontend_main(ArrayRef<const char *>Args,
     enableDiagnosticVerifier(Instance.getSourceMgr());
   }
 
+  // An instance that was prepared in advance already has a tracker, which
+  // recorded the modules loaded while it was being prepared.
   DependencyTracker depTracker;
-  if (!Invocation.getFrontendOptions().DependenciesFilePath.empty() ||
-      !Invocation.getFrontendOptions().ReferenceDependenciesFilePath.empty()) {
+  if (!Instance.hasASTContext() &&
+      (!Invocation.getFrontendOptions().DependenciesFilePath.empty() ||
+       !Invocation.getFrontendOptions().ReferenceDependenciesFilePath.empty() ||
+       Invocation.getFrontendOptions().isBatchMode())) {
     Instance.setDependencyTracker(&depTracker);
   }
 
@@ -1122,9 +1655,27 @@ int frontend_main(ArrayRef<const char *>Args,
     return 1;
   }
 
+  Instance.getASTContext().Stats = StatsReporter.get();
+
   int ReturnValue = 0;
-  bool HadError = performCompile(Instance, Invocation, Args, ReturnValue) ||
-                  Instance.getASTContext().hadError();
+  bool HadError;
+  {
+    CompileTimeTraceScope Trace("Compile", [&]() -> std::string {
+      return Invocation.getModuleName();
+    });
+    HadError = performCompile(Instance, Invocation, Args, ReturnValue,
+                              BatchErrors) ||
+               Instance.getASTContext().hadError();
+  }
+
+  if (StatsReporter) {
+    countStatsOfAST(*StatsReporter, Instance);
+    Instance.getASTContext().Stats = nullptr;
+  }
+
+  if (!CompileTimeTracePath.empty())
+    HadError |= writeCompileTimeTrace(CompileTimeTracePath,
+                                      Instance.getDiags());
 
   if (!HadError && !Invocation.getFrontendOptions().DumpAPIPath.empty()) {
     HadError = dumpAPI(Instance.getMainModule(),
@@ -1145,3 +1696,9 @@ int frontend_main(ArrayRef<const char *>Args,
 
   return (HadError ? 1 : ReturnValue);
 }
+
+int frontend_main(ArrayRef<const char *>Args,
+                  const char *Argv0, void *MainAddr) {
+  CompilerInstance Instance;
+  return frontend_main(Args, Argv0, MainAddr, Instance);
+}
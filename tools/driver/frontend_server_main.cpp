@@ -0,0 +1,556 @@
+//===--- frontend_server_main.cpp - Swift Frontend Server -----------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// The frontend server runs frontend jobs sent by the driver over a Unix
+// domain socket (see swift/Basic/FrontendServer.h), for a driver passed
+// -driver-use-frontend-server.
+//
+// Every job runs in a process forked from the server, so a job can't affect
+// the server or any other job. What a job gains is that it can be forked from
+// a CompilerInstance which the server prepared earlier for a job with the
+// same configuration: its ASTContext already exists, the Clang importer is
+// set up, and the standard library is loaded, which is most of the time taken
+// by a job that compiles a small file.
+//
+// The server keeps a few of these warm instances, keyed by the arguments of
+// the jobs they were prepared for (leaving out inputs, and the paths of
+// outputs), along with the working directory and environment. An instance is
+// discarded if any of the files it loaded has changed since, and the server
+// exits, rejecting the job, if its own executable changes. Rejected jobs are
+// run by the driver itself.
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/Basic/FrontendServer.h"
+#include "swift/Frontend/Frontend.h"
+#include "swift/Option/Options.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Config/config.h"
+#include "llvm/Option/ArgList.h"
+#include "llvm/Option/Option.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace swift;
+
+#if LLVM_ON_UNIX && !defined(__CYGWIN__)
+
+#include <cerrno>
+#include <cstdio>
+#include <poll.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#if !defined(__APPLE__)
+extern char **environ;
+#else
+#include <crt_externs.h> // for _NSGetEnviron
+#endif
+
+extern int frontend_main(ArrayRef<const char *> Args, const char *Argv0,
+                         void *MainAddr, CompilerInstance &Instance);
+
+/// The number of warm instances kept at once.
+static const unsigned MaxWarmInstances = 4;
+
+/// How long the server waits for a job before exiting, by default.
+static const unsigned DefaultIdleTimeout = 10 * 60;
+
+static char **&getEnvironment() {
+#if __APPLE__
+  return *_NSGetEnviron();
+#else
+  return environ;
+#endif
+}
+
+namespace {
+/// Makes the environment of a job the environment of this process, for as
+/// long as this object exists.
+class ScopedEnvironment {
+  std::vector<char *> EnvP;
+  char **Saved;
+
+public:
+  explicit ScopedEnvironment(std::vector<std::string> &Env) {
+    for (std::string &Var : Env)
+      EnvP.push_back(&Var[0]);
+    EnvP.push_back(nullptr);
+    Saved = getEnvironment();
+    getEnvironment() = EnvP.data();
+  }
+
+  ~ScopedEnvironment() {
+    getEnvironment() = Saved;
+  }
+};
+
+/// The identity and version of a file which a warm instance depends on.
+struct FileStamp {
+  std::string Path;
+  llvm::sys::TimeValue ModTime;
+  uint64_t Size;
+};
+
+/// A CompilerInstance prepared in advance for jobs with a particular
+/// configuration.
+struct WarmInstance {
+  /// The configuration of the jobs this instance can be used for.
+  std::string Key;
+
+  DependencyTracker Tracker;
+  CompilerInstance Instance;
+
+  /// The files loaded while preparing the instance, as they were then.
+  std::vector<FileStamp> Dependencies;
+
+  /// The request for which this instance was last used.
+  unsigned LastUsed = 0;
+
+  /// Returns true if none of the files this instance depends on have changed.
+  bool isUpToDate() const {
+    for (const FileStamp &Stamp : Dependencies) {
+      llvm::sys::fs::file_status Status;
+      if (llvm::sys::fs::status(Stamp.Path, Status) ||
+          Status.getLastModificationTime() != Stamp.ModTime ||
+          Status.getSize() != Stamp.Size)
+        return false;
+    }
+    return true;
+  }
+};
+
+/// The state of the server between requests.
+class FrontendServer {
+  const char *Argv0;
+  void *MainAddr;
+  std::string MainExecutablePath;
+
+  /// The executable as it was when the server started.
+  llvm::sys::fs::file_status MainExecutableStatus;
+
+  std::vector<std::unique_ptr<WarmInstance>> Instances;
+  unsigned NumRequests = 0;
+
+  /// Returns true if the server's own executable has been replaced.
+  bool isExecutableOutOfDate() const;
+
+  /// Returns the key of the warm instance which \p R can use, or an empty
+  /// string if it shouldn't use one.
+  std::string getKey(const frontend_server::Request &R) const;
+
+  /// Prepares a new warm instance for jobs like \p R.
+  std::unique_ptr<WarmInstance> createWarmInstance(
+      frontend_server::Request &R, std::string Key) const;
+
+  /// Returns the warm instance for \p R, preparing it if necessary, or null
+  /// if \p R should be run from scratch.
+  CompilerInstance *getWarmInstance(frontend_server::Request &R);
+
+  /// Runs the job \p R in a new process, and reports how it finished to the
+  /// client at \p Socket. Called in a process forked for the purpose.
+  LLVM_ATTRIBUTE_NORETURN
+  void runJob(int Socket, int OutputFD, frontend_server::Request &R,
+              CompilerInstance *Warm);
+
+public:
+  FrontendServer(const char *Argv0, void *MainAddr);
+
+  /// Handles the request from the client at \p Socket, and closes \p Socket.
+  ///
+  /// \returns true if the server should exit.
+  bool serve(int ListenSocket, int Socket);
+};
+} // end anonymous namespace
+
+FrontendServer::FrontendServer(const char *Argv0, void *MainAddr)
+  : Argv0(Argv0), MainAddr(MainAddr),
+    MainExecutablePath(llvm::sys::fs::getMainExecutable(Argv0, MainAddr)) {
+  llvm::sys::fs::status(MainExecutablePath, MainExecutableStatus);
+}
+
+bool FrontendServer::isExecutableOutOfDate() const {
+  llvm::sys::fs::file_status Status;
+  if (llvm::sys::fs::status(MainExecutablePath, Status))
+    return true;
+  return Status.getUniqueID() != MainExecutableStatus.getUniqueID() ||
+         Status.getLastModificationTime() !=
+           MainExecutableStatus.getLastModificationTime() ||
+         Status.getSize() != MainExecutableStatus.getSize();
+}
+
+std::string FrontendServer::getKey(const frontend_server::Request &R) const {
+  SmallVector<const char *, 64> Args;
+  for (const std::string &Arg : llvm::makeArrayRef(R.Args).slice(1))
+    Args.push_back(Arg.c_str());
+
+  std::unique_ptr<llvm::opt::OptTable> Table = createSwiftOptTable();
+  unsigned MissingIndex;
+  unsigned MissingCount;
+  llvm::opt::InputArgList ParsedArgs =
+    Table->ParseArgs(Args, MissingIndex, MissingCount,
+                     options::FrontendOption);
+  if (MissingCount)
+    return std::string();
+
+  std::string Key;
+  llvm::raw_string_ostream Out(Key);
+  for (const llvm::opt::Arg *A : ParsedArgs) {
+    switch (A->getOption().getID()) {
+    // Inputs, and the name of the module they make up, don't affect the
+    // instance; they're only loaded once the job runs.
+    case options::OPT_INPUT:
+    case options::OPT_primary_file:
+    case options::OPT_filelist:
+    case options::OPT_module_name:
+    case options::OPT_o:
+    case options::OPT_output_filelist:
+      continue;
+
+    // Only whether these outputs are requested matters, not where they go.
+    // (For example, emitting module documentation changes how the instance
+    // parses comments.)
+    case options::OPT_emit_module_path:
+    case options::OPT_emit_module_doc_path:
+    case options::OPT_emit_objc_header_path:
+    case options::OPT_emit_dependencies_path:
+    case options::OPT_emit_reference_dependencies_path:
+    case options::OPT_serialize_diagnostics_path:
+    case options::OPT_emit_fixits_path:
+    case options::OPT_dump_api_path:
+      Out << A->getSpelling() << '\0';
+      continue;
+
+    // Options passed to LLVM are global to the process, so the server must
+    // never parse them.
+    case options::OPT_Xllvm:
+      return std::string();
+
+    default:
+      Out << A->getSpelling();
+      for (const char *Value : A->getValues())
+        Out << Value << '\0';
+      Out << '\0';
+      continue;
+    }
+  }
+
+  Out << '\0' << R.WorkingDirectory << '\0';
+  for (const std::string &Var : R.Env)
+    Out << Var << '\0';
+  return Out.str();
+}
+
+std::unique_ptr<WarmInstance>
+FrontendServer::createWarmInstance(frontend_server::Request &R,
+                                   std::string Key) const {
+  // Prepare the instance as the job itself would see the world, so that
+  // relative search paths and the environment variables read by Clang mean
+  // the same thing.
+  if (chdir(R.WorkingDirectory.c_str()) != 0)
+    return nullptr;
+  ScopedEnvironment Env(R.Env);
+
+  std::unique_ptr<WarmInstance> WI(new WarmInstance());
+  WI->Key = std::move(Key);
+
+  SmallVector<const char *, 64> Args;
+  for (const std::string &Arg : llvm::makeArrayRef(R.Args).slice(1))
+    Args.push_back(Arg.c_str());
+
+  CompilerInvocation Invocation;
+  Invocation.setMainExecutablePath(MainExecutablePath);
+  if (Invocation.parseArgs(Args, WI->Instance.getDiags(), R.WorkingDirectory))
+    return nullptr;
+
+  // Only ordinary Swift compilations load the standard library up front.
+  const FrontendOptions &Opts = Invocation.getFrontendOptions();
+  if (Invocation.getInputKind() != InputFileKind::IFK_Swift ||
+      Invocation.getParseStdlib() || Invocation.isCodeCompletion() ||
+      Opts.RequestedAction == FrontendOptions::NoneAction ||
+      Opts.actionIsImmediate() || Opts.PrintHelp || Opts.PrintHelpHidden ||
+      !Opts.LLVMArgs.empty())
+    return nullptr;
+
+  WI->Instance.setDependencyTracker(&WI->Tracker);
+  if (WI->Instance.setupASTContext(Invocation))
+    return nullptr;
+
+  ModuleDecl *Stdlib =
+    WI->Instance.getASTContext().getStdlibModule(/*loadIfAbsent=*/true);
+  if (!Stdlib || Stdlib->failedToLoad() ||
+      WI->Instance.getDiags().hadAnyError())
+    return nullptr;
+
+  for (const std::string &Path : WI->Tracker.getDependencies()) {
+    llvm::sys::fs::file_status Status;
+    if (llvm::sys::fs::status(Path, Status))
+      return nullptr;
+    WI->Dependencies.push_back({Path, Status.getLastModificationTime(),
+                                Status.getSize()});
+  }
+  return WI;
+}
+
+CompilerInstance *
+FrontendServer::getWarmInstance(frontend_server::Request &R) {
+  std::string Key = getKey(R);
+  if (Key.empty())
+    return nullptr;
+
+  auto Found = std::find_if(Instances.begin(), Instances.end(),
+                            [&](const std::unique_ptr<WarmInstance> &WI) {
+    return WI->Key == Key;
+  });
+  if (Found != Instances.end()) {
+    if ((*Found)->isUpToDate()) {
+      (*Found)->LastUsed = NumRequests;
+      return &(*Found)->Instance;
+    }
+    Instances.erase(Found);
+  }
+
+  std::unique_ptr<WarmInstance> WI = createWarmInstance(R, std::move(Key));
+  if (!WI)
+    return nullptr;
+  WI->LastUsed = NumRequests;
+
+  if (Instances.size() >= MaxWarmInstances) {
+    auto LeastRecentlyUsed =
+      std::min_element(Instances.begin(), Instances.end(),
+                       [](const std::unique_ptr<WarmInstance> &LHS,
+                          const std::unique_ptr<WarmInstance> &RHS) {
+      return LHS->LastUsed < RHS->LastUsed;
+    });
+    Instances.erase(LeastRecentlyUsed);
+  }
+  Instances.push_back(std::move(WI));
+  return &Instances.back()->Instance;
+}
+
+static uint64_t toMicroseconds(const struct timeval &TV) {
+  return uint64_t(TV.tv_sec) * 1000000 + TV.tv_usec;
+}
+
+void FrontendServer::runJob(int Socket, int OutputFD,
+                            frontend_server::Request &R,
+                            CompilerInstance *Warm) {
+  pid_t Worker = fork();
+  if (Worker == 0) {
+    // Set up the job's process as the driver would have spawned it.
+    close(Socket);
+    dup2(OutputFD, STDOUT_FILENO);
+    dup2(OutputFD, STDERR_FILENO);
+    close(OutputFD);
+    signal(SIGPIPE, SIG_DFL);
+    if (chdir(R.WorkingDirectory.c_str()) != 0) {
+      llvm::errs() << "error: unable to change to directory '"
+                   << R.WorkingDirectory << "'\n";
+      _exit(1);
+    }
+    // The environment is never restored; the process exits first.
+    new ScopedEnvironment(R.Env);
+
+    SmallVector<const char *, 64> Args;
+    for (const std::string &Arg : llvm::makeArrayRef(R.Args).slice(1))
+      Args.push_back(Arg.c_str());
+
+    int Result;
+    if (Warm) {
+      Result = frontend_main(Args, Argv0, MainAddr, *Warm);
+    } else {
+      CompilerInstance Instance;
+      Result = frontend_main(Args, Argv0, MainAddr, Instance);
+    }
+
+    // Use _exit rather than exit so that the destructors of the server's
+    // state, cloned into this process, aren't run.
+    llvm::outs().flush();
+    llvm::errs().flush();
+    fflush(nullptr);
+    _exit(Result);
+  }
+
+  close(OutputFD);
+  if (Worker < 0) {
+    frontend_server::sendPid(Socket, -1);
+    _exit(1);
+  }
+  if (frontend_server::sendPid(Socket, Worker)) {
+    // The client has gone away, so nothing is waiting for the job.
+    kill(Worker, SIGKILL);
+  }
+
+  int Status;
+  struct rusage RU;
+  pid_t Pid;
+  do {
+    Status = 0;
+    Pid = wait4(Worker, &Status, 0, &RU);
+  } while (Pid < 0 && errno == EINTR);
+  if (Pid < 0)
+    _exit(1);
+
+  frontend_server::Result Result;
+  Result.Status = Status;
+  Result.UserTime = toMicroseconds(RU.ru_utime);
+  Result.SystemTime = toMicroseconds(RU.ru_stime);
+#if defined(__APPLE__)
+  // Darwin reports the maximum resident set size in bytes...
+  Result.MaxRSS = RU.ru_maxrss;
+#else
+  // ...but Linux and the BSDs report it in kilobytes.
+  Result.MaxRSS = uint64_t(RU.ru_maxrss) * 1024;
+#endif
+  frontend_server::sendResult(Socket, Result);
+  _exit(0);
+}
+
+bool FrontendServer::serve(int ListenSocket, int Socket) {
+  ++NumRequests;
+
+  // Jobs run as the server's user, so they may only come from that user.
+  if (!frontend_server::isPeerSameUser(Socket)) {
+    close(Socket);
+    return false;
+  }
+
+  frontend_server::Request R;
+  int OutputFD;
+  if (frontend_server::receiveRequest(Socket, R, OutputFD)) {
+    close(Socket);
+    return false;
+  }
+
+  auto reject = [&] {
+    frontend_server::sendPid(Socket, -1);
+    close(OutputFD);
+    close(Socket);
+  };
+
+  // Only run frontend jobs for clients of this very compiler. Once it has
+  // been rebuilt, leave the jobs to the clients until a new server starts.
+  if (R.Args.empty() || R.Args.front() != "-frontend" ||
+      !llvm::sys::fs::equivalent(R.ExecPath, MainExecutablePath)) {
+    reject();
+    return false;
+  }
+  if (isExecutableOutOfDate()) {
+    reject();
+    return true;
+  }
+
+  CompilerInstance *Warm = getWarmInstance(R);
+
+  // Fork a process to wait for the job and report on it, so that the server
+  // can go on accepting jobs in the meantime.
+  pid_t Handler = fork();
+  if (Handler == 0) {
+    close(ListenSocket);
+    runJob(Socket, OutputFD, R, Warm);
+  }
+  if (Handler < 0) {
+    reject();
+    return false;
+  }
+
+  close(OutputFD);
+  close(Socket);
+  return false;
+}
+
+int frontend_server_main(ArrayRef<const char *> Args, const char *Argv0,
+                         void *MainAddr) {
+  std::string SocketPath;
+  unsigned IdleTimeout = DefaultIdleTimeout;
+  for (unsigned i = 0, e = Args.size(); i != e; ++i) {
+    StringRef Arg = Args[i];
+    if (Arg == "-idle-timeout" && i + 1 != e) {
+      if (StringRef(Args[++i]).getAsInteger(10, IdleTimeout)) {
+        llvm::errs() << "error: invalid value '" << Args[i]
+                     << "' in '-idle-timeout'\n";
+        return 1;
+      }
+    } else if (SocketPath.empty() && !Arg.startswith("-")) {
+      SocketPath = Arg;
+    } else {
+      llvm::errs() << "error: unknown argument: '" << Arg << "'\n";
+      return 1;
+    }
+  }
+  if (SocketPath.empty()) {
+    llvm::errs() << "usage: swift -frontend-server <socket> "
+                    "[-idle-timeout <seconds>]\n";
+    return 1;
+  }
+
+  // The server changes directory while preparing instances, so it needs an
+  // absolute path to remove the socket when it exits.
+  SmallString<128> AbsoluteSocketPath(SocketPath);
+  llvm::sys::fs::make_absolute(AbsoluteSocketPath);
+  SocketPath = AbsoluteSocketPath.str();
+
+  int ListenSocket = frontend_server::listen(SocketPath);
+  if (ListenSocket < 0) {
+    llvm::errs() << "error: unable to listen at '" << SocketPath << "'\n";
+    return 1;
+  }
+
+  // Clients that go away shouldn't take the server with them.
+  signal(SIGPIPE, SIG_IGN);
+
+  FrontendServer Server(Argv0, MainAddr);
+  while (true) {
+    // Reap the processes that have finished reporting on their jobs.
+    while (waitpid(-1, nullptr, WNOHANG) > 0)
+      ;
+
+    struct pollfd PollFD = { ListenSocket, POLLIN, 0 };
+    int Ready = poll(&PollFD, 1, IdleTimeout ? IdleTimeout * 1000 : -1);
+    if (Ready < 0 && errno == EINTR)
+      continue;
+    if (Ready <= 0)
+      break;
+
+    int Socket = accept(ListenSocket, nullptr, nullptr);
+    if (Socket < 0)
+      continue;
+    if (Server.serve(ListenSocket, Socket))
+      break;
+  }
+
+  close(ListenSocket);
+  unlink(SocketPath.c_str());
+  return 0;
+}
+
+#else
+
+int frontend_server_main(ArrayRef<const char *> Args, const char *Argv0,
+                         void *MainAddr) {
+  llvm::errs() << "error: the frontend server is not supported on this "
+                  "platform\n";
+  return 1;
+}
+
+#endif
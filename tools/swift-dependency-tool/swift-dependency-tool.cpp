@@ -0,0 +1,70 @@
+//===--- swift-dependency-tool.cpp - Inspect incremental build files ------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// Prints binary reference dependencies files and build records as YAML, for
+// debugging incremental builds. Files that are already YAML are printed
+// unchanged.
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/Driver/BinaryDependencies.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <cstdlib>
+
+using namespace swift;
+
+static llvm::cl::opt<std::string>
+InputFilename(llvm::cl::Positional, llvm::cl::desc("<input file>"),
+              llvm::cl::init("-"));
+
+int main(int argc, char **argv) {
+  llvm::sys::PrintStackTraceOnErrorSignal();
+  llvm::PrettyStackTraceProgram X(argc, argv);
+  llvm::cl::ParseCommandLineOptions(argc, argv,
+                                    "Swift incremental build file printer\n");
+
+  auto input = llvm::MemoryBuffer::getFileOrSTDIN(InputFilename);
+  if (!input) {
+    llvm::errs() << InputFilename << ": " << input.getError().message()
+                 << '\n';
+    return EXIT_FAILURE;
+  }
+  StringRef data = input.get()->getBuffer();
+
+  if (binary_deps::isBinaryDependencyFile(data)) {
+    auto file = binary_deps::DependencyFileView::get(data);
+    if (!file) {
+      llvm::errs() << InputFilename << ": malformed dependencies file\n";
+      return EXIT_FAILURE;
+    }
+    file->printAsYAML(llvm::outs());
+    return EXIT_SUCCESS;
+  }
+
+  if (binary_deps::isBinaryBuildRecord(data)) {
+    auto record = binary_deps::BuildRecordView::get(data);
+    if (!record) {
+      llvm::errs() << InputFilename << ": malformed build record\n";
+      return EXIT_FAILURE;
+    }
+    record->printAsYAML(llvm::outs());
+    return EXIT_SUCCESS;
+  }
+
+  llvm::outs() << data;
+  return EXIT_SUCCESS;
+}
@@ -13,6 +13,7 @@
 #include "swift/Basic/Demangle.h"
 #include "swift/Basic/LLVMInitialize.h"
 #include "swift/Reflection/ReflectionContext.h"
+#include "swift/Reflection/TypeLowering.h"
 #include "swift/Reflection/TypeRef.h"
 #include "llvm/Object/Archive.h"
 #include "llvm/Object/MachO.h"
@@ -20,9 +21,11 @@
 #include "llvm/Object/ELF.h"
 #include "llvm/Support/CommandLine.h"
 
+#include <chrono>
 #include <iostream>
 
 using llvm::dyn_cast;
+using llvm::isa;
 using llvm::StringRef;
 using llvm::ArrayRef;
 using namespace llvm::object;
@@ -35,7 +38,10 @@ namespace {
 
 enum class ActionType {
   None,
-  DumpReflectionSections
+  DumpReflectionSections,
+  DumpTypeLayouts,
+  BenchmarkTypeRefDecoding,
+  BenchmarkFieldDescriptorLookup
 };
 
 } // end anonymous namespace
@@ -47,6 +53,15 @@ Action(llvm::cl::desc("Mode:"),
          clEnumValN(ActionType::DumpReflectionSections,
                     "dump-reflection-sections",
                     "Dump the field reflection section"),
+         clEnumValN(ActionType::DumpTypeLayouts,
+                    "dump-type-layouts",
+                    "Dump the layout of every concrete type in the binary"),
+         clEnumValN(ActionType::BenchmarkTypeRefDecoding,
+                    "benchmark-typeref-decoding",
+                    "Time decoding every field type in the binary"),
+         clEnumValN(ActionType::BenchmarkFieldDescriptorLookup,
+                    "benchmark-field-descriptor-lookup",
+                    "Time looking up the field descriptor of every type"),
          clEnumValEnd));
 
 static llvm::cl::opt<std::string>
@@ -56,6 +71,11 @@ BinaryFilename("binary-filename", llvm::cl::desc("Filename of the binary file"),
 static llvm::cl::opt<std::string>
 Architecture("arch", llvm::cl::desc("Architecture to inspect in the binary"),
              llvm::cl::Required);
+
+static llvm::cl::opt<unsigned>
+Iterations("iterations",
+           llvm::cl::desc("Number of iterations for benchmark modes"),
+           llvm::cl::init(10));
 } // end namespace options
 
 
@@ -93,13 +113,12 @@ getSectionRef(const Binary *binaryFile, StringRef arch,
   return SectionRef();
 }
 
-static int doDumpReflectionSections(std::string BinaryFilename,
-                                    StringRef arch) {
-  auto binaryOrError = llvm::object::createBinary(BinaryFilename);
-  guardError(binaryOrError.getError());
-
-  const auto binary = binaryOrError.get().getBinary();
-
+/// Find the reflection sections in \p binary and register them with
+/// \p Reader. Returns false after printing a diagnostic if the binary is
+/// missing either section.
+static bool addReflectionInfo(MemoryReader &Reader, const Binary *binary,
+                              const std::string &BinaryFilename,
+                              StringRef arch) {
   auto fieldSectionRef = getSectionRef(binary, arch, {
     "__swift3_fieldmd", ".swift3_fieldmd"
   });
@@ -107,7 +126,7 @@ static int doDumpReflectionSections(std::string BinaryFilename,
   if (fieldSectionRef.getObject() == nullptr) {
     std::cerr << BinaryFilename;
     std::cerr << " doesn't have a field reflection section!\n";
-    return EXIT_FAILURE;
+    return false;
   }
 
   auto associatedTypeSectionRef = getSectionRef(binary, arch, {
@@ -117,7 +136,7 @@ static int doDumpReflectionSections(std::string BinaryFilename,
   if (associatedTypeSectionRef.getObject() == nullptr) {
     std::cerr << BinaryFilename;
     std::cerr << " doesn't have an associated type reflection section!\n";
-    return EXIT_FAILURE;
+    return false;
   }
 
   StringRef fieldSectionContents;
@@ -138,20 +157,207 @@ static int doDumpReflectionSections(std::string BinaryFilename,
     reinterpret_cast<const void *>(associatedTypeSectionContents.end())
   };
 
-  MemoryReader Reader;
   Reader.addReflectionInfo({fieldSection, associatedTypeSection});
+  return true;
+}
+
+static int doDumpReflectionSections(std::string BinaryFilename,
+                                    StringRef arch) {
+  auto binaryOrError = llvm::object::createBinary(BinaryFilename);
+  guardError(binaryOrError.getError());
+
+  const auto binary = binaryOrError.get().getBinary();
+
+  MemoryReader Reader;
+  if (!addReflectionInfo(Reader, binary, BinaryFilename, arch))
+    return EXIT_FAILURE;
+
   ReflectionContext RC(Reader);
   RC.dumpAllSections(std::cout);
 
   return EXIT_SUCCESS;
 }
 
+static int doDumpTypeLayouts(std::string BinaryFilename, StringRef arch) {
+  auto binaryOrError = llvm::object::createBinary(BinaryFilename);
+  guardError(binaryOrError.getError());
+
+  const auto binary = binaryOrError.get().getBinary();
+
+  MemoryReader Reader;
+  if (!addReflectionInfo(Reader, binary, BinaryFilename, arch))
+    return EXIT_FAILURE;
+
+  ReflectionContext RC(Reader);
+  TypeConverter TC(RC);
+  auto &Builder = RC.getBuilder();
+
+  for (const auto &sections : Reader.getInfo()) {
+    for (const auto &descriptor : sections.Fields) {
+      auto MangledName = descriptor.getMangledTypeName();
+      auto TR = Builder.decodeMangledType(MangledName);
+
+      std::cout << Demangle::demangleTypeAsString(MangledName) << '\n';
+
+      // Generic types have no layout until they are bound.
+      if (TR == nullptr || !TR->isConcrete()) {
+        std::cout << "<<generic>>\n\n";
+        continue;
+      }
+
+      // For classes, show the layout of the heap instance rather than of
+      // the reference.
+      const TypeInfo *TI = TC.getTypeInfo(TR);
+      if (TI != nullptr && isa<ReferenceTypeInfo>(TI))
+        TI = TC.getClassInstanceTypeInfo(TR);
+
+      if (TI == nullptr)
+        std::cout << "<<unknown layout>>\n";
+      else
+        TI->dump(std::cout);
+      std::cout << '\n';
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+static int doBenchmarkTypeRefDecoding(std::string BinaryFilename,
+                                      StringRef arch, unsigned Iterations) {
+  auto binaryOrError = llvm::object::createBinary(BinaryFilename);
+  guardError(binaryOrError.getError());
+
+  const auto binary = binaryOrError.get().getBinary();
+
+  MemoryReader Reader;
+  if (!addReflectionInfo(Reader, binary, BinaryFilename, arch))
+    return EXIT_FAILURE;
+
+  using Clock = std::chrono::steady_clock;
+  Clock::duration Total = Clock::duration::zero();
+  unsigned NumDecoded = 0;
+  unsigned NumTypeRefs = 0;
+  size_t TotalMemory = 0;
+
+  for (unsigned i = 0; i < Iterations; ++i) {
+    // Use a fresh context for every iteration so that nothing is served
+    // from a previous iteration's caches.
+    ReflectionContext RC(Reader);
+    auto Start = Clock::now();
+    NumDecoded = RC.decodeAllFieldTypes();
+    Total += Clock::now() - Start;
+    NumTypeRefs = RC.getBuilder().getNumTypeRefs();
+    TotalMemory = RC.getBuilder().getTotalMemory();
+  }
+
+  auto TotalUS =
+    std::chrono::duration_cast<std::chrono::microseconds>(Total).count();
+  std::cout << "Iterations: " << Iterations << "\n";
+  std::cout << "Mangled names decoded: " << NumDecoded << "\n";
+  std::cout << "Unique TypeRefs: " << NumTypeRefs << "\n";
+  std::cout << "TypeRef arena bytes: " << TotalMemory << "\n";
+  std::cout << "Time per iteration (us): "
+            << (Iterations ? TotalUS / Iterations : 0) << "\n";
+
+  return EXIT_SUCCESS;
+}
+
+static int doBenchmarkFieldDescriptorLookup(std::string BinaryFilename,
+                                            StringRef arch,
+                                            unsigned Iterations) {
+  auto binaryOrError = llvm::object::createBinary(BinaryFilename);
+  guardError(binaryOrError.getError());
+
+  const auto binary = binaryOrError.get().getBinary();
+
+  MemoryReader Reader;
+  if (!addReflectionInfo(Reader, binary, BinaryFilename, arch))
+    return EXIT_FAILURE;
+
+  ReflectionContext RC(Reader);
+
+  // Collect the names of all described types up front so that only the
+  // lookups themselves are timed.
+  std::vector<std::string> Names;
+  for (const auto &sections : Reader.getInfo())
+    for (const auto &descriptor : sections.Fields)
+      Names.push_back(ReflectionContext::getNominalMangledName(
+        RC.getBuilder().decodeMangledType(descriptor.getMangledTypeName())));
+
+  using Clock = std::chrono::steady_clock;
+  auto toUS = [](Clock::duration D) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(D).count();
+  };
+
+  // Baseline: scan every section for each lookup.
+  auto Start = Clock::now();
+  unsigned NumFound = 0;
+  for (unsigned i = 0; i < Iterations; ++i) {
+    for (const auto &Name : Names) {
+      for (const auto &sections : Reader.getInfo()) {
+        bool Found = false;
+        for (const auto &descriptor : sections.Fields) {
+          auto TR = RC.getBuilder().decodeMangledType(
+            descriptor.getMangledTypeName());
+          if (ReflectionContext::getNominalMangledName(TR) == Name) {
+            Found = true;
+            break;
+          }
+        }
+        if (Found) {
+          ++NumFound;
+          break;
+        }
+      }
+    }
+  }
+  auto LinearTime = Clock::now() - Start;
+
+  // The first indexed lookup builds the index.
+  Start = Clock::now();
+  RC.lookupFieldDescriptor("");
+  auto IndexTime = Clock::now() - Start;
+
+  Start = Clock::now();
+  unsigned NumIndexedFound = 0;
+  for (unsigned i = 0; i < Iterations; ++i)
+    for (const auto &Name : Names)
+      if (RC.lookupFieldDescriptor(Name))
+        ++NumIndexedFound;
+  auto IndexedTime = Clock::now() - Start;
+
+  if (NumFound != NumIndexedFound) {
+    std::cerr << "swift-reflection-test error: indexed lookup found "
+              << NumIndexedFound << " descriptors, linear scan found "
+              << NumFound << "\n";
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Iterations: " << Iterations << "\n";
+  std::cout << "Types: " << Names.size() << "\n";
+  std::cout << "Linear scan time (us): " << toUS(LinearTime) << "\n";
+  std::cout << "Index build time (us): " << toUS(IndexTime) << "\n";
+  std::cout << "Indexed lookup time (us): " << toUS(IndexedTime) << "\n";
+
+  return EXIT_SUCCESS;
+}
+
 int main(int argc, char *argv[]) {
   llvm::cl::ParseCommandLineOptions(argc, argv, "Swift Reflection Test\n");
   switch (options::Action) {
   case ActionType::DumpReflectionSections:
     return doDumpReflectionSections(options::BinaryFilename,
                                     options::Architecture);
+  case ActionType::DumpTypeLayouts:
+    return doDumpTypeLayouts(options::BinaryFilename, options::Architecture);
+  case ActionType::BenchmarkTypeRefDecoding:
+    return doBenchmarkTypeRefDecoding(options::BinaryFilename,
+                                      options::Architecture,
+                                      options::Iterations);
+  case ActionType::BenchmarkFieldDescriptorLookup:
+    return doBenchmarkFieldDescriptorLookup(options::BinaryFilename,
+                                            options::Architecture,
+                                            options::Iterations);
   case ActionType::None:
     llvm::cl::PrintHelpMessage();
     return EXIT_FAILURE;
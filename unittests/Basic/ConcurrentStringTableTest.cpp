@@ -0,0 +1,95 @@
+//===--- ConcurrentStringTableTest.cpp - for ConcurrentStringTable.h ------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/Basic/ConcurrentStringTable.h"
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace swift;
+
+TEST(ConcurrentStringTable, InternsUniqueCopies) {
+  ConcurrentStringTable table;
+  std::string hello = "hello";
+
+  const char *first = table.intern(hello);
+  EXPECT_NE(hello.data(), first);
+  EXPECT_STREQ("hello", first);
+  EXPECT_EQ(first, table.intern("hello"));
+  EXPECT_EQ(first, table.lookup("hello"));
+  EXPECT_NE(first, table.intern("hell"));
+  EXPECT_EQ(nullptr, table.lookup("help"));
+
+  const char *empty = table.intern("");
+  EXPECT_STREQ("", empty);
+  EXPECT_EQ(empty, table.intern(StringRef()));
+
+  // A string with an embedded null is different from its prefix.
+  EXPECT_NE(table.intern(StringRef("a\0b", 3)), table.intern("a"));
+  EXPECT_EQ(5u, table.size());
+}
+
+TEST(ConcurrentStringTable, Alignment) {
+  ConcurrentStringTable table;
+  for (unsigned i = 0; i != 100; ++i) {
+    const char *str = table.intern(std::string(i, 'x'));
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(str) %
+                  ConcurrentStringTable::StringAlignment);
+  }
+}
+
+TEST(ConcurrentStringTable, Growth) {
+  ConcurrentStringTable table;
+  std::vector<const char *> interned;
+  for (unsigned i = 0; i != 20000; ++i)
+    interned.push_back(table.intern("name" + std::to_string(i)));
+
+  EXPECT_EQ(20000u, table.size());
+  for (unsigned i = 0; i != 20000; ++i)
+    EXPECT_EQ(interned[i], table.lookup("name" + std::to_string(i)));
+}
+
+TEST(ConcurrentStringTable, ThirtyTwoThreads) {
+  const unsigned numThreads = 32;
+  const unsigned numStrings = 5000;
+
+  ConcurrentStringTable table;
+  table.setThreadSafe(true);
+
+  // Every thread interns the same strings, in a different order, so that
+  // threads race to add each one.
+  std::vector<std::vector<const char *>> results(numThreads);
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t != numThreads; ++t) {
+    threads.emplace_back([&table, &results, t, numStrings] {
+      std::vector<const char *> &interned = results[t];
+      interned.resize(numStrings);
+      for (unsigned n = 0; n != numStrings; ++n) {
+        unsigned i = (n * 7919 + t * 131) % numStrings;
+        interned[i] = table.intern("identifier" + std::to_string(i));
+      }
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+  table.setThreadSafe(false);
+
+  EXPECT_EQ(numStrings, table.size());
+  for (unsigned i = 0; i != numStrings; ++i) {
+    EXPECT_EQ("identifier" + std::to_string(i), results[0][i]);
+    for (unsigned t = 1; t != numThreads; ++t)
+      ASSERT_EQ(results[0][i], results[t][i]);
+  }
+}
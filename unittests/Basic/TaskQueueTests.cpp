@@ -0,0 +1,501 @@
+//===--- TaskQueueTests.cpp - for swift/Basic/TaskQueue.h -----------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/Basic/TaskQueue.h"
+#include "swift/Basic/FrontendServer.h"
+#include "swift/Basic/JobServer.h"
+#include "swift/Basic/LLVM.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if LLVM_ON_UNIX && !defined(__CYGWIN__)
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace swift;
+using namespace swift::sys;
+
+namespace {
+
+void *toContext(uintptr_t value) {
+  return reinterpret_cast<void *>(value);
+}
+
+uintptr_t fromContext(void *context) {
+  return reinterpret_cast<uintptr_t>(context);
+}
+
+} // end anonymous namespace
+
+TEST(TaskQueue, DummyQueueRunsInOrderAdded) {
+  DummyTaskQueue TQ(1);
+  for (uintptr_t i = 0; i < 4; ++i)
+    TQ.addTask("/bin/true", llvm::None, llvm::None, toContext(i));
+
+  SmallVector<uintptr_t, 4> began;
+  TQ.execute([&](ProcessId, void *context) {
+    began.push_back(fromContext(context));
+  });
+
+  ASSERT_EQ(4u, began.size());
+  EXPECT_EQ(0u, began[0]);
+  EXPECT_EQ(1u, began[1]);
+  EXPECT_EQ(2u, began[2]);
+  EXPECT_EQ(3u, began[3]);
+}
+
+TEST(TaskQueue, DummyQueueRunsHighestPriorityFirst) {
+  DummyTaskQueue TQ(1);
+  TQ.addTask("/bin/true", llvm::None, llvm::None, toContext(0), 10);
+  TQ.addTask("/bin/true", llvm::None, llvm::None, toContext(1), 30);
+  TQ.addTask("/bin/true", llvm::None, llvm::None, toContext(2), 20);
+  TQ.addTask("/bin/true", llvm::None, llvm::None, toContext(3), 30);
+
+  SmallVector<uintptr_t, 4> began;
+  TQ.execute([&](ProcessId, void *context) {
+    began.push_back(fromContext(context));
+  });
+
+  // Tasks with equal priorities still run in the order they were added.
+  ASSERT_EQ(4u, began.size());
+  EXPECT_EQ(1u, began[0]);
+  EXPECT_EQ(3u, began[1]);
+  EXPECT_EQ(2u, began[2]);
+  EXPECT_EQ(0u, began[3]);
+}
+
+TEST(TaskQueue, DummyQueuePrioritizesTasksAddedLater) {
+  DummyTaskQueue TQ(1);
+  TQ.addTask("/bin/true", llvm::None, llvm::None, toContext(0), 5);
+  TQ.addTask("/bin/true", llvm::None, llvm::None, toContext(1), 1);
+  TQ.addTask("/bin/true", llvm::None, llvm::None, toContext(2), 1);
+
+  SmallVector<uintptr_t, 4> began;
+  auto taskBegan = [&](ProcessId, void *context) {
+    began.push_back(fromContext(context));
+  };
+  auto taskFinished = [&](ProcessId, int, StringRef,
+                          Optional<TaskResourceUsage> usage,
+                          void *context) -> TaskFinishedResponse {
+    EXPECT_FALSE(usage.hasValue());
+
+    // A task that becomes ready while others are waiting jumps ahead of them
+    // if its priority is higher.
+    if (fromContext(context) == 0)
+      TQ.addTask("/bin/true", llvm::None, llvm::None, toContext(3), 2);
+    return TaskFinishedResponse::ContinueExecution;
+  };
+  TQ.execute(taskBegan, taskFinished);
+
+  ASSERT_EQ(4u, began.size());
+  EXPECT_EQ(0u, began[0]);
+  EXPECT_EQ(3u, began[1]);
+  EXPECT_EQ(1u, began[2]);
+  EXPECT_EQ(2u, began[3]);
+}
+
+TEST(JobServer, IgnoresMakeFlagsWithoutJobServer) {
+  EXPECT_FALSE(JobServer::connect(""));
+  EXPECT_FALSE(JobServer::connect("-j4"));
+  EXPECT_FALSE(JobServer::connect("-j --jobserver-auth=fifo:"));
+  EXPECT_FALSE(JobServer::connect("-j --jobserver-auth=x,y"));
+}
+
+#if LLVM_ON_UNIX && !defined(__CYGWIN__)
+
+namespace {
+
+/// A jobserver like the one make sets up, backed by a named FIFO in a
+/// temporary directory.
+class FakeJobServer {
+  SmallString<128> Directory;
+  SmallString<128> Path;
+
+  /// Keeps the FIFO open, so that tokens written to it aren't lost.
+  int FD = -1;
+
+public:
+  explicit FakeJobServer(unsigned NumTokens) {
+    std::error_code EC =
+        llvm::sys::fs::createUniqueDirectory("jobserver-test", Directory);
+    EXPECT_FALSE(EC);
+    Path = Directory;
+    llvm::sys::path::append(Path, "fifo");
+    EXPECT_EQ(0, mkfifo(Path.c_str(), 0600));
+    FD = open(Path.c_str(), O_RDWR | O_NONBLOCK);
+    EXPECT_LE(0, FD);
+    for (unsigned i = 0; i < NumTokens; ++i)
+      EXPECT_EQ(1, write(FD, "+", 1));
+  }
+
+  ~FakeJobServer() {
+    close(FD);
+    llvm::sys::fs::remove(Path);
+    llvm::sys::fs::remove(Directory);
+  }
+
+  std::string getMakeFlags() const {
+    return "-j --jobserver-auth=fifo:" + Path.str().str();
+  }
+
+  /// Takes every token that has been returned to the jobserver.
+  unsigned drainTokens() {
+    unsigned Count = 0;
+    char Token;
+    while (read(FD, &Token, 1) == 1) {
+      EXPECT_EQ('+', Token);
+      ++Count;
+    }
+    return Count;
+  }
+};
+
+} // end anonymous namespace
+
+TEST(JobServer, AcquiresAndReturnsTokens) {
+  FakeJobServer Server(2);
+  {
+    auto JS = JobServer::connect(Server.getMakeFlags());
+    ASSERT_TRUE(JS != nullptr);
+    EXPECT_TRUE(JS->tryAcquire());
+    EXPECT_TRUE(JS->tryAcquire());
+    EXPECT_FALSE(JS->tryAcquire());
+    EXPECT_EQ(2u, JS->getNumTokens());
+
+    JS->release();
+    EXPECT_EQ(1u, JS->getNumTokens());
+    EXPECT_TRUE(JS->tryAcquire());
+  }
+  // Tokens still held are given back when the client goes away.
+  EXPECT_EQ(2u, Server.drainTokens());
+}
+
+#if defined(__linux__)
+TEST(JobServer, InheritedPipe) {
+  int Pipe[2];
+  ASSERT_EQ(0, pipe(Pipe));
+  ASSERT_EQ(1, write(Pipe[1], "+", 1));
+
+  std::string MakeFlags = "-j --jobserver-auth=" + std::to_string(Pipe[0]) +
+                          "," + std::to_string(Pipe[1]);
+  {
+    auto JS = JobServer::connect(MakeFlags);
+    ASSERT_TRUE(JS != nullptr);
+    EXPECT_TRUE(JS->tryAcquire());
+    EXPECT_FALSE(JS->tryAcquire());
+  }
+
+  // The inherited descriptor is still blocking, and has the token back.
+  EXPECT_EQ(0, fcntl(Pipe[0], F_GETFL) & O_NONBLOCK);
+  char Token;
+  EXPECT_EQ(1, read(Pipe[0], &Token, 1));
+  close(Pipe[0]);
+  close(Pipe[1]);
+}
+#endif
+
+TEST(TaskQueue, JobServerLimitsParallelTasks) {
+  FakeJobServer Server(1);
+
+  TaskQueue TQ(4);
+  TQ.setJobServer(JobServer::connect(Server.getMakeFlags()));
+
+  const char *Args[] = { "-c", "sleep 0.2" };
+  for (uintptr_t i = 0; i < 6; ++i)
+    TQ.addTask("/bin/sh", Args, llvm::None, toContext(i));
+
+  unsigned Running = 0;
+  unsigned MaxRunning = 0;
+  auto taskBegan = [&](ProcessId, void *) {
+    MaxRunning = std::max(MaxRunning, ++Running);
+  };
+  auto taskFinished = [&](ProcessId, int ReturnCode, StringRef,
+                          Optional<TaskResourceUsage>,
+                          void *) -> TaskFinishedResponse {
+    EXPECT_EQ(0, ReturnCode);
+    --Running;
+    return TaskFinishedResponse::ContinueExecution;
+  };
+  EXPECT_FALSE(TQ.execute(taskBegan, taskFinished));
+
+  // One task runs on the process's implicit token, and one on the
+  // jobserver's only token, even though four are allowed.
+  EXPECT_EQ(2u, MaxRunning);
+  EXPECT_EQ(1u, Server.drainTokens());
+}
+
+TEST(TaskQueue, ReportsResourceUsage) {
+  ASSERT_TRUE(TaskQueue::supportsResourceUsage());
+
+  TaskQueue TQ(2);
+  const char *Args[] = { "-c", "sleep 0.2" };
+  TQ.addTask("/bin/sh", Args);
+
+  Optional<TaskResourceUsage> Usage;
+  auto taskFinished = [&](ProcessId, int ReturnCode, StringRef,
+                          Optional<TaskResourceUsage> TaskUsage,
+                          void *) -> TaskFinishedResponse {
+    EXPECT_EQ(0, ReturnCode);
+    Usage = TaskUsage;
+    return TaskFinishedResponse::ContinueExecution;
+  };
+  EXPECT_FALSE(TQ.execute(nullptr, taskFinished));
+
+  ASSERT_TRUE(Usage.hasValue());
+  EXPECT_GE(Usage->WallTime, 200000u);
+  // Sleeping takes hardly any CPU time, but any process needs some memory.
+  EXPECT_LT(Usage->UserTime + Usage->SystemTime, Usage->WallTime);
+  EXPECT_GT(Usage->MaxRSS, 0u);
+}
+
+TEST(TaskQueue, ReportsResourceUsageOfSignalledTasks) {
+  TaskQueue TQ(1);
+  const char *Args[] = { "-c", "kill -9 $$" };
+  TQ.addTask("/bin/sh", Args);
+
+  Optional<TaskResourceUsage> Usage;
+  auto taskSignalled = [&](ProcessId, StringRef, StringRef,
+                           Optional<TaskResourceUsage> TaskUsage,
+                           void *) -> TaskFinishedResponse {
+    Usage = TaskUsage;
+    return TaskFinishedResponse::ContinueExecution;
+  };
+  TQ.execute(nullptr, nullptr, taskSignalled);
+
+  ASSERT_TRUE(Usage.hasValue());
+  EXPECT_GT(Usage->MaxRSS, 0u);
+}
+
+TEST(TaskQueue, RunsFrontendTasksInFrontendServer) {
+  SmallString<128> Directory;
+  ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("frontend-server-test",
+                                                    Directory));
+  SmallString<128> SocketPath = Directory;
+  llvm::sys::path::append(SocketPath, "socket");
+  int ListenSocket = frontend_server::listen(SocketPath);
+  ASSERT_LE(0, ListenSocket);
+
+  // A server that runs a single job, whose process exits with status 3.
+  frontend_server::Request Received;
+  std::thread Server([&] {
+    int Socket = accept(ListenSocket, nullptr, nullptr);
+    ASSERT_LE(0, Socket);
+    int OutputFD;
+    ASSERT_FALSE(frontend_server::receiveRequest(Socket, Received, OutputFD));
+
+    pid_t Pid = fork();
+    if (Pid == 0) {
+      (void)write(OutputFD, "compiled", 8);
+      _exit(3);
+    }
+    close(OutputFD);
+    EXPECT_FALSE(frontend_server::sendPid(Socket, Pid));
+
+    frontend_server::Result Result;
+    EXPECT_EQ(Pid, waitpid(Pid, &Result.Status, 0));
+    Result.MaxRSS = 1024;
+    EXPECT_FALSE(frontend_server::sendResult(Socket, Result));
+    close(Socket);
+  });
+
+  TaskQueue TQ(1);
+  TQ.setFrontendServer(SocketPath);
+  const char *Args[] = { "-frontend", "-c", "main.swift" };
+  TQ.addTask("/path/to/swift", Args);
+
+  int ReturnCode = -1;
+  std::string Output;
+  Optional<TaskResourceUsage> Usage;
+  auto taskFinished = [&](ProcessId, int TaskReturnCode, StringRef TaskOutput,
+                          Optional<TaskResourceUsage> TaskUsage,
+                          void *) -> TaskFinishedResponse {
+    ReturnCode = TaskReturnCode;
+    Output = TaskOutput;
+    Usage = TaskUsage;
+    return TaskFinishedResponse::ContinueExecution;
+  };
+  TQ.execute(nullptr, taskFinished);
+  Server.join();
+
+  EXPECT_EQ("/path/to/swift", Received.ExecPath);
+  ASSERT_EQ(3u, Received.Args.size());
+  EXPECT_EQ("-frontend", Received.Args[0]);
+  EXPECT_EQ("main.swift", Received.Args[2]);
+  EXPECT_FALSE(Received.WorkingDirectory.empty());
+  EXPECT_FALSE(Received.Env.empty());
+
+  EXPECT_EQ(3, ReturnCode);
+  EXPECT_EQ("compiled", Output);
+  ASSERT_TRUE(Usage.hasValue());
+  EXPECT_EQ(1024u, Usage->MaxRSS);
+
+  close(ListenSocket);
+  llvm::sys::fs::remove(SocketPath);
+  llvm::sys::fs::remove(Directory);
+}
+
+TEST(TaskQueue, FrontendServerSocketIsPrivate) {
+  SmallString<128> Directory;
+  ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("frontend-server-test",
+                                                    Directory));
+  SmallString<128> SocketPath = Directory;
+  llvm::sys::path::append(SocketPath, "socket");
+  int ListenSocket = frontend_server::listen(SocketPath);
+  ASSERT_LE(0, ListenSocket);
+
+  struct stat Status;
+  ASSERT_EQ(0, stat(SocketPath.c_str(), &Status));
+  EXPECT_EQ(0u, Status.st_mode & (S_IRWXG | S_IRWXO));
+
+  int Client = frontend_server::connect(SocketPath);
+  ASSERT_LE(0, Client);
+  int Socket = accept(ListenSocket, nullptr, nullptr);
+  ASSERT_LE(0, Socket);
+  EXPECT_TRUE(frontend_server::isPeerSameUser(Socket));
+
+  close(Socket);
+  close(Client);
+  close(ListenSocket);
+  llvm::sys::fs::remove(SocketPath);
+  llvm::sys::fs::remove(Directory);
+}
+
+TEST(TaskQueue, SpawnsTasksWithoutFrontendServer) {
+  TaskQueue TQ(1);
+  TQ.setFrontendServer("/nonexistent/socket");
+  const char *Args[] = { "-frontend", "-c" };
+  TQ.addTask("/bin/echo", Args);
+
+  std::string Output;
+  auto taskFinished = [&](ProcessId, int ReturnCode, StringRef TaskOutput,
+                          Optional<TaskResourceUsage>,
+                          void *) -> TaskFinishedResponse {
+    EXPECT_EQ(0, ReturnCode);
+    Output = TaskOutput;
+    return TaskFinishedResponse::ContinueExecution;
+  };
+  EXPECT_FALSE(TQ.execute(nullptr, taskFinished));
+  EXPECT_EQ("-frontend -c\n", Output);
+}
+
+TEST(TaskQueue, StreamsOutputWhileTasksRun) {
+  ASSERT_TRUE(TaskQueue::supportsStreamingOutput());
+
+  TaskQueue TQ(1);
+  const char *Args[] = { "-c", "echo first; sleep 0.2; echo second" };
+  TQ.addTask("/bin/sh", Args);
+
+  SmallVector<std::string, 2> Chunks;
+  bool FinishedBeforeOutput = false;
+  bool HasFinished = false;
+  std::string Output;
+  auto taskFinished = [&](ProcessId, int ReturnCode, StringRef TaskOutput,
+                          Optional<TaskResourceUsage>,
+                          void *) -> TaskFinishedResponse {
+    EXPECT_EQ(0, ReturnCode);
+    HasFinished = true;
+    Output = TaskOutput;
+    return TaskFinishedResponse::ContinueExecution;
+  };
+  auto outputReceived = [&](ProcessId, StringRef Chunk, void *) {
+    FinishedBeforeOutput |= HasFinished;
+    Chunks.push_back(Chunk);
+  };
+  EXPECT_FALSE(TQ.execute(nullptr, taskFinished, nullptr, outputReceived));
+
+  EXPECT_FALSE(FinishedBeforeOutput);
+  ASSERT_EQ(2u, Chunks.size());
+  EXPECT_EQ("first\n", Chunks[0]);
+  EXPECT_EQ("second\n", Chunks[1]);
+  EXPECT_EQ("first\nsecond\n", Output);
+}
+
+TEST(TaskQueue, RunsHundredsOfTasksInParallel) {
+  const unsigned NumTasks = 300;
+  std::vector<std::string> Messages;
+  std::vector<const char *> Args;
+  Messages.reserve(NumTasks);
+  for (unsigned i = 0; i < NumTasks; ++i)
+    Messages.push_back(std::to_string(i));
+  for (const std::string &Message : Messages)
+    Args.push_back(Message.c_str());
+
+  TaskQueue TQ(NumTasks);
+  for (uintptr_t i = 0; i < NumTasks; ++i)
+    TQ.addTask("/bin/echo", llvm::makeArrayRef(Args[i]), llvm::None,
+               toContext(i));
+
+  unsigned Running = 0;
+  unsigned MaxRunning = 0;
+  std::vector<bool> Seen(NumTasks);
+  auto taskBegan = [&](ProcessId, void *) {
+    MaxRunning = std::max(MaxRunning, ++Running);
+  };
+  auto taskFinished = [&](ProcessId, int ReturnCode, StringRef Output,
+                          Optional<TaskResourceUsage>,
+                          void *Context) -> TaskFinishedResponse {
+    --Running;
+    uintptr_t i = fromContext(Context);
+    EXPECT_EQ(0, ReturnCode);
+    EXPECT_EQ(Messages[i] + "\n", Output);
+    EXPECT_FALSE(Seen[i]);
+    Seen[i] = true;
+    return TaskFinishedResponse::ContinueExecution;
+  };
+  EXPECT_FALSE(TQ.execute(taskBegan, taskFinished));
+
+  EXPECT_EQ(NumTasks, MaxRunning);
+  EXPECT_EQ(NumTasks, unsigned(std::count(Seen.begin(), Seen.end(), true)));
+}
+
+TEST(TaskQueue, ReadsLargeOutputOfParallelTasks) {
+  // Each task writes much more than fits in a pipe, so neither can finish
+  // unless the other's output is read as it arrives too.
+  TaskQueue TQ(2);
+  const char *Args[] = { "-c", "head -c 1000000 /dev/zero" };
+  TQ.addTask("/bin/sh", Args, llvm::None, toContext(0));
+  TQ.addTask("/bin/sh", Args, llvm::None, toContext(1));
+
+  size_t Streamed[2] = { 0, 0 };
+  size_t Finished[2] = { 0, 0 };
+  auto taskFinished = [&](ProcessId, int ReturnCode, StringRef Output,
+                          Optional<TaskResourceUsage>,
+                          void *Context) -> TaskFinishedResponse {
+    EXPECT_EQ(0, ReturnCode);
+    Finished[fromContext(Context)] = Output.size();
+    EXPECT_EQ(StringRef::npos, Output.find_first_not_of('\0'));
+    return TaskFinishedResponse::ContinueExecution;
+  };
+  auto outputReceived = [&](ProcessId, StringRef Chunk, void *Context) {
+    Streamed[fromContext(Context)] += Chunk.size();
+  };
+  EXPECT_FALSE(TQ.execute(nullptr, taskFinished, nullptr, outputReceived));
+
+  for (unsigned i = 0; i < 2; ++i) {
+    EXPECT_EQ(1000000u, Finished[i]);
+    EXPECT_EQ(1000000u, Streamed[i]);
+  }
+}
+
+#endif
@@ -0,0 +1,239 @@
+#include "swift/Driver/BinaryDependencies.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+
+using namespace swift;
+using namespace swift::binary_deps;
+
+static std::string writeBinary(const DependencyFileWriter &writer) {
+  std::string result;
+  llvm::raw_string_ostream out(result);
+  writer.writeBinary(out);
+  return out.str();
+}
+
+static std::string writeYAML(const DependencyFileWriter &writer) {
+  std::string result;
+  llvm::raw_string_ostream out(result);
+  writer.writeYAML(out);
+  return out.str();
+}
+
+TEST(BinaryDependencies, Empty) {
+  DependencyFileWriter writer;
+  std::string data = writeBinary(writer);
+
+  EXPECT_TRUE(isBinaryDependencyFile(data));
+  EXPECT_FALSE(isBinaryBuildRecord(data));
+
+  auto file = DependencyFileView::get(data);
+  ASSERT_TRUE(file.hasValue());
+  EXPECT_EQ(0u, file->getNumEntries());
+  EXPECT_EQ("", file->getInterfaceHash());
+  EXPECT_FALSE(file->hasSection(Section::ProvidesTopLevel));
+}
+
+TEST(BinaryDependencies, RoundTrip) {
+  DependencyFileWriter writer;
+  writer.beginSection(Section::ProvidesTopLevel);
+  writer.addEntry(Section::ProvidesTopLevel, "a");
+  writer.addEntry(Section::ProvidesTopLevel, "b");
+  writer.addMemberEntry(Section::ProvidesMember, "V4main1S", "");
+  writer.addMemberEntry(Section::DependsMember, "V4main1S", "x",
+                        /*isCascading=*/false);
+  writer.addEntry(Section::DependsTopLevel, "a", /*isCascading=*/false);
+  writer.addEntry(Section::DependsExternal, "/foo/bar.swiftmodule");
+  writer.beginSection(Section::DependsDynamicLookup);
+  writer.setInterfaceHash("0123456789abcdef");
+
+  std::string data = writeBinary(writer);
+  auto file = DependencyFileView::get(data);
+  ASSERT_TRUE(file.hasValue());
+
+  EXPECT_EQ("0123456789abcdef", file->getInterfaceHash());
+  EXPECT_TRUE(file->hasSection(Section::ProvidesTopLevel));
+  EXPECT_TRUE(file->hasSection(Section::DependsDynamicLookup));
+  EXPECT_FALSE(file->hasSection(Section::ProvidesNominal));
+
+  ASSERT_EQ(6u, file->getNumEntries());
+
+  // Entries come back grouped by section.
+  EXPECT_EQ(Section::ProvidesTopLevel, file->getEntry(0).Kind);
+  EXPECT_EQ("a", file->getEntry(0).Name);
+  EXPECT_EQ("b", file->getEntry(1).Name);
+
+  EXPECT_EQ(Section::ProvidesMember, file->getEntry(2).Kind);
+  EXPECT_EQ(StringRef("V4main1S\0", 9), file->getEntry(2).Name);
+
+  EXPECT_EQ(Section::DependsTopLevel, file->getEntry(3).Kind);
+  EXPECT_EQ("a", file->getEntry(3).Name);
+  EXPECT_FALSE(file->getEntry(3).IsCascading);
+
+  EXPECT_EQ(Section::DependsMember, file->getEntry(4).Kind);
+  EXPECT_EQ(StringRef("V4main1S\0x", 10), file->getEntry(4).Name);
+  EXPECT_FALSE(file->getEntry(4).IsCascading);
+
+  EXPECT_EQ(Section::DependsExternal, file->getEntry(5).Kind);
+  EXPECT_TRUE(file->getEntry(5).IsCascading);
+
+  // Converting back to YAML gives the same text as writing YAML directly.
+  std::string printed;
+  llvm::raw_string_ostream out(printed);
+  file->printAsYAML(out);
+  EXPECT_EQ(writeYAML(writer), out.str());
+}
+
+TEST(BinaryDependencies, YAMLForm) {
+  DependencyFileWriter writer;
+  writer.beginSection(Section::ProvidesTopLevel);
+  writer.addEntry(Section::ProvidesTopLevel, "a\"b");
+  writer.addEntry(Section::DependsNominal, "V4main1S", /*isCascading=*/false);
+  writer.addMemberEntry(Section::DependsMember, "V4main1S", "x");
+  writer.setInterfaceHash("abc");
+
+  EXPECT_EQ("### Swift dependencies file v0 ###\n"
+            "provides-top-level:\n"
+            "- \"a\\\"b\"\n"
+            "depends-member:\n"
+            "- [\"V4main1S\", \"x\"]\n"
+            "depends-nominal:\n"
+            "- !private \"V4main1S\"\n"
+            "interface-hash: \"abc\"\n",
+            writeYAML(writer));
+}
+
+TEST(BinaryDependencies, Malformed) {
+  DependencyFileWriter writer;
+  writer.addEntry(Section::ProvidesTopLevel, "a");
+  std::string data = writeBinary(writer);
+
+  EXPECT_FALSE(DependencyFileView::get(StringRef(data).drop_back()));
+  EXPECT_FALSE(DependencyFileView::get(data + "x"));
+  EXPECT_FALSE(DependencyFileView::get("provides-top-level: [a]"));
+
+  // Corrupt the format version.
+  std::string badVersion = data;
+  badVersion[4] = 0x7f;
+  EXPECT_FALSE(DependencyFileView::get(badVersion));
+}
+
+TEST(BinaryDependencies, Fingerprints) {
+  DependencyFileWriter writer;
+  writer.addEntry(Section::ProvidesTopLevel, "a", true, "fa");
+  writer.addEntry(Section::ProvidesTopLevel, "b");
+  writer.addEntry(Section::ProvidesNominal, "V4main1S", true, "fs");
+  writer.addMemberEntry(Section::ProvidesMember, "V4main1S", "x", true, "fx");
+  writer.addEntry(Section::DependsTopLevel, "a");
+  writer.setInterfaceHash("abc");
+
+  std::string data = writeBinary(writer);
+  auto file = DependencyFileView::get(data);
+  ASSERT_TRUE(file.hasValue());
+  ASSERT_EQ(5u, file->getNumEntries());
+
+  EXPECT_EQ("fa", file->getEntry(0).Fingerprint);
+  EXPECT_EQ("", file->getEntry(1).Fingerprint);
+  EXPECT_EQ("fs", file->getEntry(2).Fingerprint);
+  EXPECT_EQ("fx", file->getEntry(3).Fingerprint);
+  EXPECT_EQ("", file->getEntry(4).Fingerprint);
+
+  // The entries themselves are listed as usual; fingerprints come afterwards,
+  // one line per section.
+  EXPECT_EQ("### Swift dependencies file v0 ###\n"
+            "provides-top-level:\n"
+            "- \"a\"\n"
+            "- \"b\"\n"
+            "provides-nominal:\n"
+            "- \"V4main1S\"\n"
+            "provides-member:\n"
+            "- [\"V4main1S\", \"x\"]\n"
+            "depends-top-level:\n"
+            "- \"a\"\n"
+            "fingerprints-top-level: [[\"a\", \"fa\"]]\n"
+            "fingerprints-nominal: [[\"V4main1S\", \"fs\"]]\n"
+            "fingerprints-member: [[\"V4main1S\", \"x\", \"fx\"]]\n"
+            "interface-hash: \"abc\"\n",
+            writeYAML(writer));
+
+  std::string printed;
+  llvm::raw_string_ostream out(printed);
+  file->printAsYAML(out);
+  EXPECT_EQ(writeYAML(writer), out.str());
+}
+
+TEST(BinaryDependencies, FingerprintOnDependsEntry) {
+  DependencyFileWriter writer;
+  writer.addEntry(Section::DependsTopLevel, "a");
+  std::string data = writeBinary(writer);
+  ASSERT_TRUE(DependencyFileView::get(data).hasValue());
+
+  // Point the record's fingerprint at the only string, "a". The header, info
+  // block, and single string entry take up the first 40 bytes.
+  const size_t fingerprintOffset = 40 + 8;
+  data[fingerprintOffset] = 0;
+  data[fingerprintOffset + 1] = 0;
+  data[fingerprintOffset + 2] = 0;
+  data[fingerprintOffset + 3] = 0;
+  EXPECT_FALSE(DependencyFileView::get(data));
+}
+
+TEST(BinaryDependencies, BuildRecord) {
+  llvm::sys::TimeValue buildTime(1000, 20);
+  driver::FileStamp mainStamp;
+  mainStamp.ModTime = llvm::sys::TimeValue(900, 10);
+  mainStamp.Size = 123;
+  mainStamp.Device = 4;
+  mainStamp.Inode = 56;
+  ASSERT_FALSE(mainStamp.setHashString("000102030405060708090a0b0c0d0e0f"));
+  driver::FileStamp otherStamp;
+  otherStamp.ModTime = buildTime;
+  BuildRecordInput inputs[] = {
+    { "./main.swift", InputStatus::UpToDate, mainStamp, 1500 },
+    { "./other.swift", InputStatus::NeedsNonCascadingBuild, otherStamp, 0 },
+  };
+
+  std::string data;
+  llvm::raw_string_ostream out(data);
+  writeBuildRecord(out, "Swift version 3.0", "abcdef", buildTime, inputs);
+  out.flush();
+
+  EXPECT_TRUE(isBinaryBuildRecord(data));
+  EXPECT_FALSE(isBinaryDependencyFile(data));
+  EXPECT_FALSE(DependencyFileView::get(data));
+
+  auto record = BuildRecordView::get(data);
+  ASSERT_TRUE(record.hasValue());
+  EXPECT_EQ("Swift version 3.0", record->getVersion());
+  EXPECT_EQ("abcdef", record->getOptions());
+  EXPECT_EQ(buildTime, record->getBuildTime());
+
+  ASSERT_EQ(2u, record->getNumInputs());
+  EXPECT_EQ("./main.swift", record->getInput(0).Path);
+  EXPECT_EQ(InputStatus::UpToDate, record->getInput(0).Status);
+  driver::FileStamp readStamp = record->getInput(0).PreviousStamp;
+  EXPECT_TRUE(readStamp.hasSameAttributes(mainStamp));
+  EXPECT_TRUE(readStamp.hasSameHash(mainStamp));
+  EXPECT_EQ(1500u, record->getInput(0).PreviousDuration);
+  EXPECT_EQ("./other.swift", record->getInput(1).Path);
+  EXPECT_EQ(InputStatus::NeedsNonCascadingBuild, record->getInput(1).Status);
+  EXPECT_EQ(buildTime, record->getInput(1).PreviousStamp.ModTime);
+  EXPECT_FALSE(record->getInput(1).PreviousStamp.hasHash());
+  EXPECT_EQ(0u, record->getInput(1).PreviousDuration);
+
+  std::string printed;
+  llvm::raw_string_ostream printedOut(printed);
+  record->printAsYAML(printedOut);
+  EXPECT_EQ("version: \"Swift version 3.0\"\n"
+            "options: \"abcdef\"\n"
+            "build_time: [1000, 20]\n"
+            "inputs:\n"
+            "  \"./main.swift\": [900, 10]\n"
+            "  \"./other.swift\": !private [1000, 20]\n"
+            "stamps:\n"
+            "  \"./main.swift\": [123, 4, 56, "
+              "\"000102030405060708090a0b0c0d0e0f\"]\n"
+            "  \"./other.swift\": [0, 0, 0]\n"
+            "durations:\n"
+            "  \"./main.swift\": 1500\n",
+            printedOut.str());
+}
@@ -1,4 +1,6 @@
 #include "swift/Driver/DependencyGraph.h"
+#include "swift/Driver/BinaryDependencies.h"
+#include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
 
 using namespace swift;
@@ -790,3 +792,235 @@ TEST(DependencyGraph, ChainedExternalPreMarked) {
   EXPECT_TRUE(graph.isMarked(0));
   EXPECT_FALSE(graph.isMarked(1));
 }
+
+using DepsWriter = binary_deps::DependencyFileWriter;
+
+static std::string toBinary(llvm::function_ref<void(DepsWriter &)> fill) {
+  DepsWriter writer;
+  fill(writer);
+  std::string result;
+  llvm::raw_string_ostream out(result);
+  writer.writeBinary(out);
+  return out.str();
+}
+
+TEST(DependencyGraph, BinaryChained) {
+  using binary_deps::Section;
+  DependencyGraph<uintptr_t> graph;
+
+  EXPECT_EQ(graph.loadFromString(0, toBinary([](DepsWriter &W) {
+    W.addEntry(Section::ProvidesTopLevel, "a");
+  })), LoadResult::UpToDate);
+  EXPECT_EQ(graph.loadFromString(1, toBinary([](DepsWriter &W) {
+    W.addEntry(Section::ProvidesNominal, "b");
+    W.addEntry(Section::DependsTopLevel, "a");
+  })), LoadResult::UpToDate);
+  EXPECT_EQ(graph.loadFromString(2, toBinary([](DepsWriter &W) {
+    W.addEntry(Section::DependsNominal, "b", /*isCascading=*/false);
+  })), LoadResult::UpToDate);
+  EXPECT_EQ(graph.loadFromString(3, toBinary([](DepsWriter &W) {
+    W.addEntry(Section::DependsNominal, "b");
+  })), LoadResult::UpToDate);
+
+  SmallVector<uintptr_t, 4> marked;
+  graph.markTransitive(marked, 0);
+  EXPECT_EQ(3u, marked.size());
+  EXPECT_TRUE(graph.isMarked(0));
+  EXPECT_TRUE(graph.isMarked(1));
+  EXPECT_FALSE(graph.isMarked(2));
+  EXPECT_TRUE(graph.isMarked(3));
+}
+
+TEST(DependencyGraph, BinaryMembersMatchYAML) {
+  using binary_deps::Section;
+  DependencyGraph<uintptr_t> graph;
+
+  EXPECT_EQ(graph.loadFromString(0, "provides-member: [[a,aa]]"),
+            LoadResult::UpToDate);
+  EXPECT_EQ(graph.loadFromString(1, toBinary([](DepsWriter &W) {
+    W.addMemberEntry(Section::DependsMember, "a", "aa");
+  })), LoadResult::UpToDate);
+  EXPECT_EQ(graph.loadFromString(2, toBinary([](DepsWriter &W) {
+    W.addMemberEntry(Section::DependsMember, "a", "bb");
+  })), LoadResult::UpToDate);
+
+  SmallVector<uintptr_t, 4> marked;
+  graph.markTransitive(marked, 0);
+  EXPECT_EQ(1u, marked.size());
+  EXPECT_EQ(1u, marked.front());
+  EXPECT_FALSE(graph.isMarked(2));
+}
+
+TEST(DependencyGraph, BinaryInterfaceHash) {
+  DependencyGraph<uintptr_t> graph;
+
+  auto withHash = [](StringRef hash) {
+    return toBinary([hash](DepsWriter &W) {
+      W.setInterfaceHash(hash);
+    });
+  };
+
+  EXPECT_EQ(graph.loadFromString(0, withHash("abc")), LoadResult::UpToDate);
+  EXPECT_EQ(graph.loadFromString(0, withHash("abc")), LoadResult::UpToDate);
+  EXPECT_EQ(graph.loadFromString(0, withHash("def")),
+            LoadResult::AffectsDownstream);
+}
+
+TEST(DependencyGraph, BinaryMalformed) {
+  using binary_deps::Section;
+  DependencyGraph<uintptr_t> graph;
+
+  std::string data = toBinary([](DepsWriter &W) {
+    W.addEntry(Section::ProvidesTopLevel, "a");
+    W.addEntry(Section::DependsExternal, "/foo");
+  });
+  EXPECT_EQ(graph.loadFromString(0, StringRef(data).drop_back()),
+            LoadResult::HadError);
+}
+
+TEST(DependencyGraph, UnchangedFingerprints) {
+  DependencyGraph<uintptr_t> graph;
+
+  EXPECT_EQ(graph.loadFromString(0,
+                                 "provides-top-level: [a, b]\n"
+                                 "fingerprints-top-level: [[a, a1], [b, b1]]\n"
+                                 "interface-hash: \"before\""),
+            LoadResult::UpToDate);
+  EXPECT_EQ(graph.loadFromString(1, "depends-top-level: [a]"),
+            LoadResult::UpToDate);
+  EXPECT_EQ(graph.loadFromString(2, "depends-top-level: [b]"),
+            LoadResult::UpToDate);
+
+  EXPECT_EQ(graph.loadFromString(0,
+                                 "provides-top-level: [a, b]\n"
+                                 "fingerprints-top-level: [[a, a1], [b, b2]]\n"
+                                 "interface-hash: \"after\""),
+            LoadResult::AffectsDownstream);
+
+  SmallVector<uintptr_t, 4> marked;
+  graph.markTransitiveFromChangedProvides(marked, 0);
+  EXPECT_EQ(1u, marked.size());
+  EXPECT_EQ(2u, marked.front());
+  EXPECT_FALSE(graph.isMarked(1));
+  EXPECT_TRUE(graph.isMarked(2));
+}
+
+TEST(DependencyGraph, MissingFingerprints) {
+  DependencyGraph<uintptr_t> graph;
+
+  EXPECT_EQ(graph.loadFromString(0,
+                                 "provides-top-level: [a, b]\n"
+                                 "fingerprints-top-level: [[a, a1]]\n"
+                                 "interface-hash: \"before\""),
+            LoadResult::UpToDate);
+  EXPECT_EQ(graph.loadFromString(1, "depends-top-level: [a]"),
+            LoadResult::UpToDate);
+  EXPECT_EQ(graph.loadFromString(2, "depends-top-level: [b]"),
+            LoadResult::UpToDate);
+
+  // "a" lost its fingerprint, and "b" never had one, so both have to be
+  // treated as changed.
+  EXPECT_EQ(graph.loadFromString(0,
+                                 "provides-top-level: [a, b]\n"
+                                 "interface-hash: \"after\""),
+            LoadResult::AffectsDownstream);
+
+  SmallVector<uintptr_t, 4> marked;
+  graph.markTransitiveFromChangedProvides(marked, 0);
+  EXPECT_EQ(2u, marked.size());
+  EXPECT_TRUE(graph.isMarked(1));
+  EXPECT_TRUE(graph.isMarked(2));
+}
+
+TEST(DependencyGraph, MarkTransitiveIgnoresFingerprints) {
+  DependencyGraph<uintptr_t> graph;
+
+  EXPECT_EQ(graph.loadFromString(0,
+                                 "provides-nominal: [a]\n"
+                                 "fingerprints-nominal: [[a, a1]]\n"
+                                 "interface-hash: \"before\""),
+            LoadResult::UpToDate);
+  EXPECT_EQ(graph.loadFromString(1,
+                                 "depends-nominal: [a]\n"
+                                 "provides-top-level: [b]\n"
+                                 "fingerprints-top-level: [[b, b1]]"),
+            LoadResult::UpToDate);
+  EXPECT_EQ(graph.loadFromString(2, "depends-top-level: [b]"),
+            LoadResult::UpToDate);
+
+  EXPECT_EQ(graph.loadFromString(0,
+                                 "provides-nominal: [a]\n"
+                                 "fingerprints-nominal: [[a, a1]]\n"
+                                 "interface-hash: \"after\""),
+            LoadResult::AffectsDownstream);
+
+  // The fingerprint of "a" didn't change, but the caller didn't ask for
+  // fingerprints to be checked.
+  SmallVector<uintptr_t, 4> marked;
+  graph.markTransitive(marked, 0);
+  EXPECT_EQ(2u, marked.size());
+  EXPECT_TRUE(graph.isMarked(1));
+  EXPECT_TRUE(graph.isMarked(2));
+}
+
+TEST(DependencyGraph, FingerprintsDoNotPropagate) {
+  DependencyGraph<uintptr_t> graph;
+
+  EXPECT_EQ(graph.loadFromString(0,
+                                 "provides-nominal: [a]\n"
+                                 "fingerprints-nominal: [[a, a1]]\n"
+                                 "interface-hash: \"before\""),
+            LoadResult::UpToDate);
+  EXPECT_EQ(graph.loadFromString(1,
+                                 "depends-nominal: [a]\n"
+                                 "provides-top-level: [b]\n"
+                                 "fingerprints-top-level: [[b, b1]]"),
+            LoadResult::UpToDate);
+  EXPECT_EQ(graph.loadFromString(2, "depends-top-level: [b]"),
+            LoadResult::UpToDate);
+
+  EXPECT_EQ(graph.loadFromString(0,
+                                 "provides-nominal: [a]\n"
+                                 "fingerprints-nominal: [[a, a2]]\n"
+                                 "interface-hash: \"after\""),
+            LoadResult::AffectsDownstream);
+
+  // Fingerprints are only consulted for the node the walk starts from: "b" is
+  // unchanged, but its users are still marked because the meaning of "b" may
+  // depend on "a".
+  SmallVector<uintptr_t, 4> marked;
+  graph.markTransitiveFromChangedProvides(marked, 0);
+  EXPECT_EQ(2u, marked.size());
+  EXPECT_TRUE(graph.isMarked(1));
+  EXPECT_TRUE(graph.isMarked(2));
+}
+
+TEST(DependencyGraph, BinaryFingerprints) {
+  using binary_deps::Section;
+  DependencyGraph<uintptr_t> graph;
+
+  auto provider = [](StringRef fingerprint, StringRef hash) {
+    return toBinary([=](DepsWriter &W) {
+      W.addEntry(Section::ProvidesTopLevel, "a", true, "a1");
+      W.addMemberEntry(Section::ProvidesMember, "S", "x", true, fingerprint);
+      W.setInterfaceHash(hash);
+    });
+  };
+
+  EXPECT_EQ(graph.loadFromString(0, provider("x1", "before")),
+            LoadResult::UpToDate);
+  EXPECT_EQ(graph.loadFromString(1, toBinary([](DepsWriter &W) {
+    W.addEntry(Section::DependsTopLevel, "a");
+  })), LoadResult::UpToDate);
+  EXPECT_EQ(graph.loadFromString(2, toBinary([](DepsWriter &W) {
+    W.addMemberEntry(Section::DependsMember, "S", "x");
+  })), LoadResult::UpToDate);
+
+  EXPECT_EQ(graph.loadFromString(0, provider("x2", "after")),
+            LoadResult::AffectsDownstream);
+
+  SmallVector<uintptr_t, 4> marked;
+  graph.markTransitiveFromChangedProvides(marked, 0);
+  EXPECT_EQ(1u, marked.size());
+  EXPECT_EQ(2u, marked.front());
+}
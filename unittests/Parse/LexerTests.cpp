@@ -111,6 +111,39 @@ TEST_F(LexerTest, StringLiteralWithNUL1) {
   EXPECT_EQ(Toks[1].getLength(), 0U);
 }
 
+TEST_F(LexerTest, LongTokens) {
+  // Long enough that the lexer steps over most of each token in blocks.
+  const char *Source =
+      "// A line comment that goes on for a while, with \xC3\xA9 in it\n"
+      "/* A block comment /* with a nested comment that is also long */ and\n"
+      "   more text after it, ending with several stars ***/\n"
+      "let anIdentifierWithManyCharacters_$0123456789\xC3\xA9xyzXYZ =\n"
+      "  \"A string literal with \\\"escapes\\\" and \\(interpolation) in it\"\n"
+      "\t \t                                                        ;";
+  std::vector<tok> ExpectedTokens{
+    tok::comment, tok::comment, tok::kw_let, tok::identifier, tok::equal,
+    tok::string_literal, tok::semi
+  };
+  std::vector<Token> Toks = checkLex(Source, ExpectedTokens,
+                                     /*KeepComments=*/true);
+  EXPECT_EQ("/* A block comment /* with a nested comment that is also long */ "
+            "and\n   more text after it, ending with several stars ***/",
+            Toks[1].getText());
+  EXPECT_EQ("anIdentifierWithManyCharacters_$0123456789\xC3\xA9xyzXYZ",
+            Toks[3].getText());
+  EXPECT_EQ(62U, Toks[5].getLength());
+}
+
+TEST_F(LexerTest, LongUnterminatedComment) {
+  const char *Source =
+      "/* This comment is never closed; / and * on their own are fine.";
+  std::vector<tok> ExpectedTokens{ tok::comment, tok::eof };
+  std::vector<Token> Toks = checkLex(Source, ExpectedTokens,
+                                     /*KeepComments=*/true,
+                                     /*KeepEOF=*/true);
+  EXPECT_EQ(StringRef(Source).size(), Toks[0].getLength());
+}
+
 TEST_F(LexerTest, RestoreBasic) {
   const char *Source = "aaa \t\0 bbb ccc";
 
@@ -0,0 +1,82 @@
+//===--- TypeRefTest.cpp - for TypeRef.h and TypeRefBuilder.h -------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/Reflection/TypeRefBuilder.h"
+#include "gtest/gtest.h"
+
+using namespace swift;
+using namespace reflection;
+
+TEST(TypeRef, IsConcrete) {
+  TypeRefBuilder Builder;
+  auto Int = Builder.createNominalType("Si");
+  auto T = Builder.createGenericTypeParameterType(0, 0);
+
+  EXPECT_TRUE(Int->isConcrete());
+  EXPECT_FALSE(T->isConcrete());
+  EXPECT_TRUE(Builder.createTupleType({Int, Int})->isConcrete());
+  EXPECT_FALSE(Builder.createTupleType({Int, T})->isConcrete());
+  EXPECT_FALSE(Builder.createMetatypeType(T)->isConcrete());
+}
+
+TEST(TypeRef, NullChildrenAreNotConcrete) {
+  // The decoder leaves a null child for a part of a type it can't decode.
+  TypeRefBuilder Builder;
+  auto Int = Builder.createNominalType("Si");
+
+  auto Function = Builder.createFunctionType(nullptr, Int);
+  EXPECT_FALSE(Function->isConcrete());
+
+  auto Tuple = Builder.createTupleType({Int, nullptr});
+  EXPECT_FALSE(Tuple->isConcrete());
+
+  auto Metatype = Builder.createMetatypeType(nullptr);
+  EXPECT_FALSE(Metatype->isConcrete());
+
+  auto Generic = Builder.createBoundGenericType("Sq", {nullptr});
+  EXPECT_FALSE(Generic->isConcrete());
+}
+
+TEST(TypeRef, SubstituteWithNullChildren) {
+  TypeRefBuilder Builder;
+  auto Int = Builder.createNominalType("Si");
+  auto T = Builder.createGenericTypeParameterType(0, 0);
+
+  GenericArgumentMap Subs;
+  Subs[{0, 0}] = Int;
+
+  auto Function = Builder.createFunctionType(T, nullptr);
+  auto Subst = Function->subst(Builder, Subs);
+  EXPECT_EQ(Builder.createFunctionType(Int, nullptr), Subst);
+
+  auto Tuple = Builder.createTupleType({nullptr, T});
+  EXPECT_EQ(Builder.createTupleType({nullptr, Int}),
+            Tuple->subst(Builder, Subs));
+}
+
+TEST(TypeRef, SubstitutedMetatypesRememberTheyWereAbstract) {
+  // A stored 'T.Type' is thick even when T is bound to a struct.
+  TypeRefBuilder Builder;
+  auto Int = Builder.createNominalType("Si");
+  auto T = Builder.createGenericTypeParameterType(0, 0);
+
+  GenericArgumentMap Subs;
+  Subs[{0, 0}] = Int;
+
+  auto Subst = Builder.createMetatypeType(T)->subst(Builder, Subs);
+  EXPECT_EQ(Builder.createMetatypeType(Int, /*WasAbstract=*/true), Subst);
+  EXPECT_NE(Builder.createMetatypeType(Int), Subst);
+
+  // Concrete metatypes are left alone.
+  auto IntMetatype = Builder.createMetatypeType(Int);
+  EXPECT_EQ(IntMetatype, IntMetatype->subst(Builder, Subs));
+}
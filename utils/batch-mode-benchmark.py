@@ -0,0 +1,104 @@
+#!/usr/bin/env python
+# utils/batch-mode-benchmark.py - Compare batch-mode build times -*- python -*-
+#
+# This source file is part of the Swift.org open source project
+#
+# Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+# Licensed under Apache License v2.0 with Runtime Library Exception
+#
+# See http://swift.org/LICENSE.txt for license information
+# See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+
+# Generates a synthetic multi-file module in which every file refers to
+# declarations from a few of the others, then times a clean build of it with
+# one frontend invocation per file and with -enable-batch-mode.
+
+from __future__ import print_function
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+
+def generate_module(directory, num_files, decls_per_file):
+    paths = []
+    for i in range(num_files):
+        path = os.path.join(directory, "file%d.swift" % i)
+        with open(path, "w") as f:
+            for j in range(decls_per_file):
+                f.write("public struct S%d_%d {\n" % (i, j))
+                f.write("  public var value: Int\n")
+                f.write("  public init(value: Int) { self.value = value }\n")
+                f.write("  public func next() -> Int {\n")
+                f.write("    return value &+ %d\n" % j)
+                f.write("  }\n")
+                f.write("}\n\n")
+            # Use a few declarations from the preceding files so that each
+            # frontend job has to type-check more than its own primary file.
+            f.write("public func use%d() -> Int {\n" % i)
+            f.write("  var total = 0\n")
+            for k in range(max(0, i - 3), i):
+                f.write("  total = total &+ S%d_0(value: %d).next()\n" % (k, i))
+            f.write("  return total\n")
+            f.write("}\n")
+        paths.append(path)
+    return paths
+
+
+def time_build(swiftc, sources, build_dir, jobs, extra_args):
+    if os.path.exists(build_dir):
+        shutil.rmtree(build_dir)
+    os.makedirs(build_dir)
+    command = [swiftc, "-c", "-module-name", "Synthetic",
+               "-j%d" % jobs] + extra_args + sources
+    start = time.time()
+    subprocess.check_call(command, cwd=build_dir)
+    return time.time() - start
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Compare the build time of a synthetic module with and "
+                    "without -enable-batch-mode.")
+    parser.add_argument("--swiftc", default="swiftc",
+                        help="the swiftc driver to benchmark")
+    parser.add_argument("--files", type=int, default=100,
+                        help="the number of source files to generate")
+    parser.add_argument("--decls-per-file", type=int, default=20,
+                        help="the number of structs in each source file")
+    parser.add_argument("-j", "--jobs", type=int, default=4,
+                        help="the number of parallel frontend jobs")
+    parser.add_argument("--iterations", type=int, default=3,
+                        help="the number of builds to time in each mode")
+    args = parser.parse_args()
+
+    work_dir = tempfile.mkdtemp(prefix="batch-mode-benchmark-")
+    try:
+        source_dir = os.path.join(work_dir, "src")
+        os.makedirs(source_dir)
+        sources = generate_module(source_dir, args.files, args.decls_per_file)
+
+        modes = [("per-file", ["-disable-batch-mode"]),
+                 ("batch", ["-enable-batch-mode"])]
+        results = {}
+        for name, extra_args in modes:
+            build_dir = os.path.join(work_dir, "build-" + name)
+            times = [time_build(args.swiftc, sources, build_dir, args.jobs,
+                                extra_args)
+                     for _ in range(args.iterations)]
+            results[name] = min(times)
+            print("%-10s best of %d: %.2fs" % (name, args.iterations,
+                                                results[name]))
+
+        print("speedup: %.2fx" % (results["per-file"] / results["batch"]))
+    finally:
+        shutil.rmtree(work_dir)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
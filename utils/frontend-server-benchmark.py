@@ -0,0 +1,114 @@
+#!/usr/bin/env python
+# utils/frontend-server-benchmark.py - Time frontend server jobs -*- python -*-
+#
+# This source file is part of the Swift.org open source project
+#
+# Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+# Licensed under Apache License v2.0 with Runtime Library Exception
+#
+# See http://swift.org/LICENSE.txt for license information
+# See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+
+# Generates a module of trivial source files, then times a clean build of it
+# with each frontend job spawned as a new process, and with each job sent to a
+# frontend server that has already loaded the standard library. With small
+# files most of a job's time is spent setting up, so the difference per job is
+# roughly the setup time the server saves.
+
+from __future__ import print_function
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+
+def generate_module(directory, num_files):
+    paths = []
+    for i in range(num_files):
+        path = os.path.join(directory, "file%d.swift" % i)
+        with open(path, "w") as f:
+            f.write("public func f%d(_ x: Int) -> Int {\n" % i)
+            f.write("  return x &+ %d\n" % i)
+            f.write("}\n")
+        paths.append(path)
+    return paths
+
+
+def time_build(swiftc, sources, build_dir, jobs, extra_args):
+    if os.path.exists(build_dir):
+        shutil.rmtree(build_dir)
+    os.makedirs(build_dir)
+    command = [swiftc, "-c", "-module-name", "Trivial",
+               "-j%d" % jobs] + extra_args + sources
+    start = time.time()
+    subprocess.check_call(command, cwd=build_dir)
+    return time.time() - start
+
+
+def start_server(swiftc, socket_path):
+    server = subprocess.Popen([swiftc, "-frontend-server", socket_path,
+                               "-idle-timeout", "60"])
+    deadline = time.time() + 10
+    while not os.path.exists(socket_path):
+        if server.poll() is not None or time.time() > deadline:
+            raise RuntimeError("the frontend server did not start")
+        time.sleep(0.05)
+    return server
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Compare the time taken by trivial frontend jobs when "
+                    "spawned as processes and when run by the frontend "
+                    "server.")
+    parser.add_argument("--swiftc", default="swiftc",
+                        help="the swiftc driver to benchmark")
+    parser.add_argument("--files", type=int, default=50,
+                        help="the number of source files to generate")
+    parser.add_argument("-j", "--jobs", type=int, default=1,
+                        help="the number of parallel frontend jobs")
+    parser.add_argument("--iterations", type=int, default=3,
+                        help="the number of builds to time in each mode")
+    args = parser.parse_args()
+
+    work_dir = tempfile.mkdtemp(prefix="frontend-server-benchmark-")
+    server = None
+    try:
+        source_dir = os.path.join(work_dir, "src")
+        os.makedirs(source_dir)
+        sources = generate_module(source_dir, args.files)
+
+        socket_path = os.path.join(work_dir, "server.sock")
+        server = start_server(args.swiftc, socket_path)
+
+        modes = [("spawned", []),
+                 ("server", ["-driver-use-frontend-server", socket_path])]
+        results = {}
+        for name, extra_args in modes:
+            build_dir = os.path.join(work_dir, "build-" + name)
+            # The first build prepares the server's instance, as the first
+            # build of a session would; it isn't counted.
+            time_build(args.swiftc, sources, build_dir, args.jobs, extra_args)
+            times = [time_build(args.swiftc, sources, build_dir, args.jobs,
+                                extra_args)
+                     for _ in range(args.iterations)]
+            results[name] = min(times)
+            print("%-8s best of %d: %.2fs (%.1fms per job)" % (
+                name, args.iterations, results[name],
+                1000 * results[name] / args.files))
+
+        print("speedup: %.2fx" % (results["spawned"] / results["server"]))
+    finally:
+        if server is not None:
+            server.terminate()
+            server.wait()
+        shutil.rmtree(work_dir)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
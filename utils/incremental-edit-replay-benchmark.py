@@ -0,0 +1,161 @@
+#!/usr/bin/env python
+# utils/incremental-edit-replay-benchmark.py - Replay edits -*- python -*-
+#
+# This source file is part of the Swift.org open source project
+#
+# Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+# Licensed under Apache License v2.0 with Runtime Library Exception
+#
+# See http://swift.org/LICENSE.txt for license information
+# See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+
+# Generates a synthetic multi-file module, builds it incrementally once, and
+# then replays a series of edits that each change the signature of one
+# function. After every edit it counts the frontend jobs the driver runs, as
+# reported by -driver-show-incremental. This is done once with the default
+# per-declaration fingerprints and once with -driver-ignore-fingerprints, in
+# which case every file that uses anything from the edited file is rebuilt.
+
+from __future__ import print_function
+
+import argparse
+import json
+import os
+import random
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+
+def file_contents(i, decls_per_file, num_files, edited_decl):
+    lines = []
+    for j in range(decls_per_file):
+        # The edited function gets an extra parameter.
+        if j == edited_decl:
+            lines.append("public func f%d_%d(_ x: Int, _ y: Int = 0) -> Int {"
+                         % (i, j))
+        else:
+            lines.append("public func f%d_%d(_ x: Int) -> Int {" % (i, j))
+        lines.append("  return x &+ %d" % j)
+        lines.append("}")
+        lines.append("")
+    # Each file uses one function from each of a few of the others, so that
+    # the files using any particular declaration are a small subset of the
+    # files depending on its file.
+    lines.append("public func use%d() -> Int {" % i)
+    lines.append("  var total = 0")
+    for k in range(1, 6):
+        other = (i + k) % num_files
+        lines.append("  total = total &+ f%d_%d(%d)"
+                     % (other, (i + k) % decls_per_file, i))
+    lines.append("  return total")
+    lines.append("}")
+    return "\n".join(lines) + "\n"
+
+
+def write_file(directory, i, decls_per_file, num_files, edited_decl=None):
+    path = os.path.join(directory, "file%d.swift" % i)
+    with open(path, "w") as f:
+        f.write(file_contents(i, decls_per_file, num_files, edited_decl))
+    return path
+
+
+def write_output_file_map(build_dir, sources):
+    output_map = {"": {"swift-dependencies":
+                       os.path.join(build_dir, "main~buildrecord.swiftdeps")}}
+    for source in sources:
+        base = os.path.join(build_dir,
+                            os.path.splitext(os.path.basename(source))[0])
+        output_map[source] = {
+            "object": base + ".o",
+            "swift-dependencies": base + ".swiftdeps",
+        }
+    path = os.path.join(build_dir, "output.json")
+    with open(path, "w") as f:
+        json.dump(output_map, f, indent=2)
+    return path
+
+
+def build(swiftc, sources, build_dir, output_map, jobs, extra_args):
+    command = [swiftc, "-c", "-incremental", "-driver-show-incremental",
+               "-module-name", "Synthetic", "-output-file-map", output_map,
+               "-j%d" % jobs] + extra_args + sources
+    output = subprocess.check_output(command, cwd=build_dir,
+                                     stderr=subprocess.STDOUT)
+    return len([line for line in output.decode("utf-8").splitlines()
+                if line.startswith("Queuing")])
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Count the frontend jobs run after a series of signature "
+                    "edits to a synthetic module, with and without "
+                    "per-declaration fingerprints.")
+    parser.add_argument("--swiftc", default="swiftc",
+                        help="the swiftc driver to benchmark")
+    parser.add_argument("--files", type=int, default=100,
+                        help="the number of source files to generate")
+    parser.add_argument("--decls-per-file", type=int, default=20,
+                        help="the number of functions in each source file")
+    parser.add_argument("-j", "--jobs", type=int, default=8,
+                        help="the number of parallel frontend jobs")
+    parser.add_argument("--edits", type=int, default=20,
+                        help="the number of edits to replay in each mode")
+    parser.add_argument("--seed", type=int, default=0,
+                        help="the seed used to choose which functions to edit")
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    edits = [(rng.randrange(args.files), rng.randrange(args.decls_per_file))
+             for _ in range(args.edits)]
+
+    work_dir = tempfile.mkdtemp(prefix="incremental-edit-replay-benchmark-")
+    try:
+        modes = [("fingerprints", []),
+                 ("no-fingerprints", ["-driver-ignore-fingerprints"])]
+        results = {}
+        for name, extra_args in modes:
+            source_dir = os.path.join(work_dir, "src-" + name)
+            build_dir = os.path.join(work_dir, "build-" + name)
+            os.makedirs(source_dir)
+            os.makedirs(build_dir)
+            sources = [write_file(source_dir, i, args.decls_per_file,
+                                  args.files)
+                       for i in range(args.files)]
+            output_map = write_output_file_map(build_dir, sources)
+
+            build(args.swiftc, sources, build_dir, output_map, args.jobs,
+                  extra_args)
+
+            total_jobs = 0
+            start = time.time()
+            for file_index, decl_index in edits:
+                # Make sure the edited file looks newer than the build record.
+                time.sleep(1)
+                write_file(source_dir, file_index, args.decls_per_file,
+                           args.files, decl_index)
+                total_jobs += build(args.swiftc, sources, build_dir,
+                                    output_map, args.jobs, extra_args)
+                write_file(source_dir, file_index, args.decls_per_file,
+                           args.files)
+                time.sleep(1)
+                total_jobs += build(args.swiftc, sources, build_dir,
+                                    output_map, args.jobs, extra_args)
+            elapsed = time.time() - start
+
+            results[name] = total_jobs
+            print("%-16s %d edits: %d jobs, %.2fs including pauses" %
+                  (name, 2 * len(edits), total_jobs, elapsed))
+
+        print("jobs saved: %.1f%%" %
+              (100.0 * (1 - float(results["fingerprints"]) /
+                        max(1, results["no-fingerprints"]))))
+    finally:
+        shutil.rmtree(work_dir)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,123 @@
+#!/usr/bin/env python
+# utils/incremental-noop-benchmark.py - Time no-op builds -*- python -*-
+#
+# This source file is part of the Swift.org open source project
+#
+# Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+# Licensed under Apache License v2.0 with Runtime Library Exception
+#
+# See http://swift.org/LICENSE.txt for license information
+# See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+
+# Generates a synthetic multi-file module, builds it incrementally once, and
+# then times no-op rebuilds, in which the driver only has to load the build
+# record and every .swiftdeps file before deciding that nothing needs to run.
+# This is done once with the YAML dependency files and once with
+# -enable-binary-dependencies.
+
+from __future__ import print_function
+
+import argparse
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+
+def generate_module(directory, num_files, decls_per_file):
+    paths = []
+    for i in range(num_files):
+        path = os.path.join(directory, "file%d.swift" % i)
+        with open(path, "w") as f:
+            for j in range(decls_per_file):
+                f.write("public struct S%d_%d {\n" % (i, j))
+                f.write("  public var value: Int\n")
+                f.write("  public func next() -> Int { return value + %d }\n"
+                        % j)
+                f.write("}\n\n")
+            f.write("public func use%d() -> Int {\n" % i)
+            f.write("  var total = 0\n")
+            for k in range(max(0, i - 5), i):
+                f.write("  total += S%d_0(value: %d).next()\n" % (k, i))
+            f.write("  return total\n")
+            f.write("}\n")
+        paths.append(path)
+    return paths
+
+
+def write_output_file_map(build_dir, sources):
+    output_map = {"": {"swift-dependencies":
+                       os.path.join(build_dir, "main~buildrecord.swiftdeps")}}
+    for source in sources:
+        base = os.path.join(build_dir,
+                            os.path.splitext(os.path.basename(source))[0])
+        output_map[source] = {
+            "object": base + ".o",
+            "swift-dependencies": base + ".swiftdeps",
+        }
+    path = os.path.join(build_dir, "output.json")
+    with open(path, "w") as f:
+        json.dump(output_map, f, indent=2)
+    return path
+
+
+def build(swiftc, sources, build_dir, output_map, jobs, extra_args):
+    command = [swiftc, "-c", "-incremental", "-module-name", "Synthetic",
+               "-output-file-map", output_map,
+               "-j%d" % jobs] + extra_args + sources
+    start = time.time()
+    subprocess.check_call(command, cwd=build_dir)
+    return time.time() - start
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Compare the time taken by no-op incremental builds of a "
+                    "synthetic module with YAML and binary dependency files.")
+    parser.add_argument("--swiftc", default="swiftc",
+                        help="the swiftc driver to benchmark")
+    parser.add_argument("--files", type=int, default=500,
+                        help="the number of source files to generate")
+    parser.add_argument("--decls-per-file", type=int, default=20,
+                        help="the number of structs in each source file")
+    parser.add_argument("-j", "--jobs", type=int, default=8,
+                        help="the number of parallel frontend jobs")
+    parser.add_argument("--iterations", type=int, default=10,
+                        help="the number of no-op builds to time in each mode")
+    args = parser.parse_args()
+
+    work_dir = tempfile.mkdtemp(prefix="incremental-noop-benchmark-")
+    try:
+        source_dir = os.path.join(work_dir, "src")
+        os.makedirs(source_dir)
+        sources = generate_module(source_dir, args.files, args.decls_per_file)
+
+        modes = [("yaml", []), ("binary", ["-enable-binary-dependencies"])]
+        results = {}
+        for name, extra_args in modes:
+            build_dir = os.path.join(work_dir, "build-" + name)
+            os.makedirs(build_dir)
+            output_map = write_output_file_map(build_dir, sources)
+
+            # The initial build writes every dependency file in this format.
+            build(args.swiftc, sources, build_dir, output_map, args.jobs,
+                  extra_args)
+
+            times = [build(args.swiftc, sources, build_dir, output_map,
+                           args.jobs, extra_args)
+                     for _ in range(args.iterations)]
+            results[name] = min(times)
+            print("%-8s no-op build, best of %d: %.3fs" %
+                  (name, args.iterations, results[name]))
+
+        print("speedup: %.2fx" % (results["yaml"] / results["binary"]))
+    finally:
+        shutil.rmtree(work_dir)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,148 @@
+#!/usr/bin/env python
+# utils/job-scheduling-benchmark.py - Time job scheduling -*- python -*-
+#
+# This source file is part of the Swift.org open source project
+#
+# Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+# Licensed under Apache License v2.0 with Runtime Library Exception
+#
+# See http://swift.org/LICENSE.txt for license information
+# See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+
+# Generates a synthetic multi-file module in which a few files take much
+# longer to compile than the rest and come last on the command line. After an
+# initial build has recorded how long each file takes, it times rebuilds of
+# every file and of a subset of the files, once with the default scheduling
+# (longest critical path first) and once with -driver-ignore-job-durations
+# (jobs start in the order they become ready).
+
+from __future__ import print_function
+
+import argparse
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+
+def generate_module(directory, num_files, num_slow_files, decls_per_file,
+                    slow_factor):
+    paths = []
+    for i in range(num_files):
+        count = decls_per_file
+        if i >= num_files - num_slow_files:
+            count *= slow_factor
+        path = os.path.join(directory, "file%d.swift" % i)
+        with open(path, "w") as f:
+            for j in range(count):
+                f.write("public struct S%d_%d {\n" % (i, j))
+                f.write("  public var value: Int\n")
+                f.write("  public init(value: Int) { self.value = value }\n")
+                f.write("  public func next() -> Int {\n")
+                f.write("    return value &+ %d\n" % j)
+                f.write("  }\n")
+                f.write("}\n\n")
+        paths.append(path)
+    return paths
+
+
+def write_output_file_map(build_dir, sources):
+    output_map = {"": {"swift-dependencies":
+                       os.path.join(build_dir, "main~buildrecord.swiftdeps")}}
+    for source in sources:
+        base = os.path.join(build_dir,
+                            os.path.splitext(os.path.basename(source))[0])
+        output_map[source] = {
+            "object": base + ".o",
+            "swift-dependencies": base + ".swiftdeps",
+        }
+    path = os.path.join(build_dir, "output.json")
+    with open(path, "w") as f:
+        json.dump(output_map, f, indent=2)
+    return path
+
+
+def build(swiftc, sources, build_dir, output_map, jobs, extra_args):
+    command = [swiftc, "-c", "-incremental", "-module-name", "Synthetic",
+               "-output-file-map", output_map,
+               "-j%d" % jobs] + extra_args + sources
+    start = time.time()
+    subprocess.check_call(command, cwd=build_dir)
+    return time.time() - start
+
+
+def touch(paths):
+    # Make sure the files look newer than the build record.
+    time.sleep(1)
+    for path in paths:
+        os.utime(path, None)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Compare rebuild times of a synthetic module with a long "
+                    "tail of slow files, with and without scheduling by "
+                    "recorded job durations.")
+    parser.add_argument("--swiftc", default="swiftc",
+                        help="the swiftc driver to benchmark")
+    parser.add_argument("--files", type=int, default=64,
+                        help="the number of source files to generate")
+    parser.add_argument("--slow-files", type=int, default=4,
+                        help="the number of those files that are slow")
+    parser.add_argument("--decls-per-file", type=int, default=20,
+                        help="the number of structs in each ordinary file")
+    parser.add_argument("--slow-factor", type=int, default=20,
+                        help="how many times more structs a slow file has")
+    parser.add_argument("-j", "--jobs", type=int, default=8,
+                        help="the number of parallel frontend jobs")
+    parser.add_argument("--iterations", type=int, default=3,
+                        help="the number of builds to time in each mode")
+    args = parser.parse_args()
+
+    work_dir = tempfile.mkdtemp(prefix="job-scheduling-benchmark-")
+    try:
+        source_dir = os.path.join(work_dir, "src")
+        os.makedirs(source_dir)
+        sources = generate_module(source_dir, args.files, args.slow_files,
+                                  args.decls_per_file, args.slow_factor)
+
+        # Rebuild every file, or every fourth file plus the slow ones.
+        scenarios = [("clean", sources),
+                     ("incremental",
+                      sources[::4] + sources[len(sources) - args.slow_files:])]
+        modes = [("in-order", ["-driver-ignore-job-durations"]),
+                 ("prioritized", [])]
+
+        for scenario, touched in scenarios:
+            results = {}
+            for name, extra_args in modes:
+                build_dir = os.path.join(work_dir, "build-" + name)
+                if not os.path.exists(build_dir):
+                    os.makedirs(build_dir)
+                    output_map = write_output_file_map(build_dir, sources)
+                    # The initial build records how long each file takes.
+                    build(args.swiftc, sources, build_dir, output_map,
+                          args.jobs, extra_args)
+                output_map = os.path.join(build_dir, "output.json")
+
+                times = []
+                for _ in range(args.iterations):
+                    touch(touched)
+                    times.append(build(args.swiftc, sources, build_dir,
+                                       output_map, args.jobs, extra_args))
+                results[name] = min(times)
+                print("%-12s %-12s best of %d: %.2fs" %
+                      (scenario, name, args.iterations, results[name]))
+
+            print("%-12s speedup: %.2fx" %
+                  (scenario, results["in-order"] / results["prioritized"]))
+    finally:
+        shutil.rmtree(work_dir)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
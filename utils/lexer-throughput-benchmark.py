@@ -0,0 +1,89 @@
+#!/usr/bin/env python
+# utils/lexer-throughput-benchmark.py - Time lexing large files -*- python -*-
+#
+# This source file is part of the Swift.org open source project
+#
+# Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+# Licensed under Apache License v2.0 with Runtime Library Exception
+#
+# See http://swift.org/LICENSE.txt for license information
+# See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+
+# Generates a large source file that looks like generated code (long doc
+# comments, tables of string literals, long identifiers and indentation), and
+# times parsing it with the frontend. The time taken to parse an empty file is
+# subtracted, so that the result is roughly the throughput of the lexer and
+# parser on this kind of input.
+
+from __future__ import print_function, unicode_literals
+
+import argparse
+import io
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+
+def generate_file(path, size):
+    words = ["generated", "documentation", "for", "the", "entry", "below",
+             "which", "describes", "a", "localized", "resource", "string"]
+    with io.open(path, "w", encoding="utf-8") as f:
+        i = 0
+        while f.tell() < size:
+            f.write("/// %s\n" % " ".join(words[(i + j) % len(words)]
+                                         for j in range(14)))
+            f.write("/// - Note: entries are keyed by \u00e9tiquette.\n")
+            f.write("/* Block comment %d: %s */\n" % (i, " ".join(words)))
+            f.write("public let localizedResourceStringTableEntry%d = [\n" % i)
+            for j in range(8):
+                f.write("    \"key_%d_%d\": \"%s \\(%d) \\\"%s\\\"\",\n" % (
+                    i, j, " ".join(words[j:]), j, words[j]))
+            f.write("]\n\n")
+            i += 1
+
+
+def time_parse(swift, path, iterations):
+    command = [swift, "-frontend", "-parse", "-parse-stdlib", path]
+    times = []
+    for _ in range(iterations):
+        start = time.time()
+        subprocess.check_call(command)
+        times.append(time.time() - start)
+    return min(times)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Measure how quickly the frontend lexes and parses a "
+                    "large file of generated-looking code.")
+    parser.add_argument("--swift", default="swift",
+                        help="the swift executable to benchmark")
+    parser.add_argument("--size", type=int, default=32,
+                        help="the size of the generated file, in MB")
+    parser.add_argument("--iterations", type=int, default=5,
+                        help="the number of times to parse each file")
+    args = parser.parse_args()
+
+    work_dir = tempfile.mkdtemp(prefix="lexer-throughput-benchmark-")
+    try:
+        empty = os.path.join(work_dir, "empty.swift")
+        open(empty, "w").close()
+        source = os.path.join(work_dir, "generated.swift")
+        generate_file(source, args.size * 1024 * 1024)
+        size_mb = os.path.getsize(source) / (1024.0 * 1024.0)
+
+        baseline = time_parse(args.swift, empty, args.iterations)
+        elapsed = time_parse(args.swift, source, args.iterations) - baseline
+        print("parsed %.1fMB in %.3fs (best of %d, %.3fs startup): "
+              "%.1fMB/s" % (size_mb, elapsed, args.iterations, baseline,
+                            size_mb / elapsed))
+    finally:
+        shutil.rmtree(work_dir)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,113 @@
+#!/usr/bin/env python
+# utils/parallel-parsing-benchmark.py - Time parallel parsing -*- python -*-
+#
+# This source file is part of the Swift.org open source project
+#
+# Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+# Licensed under Apache License v2.0 with Runtime Library Exception
+#
+# See http://swift.org/LICENSE.txt for license information
+# See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+
+# Generates a synthetic module of many source files, then times a
+# whole-module build of it with the non-main files parsed on different
+# numbers of threads (-num-parsing-threads).
+
+from __future__ import print_function
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+
+def generate_module(directory, num_files, decls_per_file):
+    paths = []
+    for i in range(num_files):
+        path = os.path.join(directory, "file%d.swift" % i)
+        with open(path, "w") as f:
+            for j in range(decls_per_file):
+                f.write("public struct S%d_%d {\n" % (i, j))
+                f.write("  public var value: Int\n")
+                f.write("  public var name: String\n")
+                f.write("  public init(value: Int, name: String) {\n")
+                f.write("    self.value = value\n")
+                f.write("    self.name = name\n")
+                f.write("  }\n")
+                f.write("  public func scaled(by factor: Int) -> Int {\n")
+                f.write("    // Adds the factor %d times.\n" % j)
+                f.write("    return value &* factor &+ %d\n" % j)
+                f.write("  }\n")
+                f.write("}\n\n")
+            f.write("public func use%d() -> Int {\n" % i)
+            f.write("  return S%d_0(value: %d, name: \"s%d\").scaled(by: 2)\n"
+                    % (i, i, i))
+            f.write("}\n")
+        paths.append(path)
+    return paths
+
+
+def time_build(swiftc, sources, build_dir, threads, action):
+    if os.path.exists(build_dir):
+        shutil.rmtree(build_dir)
+    os.makedirs(build_dir)
+    command = [swiftc, action, "-whole-module-optimization",
+               "-module-name", "Synthetic",
+               "-Xfrontend", "-num-parsing-threads",
+               "-Xfrontend", str(threads)] + sources
+    start = time.time()
+    subprocess.check_call(command, cwd=build_dir)
+    return time.time() - start
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Compare the whole-module build time of a synthetic "
+                    "module with its files parsed on different numbers of "
+                    "threads.")
+    parser.add_argument("--swiftc", default="swiftc",
+                        help="the swiftc driver to benchmark")
+    parser.add_argument("--files", type=int, default=1000,
+                        help="the number of source files to generate")
+    parser.add_argument("--decls-per-file", type=int, default=10,
+                        help="the number of structs in each source file")
+    parser.add_argument("--threads", type=int, nargs="+", default=[1, 2, 4, 8],
+                        help="the numbers of parsing threads to time")
+    parser.add_argument("--parse-only", action="store_true",
+                        help="only parse the module (-parse) instead of "
+                             "compiling it (-c)")
+    parser.add_argument("--iterations", type=int, default=3,
+                        help="the number of builds to time for each setting")
+    args = parser.parse_args()
+
+    action = "-parse" if args.parse_only else "-c"
+    work_dir = tempfile.mkdtemp(prefix="parallel-parsing-benchmark-")
+    try:
+        source_dir = os.path.join(work_dir, "src")
+        os.makedirs(source_dir)
+        sources = generate_module(source_dir, args.files, args.decls_per_file)
+
+        results = {}
+        for threads in args.threads:
+            build_dir = os.path.join(work_dir, "build-%d" % threads)
+            times = [time_build(args.swiftc, sources, build_dir, threads,
+                                action)
+                     for _ in range(args.iterations)]
+            results[threads] = min(times)
+            print("%2d threads best of %d: %.2fs" % (threads, args.iterations,
+                                                      results[threads]))
+
+        baseline = results[args.threads[0]]
+        for threads in args.threads[1:]:
+            print("speedup with %d threads: %.2fx"
+                  % (threads, baseline / results[threads]))
+    finally:
+        shutil.rmtree(work_dir)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
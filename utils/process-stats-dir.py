@@ -0,0 +1,137 @@
+#!/usr/bin/env python
+# utils/process-stats-dir.py - Summarize and compare stats files -*- python -*-
+#
+# This source file is part of the Swift.org open source project
+#
+# Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+# Licensed under Apache License v2.0 with Runtime Library Exception
+#
+# See http://swift.org/LICENSE.txt for license information
+# See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+
+# Reads the files written by the driver and frontend jobs of a build with
+# -stats-output-dir. "aggregate" adds up each counter over all of a build's
+# jobs, except for peaks, of which it takes the largest; "compare" does the same for two builds and prints the counters that
+# changed, exiting with a failure status if any of them grew by more than a
+# given percentage, so that it can be used to catch compile-time regressions.
+
+from __future__ import print_function
+
+import argparse
+import json
+import os
+import sys
+
+
+def is_peak(key):
+    return key.split(".")[-1].startswith("Peak")
+
+
+def load_stats_dir(path):
+    """Returns the sum of each counter over the stats files in path (or the
+    largest value, for peaks), and the number of files."""
+    totals = {}
+    num_files = 0
+    for name in sorted(os.listdir(path)):
+        if not (name.startswith("stats-") and name.endswith(".json")):
+            continue
+        with open(os.path.join(path, name)) as f:
+            stats = json.load(f)
+        for key, value in stats.items():
+            if is_peak(key):
+                totals[key] = max(totals.get(key, 0), value)
+            else:
+                totals[key] = totals.get(key, 0) + value
+        num_files += 1
+    return totals, num_files
+
+
+def is_timer(key):
+    return key.startswith("time.")
+
+
+def format_value(key, value):
+    if is_timer(key):
+        return "%.3fs" % value
+    return "%d" % value
+
+
+def aggregate(args):
+    totals, num_files = load_stats_dir(args.dir)
+    if num_files == 0:
+        print("error: no stats files in '%s'" % args.dir, file=sys.stderr)
+        return 1
+    print("%d stats files" % num_files)
+    for key in sorted(totals):
+        if args.exclude_timers and is_timer(key):
+            continue
+        print("%-60s %s" % (key, format_value(key, totals[key])))
+    return 0
+
+
+def compare(args):
+    old, num_old = load_stats_dir(args.old)
+    new, num_new = load_stats_dir(args.new)
+    if num_old == 0 or num_new == 0:
+        print("error: no stats files in '%s'" %
+              (args.old if num_old == 0 else args.new), file=sys.stderr)
+        return 1
+
+    regressions = []
+    print("%-60s %14s %14s %8s" % ("counter", "old", "new", "delta"))
+    for key in sorted(set(old) | set(new)):
+        if args.exclude_timers and is_timer(key):
+            continue
+        old_value = old.get(key, 0)
+        new_value = new.get(key, 0)
+        if old_value == new_value:
+            continue
+        if old_value == 0:
+            delta_pct = float("inf")
+        else:
+            delta_pct = 100.0 * (new_value - old_value) / old_value
+        print("%-60s %14s %14s %+7.1f%%" % (
+            key, format_value(key, old_value), format_value(key, new_value),
+            delta_pct))
+        if delta_pct > args.delta_pct:
+            regressions.append(key)
+
+    if regressions:
+        print("\n%d counters grew by more than %.1f%%:" % (
+            len(regressions), args.delta_pct))
+        for key in regressions:
+            print("  " + key)
+        return 1
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Summarize the statistics written by a build with "
+                    "-stats-output-dir, or compare those of two builds.")
+    parser.add_argument("--exclude-timers", action="store_true",
+                        help="leave out timers, which vary from run to run")
+    subparsers = parser.add_subparsers()
+
+    aggregate_parser = subparsers.add_parser(
+        "aggregate", help="sum each counter over all of a build's jobs")
+    aggregate_parser.add_argument("dir", help="the stats directory")
+    aggregate_parser.set_defaults(func=aggregate)
+
+    compare_parser = subparsers.add_parser(
+        "compare", help="compare the counters of two builds")
+    compare_parser.add_argument("old", help="the stats directory of the "
+                                            "baseline build")
+    compare_parser.add_argument("new", help="the stats directory of the "
+                                            "build to check")
+    compare_parser.add_argument("--delta-pct", type=float, default=1.0,
+                                help="fail if a counter grew by more than "
+                                     "this percentage (default: 1.0)")
+    compare_parser.set_defaults(func=compare)
+
+    args = parser.parse_args()
+    return args.func(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())